@@ -0,0 +1,110 @@
+#include "cpu_topology.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <sched.h>
+#include <unistd.h>
+#include "native_log.h"
+
+#define TAG "CpuTopology"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+uint32_t readSysfsValue(const std::string& path) {
+    std::ifstream file(path);
+    uint32_t value = 0;
+    if (file >> value) {
+        return value;
+    }
+    return 0;
+}
+
+CpuTopology detect() {
+    CpuTopology topology;
+    const long count = sysconf(_SC_NPROCESSORS_CONF);
+    for (int id = 0; id < count; id++) {
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/";
+        CpuCore core;
+        core.id = id;
+        core.capacity = readSysfsValue(base + "cpu_capacity");
+        core.maxFreqKhz = readSysfsValue(base + "cpufreq/cpuinfo_max_freq");
+        topology.cores.push_back(core);
+    }
+
+    // Capacity already folds in microarchitecture; frequency is the fallback
+    auto rank = [](const CpuCore& core) { return core.capacity ? core.capacity : core.maxFreqKhz; };
+    uint32_t lowest = UINT32_MAX;
+    uint32_t highest = 0;
+    for (const CpuCore& core : topology.cores) {
+        lowest = std::min(lowest, rank(core));
+        highest = std::max(highest, rank(core));
+    }
+    for (const CpuCore& core : topology.cores) {
+        if (lowest != highest && rank(core) == lowest) {
+            topology.efficiencyCores.push_back(core.id);
+        } else {
+            topology.performanceCores.push_back(core.id);
+        }
+    }
+    if (topology.performanceCores.empty()) {
+        topology.performanceCores.push_back(0);
+    }
+    return topology;
+}
+
+} // namespace
+
+std::string CpuTopology::describe() const {
+    std::ostringstream ss;
+    ss << cores.size() << " cores, performance [";
+    for (size_t i = 0; i < performanceCores.size(); i++) {
+        ss << (i ? "," : "") << performanceCores[i];
+    }
+    ss << "], efficiency [";
+    for (size_t i = 0; i < efficiencyCores.size(); i++) {
+        ss << (i ? "," : "") << efficiencyCores[i];
+    }
+    ss << "]";
+    return ss.str();
+}
+
+const CpuTopology& CpuTopology::get() {
+    static const CpuTopology topology = [] {
+        CpuTopology detected = detect();
+        LOGi("Detected %s", detected.describe().c_str());
+        return detected;
+    }();
+    return topology;
+}
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        LOGe("sched_setaffinity failed, running unpinned");
+        return false;
+    }
+    return true;
+}
+
+bool cpuHasAvx2() {
+#if defined(TASTYDIET_AVX2_KERNELS)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+ThreadConfig defaultThreadConfig(const CpuTopology& topology) {
+    const int32_t performance = (int32_t) topology.performanceCores.size();
+    ThreadConfig config;
+    config.prefillThreads = std::max(1, performance);
+    config.decodeThreads = std::max(1, std::min(performance, 4));
+    return config;
+}
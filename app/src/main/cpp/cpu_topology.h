@@ -0,0 +1,54 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CpuCore {
+    int id = 0;
+    uint32_t capacity = 0;    // cpu_capacity (0-1024), 0 if the kernel doesn't expose it
+    uint32_t maxFreqKhz = 0;  // cpufreq/cpuinfo_max_freq
+};
+
+// Core layout read from /sys/devices/system/cpu. On heterogeneous (big.LITTLE /
+// DynamIQ) SoCs the lowest-capacity cluster is treated as efficiency cores and
+// everything above it as performance cores.
+struct CpuTopology {
+    std::vector<CpuCore> cores;
+    std::vector<int> performanceCores;
+    std::vector<int> efficiencyCores;
+
+    bool isHeterogeneous() const { return !efficiencyCores.empty(); }
+    std::string describe() const;
+
+    // Detected once per process
+    static const CpuTopology& get();
+};
+
+// Thread counts for multi-token (prefill) and single-token (decode) batches
+struct ThreadConfig {
+    int32_t prefillThreads = 4;
+    int32_t decodeThreads = 4;
+};
+
+// Restricts the calling thread to `cpus`. Threads it spawns afterwards (the
+// ggml compute workers) inherit the mask.
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+// Heuristic before calibration: prefill is compute bound and uses every
+// performance core; decode is memory bound and rarely scales past 4 threads.
+ThreadConfig defaultThreadConfig(const CpuTopology& topology);
+
+// x86 kernels are compiled for AVX2 one function at a time (TASTYDIET_TARGET_AVX2)
+// so the rest of the build keeps the baseline instruction set; callers pick them
+// when cpuHasAvx2(). NEON needs no check, it is part of arm64.
+#if defined(__x86_64__) || defined(__i386__)
+#define TASTYDIET_AVX2_KERNELS 1
+#define TASTYDIET_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Detected once per process; false on CPUs other than x86
+bool cpuHasAvx2();
+
+#endif // CPU_TOPOLOGY_H
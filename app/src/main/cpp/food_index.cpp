@@ -0,0 +1,488 @@
+#include "food_index.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "json_reader.h"
+#include "native_log.h"
+
+#define TAG "FoodIndex"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'D', 'F', 'I'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t rows;
+    uint32_t hashCapacity;   // power of two
+    uint32_t wordCount;
+    uint32_t stringBytes;
+    uint64_t columnsOffset;
+    uint64_t flagsOffset;
+    uint64_t stringRefsOffset;
+    uint64_t hashOffset;
+    uint64_t wordsOffset;
+    uint64_t stringsOffset;
+    uint64_t fileSize;
+};
+
+// JSON keys of the FoodColumn / FoodFlag entries
+const char* const kColumnKeys[FOOD_COLUMN_COUNT] = {
+    "caloriesPerUnit", "proteinPerUnit", "carbsPerUnit", "fatPerUnit",
+    "fiberPerUnit", "sugarPerUnit", "sodiumPerUnit",
+};
+const char* const kFlagKeys[FOOD_FLAG_COUNT] = {"isVeg", "isGlutenFree", "isDairyFree"};
+
+uint32_t hashKey(const char* key, size_t len) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t) key[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint64_t wordsOf(uint32_t rows) {
+    return (rows + 63) / 64;
+}
+
+class Writer {
+public:
+    std::vector<uint8_t> bytes;
+
+    uint64_t align() {
+        bytes.resize((bytes.size() + 7) & ~(size_t) 7, 0);
+        return bytes.size();
+    }
+
+    template <typename T>
+    uint64_t append(const std::vector<T>& values) {
+        const uint64_t offset = align();
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(values.data());
+        bytes.insert(bytes.end(), raw, raw + values.size() * sizeof(T));
+        return offset;
+    }
+};
+
+// Edit distance capped at maxDistance + 1, with an early exit once every cell
+// of a row exceeds the cap
+int boundedLevenshtein(const char* a, size_t aLen, const char* b, size_t bLen, int maxDistance) {
+    if ((int) (aLen > bLen ? aLen - bLen : bLen - aLen) > maxDistance) {
+        return maxDistance + 1;
+    }
+    std::vector<int> prev(bLen + 1), cur(bLen + 1);
+    for (size_t j = 0; j <= bLen; j++) {
+        prev[j] = (int) j;
+    }
+    for (size_t i = 1; i <= aLen; i++) {
+        cur[0] = (int) i;
+        int rowMin = cur[0];
+        for (size_t j = 1; j <= bLen; j++) {
+            const int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            cur[j] = std::min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + cost});
+            rowMin = std::min(rowMin, cur[j]);
+        }
+        if (rowMin > maxDistance) {
+            return maxDistance + 1;
+        }
+        std::swap(prev, cur);
+    }
+    return std::min(prev[bLen], maxDistance + 1);
+}
+
+} // namespace
+
+std::string foodKey(const std::string& name) {
+    std::string key;
+    key.reserve(name.size());
+    for (unsigned char c : name) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (!key.empty() && key.back() != ' ') {
+                key += ' ';
+            }
+        } else {
+            key += (char) (c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+        }
+    }
+    if (!key.empty() && key.back() == ' ') {
+        key.pop_back();
+    }
+    return key;
+}
+
+uint64_t FoodIndex::sourceHash(const char* json, size_t size) {
+    uint64_t hash = 14695981039346656037ull;  // FNV-1a 64
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ (uint8_t) json[i]) * 1099511628211ull;
+    }
+    return hash ^ size;
+}
+
+bool FoodIndex::compile(const char* json, size_t size, const std::string& path, std::string& error) {
+    JsonValue root;
+    if (!parseJson(json, size, root, error)) {
+        return false;
+    }
+    const JsonValue* items = root.get("foodItems");
+    if (!items || !items->isArray() || items->items.empty()) {
+        error = "no foodItems array";
+        return false;
+    }
+
+    const uint32_t rows = (uint32_t) items->items.size();
+    std::vector<std::vector<float>> columns(FOOD_COLUMN_COUNT, std::vector<float>(rows, 0.0f));
+    std::vector<std::vector<uint64_t>> flags(FOOD_FLAG_COUNT, std::vector<uint64_t>(wordsOf(rows), 0));
+    std::vector<uint32_t> stringRefs((size_t) rows * 4);  // name, lowercase name, category, unit
+
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> interned;
+    auto intern = [&](const std::string& s) {
+        auto it = interned.find(s);
+        if (it != interned.end()) {
+            return it->second;
+        }
+        const uint32_t offset = (uint32_t) strings.size();
+        strings.append(s).push_back('\0');
+        interned.emplace(s, offset);
+        return offset;
+    };
+
+    for (uint32_t row = 0; row < rows; row++) {
+        const JsonValue& item = items->items[row];
+        for (int c = 0; c < FOOD_COLUMN_COUNT; c++) {
+            columns[c][row] = (float) item.numberOr(kColumnKeys[c], 0.0);
+        }
+        for (int f = 0; f < FOOD_FLAG_COUNT; f++) {
+            // Same defaults as FoodDatabaseImporter
+            if (item.boolOr(kFlagKeys[f], true)) {
+                flags[f][row >> 6] |= 1ull << (row & 63);
+            }
+        }
+        const std::string name = item.stringOr("name", "");
+        stringRefs[row] = intern(name);
+        stringRefs[rows + row] = intern(foodKey(name));
+        stringRefs[2 * rows + row] = intern(item.stringOr("category", ""));
+        stringRefs[3 * rows + row] = intern(item.stringOr("unit", ""));
+    }
+
+    // First row wins for duplicate names, matching a linear scan
+    uint32_t capacity = 16;
+    while (capacity < rows * 2) {
+        capacity <<= 1;
+    }
+    std::vector<uint32_t> table(capacity, 0);
+    for (uint32_t row = 0; row < rows; row++) {
+        const char* key = strings.c_str() + stringRefs[rows + row];
+        for (uint32_t slot = hashKey(key, std::strlen(key)) & (capacity - 1);; slot = (slot + 1) & (capacity - 1)) {
+            if (table[slot] == 0) {
+                table[slot] = row + 1;
+                break;
+            }
+            if (stringRefs[rows + table[slot] - 1] == stringRefs[rows + row]) {
+                break;  // interned: equal offsets mean equal names
+            }
+        }
+    }
+
+    std::vector<uint32_t> words;
+    for (uint32_t row = 0; row < rows; row++) {
+        const uint32_t offset = stringRefs[rows + row];
+        const char* key = strings.c_str() + offset;
+        for (uint32_t i = 0; key[i]; i++) {
+            if (i == 0 || key[i - 1] == ' ') {
+                words.push_back(offset + i);
+                words.push_back(row);
+            }
+        }
+    }
+    const uint32_t wordCount = (uint32_t) (words.size() / 2);
+    std::vector<std::pair<uint32_t, uint32_t>> sorted(wordCount);
+    for (uint32_t i = 0; i < wordCount; i++) {
+        sorted[i] = {words[2 * i], words[2 * i + 1]};
+    }
+    std::sort(sorted.begin(), sorted.end(), [&](const auto& a, const auto& b) {
+        const int cmp = std::strcmp(strings.c_str() + a.first, strings.c_str() + b.first);
+        return cmp != 0 ? cmp < 0 : a.second < b.second;
+    });
+    for (uint32_t i = 0; i < wordCount; i++) {
+        words[2 * i] = sorted[i].first;
+        words[2 * i + 1] = sorted[i].second;
+    }
+
+    Writer writer;
+    FileHeader header {};
+    writer.bytes.resize(sizeof(FileHeader));
+    header.columnsOffset = writer.align();
+    for (const auto& column : columns) {
+        writer.append(column);
+    }
+    header.flagsOffset = writer.align();
+    for (const auto& bits : flags) {
+        writer.append(bits);
+    }
+    header.stringRefsOffset = writer.append(stringRefs);
+    header.hashOffset = writer.append(table);
+    header.wordsOffset = writer.append(words);
+    header.stringsOffset = writer.append(std::vector<char>(strings.begin(), strings.end()));
+    writer.align();
+
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.sourceHash = sourceHash(json, size);
+    header.rows = rows;
+    header.hashCapacity = capacity;
+    header.wordCount = wordCount;
+    header.stringBytes = (uint32_t) strings.size();
+    header.fileSize = writer.bytes.size();
+    std::memcpy(writer.bytes.data(), &header, sizeof(header));
+
+    const std::string tmpPath = path + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + tmpPath;
+        return false;
+    }
+    const bool written = std::fwrite(writer.bytes.data(), 1, writer.bytes.size(), file) == writer.bytes.size();
+    const bool closed = std::fclose(file) == 0;
+    if (!written || !closed || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        error = "cannot write " + path;
+        return false;
+    }
+    LOGi("Compiled %u foods (%u words, %u string bytes) into %zu bytes",
+         rows, wordCount, header.stringBytes, writer.bytes.size());
+    return true;
+}
+
+FoodIndex::FoodIndex()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_rows(0)
+    , m_hashMask(0)
+    , m_wordCount(0)
+    , m_columns()
+    , m_flags()
+    , m_nameOffsets(nullptr)
+    , m_lowerOffsets(nullptr)
+    , m_categoryOffsets(nullptr)
+    , m_unitOffsets(nullptr)
+    , m_hashTable(nullptr)
+    , m_words(nullptr)
+    , m_strings(nullptr)
+    , m_stringBytes(0) {
+}
+
+FoodIndex::~FoodIndex() {
+    close();
+}
+
+bool FoodIndex::open(const std::string& path, uint64_t expectedSourceHash) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    void* addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(FileHeader)) {
+        addr = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(addr);
+    m_size = (size_t) st.st_size;
+
+    FileHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    const uint64_t rows = header.rows;
+    auto fits = [&](uint64_t offset, uint64_t bytes) { return offset % 8 == 0 && offset <= m_size && bytes <= m_size - offset; };
+    const bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                       header.version == kVersion &&
+                       header.fileSize == m_size &&
+                       rows > 0 &&
+                       header.hashCapacity >= rows && (header.hashCapacity & (header.hashCapacity - 1)) == 0 &&
+                       fits(header.columnsOffset, FOOD_COLUMN_COUNT * rows * sizeof(float)) &&
+                       fits(header.flagsOffset, FOOD_FLAG_COUNT * wordsOf(header.rows) * sizeof(uint64_t)) &&
+                       fits(header.stringRefsOffset, 4 * rows * sizeof(uint32_t)) &&
+                       fits(header.hashOffset, (uint64_t) header.hashCapacity * sizeof(uint32_t)) &&
+                       fits(header.wordsOffset, 2ull * header.wordCount * sizeof(uint32_t)) &&
+                       fits(header.stringsOffset, header.stringBytes) &&
+                       header.stringBytes > 0 && m_data[header.stringsOffset + header.stringBytes - 1] == '\0';
+    if (!valid || (expectedSourceHash != 0 && header.sourceHash != expectedSourceHash)) {
+        LOGi("Food index at %s is %s", path.c_str(), valid ? "stale" : "invalid");
+        close();
+        return false;
+    }
+
+    m_rows = header.rows;
+    m_hashMask = header.hashCapacity - 1;
+    m_wordCount = header.wordCount;
+    const float* columns = reinterpret_cast<const float*>(m_data + header.columnsOffset);
+    for (int c = 0; c < FOOD_COLUMN_COUNT; c++) {
+        m_columns[c] = columns + (size_t) c * m_rows;
+    }
+    const uint64_t* flags = reinterpret_cast<const uint64_t*>(m_data + header.flagsOffset);
+    for (int f = 0; f < FOOD_FLAG_COUNT; f++) {
+        m_flags[f] = flags + (size_t) f * wordsOf(m_rows);
+    }
+    const uint32_t* refs = reinterpret_cast<const uint32_t*>(m_data + header.stringRefsOffset);
+    m_nameOffsets = refs;
+    m_lowerOffsets = refs + m_rows;
+    m_categoryOffsets = refs + 2 * (size_t) m_rows;
+    m_unitOffsets = refs + 3 * (size_t) m_rows;
+    m_hashTable = reinterpret_cast<const uint32_t*>(m_data + header.hashOffset);
+    m_words = reinterpret_cast<const uint32_t*>(m_data + header.wordsOffset);
+    m_strings = reinterpret_cast<const char*>(m_data + header.stringsOffset);
+    m_stringBytes = header.stringBytes;
+
+    // Offsets are only trusted after this pass
+    for (size_t i = 0; i < 4 * (size_t) m_rows; i++) {
+        if (refs[i] >= m_stringBytes) {
+            LOGe("Food index at %s has a bad string offset", path.c_str());
+            close();
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < m_wordCount; i++) {
+        if (m_words[2 * i] >= m_stringBytes || m_words[2 * i + 1] >= m_rows) {
+            LOGe("Food index at %s has a bad word entry", path.c_str());
+            close();
+            return false;
+        }
+    }
+    for (uint32_t slot = 0; slot <= m_hashMask; slot++) {
+        if (m_hashTable[slot] > m_rows) {
+            LOGe("Food index at %s has a bad hash entry", path.c_str());
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void FoodIndex::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_rows = 0;
+    m_wordCount = 0;
+}
+
+const char* FoodIndex::name(int32_t row) const {
+    return string(m_nameOffsets[row]);
+}
+
+const char* FoodIndex::category(int32_t row) const {
+    return string(m_categoryOffsets[row]);
+}
+
+const char* FoodIndex::unit(int32_t row) const {
+    return string(m_unitOffsets[row]);
+}
+
+int32_t FoodIndex::find(const std::string& name) const {
+    if (!m_data) {
+        return -1;
+    }
+    const std::string key = foodKey(name);
+    for (uint32_t slot = hashKey(key.data(), key.size()) & m_hashMask;; slot = (slot + 1) & m_hashMask) {
+        const uint32_t entry = m_hashTable[slot];
+        if (entry == 0) {
+            return -1;
+        }
+        if (key == string(m_lowerOffsets[entry - 1])) {
+            return (int32_t) entry - 1;
+        }
+    }
+}
+
+std::vector<int32_t> FoodIndex::prefixSearch(const std::string& prefix, size_t limit) const {
+    std::vector<int32_t> rows;
+    const std::string key = foodKey(prefix);
+    if (!m_data || key.empty()) {
+        return rows;
+    }
+
+    // Binary search over the sorted (offset, row) pairs
+    uint32_t lo = 0, hi = m_wordCount;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (std::strcmp(string(m_words[2 * mid]), key.c_str()) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Identical names are interned once, so the lowercase offset identifies a name
+    std::unordered_set<uint32_t> seen;
+    for (uint32_t i = lo; i < m_wordCount && rows.size() < limit; i++) {
+        if (std::strncmp(string(m_words[2 * i]), key.c_str(), key.size()) != 0) {
+            break;
+        }
+        const uint32_t row = m_words[2 * i + 1];
+        if (seen.insert(m_lowerOffsets[row]).second) {
+            rows.push_back((int32_t) row);
+        }
+    }
+    return rows;
+}
+
+std::vector<int32_t> FoodIndex::fuzzySearch(const std::string& query, size_t limit, int maxDistance) const {
+    std::vector<int32_t> rows;
+    const std::string key = foodKey(query);
+    if (!m_data || key.empty()) {
+        return rows;
+    }
+
+    struct Match {
+        int distance;
+        size_t length;
+        int32_t row;
+    };
+    std::vector<Match> matches;
+    std::unordered_set<uint32_t> seen;
+    for (uint32_t row = 0; row < m_rows; row++) {
+        if (!seen.insert(m_lowerOffsets[row]).second) {
+            continue;
+        }
+        const char* name = string(m_lowerOffsets[row]);
+        const size_t length = std::strlen(name);
+        int best = boundedLevenshtein(key.data(), key.size(), name, length, maxDistance);
+        for (size_t start = 0; start < length && best > 0;) {
+            size_t end = start;
+            while (end < length && name[end] != ' ') {
+                end++;
+            }
+            if (start > 0 || end < length) {
+                best = std::min(best, boundedLevenshtein(key.data(), key.size(), name + start, end - start, maxDistance));
+            }
+            start = end + 1;
+        }
+        if (best <= maxDistance) {
+            matches.push_back(Match{best, length, (int32_t) row});
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.length < b.length;
+    });
+    for (size_t i = 0; i < matches.size() && i < limit; i++) {
+        rows.push_back(matches[i].row);
+    }
+    return rows;
+}
@@ -0,0 +1,105 @@
+#ifndef FOOD_INDEX_H
+#define FOOD_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Nutrient columns, in file order
+enum FoodColumn {
+    FOOD_CALORIES = 0,
+    FOOD_PROTEIN,
+    FOOD_CARBS,
+    FOOD_FAT,
+    FOOD_FIBER,
+    FOOD_SUGAR,
+    FOOD_SODIUM,
+    FOOD_COLUMN_COUNT
+};
+
+enum FoodFlag {
+    FOOD_VEG = 0,
+    FOOD_GLUTEN_FREE,
+    FOOD_DAIRY_FREE,
+    FOOD_FLAG_COUNT
+};
+
+// Read-only nutrition index compiled from comprehensive_food_database.json.
+//
+// File layout (little-endian, every section 8-byte aligned):
+//   header | FOOD_COLUMN_COUNT float[rows] columns | FOOD_FLAG_COUNT uint64 bitsets
+//   | uint32 name/lowercase-name/category/unit string offsets per row
+//   | uint32 open-addressing hash table over lowercase names (row + 1, 0 = empty)
+//   | word index: (string offset, row) pairs sorted by the text from each word
+//     start in the lowercase name, for prefix search on any word
+//   | interned NUL-terminated strings
+//
+// The whole file is mmapped; lookups touch only the pages they need and never
+// allocate on the Java heap.
+class FoodIndex {
+public:
+    FoodIndex();
+    ~FoodIndex();
+    FoodIndex(const FoodIndex&) = delete;
+    FoodIndex& operator=(const FoodIndex&) = delete;
+
+    // Compiles the JSON food database into an index file at `path` (written to a
+    // temp file and renamed, so readers never see a partial index)
+    static bool compile(const char* json, size_t size, const std::string& path, std::string& error);
+
+    // Hash identifying the JSON a given index was compiled from
+    static uint64_t sourceHash(const char* json, size_t size);
+
+    // Maps an index file; fails when it is missing, corrupt, or was compiled
+    // from a different source (expectedSourceHash != 0)
+    bool open(const std::string& path, uint64_t expectedSourceHash = 0);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    uint32_t size() const { return m_rows; }
+
+    // Exact, case-insensitive name lookup in O(1); -1 when absent
+    int32_t find(const std::string& name) const;
+
+    // Rows with any name word starting with `prefix`, alphabetical by match text
+    std::vector<int32_t> prefixSearch(const std::string& prefix, size_t limit) const;
+
+    // Rows whose name (or one of its words) is within `maxDistance` edits of
+    // `query`, closest first
+    std::vector<int32_t> fuzzySearch(const std::string& query, size_t limit, int maxDistance = 2) const;
+
+    const char* name(int32_t row) const;
+    const char* category(int32_t row) const;
+    const char* unit(int32_t row) const;
+    float value(int32_t row, FoodColumn column) const { return m_columns[column][row]; }
+    const float* column(FoodColumn column) const { return m_columns[column]; }
+    bool flag(int32_t row, FoodFlag flag) const { return (m_flags[flag][row >> 6] >> (row & 63)) & 1; }
+    const uint64_t* flagBits(FoodFlag flag) const { return m_flags[flag]; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    uint32_t m_rows;
+    uint32_t m_hashMask;
+    uint32_t m_wordCount;
+
+    const float* m_columns[FOOD_COLUMN_COUNT];
+    const uint64_t* m_flags[FOOD_FLAG_COUNT];
+    const uint32_t* m_nameOffsets;
+    const uint32_t* m_lowerOffsets;
+    const uint32_t* m_categoryOffsets;
+    const uint32_t* m_unitOffsets;
+    const uint32_t* m_hashTable;
+    const uint32_t* m_words;   // pairs: string offset, row
+    const char* m_strings;
+    uint32_t m_stringBytes;
+
+    const char* string(uint32_t offset) const { return m_strings + offset; }
+};
+
+// Lowercase ASCII with runs of whitespace collapsed and trimmed: the form used
+// for hashing and matching names
+std::string foodKey(const std::string& name);
+
+#endif // FOOD_INDEX_H
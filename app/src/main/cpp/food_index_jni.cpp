@@ -0,0 +1,116 @@
+#include <jni.h>
+#include <string>
+#include <android/asset_manager.h>
+#include <android/asset_manager_jni.h>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "food_index.h"
+#include "jni_utf8.h"
+#include "native_log.h"
+
+#define LOG_TAG "FoodIndexJNI"
+#define LOGI(...) nativeLog(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) nativeLog(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// One process-wide index; reopened only when the bundled JSON changes
+static FoodIndex foodIndex;
+static std::shared_mutex foodIndexMutex;
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_util_NativeFoodIndex_openIndex(JNIEnv *env, jobject thiz, jobject assetManager, jstring assetName, jstring indexPath) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 name(env, assetName);
+    JniUtf8 path(env, indexPath);
+
+    AAssetManager* manager = AAssetManager_fromJava(env, assetManager);
+    AAsset* asset = manager ? AAssetManager_open(manager, name.c_str(), AASSET_MODE_BUFFER) : nullptr;
+    if (!asset) {
+        LOGE("Food database asset not found: %s", name.c_str());
+        return JNI_FALSE;
+    }
+    const char* json = static_cast<const char*>(AAsset_getBuffer(asset));
+    const size_t size = (size_t) AAsset_getLength(asset);
+    if (!json) {
+        AAsset_close(asset);
+        return JNI_FALSE;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(foodIndexMutex);
+    const uint64_t hash = FoodIndex::sourceHash(json, size);
+    bool opened = foodIndex.open(path, hash);
+    if (!opened) {
+        // First launch or a new database version: compile once, then map
+        std::string error;
+        if (FoodIndex::compile(json, size, path, error)) {
+            opened = foodIndex.open(path, hash);
+        } else {
+            LOGE("Failed to compile food index: %s", error.c_str());
+        }
+    }
+    AAsset_close(asset);
+
+    LOGI("Food index %s (%u foods)", opened ? "ready" : "unavailable", foodIndex.size());
+    return opened;
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_tastydiet_util_NativeFoodIndex_lookupFood(JNIEnv *env, jobject thiz, jstring name) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 key(env, name);
+    std::shared_lock<std::shared_mutex> lock(foodIndexMutex);
+    const int32_t row = foodIndex.isOpen() ? foodIndex.find(key) : -1;
+    if (row < 0) {
+        return nullptr;
+    }
+
+    // Nutrient columns followed by the flag bits (FoodFlag order)
+    jfloat values[FOOD_COLUMN_COUNT + 1];
+    uint32_t flags = 0;
+    for (int c = 0; c < FOOD_COLUMN_COUNT; c++) {
+        values[c] = foodIndex.value(row, (FoodColumn) c);
+    }
+    for (int f = 0; f < FOOD_FLAG_COUNT; f++) {
+        flags |= (uint32_t) foodIndex.flag(row, (FoodFlag) f) << f;
+    }
+    values[FOOD_COLUMN_COUNT] = (jfloat) flags;
+
+    jfloatArray result = env->NewFloatArray(FOOD_COLUMN_COUNT + 1);
+    env->SetFloatArrayRegion(result, 0, FOOD_COLUMN_COUNT + 1, values);
+    return result;
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_tastydiet_util_NativeFoodIndex_lookupFoodText(JNIEnv *env, jobject thiz, jstring name) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 key(env, name);
+    std::shared_lock<std::shared_mutex> lock(foodIndexMutex);
+    const int32_t row = foodIndex.isOpen() ? foodIndex.find(key) : -1;
+    if (row < 0) {
+        return nullptr;
+    }
+    return newJniStringArray(env, {foodIndex.name(row), foodIndex.category(row), foodIndex.unit(row)});
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_tastydiet_util_NativeFoodIndex_searchFoods(JNIEnv *env, jobject thiz, jstring query, jint limit, jboolean fuzzy) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 text(env, query);
+    std::shared_lock<std::shared_mutex> lock(foodIndexMutex);
+    std::vector<const char*> names;
+    if (foodIndex.isOpen() && limit > 0) {
+        std::vector<int32_t> rows = foodIndex.prefixSearch(text, (size_t) limit);
+        if (rows.empty() && fuzzy) {
+            rows = foodIndex.fuzzySearch(text, (size_t) limit);
+        }
+        for (int32_t row : rows) {
+            names.push_back(foodIndex.name(row));
+        }
+    }
+    return newJniStringArray(env, names);
+}
+
+}
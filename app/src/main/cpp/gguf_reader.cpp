@@ -0,0 +1,398 @@
+#include "gguf_reader.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ggml.h"
+#include "json_reader.h"
+
+namespace {
+
+enum GgufValueType : uint32_t {
+    GGUF_TYPE_UINT8 = 0,
+    GGUF_TYPE_INT8 = 1,
+    GGUF_TYPE_UINT16 = 2,
+    GGUF_TYPE_INT16 = 3,
+    GGUF_TYPE_UINT32 = 4,
+    GGUF_TYPE_INT32 = 5,
+    GGUF_TYPE_FLOAT32 = 6,
+    GGUF_TYPE_BOOL = 7,
+    GGUF_TYPE_STRING = 8,
+    GGUF_TYPE_ARRAY = 9,
+    GGUF_TYPE_UINT64 = 10,
+    GGUF_TYPE_INT64 = 11,
+    GGUF_TYPE_FLOAT64 = 12,
+};
+
+// Bounds-checked little-endian cursor over the mapped header
+class Cursor {
+public:
+    Cursor(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_pos(0), m_ok(true) {}
+
+    template <typename T>
+    T read() {
+        T value{};
+        if (!need(sizeof(T))) {
+            return value;
+        }
+        std::memcpy(&value, m_data + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return value;
+    }
+
+    std::string readString() {
+        const uint64_t len = read<uint64_t>();
+        if (!need(len)) {
+            return std::string();
+        }
+        std::string s(reinterpret_cast<const char*>(m_data + m_pos), (size_t) len);
+        m_pos += (size_t) len;
+        return s;
+    }
+
+    void skip(uint64_t n) {
+        if (need(n)) {
+            m_pos += (size_t) n;
+        }
+    }
+
+    bool ok() const { return m_ok; }
+    size_t pos() const { return m_pos; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos;
+    bool m_ok;
+
+    bool need(uint64_t n) {
+        if (!m_ok || n > m_size - m_pos) {
+            m_ok = false;
+        }
+        return m_ok;
+    }
+};
+
+size_t scalarSize(uint32_t type) {
+    switch (type) {
+        case GGUF_TYPE_UINT8: case GGUF_TYPE_INT8: case GGUF_TYPE_BOOL: return 1;
+        case GGUF_TYPE_UINT16: case GGUF_TYPE_INT16: return 2;
+        case GGUF_TYPE_UINT32: case GGUF_TYPE_INT32: case GGUF_TYPE_FLOAT32: return 4;
+        case GGUF_TYPE_UINT64: case GGUF_TYPE_INT64: case GGUF_TYPE_FLOAT64: return 8;
+        default: return 0;
+    }
+}
+
+// Reads an integer scalar of any width; false (nothing consumed) for other types
+bool readInteger(Cursor& cur, uint32_t type, uint64_t& value) {
+    switch (type) {
+        case GGUF_TYPE_UINT8: value = cur.read<uint8_t>(); return true;
+        case GGUF_TYPE_INT8: value = (uint64_t) cur.read<int8_t>(); return true;
+        case GGUF_TYPE_UINT16: value = cur.read<uint16_t>(); return true;
+        case GGUF_TYPE_INT16: value = (uint64_t) cur.read<int16_t>(); return true;
+        case GGUF_TYPE_UINT32: value = cur.read<uint32_t>(); return true;
+        case GGUF_TYPE_INT32: value = (uint64_t) cur.read<int32_t>(); return true;
+        case GGUF_TYPE_UINT64: value = cur.read<uint64_t>(); return true;
+        case GGUF_TYPE_INT64: value = (uint64_t) cur.read<int64_t>(); return true;
+        default: return false;
+    }
+}
+
+// Skips one value; reports the element count of arrays through `arrayCount`
+bool skipValue(Cursor& cur, uint32_t type, uint64_t* arrayCount = nullptr) {
+    if (type == GGUF_TYPE_STRING) {
+        cur.skip(cur.read<uint64_t>());
+    } else if (type == GGUF_TYPE_ARRAY) {
+        const uint32_t elemType = cur.read<uint32_t>();
+        const uint64_t count = cur.read<uint64_t>();
+        if (arrayCount) {
+            *arrayCount = count;
+        }
+        if (elemType == GGUF_TYPE_STRING) {
+            for (uint64_t i = 0; i < count && cur.ok(); i++) {
+                cur.skip(cur.read<uint64_t>());
+            }
+        } else {
+            const size_t elemSize = scalarSize(elemType);
+            if (elemSize == 0) {
+                return false; // nested arrays are not part of the format
+            }
+            if (count > UINT64_MAX / elemSize) {
+                return false;
+            }
+            cur.skip(count * elemSize);
+        }
+    } else {
+        const size_t size = scalarSize(type);
+        if (size == 0) {
+            return false;
+        }
+        cur.skip(size);
+    }
+    return cur.ok();
+}
+
+enum class ParseResult {
+    Ok,
+    Malformed,
+    NeedMore  // ran past the mapped window before the end of the tensor table
+};
+
+// Parses the first `mapped` bytes of a `fileSize`-byte GGUF file
+ParseResult parseImpl(const uint8_t* data, size_t mapped, uint64_t fileSize, GgufLayout& layout, std::string& error) {
+    layout = GgufLayout();
+    Cursor cur(data, mapped);
+    const bool partial = mapped < fileSize;
+    auto truncated = [&](const std::string& what) {
+        if (partial) {
+            return ParseResult::NeedMore;
+        }
+        error = what;
+        return ParseResult::Malformed;
+    };
+
+    if (mapped < 4 || std::memcmp(data, "GGUF", 4) != 0) {
+        error = "not a GGUF file (bad magic)";
+        return ParseResult::Malformed;
+    }
+    cur.skip(4);
+    layout.version = cur.read<uint32_t>();
+    if (layout.version < 2 || layout.version > 3) {
+        error = "unsupported GGUF version " + std::to_string(layout.version);
+        return ParseResult::Malformed;
+    }
+    layout.tensorCount = cur.read<uint64_t>();
+    layout.kvCount = cur.read<uint64_t>();
+    if (!cur.ok()) {
+        return truncated("truncated GGUF header");
+    }
+
+    // Integer hyperparameters are keyed by architecture, which may come later
+    std::map<std::string, uint64_t> integers;
+    GgufMetadata& meta = layout.meta;
+    for (uint64_t i = 0; i < layout.kvCount; i++) {
+        const std::string key = cur.readString();
+        const uint32_t type = cur.read<uint32_t>();
+        uint64_t value = 0;
+        bool valid = true;
+        if (key == "general.alignment" && type == GGUF_TYPE_UINT32) {
+            layout.alignment = cur.read<uint32_t>();
+        } else if (key == "general.architecture" && type == GGUF_TYPE_STRING) {
+            meta.architecture = cur.readString();
+        } else if (key == "general.name" && type == GGUF_TYPE_STRING) {
+            meta.name = cur.readString();
+        } else if (key == "tokenizer.ggml.tokens") {
+            valid = skipValue(cur, type, &meta.vocabSize);
+        } else if (readInteger(cur, type, value)) {
+            integers[key] = value;
+        } else {
+            valid = skipValue(cur, type);
+        }
+        if (!cur.ok()) {
+            return truncated("truncated metadata at key " + std::to_string(i));
+        }
+        if (!valid) {
+            error = "malformed metadata value for key '" + key + "'";
+            return ParseResult::Malformed;
+        }
+    }
+    if (layout.alignment == 0 || (layout.alignment & (layout.alignment - 1)) != 0) {
+        error = "invalid general.alignment " + std::to_string(layout.alignment);
+        return ParseResult::Malformed;
+    }
+
+    auto lookup = [&](const std::string& key) {
+        auto it = integers.find(key);
+        return it != integers.end() ? it->second : 0;
+    };
+    const std::string& arch = meta.architecture;
+    meta.contextLength = lookup(arch + ".context_length");
+    meta.embeddingLength = lookup(arch + ".embedding_length");
+    meta.blockCount = lookup(arch + ".block_count");
+    meta.headCount = lookup(arch + ".attention.head_count");
+    meta.headCountKv = lookup(arch + ".attention.head_count_kv");
+    if (meta.headCountKv == 0) {
+        meta.headCountKv = meta.headCount;
+    }
+    if (integers.count("general.file_type")) {
+        meta.fileType = (int32_t) integers["general.file_type"];
+    }
+
+    // Each tensor info takes at least 28 bytes, which bounds a bogus count early
+    if (layout.tensorCount > (fileSize - cur.pos()) / 28) {
+        error = "tensor count " + std::to_string(layout.tensorCount) + " exceeds file size";
+        return ParseResult::Malformed;
+    }
+    layout.tensors.reserve((size_t) layout.tensorCount);
+    for (uint64_t i = 0; i < layout.tensorCount; i++) {
+        GgufTensorInfo info;
+        info.name = cur.readString();
+        info.nDims = cur.read<uint32_t>();
+        if (cur.ok() && (info.nDims == 0 || info.nDims > 4)) {
+            error = "tensor '" + info.name + "' has " + std::to_string(info.nDims) + " dims";
+            return ParseResult::Malformed;
+        }
+        for (uint32_t d = 0; d < info.nDims && cur.ok(); d++) {
+            info.ne[d] = (int64_t) cur.read<uint64_t>();
+            if (cur.ok() && info.ne[d] <= 0) {
+                error = "tensor '" + info.name + "' has a non-positive dimension";
+                return ParseResult::Malformed;
+            }
+        }
+        info.type = cur.read<uint32_t>();
+        info.offset = cur.read<uint64_t>();
+        if (!cur.ok()) {
+            return truncated("truncated tensor table at tensor " + std::to_string(i));
+        }
+
+        const enum ggml_type type = (enum ggml_type) info.type;
+        const int64_t blockSize = info.type < GGML_TYPE_COUNT ? ggml_blck_size(type) : 0;
+        if (blockSize <= 0 || info.ne[0] % blockSize != 0) {
+            error = "tensor '" + info.name + "' has unsupported type " + std::to_string(info.type);
+            return ParseResult::Malformed;
+        }
+        // Dimensions come from the file; a product that wraps would pass the bounds check below
+        uint64_t size = (uint64_t) ggml_type_size(type);
+        bool overflow = __builtin_mul_overflow(size, (uint64_t) (info.ne[0] / blockSize), &size);
+        for (uint32_t d = 1; d < 4 && !overflow; d++) {
+            overflow = __builtin_mul_overflow(size, (uint64_t) info.ne[d], &size);
+        }
+        if (overflow) {
+            error = "tensor '" + info.name + "' is too large";
+            return ParseResult::Malformed;
+        }
+        info.size = size;
+        if (info.offset % layout.alignment != 0) {
+            error = "tensor '" + info.name + "' is misaligned";
+            return ParseResult::Malformed;
+        }
+        layout.tensors.push_back(std::move(info));
+    }
+
+    const uint64_t align = layout.alignment;
+    layout.dataOffset = (cur.pos() + align - 1) / align * align;
+    for (const GgufTensorInfo& info : layout.tensors) {
+        if (layout.dataOffset > fileSize || info.offset > fileSize - layout.dataOffset ||
+            info.size > fileSize - layout.dataOffset - info.offset) {
+            error = "tensor '" + info.name + "' extends past end of file (truncated download?)";
+            return ParseResult::Malformed;
+        }
+        layout.tensorBytes += info.size;
+    }
+    return ParseResult::Ok;
+}
+
+} // namespace
+
+bool parseGgufLayout(const uint8_t* data, size_t fileSize, GgufLayout& layout, std::string& error) {
+    return parseImpl(data, fileSize, fileSize, layout, error) == ParseResult::Ok;
+}
+
+bool inspectGgufFile(const std::string& path, GgufLayout& layout, uint64_t& fileSize, std::string& error) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        error = "cannot open model file";
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    fileSize = (uint64_t) st.st_size;
+    if (fileSize == 0) {
+        close(fd);
+        error = "model file is empty";
+        return false;
+    }
+
+    // Vocabularies make the header anywhere from a few KB to several MB; grow the
+    // window until the tensor table fits
+    size_t window = (size_t) std::min<uint64_t>(fileSize, 1 << 20);
+    ParseResult result = ParseResult::NeedMore;
+    while (result == ParseResult::NeedMore) {
+        void* addr = mmap(nullptr, window, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            error = "mmap failed";
+            break;
+        }
+        result = parseImpl(static_cast<const uint8_t*>(addr), window, fileSize, layout, error);
+        munmap(addr, window);
+        window = (size_t) std::min<uint64_t>(fileSize, (uint64_t) window * 4);
+    }
+    close(fd);
+    return result == ParseResult::Ok;
+}
+
+std::string ggufQuantizationName(const GgufLayout& layout) {
+    // Names of llama_ftype values, indexed by general.file_type
+    static const char* const kFileTypes[] = {
+        "F32", "F16", "Q4_0", "Q4_1", nullptr, nullptr, nullptr, "Q8_0", "Q5_0", "Q5_1",
+        "Q2_K", "Q3_K_S", "Q3_K_M", "Q3_K_L", "Q4_K_S", "Q4_K_M", "Q5_K_S", "Q5_K_M", "Q6_K",
+        "IQ2_XXS", "IQ2_XS", "Q2_K_S", "IQ3_XS", "IQ3_XXS", "IQ1_S", "IQ4_NL", "IQ3_S", "IQ3_M",
+        "IQ2_S", "IQ2_M", "IQ4_XS", "IQ1_M", "BF16",
+    };
+    const int32_t fileType = layout.meta.fileType;
+    if (fileType >= 0 && fileType < (int32_t) (sizeof(kFileTypes) / sizeof(kFileTypes[0])) && kFileTypes[fileType]) {
+        return kFileTypes[fileType];
+    }
+
+    std::map<uint32_t, uint64_t> bytesByType;
+    for (const GgufTensorInfo& info : layout.tensors) {
+        bytesByType[info.type] += info.size;
+    }
+    auto dominant = std::max_element(bytesByType.begin(), bytesByType.end(),
+                                     [](const std::pair<const uint32_t, uint64_t>& a,
+                                        const std::pair<const uint32_t, uint64_t>& b) { return a.second < b.second; });
+    return dominant != bytesByType.end() ? ggml_type_name((enum ggml_type) dominant->first) : "unknown";
+}
+
+uint64_t ggufKvBytesPerToken(const GgufLayout& layout, uint32_t kvType) {
+    const GgufMetadata& meta = layout.meta;
+    if (meta.headCount == 0 || kvType >= GGML_TYPE_COUNT) {
+        return 0;
+    }
+    const uint64_t kvDim = meta.embeddingLength / meta.headCount * meta.headCountKv;
+    // K and V rows of kvDim elements per layer; quantized types are block-packed
+    return 2 * meta.blockCount * ggml_row_size((enum ggml_type) kvType, (int64_t) kvDim);
+}
+
+uint64_t ggufComputeBytes(const GgufLayout& layout, uint32_t nBatch) {
+    const GgufMetadata& meta = layout.meta;
+    return (uint64_t) nBatch * (4 * meta.embeddingLength + meta.vocabSize) * sizeof(float);
+}
+
+uint64_t ggufEstimateResidentBytes(const GgufLayout& layout, uint32_t nCtx, uint32_t nBatch, uint32_t kvType) {
+    return layout.tensorBytes + ggufKvBytesPerToken(layout, kvType) * nCtx + ggufComputeBytes(layout, nBatch);
+}
+
+std::string ggufInfoJson(const GgufLayout& layout, uint64_t fileSize, uint32_t nCtx, uint32_t nBatch) {
+    const GgufMetadata& meta = layout.meta;
+    std::ostringstream ss;
+    ss << "{\"valid\":true"
+       << ",\"ggufVersion\":" << layout.version
+       << ",\"architecture\":\"" << jsonEscape(meta.architecture) << "\""
+       << ",\"name\":\"" << jsonEscape(meta.name) << "\""
+       << ",\"quantization\":\"" << ggufQuantizationName(layout) << "\""
+       << ",\"contextLength\":" << meta.contextLength
+       << ",\"embeddingLength\":" << meta.embeddingLength
+       << ",\"blockCount\":" << meta.blockCount
+       << ",\"headCount\":" << meta.headCount
+       << ",\"headCountKv\":" << meta.headCountKv
+       << ",\"vocabSize\":" << meta.vocabSize
+       << ",\"tensorCount\":" << layout.tensorCount
+       << ",\"fileSize\":" << fileSize
+       << ",\"weightBytes\":" << layout.tensorBytes
+       << ",\"kvBytesPerToken\":" << ggufKvBytesPerToken(layout)
+       << ",\"kvBytesPerTokenQ8\":" << ggufKvBytesPerToken(layout, GGML_TYPE_Q8_0)
+       << ",\"kvBytesPerTokenQ4\":" << ggufKvBytesPerToken(layout, GGML_TYPE_Q4_0)
+       << ",\"nCtx\":" << nCtx
+       << ",\"estimatedResidentBytes\":" << ggufEstimateResidentBytes(layout, nCtx, nBatch)
+       << "}";
+    return ss.str();
+}
@@ -0,0 +1,72 @@
+#ifndef GGUF_READER_H
+#define GGUF_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// In-place reader for the GGUF container: header, KV metadata and tensor table.
+// Works directly on mapped bytes and never touches tensor data.
+
+struct GgufTensorInfo {
+    std::string name;
+    uint32_t type = 0;       // ggml_type
+    uint32_t nDims = 0;
+    int64_t ne[4] = {1, 1, 1, 1};
+    uint64_t offset = 0;     // relative to GgufLayout::dataOffset
+    uint64_t size = 0;       // bytes
+};
+
+// Hyperparameters picked out of the KV metadata; 0 / empty when absent
+struct GgufMetadata {
+    std::string architecture;     // general.architecture
+    std::string name;             // general.name
+    int32_t fileType = -1;        // general.file_type (llama_ftype)
+    uint64_t contextLength = 0;   // <arch>.context_length
+    uint64_t embeddingLength = 0; // <arch>.embedding_length
+    uint64_t blockCount = 0;      // <arch>.block_count
+    uint64_t headCount = 0;       // <arch>.attention.head_count
+    uint64_t headCountKv = 0;     // <arch>.attention.head_count_kv
+    uint64_t vocabSize = 0;       // length of tokenizer.ggml.tokens
+};
+
+struct GgufLayout {
+    uint32_t version = 0;
+    uint64_t tensorCount = 0;
+    uint64_t kvCount = 0;
+    uint32_t alignment = 32;
+    uint64_t dataOffset = 0;  // absolute file offset of the tensor data section
+    uint64_t tensorBytes = 0; // sum of all tensor sizes
+    GgufMetadata meta;
+    std::vector<GgufTensorInfo> tensors;
+};
+
+// Parses and bounds-checks the header and tensor table of a GGUF image of
+// `fileSize` bytes. Returns false and sets `error` when the file is malformed,
+// truncated, or a tensor points outside the file.
+bool parseGgufLayout(const uint8_t* data, size_t fileSize, GgufLayout& layout, std::string& error);
+
+// Same checks as parseGgufLayout, but maps only as much of the file head as the
+// header and tensor table need (starting at 1 MB), so a multi-GB model is
+// inspected without faulting in any weights.
+bool inspectGgufFile(const std::string& path, GgufLayout& layout, uint64_t& fileSize, std::string& error);
+
+// Quantization label: the general.file_type name, else the dominant tensor type
+std::string ggufQuantizationName(const GgufLayout& layout);
+
+// K+V cache bytes per context token with `kvType` (ggml_type, F16 by default)
+// cells, 0 when the hyperparameters are missing
+uint64_t ggufKvBytesPerToken(const GgufLayout& layout, uint32_t kvType = 1);
+
+// Activations and logits of an nBatch-token compute graph
+uint64_t ggufComputeBytes(const GgufLayout& layout, uint32_t nBatch);
+
+// Rough resident set for a context of nCtx tokens and an nBatch-token compute
+// graph: weights + KV cache + activations/logits
+uint64_t ggufEstimateResidentBytes(const GgufLayout& layout, uint32_t nCtx, uint32_t nBatch, uint32_t kvType = 1);
+
+// Inspection summary for the app: hyperparameters, quantization, sizes
+std::string ggufInfoJson(const GgufLayout& layout, uint64_t fileSize, uint32_t nCtx, uint32_t nBatch);
+
+#endif // GGUF_READER_H
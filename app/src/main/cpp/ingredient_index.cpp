@@ -0,0 +1,389 @@
+#include "ingredient_index.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "json_reader.h"
+#include "native_log.h"
+
+#define TAG "IngredientIndex"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+// "tomatoes" -> "tomato", "onions" -> "onion"; "glass" and short words stay
+std::string singular(const std::string& word) {
+    const size_t n = word.size();
+    if (n > 4 && word.compare(n - 3, 3, "oes") == 0) {
+        return word.substr(0, n - 2);
+    }
+    if (n > 3 && word[n - 1] == 's' && word[n - 2] != 's') {
+        return word.substr(0, n - 1);
+    }
+    return word;
+}
+
+std::vector<std::string> splitWords(const std::string& normalized) {
+    std::vector<std::string> words;
+    std::istringstream in(normalized);
+    std::string word;
+    while (in >> word) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Whether `needle` occurs as a contiguous run of words in `haystack`
+bool containsRun(const std::vector<std::string>& haystack, const std::vector<std::string>& needle) {
+    if (needle.empty() || needle.size() > haystack.size()) {
+        return false;
+    }
+    return std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end()) != haystack.end();
+}
+
+void setBit(uint64_t* bits, uint32_t id) {
+    bits[id >> 6] |= 1ull << (id & 63);
+}
+
+void clearBit(uint64_t* bits, uint32_t id) {
+    bits[id >> 6] &= ~(1ull << (id & 63));
+}
+
+} // namespace
+
+uint32_t countMissingBits(const uint64_t* need, const uint64_t* have, size_t words) {
+#if defined(__ARM_NEON)
+    uint16x8_t acc = vdupq_n_u16(0);
+    for (size_t i = 0; i < words; i += 2) {
+        const uint64x2_t missing = vbicq_u64(vld1q_u64(need + i), vld1q_u64(have + i));
+        acc = vpadalq_u8(acc, vcntq_u8(vreinterpretq_u8_u64(missing)));
+    }
+#if defined(__aarch64__)
+    return vaddvq_u16(acc);
+#else
+    const uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(acc));
+    return (uint32_t) (vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+#endif
+#else
+    // Compiles to the hardware popcount where the target has one
+    uint32_t count = 0;
+    for (size_t i = 0; i < words; i++) {
+        count += (uint32_t) __builtin_popcountll(need[i] & ~have[i]);
+    }
+    return count;
+#endif
+}
+
+IngredientIndex::IngredientIndex()
+    : m_words(0)
+    , m_built(false)
+    , m_version(0) {
+}
+
+void IngredientIndex::clear() {
+    *this = IngredientIndex();
+}
+
+std::string IngredientIndex::normalize(const std::string& name) {
+    std::string spaced;
+    spaced.reserve(name.size());
+    for (unsigned char c : name) {
+        spaced += std::isalnum(c) ? (char) std::tolower(c) : ' ';
+    }
+    std::string out;
+    for (const std::string& word : splitWords(spaced)) {
+        if (!out.empty()) {
+            out += ' ';
+        }
+        out += singular(word);
+    }
+    return out;
+}
+
+uint32_t IngredientIndex::intern(const std::string& normalized, const std::string& label) {
+    auto it = m_ids.find(normalized);
+    if (it != m_ids.end()) {
+        return it->second;
+    }
+    const uint32_t id = (uint32_t) m_names.size();
+    m_ids.emplace(normalized, id);
+    m_names.push_back(normalized);
+    m_labels.push_back(label);
+    m_nameWords.push_back(splitWords(normalized));
+    m_built = false;
+    return id;
+}
+
+void IngredientIndex::addVocabulary(const char* csv, size_t size) {
+    size_t pos = 0;
+    bool header = true;
+    while (pos < size) {
+        size_t end = pos;
+        while (end < size && csv[end] != '\n') {
+            end++;
+        }
+        size_t comma = pos;
+        while (comma < end && csv[comma] != ',') {
+            comma++;
+        }
+        if (!header) {
+            const std::string label(csv + pos, comma - pos);
+            const std::string name = normalize(label);
+            if (!name.empty()) {
+                intern(name, label);
+            }
+        }
+        header = false;
+        pos = end + 1;
+    }
+}
+
+int32_t IngredientIndex::addRecipe(const std::string& name, const std::vector<std::string>& ingredients) {
+    const std::string key = normalize(name);
+    auto it = m_rows.find(key);
+    if (it != m_rows.end()) {
+        return it->second;
+    }
+    if (m_recipeStart.empty()) {
+        m_recipeStart.push_back(0);
+    }
+
+    const size_t first = m_recipeIngredients.size();
+    for (const std::string& ingredient : ingredients) {
+        const std::string normalized = normalize(ingredient);
+        if (!normalized.empty()) {
+            m_recipeIngredients.push_back(intern(normalized, ingredient));
+        }
+    }
+    // A recipe needs each ingredient once, however often it is listed
+    std::sort(m_recipeIngredients.begin() + first, m_recipeIngredients.end());
+    m_recipeIngredients.erase(std::unique(m_recipeIngredients.begin() + first, m_recipeIngredients.end()),
+                              m_recipeIngredients.end());
+    m_recipeStart.push_back((uint32_t) m_recipeIngredients.size());
+
+    const int32_t row = (int32_t) m_recipeNames.size();
+    m_recipeNames.push_back(name);
+    m_rows.emplace(key, row);
+    m_built = false;
+    return row;
+}
+
+bool IngredientIndex::addRecipes(const char* json, size_t size, std::string& error) {
+    // Some bundled assets carry stray text before the document
+    size_t start = 0;
+    while (start < size && json[start] != '{' && json[start] != '[') {
+        start++;
+    }
+    JsonValue root;
+    if (!parseJson(json + start, size - start, root, error)) {
+        return false;
+    }
+    if (!root.isArray()) {
+        error = "not a recipe list";
+        return false;
+    }
+    std::vector<std::string> names;
+    for (const JsonValue& recipe : root.items) {
+        const std::string name = recipe.stringOr("name", "");
+        if (name.empty()) {
+            continue;
+        }
+        names.clear();
+        const JsonValue* ingredients = recipe.get("ingredients");
+        if (ingredients && ingredients->isArray()) {
+            for (const JsonValue& ingredient : ingredients->items) {
+                names.push_back(ingredient.stringOr("item", ""));
+            }
+        }
+        addRecipe(name, names);
+    }
+    return true;
+}
+
+void IngredientIndex::build() {
+    const size_t rows = m_recipeNames.size();
+    const size_t ids = m_names.size();
+    m_words = std::max<size_t>(2, ((ids + 63) / 64 + 1) & ~size_t(1));
+
+    m_need.assign(rows * m_words, 0);
+    std::vector<uint32_t> postingCount(ids + 1, 0);
+    for (size_t r = 0; r < rows; r++) {
+        for (uint32_t i = m_recipeStart[r]; i < m_recipeStart[r + 1]; i++) {
+            setBit(&m_need[r * m_words], m_recipeIngredients[i]);
+            postingCount[m_recipeIngredients[i] + 1]++;
+        }
+    }
+    m_postingStart.assign(ids + 1, 0);
+    for (size_t id = 0; id < ids; id++) {
+        m_postingStart[id + 1] = m_postingStart[id] + postingCount[id + 1];
+    }
+    m_postings.resize(m_recipeIngredients.size());
+    std::vector<uint32_t> fill(m_postingStart.begin(), m_postingStart.end() - 1);
+    for (size_t r = 0; r < rows; r++) {
+        for (uint32_t i = m_recipeStart[r]; i < m_recipeStart[r + 1]; i++) {
+            m_postings[fill[m_recipeIngredients[i]]++] = (uint32_t) r;
+        }
+    }
+
+    // Covers refer to ingredient IDs, which the vocabulary may have grown past
+    m_covers.clear();
+    m_built = true;
+    std::vector<std::string> items;
+    for (const auto& entry : m_inventory) {
+        items.insert(items.end(), entry.second, entry.first);
+    }
+    setInventory(items);
+    LOGi("Built: %zu ingredients, %zu recipes, %zu bytes of recipe bitsets", ids, rows, m_need.size() * sizeof(uint64_t));
+}
+
+int32_t IngredientIndex::findRecipe(const std::string& name) const {
+    auto it = m_rows.find(normalize(name));
+    return it != m_rows.end() ? it->second : -1;
+}
+
+const std::vector<uint32_t>& IngredientIndex::coverOf(const std::string& normalized) const {
+    auto it = m_covers.find(normalized);
+    if (it != m_covers.end()) {
+        return it->second;
+    }
+    std::vector<uint32_t> cover;
+    const std::vector<std::string> words = splitWords(normalized);
+    for (uint32_t id = 0; id < (uint32_t) m_names.size(); id++) {
+        if (containsRun(m_nameWords[id], words) || containsRun(words, m_nameWords[id])) {
+            cover.push_back(id);
+        }
+    }
+    return m_covers.emplace(normalized, std::move(cover)).first->second;
+}
+
+void IngredientIndex::setInventory(const std::vector<std::string>& items) {
+    m_inventory.clear();
+    for (const std::string& item : items) {
+        const std::string normalized = normalize(item);
+        if (!normalized.empty()) {
+            m_inventory[normalized]++;
+        }
+    }
+    if (!m_built) {
+        return;
+    }
+    m_haveCount.assign(m_names.size(), 0);
+    m_have.assign(m_words, 0);
+    for (const auto& entry : m_inventory) {
+        for (uint32_t id : coverOf(entry.first)) {
+            if (m_haveCount[id]++ == 0) {
+                setBit(m_have.data(), id);
+            }
+        }
+    }
+    rescan();
+    m_version++;
+}
+
+void IngredientIndex::rescan() {
+    const size_t rows = m_recipeNames.size();
+    m_missing.resize(rows);
+    for (size_t r = 0; r < rows; r++) {
+        m_missing[r] = (int32_t) countMissingBits(&m_need[r * m_words], m_have.data(), m_words);
+    }
+}
+
+size_t IngredientIndex::addItem(const std::string& normalized) {
+    if (m_inventory[normalized]++ > 0) {
+        return 0; // another copy of something already covered
+    }
+    size_t touched = 0;
+    for (uint32_t id : coverOf(normalized)) {
+        if (m_haveCount[id]++ > 0) {
+            continue;
+        }
+        setBit(m_have.data(), id);
+        for (uint32_t i = m_postingStart[id]; i < m_postingStart[id + 1]; i++) {
+            m_missing[m_postings[i]]--;
+        }
+        touched += m_postingStart[id + 1] - m_postingStart[id];
+    }
+    return touched;
+}
+
+size_t IngredientIndex::removeItem(const std::string& normalized) {
+    auto it = m_inventory.find(normalized);
+    if (it == m_inventory.end()) {
+        return 0;
+    }
+    if (--it->second > 0) {
+        return 0;
+    }
+    m_inventory.erase(it);
+    size_t touched = 0;
+    for (uint32_t id : coverOf(normalized)) {
+        if (--m_haveCount[id] > 0) {
+            continue;
+        }
+        clearBit(m_have.data(), id);
+        for (uint32_t i = m_postingStart[id]; i < m_postingStart[id + 1]; i++) {
+            m_missing[m_postings[i]]++;
+        }
+        touched += m_postingStart[id + 1] - m_postingStart[id];
+    }
+    return touched;
+}
+
+size_t IngredientIndex::updateInventory(const std::vector<std::string>& added, const std::vector<std::string>& removed) {
+    if (!m_built) {
+        for (const std::string& item : added) {
+            m_inventory[normalize(item)]++;
+        }
+        for (const std::string& item : removed) {
+            auto it = m_inventory.find(normalize(item));
+            if (it != m_inventory.end() && --it->second == 0) {
+                m_inventory.erase(it);
+            }
+        }
+        return 0;
+    }
+    size_t touched = 0;
+    for (const std::string& item : removed) {
+        touched += removeItem(normalize(item));
+    }
+    for (const std::string& item : added) {
+        const std::string normalized = normalize(item);
+        if (!normalized.empty()) {
+            touched += addItem(normalized);
+        }
+    }
+    if (touched > 0) {
+        m_version++;
+    }
+    return touched;
+}
+
+std::vector<std::string> IngredientIndex::missingIngredients(int32_t row) const {
+    std::vector<std::string> names;
+    for (uint32_t i = m_recipeStart[row]; i < m_recipeStart[row + 1]; i++) {
+        const uint32_t id = m_recipeIngredients[i];
+        if (!(m_have[id >> 6] & (1ull << (id & 63)))) {
+            names.push_back(m_labels[id]);
+        }
+    }
+    return names;
+}
+
+std::vector<int32_t> IngredientIndex::cookable(int32_t maxMissing, size_t limit) const {
+    std::vector<int32_t> rows;
+    for (int32_t r = 0; r < (int32_t) m_missing.size(); r++) {
+        if (m_missing[r] <= maxMissing) {
+            rows.push_back(r);
+        }
+    }
+    std::stable_sort(rows.begin(), rows.end(), [this](int32_t a, int32_t b) { return m_missing[a] < m_missing[b]; });
+    if (rows.size() > limit) {
+        rows.resize(limit);
+    }
+    return rows;
+}
@@ -0,0 +1,92 @@
+#ifndef INGREDIENT_INDEX_H
+#define INGREDIENT_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Recipe <-> inventory matching over interned ingredient IDs. Every ingredient
+// name (grocery list, recipe assets, app recipes) is normalized and mapped to a
+// dense ID; each recipe is a bitset of the IDs it needs and the inventory a
+// bitset of the IDs it satisfies. Missing counts for all recipes come from one
+// popcount(need & ~have) pass (NEON / scalar popcount).
+//
+// Inventory changes are applied incrementally: only the recipes that use an
+// ingredient whose availability flipped are touched, through an ingredient ->
+// recipe posting list, and version() moves so callers can reuse cached results.
+//
+// An inventory item satisfies an ingredient when the normalized words of one
+// appear as a contiguous run in the other ("onion" covers "red onion").
+class IngredientIndex {
+public:
+    IngredientIndex();
+
+    // Build phase: vocabulary and recipes, then build() before any query
+    void clear();
+    // Grocery list CSV ("item_name,category,unit"); the header row is skipped
+    void addVocabulary(const char* csv, size_t size);
+    // Recipe list asset: [{"name", "ingredients": [{"item"}, ...]}, ...]. Recipes
+    // whose name is already indexed are skipped.
+    bool addRecipes(const char* json, size_t size, std::string& error);
+    // Returns the recipe row, or the existing row for a name already indexed
+    int32_t addRecipe(const std::string& name, const std::vector<std::string>& ingredients);
+    void build();
+    bool isBuilt() const { return m_built; }
+
+    size_t recipeCount() const { return m_recipeNames.size(); }
+    size_t ingredientCount() const { return m_names.size(); }
+    int32_t findRecipe(const std::string& name) const;
+    const std::string& recipeName(int32_t row) const { return m_recipeNames[row]; }
+
+    // Replaces the whole inventory and rescans every recipe
+    void setInventory(const std::vector<std::string>& items);
+    // Applies a diff; returns how many recipe missing counts were adjusted
+    size_t updateInventory(const std::vector<std::string>& added, const std::vector<std::string>& removed);
+    uint64_t version() const { return m_version; }
+
+    int32_t missingCount(int32_t row) const { return m_missing[row]; }
+    const std::vector<int32_t>& missingCounts() const { return m_missing; }
+    // As first spelled when indexed
+    std::vector<std::string> missingIngredients(int32_t row) const;
+    // Rows missing at most `maxMissing` ingredients, fewest missing first
+    std::vector<int32_t> cookable(int32_t maxMissing, size_t limit) const;
+
+    static std::string normalize(const std::string& name);
+
+private:
+    size_t m_words;  // uint64 words per bitset, even for the two-word SIMD step
+    bool m_built;
+    uint64_t m_version;
+
+    std::vector<std::string> m_names;  // normalized, by ingredient ID
+    std::vector<std::string> m_labels; // first spelling seen, for display
+    std::vector<std::vector<std::string>> m_nameWords;
+    std::unordered_map<std::string, uint32_t> m_ids;
+
+    std::vector<std::string> m_recipeNames;
+    std::unordered_map<std::string, int32_t> m_rows;
+    std::vector<uint32_t> m_recipeStart;  // CSR over m_recipeIngredients, recipeCount + 1 entries
+    std::vector<uint32_t> m_recipeIngredients;
+    std::vector<uint64_t> m_need;         // [row][m_words]
+    std::vector<uint32_t> m_postingStart; // CSR: ingredient ID -> recipe rows
+    std::vector<uint32_t> m_postings;
+
+    std::vector<uint64_t> m_have;
+    std::vector<uint32_t> m_haveCount;   // inventory items covering each ingredient
+    std::unordered_map<std::string, uint32_t> m_inventory;  // normalized item -> copies
+    mutable std::unordered_map<std::string, std::vector<uint32_t>> m_covers;
+    std::vector<int32_t> m_missing;
+
+    uint32_t intern(const std::string& normalized, const std::string& label);
+    const std::vector<uint32_t>& coverOf(const std::string& normalized) const;
+    void rescan();
+    size_t addItem(const std::string& normalized);
+    size_t removeItem(const std::string& normalized);
+};
+
+// popcount(need & ~have) over `words` uint64 words (a multiple of 2)
+uint32_t countMissingBits(const uint64_t* need, const uint64_t* have, size_t words);
+
+#endif // INGREDIENT_INDEX_H
@@ -0,0 +1,189 @@
+#include <jni.h>
+#include <string>
+#include <android/asset_manager.h>
+#include <android/asset_manager_jni.h>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "ingredient_index.h"
+#include "jni_utf8.h"
+#include "native_log.h"
+#include "native_trace.h"
+
+#define LOG_TAG "IngredientIndexJNI"
+#define LOGI(...) nativeLog(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) nativeLog(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// One process-wide index; rebuilt when the recipe list changes
+static IngredientIndex ingredientIndex;
+static std::shared_mutex ingredientIndexMutex;
+
+static std::vector<std::string> toStrings(JNIEnv* env, jobjectArray values) {
+    std::vector<std::string> strings;
+    const jsize count = values ? env->GetArrayLength(values) : 0;
+    strings.reserve((size_t) count);
+    for (jsize i = 0; i < count; i++) {
+        jstring value = static_cast<jstring>(env->GetObjectArrayElement(values, i));
+        {
+            JniUtf8 text(env, value);
+            strings.push_back(text.str());
+        }
+        env->DeleteLocalRef(value);
+    }
+    return strings;
+}
+
+// Calls `consume(data, size)` with the asset's bytes; false if it cannot be read
+template <typename Consume>
+static bool readAsset(AAssetManager* manager, const std::string& name, Consume consume) {
+    AAsset* asset = manager ? AAssetManager_open(manager, name.c_str(), AASSET_MODE_BUFFER) : nullptr;
+    if (!asset) {
+        LOGE("Asset not found: %s", name.c_str());
+        return false;
+    }
+    const char* data = static_cast<const char*>(AAsset_getBuffer(asset));
+    if (data) {
+        consume(data, (size_t) AAsset_getLength(asset));
+    }
+    AAsset_close(asset);
+    return data != nullptr;
+}
+
+extern "C" {
+
+// App recipes come first so their rows are stable; returns the row of each one
+JNIEXPORT jintArray JNICALL
+Java_com_example_tastydiet_util_NativeIngredientIndex_buildIndex(JNIEnv *env, jobject thiz, jobject assetManager,
+                                                                 jstring vocabularyAsset, jobjectArray recipeAssets,
+                                                                 jobjectArray recipeNames, jintArray ingredientCounts,
+                                                                 jobjectArray ingredientNames) {
+    (void)thiz; // Suppress unused parameter warning
+    TRACE_SCOPE("buildIngredientIndex");
+    const std::vector<std::string> names = toStrings(env, recipeNames);
+    const std::vector<std::string> ingredients = toStrings(env, ingredientNames);
+    std::vector<jint> counts((size_t) env->GetArrayLength(ingredientCounts));
+    env->GetIntArrayRegion(ingredientCounts, 0, (jsize) counts.size(), counts.data());
+    if (counts.size() != names.size()) {
+        LOGE("Ingredient counts differ in length from the recipe names");
+        return nullptr;
+    }
+    const std::string vocabulary = JniUtf8(env, vocabularyAsset).str();
+    const std::vector<std::string> assets = toStrings(env, recipeAssets);
+    AAssetManager* manager = AAssetManager_fromJava(env, assetManager);
+
+    std::unique_lock<std::shared_mutex> lock(ingredientIndexMutex);
+    ingredientIndex.clear();
+    std::vector<jint> rows(names.size());
+    size_t next = 0;
+    std::vector<std::string> recipeIngredients;
+    for (size_t r = 0; r < names.size(); r++) {
+        if (counts[r] < 0 || next + (size_t) counts[r] > ingredients.size()) {
+            LOGE("Ingredient counts exceed the %zu names given", ingredients.size());
+            return nullptr;
+        }
+        recipeIngredients.assign(ingredients.begin() + next, ingredients.begin() + next + counts[r]);
+        next += (size_t) counts[r];
+        rows[r] = ingredientIndex.addRecipe(names[r], recipeIngredients);
+    }
+
+    readAsset(manager, vocabulary, [](const char* data, size_t size) {
+        ingredientIndex.addVocabulary(data, size);
+    });
+    for (const std::string& asset : assets) {
+        readAsset(manager, asset, [&asset](const char* data, size_t size) {
+            std::string error;
+            if (!ingredientIndex.addRecipes(data, size, error)) {
+                LOGE("Skipping %s: %s", asset.c_str(), error.c_str());
+            }
+        });
+    }
+    ingredientIndex.build();
+    LOGI("Ingredient index ready (%zu recipes, %zu ingredients)", ingredientIndex.recipeCount(), ingredientIndex.ingredientCount());
+
+    jintArray result = env->NewIntArray((jsize) rows.size());
+    if (result) {
+        env->SetIntArrayRegion(result, 0, (jsize) rows.size(), rows.data());
+    }
+    return result;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_example_tastydiet_util_NativeIngredientIndex_setInventory(JNIEnv *env, jobject thiz, jobjectArray items) {
+    (void)thiz; // Suppress unused parameter warning
+    const std::vector<std::string> names = toStrings(env, items);
+    std::unique_lock<std::shared_mutex> lock(ingredientIndexMutex);
+    ingredientIndex.setInventory(names);
+    return (jlong) ingredientIndex.version();
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_example_tastydiet_util_NativeIngredientIndex_updateInventory(JNIEnv *env, jobject thiz, jobjectArray added, jobjectArray removed) {
+    (void)thiz; // Suppress unused parameter warning
+    const std::vector<std::string> addedNames = toStrings(env, added);
+    const std::vector<std::string> removedNames = toStrings(env, removed);
+    std::unique_lock<std::shared_mutex> lock(ingredientIndexMutex);
+    ingredientIndex.updateInventory(addedNames, removedNames);
+    return (jlong) ingredientIndex.version();
+}
+
+// Missing ingredient count per requested row, -1 for rows outside the index
+JNIEXPORT jintArray JNICALL
+Java_com_example_tastydiet_util_NativeIngredientIndex_missingCounts(JNIEnv *env, jobject thiz, jintArray rows) {
+    (void)thiz; // Suppress unused parameter warning
+    std::vector<jint> values((size_t) env->GetArrayLength(rows));
+    env->GetIntArrayRegion(rows, 0, (jsize) values.size(), values.data());
+    {
+        std::shared_lock<std::shared_mutex> lock(ingredientIndexMutex);
+        const jint count = ingredientIndex.isBuilt() ? (jint) ingredientIndex.recipeCount() : 0;
+        for (jint& value : values) {
+            value = value >= 0 && value < count ? ingredientIndex.missingCount(value) : -1;
+        }
+    }
+    jintArray result = env->NewIntArray((jsize) values.size());
+    if (result) {
+        env->SetIntArrayRegion(result, 0, (jsize) values.size(), values.data());
+    }
+    return result;
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_tastydiet_util_NativeIngredientIndex_missingIngredients(JNIEnv *env, jobject thiz, jint row) {
+    (void)thiz; // Suppress unused parameter warning
+    std::vector<std::string> names;
+    {
+        std::shared_lock<std::shared_mutex> lock(ingredientIndexMutex);
+        if (ingredientIndex.isBuilt() && row >= 0 && row < (jint) ingredientIndex.recipeCount()) {
+            names = ingredientIndex.missingIngredients(row);
+        }
+    }
+    std::vector<const char*> pointers;
+    for (const std::string& name : names) {
+        pointers.push_back(name.c_str());
+    }
+    return newJniStringArray(env, pointers);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_example_tastydiet_util_NativeIngredientIndex_findRecipe(JNIEnv *env, jobject thiz, jstring name) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 key(env, name);
+    std::shared_lock<std::shared_mutex> lock(ingredientIndexMutex);
+    return ingredientIndex.isBuilt() ? ingredientIndex.findRecipe(key) : -1;
+}
+
+// Names of the recipes missing at most `maxMissing` ingredients, fewest first
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_tastydiet_util_NativeIngredientIndex_cookableRecipes(JNIEnv *env, jobject thiz, jint maxMissing, jint limit) {
+    (void)thiz; // Suppress unused parameter warning
+    std::shared_lock<std::shared_mutex> lock(ingredientIndexMutex);
+    std::vector<const char*> names;
+    if (ingredientIndex.isBuilt() && limit > 0) {
+        for (int32_t row : ingredientIndex.cookable(maxMissing, (size_t) limit)) {
+            names.push_back(ingredientIndex.recipeName(row).c_str());
+        }
+    }
+    return newJniStringArray(env, names);
+}
+
+}
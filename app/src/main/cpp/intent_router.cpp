@@ -0,0 +1,262 @@
+#include "intent_router.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include "native_log.h"
+
+#define TAG "IntentRouter"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+// A verbatim command phrase outweighs any handful of shared words
+constexpr float kPhraseWeight = 4.0f;
+
+const std::unordered_set<std::string> kStopWords = {
+    "a", "an", "the", "i", "me", "my", "is", "are", "to", "for", "of", "in", "on",
+    "please", "can", "you", "it", "do", "be", "this", "that", "and", "or",
+};
+
+// Lowercased words of `text`; anything but ASCII letters and digits separates words
+std::vector<std::string> words(const std::string& text) {
+    std::vector<std::string> result;
+    std::string current;
+    for (unsigned char c : text) {
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            current += (char) c;
+        } else if (c >= 'A' && c <= 'Z') {
+            current += (char) (c - 'A' + 'a');
+        } else if (!current.empty()) {
+            result.push_back(std::move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        result.push_back(std::move(current));
+    }
+    return result;
+}
+
+// Pattern text as the automaton sees it: words framed by single spaces, so
+// every match lands on word boundaries
+std::string framed(const std::vector<std::string>& tokens) {
+    std::string result = " ";
+    for (const std::string& token : tokens) {
+        result += token;
+        result += ' ';
+    }
+    return result;
+}
+
+bool isNumber(const std::string& word) {
+    return std::all_of(word.begin(), word.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+} // namespace
+
+int IntentRouter::symbol(unsigned char c) {
+    if (c >= 'a' && c <= 'z') return 1 + (c - 'a');
+    if (c >= 'A' && c <= 'Z') return 1 + (c - 'A');
+    if (c >= '0' && c <= '9') return 27 + (c - '0');
+    return 0;
+}
+
+int32_t IntentRouter::insert(const std::string& normalized) {
+    int32_t state = 0;
+    for (unsigned char c : normalized) {
+        const int s = symbol(c);
+        if (m_states[state].next[s] < 0) {
+            m_states[state].next[s] = (int32_t) m_states.size();
+            State fresh;
+            fresh.next.fill(-1);
+            m_states.push_back(fresh);
+        }
+        state = m_states[state].next[s];
+    }
+    return state;
+}
+
+// Classic BFS: fail links, dictionary links, and the goto table completed into
+// a DFA so matching never walks fail chains
+void IntentRouter::link() {
+    std::deque<int32_t> queue;
+    for (int s = 0; s < kAlphabet; s++) {
+        int32_t& child = m_states[0].next[s];
+        if (child < 0) {
+            child = 0;
+        } else {
+            m_states[child].fail = 0;
+            queue.push_back(child);
+        }
+    }
+    while (!queue.empty()) {
+        const int32_t state = queue.front();
+        queue.pop_front();
+        const int32_t fail = m_states[state].fail;
+        m_states[state].dictLink = m_states[fail].pattern >= 0 ? fail : m_states[fail].dictLink;
+        for (int s = 0; s < kAlphabet; s++) {
+            const int32_t child = m_states[state].next[s];
+            if (child < 0) {
+                m_states[state].next[s] = m_states[fail].next[s];
+            } else {
+                m_states[child].fail = m_states[fail].next[s];
+                queue.push_back(child);
+            }
+        }
+    }
+}
+
+bool IntentRouter::build(const char* csv, size_t size) {
+    m_actions.clear();
+    m_states.clear();
+    m_patterns.clear();
+    m_votes.clear();
+
+    std::map<std::string, uint16_t> actionIds;
+    std::vector<std::pair<std::vector<std::string>, uint16_t>> rows;
+
+    size_t lineStart = 0;
+    while (lineStart < size) {
+        size_t lineEnd = lineStart;
+        while (lineEnd < size && csv[lineEnd] != '\n') {
+            lineEnd++;
+        }
+        std::string line(csv + lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        const size_t comma = line.rfind(',');
+        if (comma == std::string::npos) {
+            continue;
+        }
+        const std::string action = line.substr(comma + 1);
+        std::vector<std::string> tokens = words(line.substr(0, comma));
+        if (action.empty() || action == "ActionType" || tokens.empty()) {
+            continue;
+        }
+        auto it = actionIds.find(action);
+        if (it == actionIds.end()) {
+            it = actionIds.emplace(action, (uint16_t) m_actions.size()).first;
+            m_actions.push_back(action);
+        }
+        rows.emplace_back(std::move(tokens), it->second);
+    }
+    if (rows.empty()) {
+        LOGe("No commands in intent table");
+        return false;
+    }
+
+    // Per-word action histogram and document frequency
+    std::unordered_map<std::string, std::vector<uint32_t>> wordActions;
+    std::unordered_map<std::string, uint32_t> wordRows;
+    for (const auto& row : rows) {
+        std::unordered_set<std::string> seen;
+        for (const std::string& word : row.first) {
+            if (kStopWords.count(word) || isNumber(word)) {
+                continue;
+            }
+            auto& histogram = wordActions[word];
+            histogram.resize(m_actions.size());
+            histogram[row.second]++;
+            if (seen.insert(word).second) {
+                wordRows[word]++;
+            }
+        }
+    }
+
+    // Pattern text -> per-action weight; a one-word phrase and that word share a pattern
+    std::map<std::string, std::map<uint16_t, float>> patternVotes;
+    for (const auto& entry : wordActions) {
+        uint32_t total = 0;
+        for (uint32_t count : entry.second) {
+            total += count;
+        }
+        const float idf = std::log(1.0f + (float) rows.size() / (float) wordRows[entry.first]);
+        auto& votes = patternVotes[framed({entry.first})];
+        for (size_t action = 0; action < entry.second.size(); action++) {
+            if (entry.second[action]) {
+                votes[(uint16_t) action] += idf * (float) entry.second[action] / (float) total;
+            }
+        }
+    }
+    for (const auto& row : rows) {
+        patternVotes[framed(row.first)][row.second] += kPhraseWeight;
+    }
+
+    State root;
+    root.next.fill(-1);
+    m_states.push_back(root);
+    for (const auto& entry : patternVotes) {
+        const int32_t state = insert(entry.first);
+        Pattern pattern;
+        pattern.voteStart = (uint32_t) m_votes.size();
+        for (const auto& vote : entry.second) {
+            m_votes.push_back(Vote{vote.first, vote.second});
+        }
+        pattern.voteCount = (uint32_t) m_votes.size() - pattern.voteStart;
+        m_states[state].pattern = (int32_t) m_patterns.size();
+        m_patterns.push_back(pattern);
+    }
+    link();
+
+    LOGi("Intent table compiled: %zu commands, %zu actions, %zu patterns, %zu states",
+         rows.size(), m_actions.size(), m_patterns.size(), m_states.size());
+    return true;
+}
+
+std::vector<IntentScore> IntentRouter::classify(const std::string& text) const {
+    std::vector<IntentScore> ranked;
+    if (m_states.empty()) {
+        return ranked;
+    }
+
+    std::vector<float> scores(m_actions.size(), 0.0f);
+    auto collect = [&](int32_t state) {
+        for (int32_t s = m_states[state].pattern >= 0 ? state : m_states[state].dictLink; s >= 0;
+             s = m_states[s].dictLink) {
+            const Pattern& pattern = m_patterns[m_states[s].pattern];
+            for (uint32_t v = 0; v < pattern.voteCount; v++) {
+                const Vote& vote = m_votes[pattern.voteStart + v];
+                scores[vote.action] += vote.weight;
+            }
+        }
+    };
+
+    // Lowercasing and separator folding happen on the fly: runs of separators
+    // collapse into the single space the patterns were framed with
+    int32_t state = m_states[0].next[0];
+    bool lastWasSpace = true;
+    for (unsigned char c : text) {
+        const int s = symbol(c);
+        if (s == 0 && lastWasSpace) {
+            continue;
+        }
+        lastWasSpace = s == 0;
+        state = m_states[state].next[s];
+        collect(state);
+    }
+    if (!lastWasSpace) {
+        state = m_states[state].next[0];
+        collect(state);
+    }
+
+    float total = 0.0f;
+    for (size_t action = 0; action < scores.size(); action++) {
+        if (scores[action] > 0.0f) {
+            total += scores[action];
+            ranked.push_back(IntentScore{m_actions[action], scores[action], 0.0f});
+        }
+    }
+    for (IntentScore& intent : ranked) {
+        intent.confidence = intent.score / total;
+    }
+    std::sort(ranked.begin(), ranked.end(),
+              [](const IntentScore& a, const IntentScore& b) { return a.score > b.score; });
+    return ranked;
+}
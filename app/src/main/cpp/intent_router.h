@@ -0,0 +1,65 @@
+#ifndef INTENT_ROUTER_H
+#define INTENT_ROUTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct IntentScore {
+    std::string action;
+    float score = 0.0f;
+    float confidence = 0.0f;  // share of the total score, 0..1
+};
+
+// Keyword intent classifier compiled from the offline voice command table
+// (CSV rows "phrase,ActionType"). Whole command phrases and their content words
+// become patterns of one Aho-Corasick automaton, so a message is lowercased,
+// tokenized and matched against every pattern in a single pass with no copies.
+//
+// Weights: a word votes for each action by P(action | word) * idf(word); a full
+// command phrase found verbatim adds a strong vote for its action.
+class IntentRouter {
+public:
+    // Builds from the CSV text; the header row and malformed rows are skipped
+    bool build(const char* csv, size_t size);
+    bool isReady() const { return !m_states.empty(); }
+
+    // Ranked actions with score > 0, best first
+    std::vector<IntentScore> classify(const std::string& text) const;
+
+    size_t patternCount() const { return m_patterns.size(); }
+
+private:
+    // Normalized alphabet: space, a-z, 0-9
+    static constexpr int kAlphabet = 37;
+
+    struct State {
+        std::array<int32_t, kAlphabet> next;
+        int32_t fail = 0;
+        int32_t pattern = -1;   // pattern ending exactly here
+        int32_t dictLink = -1;  // nearest state on the fail chain that ends a pattern
+    };
+
+    struct Vote {
+        uint16_t action;
+        float weight;
+    };
+
+    struct Pattern {
+        uint32_t voteStart = 0;
+        uint32_t voteCount = 0;
+    };
+
+    std::vector<std::string> m_actions;
+    std::vector<State> m_states;
+    std::vector<Pattern> m_patterns;
+    std::vector<Vote> m_votes;
+
+    static int symbol(unsigned char c);
+    int32_t insert(const std::string& normalized);
+    void link();
+};
+
+#endif // INTENT_ROUTER_H
@@ -0,0 +1,177 @@
+#include "jni_utf8.h"
+
+namespace {
+
+constexpr uint16_t kReplacement = 0xFFFD;
+
+// Scratch buffers of the calling thread. Argument slots are handed out as a
+// stack; a slot grown past kMaxRetained is trimmed again on release so one huge
+// prompt does not pin memory for the life of the thread.
+constexpr size_t kArgumentSlots = 8;
+constexpr size_t kMaxRetained = 64 * 1024;
+
+struct ThreadScratch {
+    std::string arguments[kArgumentSlots];
+    size_t used = 0;
+    std::vector<uint16_t> utf16;
+};
+
+thread_local ThreadScratch t_scratch;
+
+void appendCodePoint(uint32_t cp, std::string& out) {
+    if (cp < 0x80) {
+        out += (char) cp;
+    } else if (cp < 0x800) {
+        out += (char) (0xC0 | (cp >> 6));
+        out += (char) (0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char) (0xE0 | (cp >> 12));
+        out += (char) (0x80 | ((cp >> 6) & 0x3F));
+        out += (char) (0x80 | (cp & 0x3F));
+    } else {
+        out += (char) (0xF0 | (cp >> 18));
+        out += (char) (0x80 | ((cp >> 12) & 0x3F));
+        out += (char) (0x80 | ((cp >> 6) & 0x3F));
+        out += (char) (0x80 | (cp & 0x3F));
+    }
+}
+
+} // namespace
+
+void utf16ToUtf8(const uint16_t* text, size_t length, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < length; i++) {
+        uint32_t cp = text[i];
+        if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < length && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (text[++i] - 0xDC00);
+        } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+            cp = kReplacement;
+        }
+        appendCodePoint(cp, out);
+    }
+}
+
+size_t utf8ToUtf16(const char* text, size_t length, uint16_t* out) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(text);
+    size_t n = 0;
+    size_t i = 0;
+    while (i < length) {
+        const unsigned char c = s[i];
+        if (c < 0x80) {
+            out[n++] = c;
+            i++;
+            continue;
+        }
+        size_t need = 0;
+        uint32_t cp = 0;
+        uint32_t min = 0;
+        if ((c & 0xE0) == 0xC0) {
+            need = 1; cp = c & 0x1F; min = 0x80;
+        } else if ((c & 0xF0) == 0xE0) {
+            need = 2; cp = c & 0x0F; min = 0x800;
+        } else if ((c & 0xF8) == 0xF0) {
+            need = 3; cp = c & 0x07; min = 0x10000;
+        }
+        bool valid = need > 0;
+        for (size_t k = 1; valid && k <= need; k++) {
+            if (i + k >= length || (s[i + k] & 0xC0) != 0x80) {
+                valid = false;
+            } else {
+                cp = (cp << 6) | (s[i + k] & 0x3F);
+            }
+        }
+        // Overlong forms, UTF-16 surrogates and values past U+10FFFF are not UTF-8
+        if (!valid || cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            out[n++] = kReplacement;
+            i++;
+            continue;
+        }
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            out[n++] = (uint16_t) (0xD800 + (cp >> 10));
+            out[n++] = (uint16_t) (0xDC00 + (cp & 0x3FF));
+        } else {
+            out[n++] = (uint16_t) cp;
+        }
+        i += need + 1;
+    }
+    return n;
+}
+
+void JniUtf8::acquire() {
+    m_pooled = t_scratch.used < kArgumentSlots;
+    m_buffer = m_pooled ? &t_scratch.arguments[t_scratch.used++] : new std::string();
+}
+
+JniUtf8::JniUtf8(JNIEnv* env, jstring value) {
+    acquire();
+    if (!value) {
+        m_buffer->clear();
+        return;
+    }
+    const jsize length = env->GetStringLength(value);
+    // No JNI calls until the release: the encoder reads the characters in place
+    const jchar* chars = env->GetStringCritical(value, nullptr);
+    if (!chars) {
+        m_buffer->clear();
+        return;
+    }
+    utf16ToUtf8(reinterpret_cast<const uint16_t*>(chars), (size_t) length, *m_buffer);
+    env->ReleaseStringCritical(value, chars);
+}
+
+JniUtf8::JniUtf8(JNIEnv* env, jbyteArray value) {
+    acquire();
+    const jsize length = value ? env->GetArrayLength(value) : 0;
+    m_buffer->resize((size_t) length);
+    if (length > 0) {
+        env->GetByteArrayRegion(value, 0, length, reinterpret_cast<jbyte*>(&(*m_buffer)[0]));
+    }
+}
+
+JniUtf8::~JniUtf8() {
+    if (!m_pooled) {
+        delete m_buffer;
+        return;
+    }
+    if (m_buffer->capacity() > kMaxRetained) {
+        std::string().swap(*m_buffer);
+    }
+    t_scratch.used--;
+}
+
+jstring newJniString(JNIEnv* env, const char* utf8, size_t length) {
+    std::vector<uint16_t>& utf16 = t_scratch.utf16;
+    if (utf16.size() < length) {
+        utf16.resize(length);
+    }
+    const size_t units = utf8ToUtf16(utf8, length, utf16.data());
+    jstring result = env->NewString(reinterpret_cast<const jchar*>(utf16.data()), (jsize) units);
+    if (utf16.size() > kMaxRetained) {
+        std::vector<uint16_t>().swap(utf16);
+    }
+    return result;
+}
+
+jbyteArray newJniBytes(JNIEnv* env, const std::string& utf8) {
+    jbyteArray array = env->NewByteArray((jsize) utf8.size());
+    if (array) {
+        env->SetByteArrayRegion(array, 0, (jsize) utf8.size(), reinterpret_cast<const jbyte*>(utf8.data()));
+    }
+    return array;
+}
+
+jobjectArray newJniStringArray(JNIEnv* env, const std::vector<const char*>& values) {
+    static jclass stringClass = static_cast<jclass>(env->NewGlobalRef(env->FindClass("java/lang/String")));
+    jobjectArray array = env->NewObjectArray((jsize) values.size(), stringClass, nullptr);
+    if (!array) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < values.size(); i++) {
+        const char* value = values[i] ? values[i] : "";
+        jstring element = newJniString(env, value, std::char_traits<char>::length(value));
+        env->SetObjectArrayElement(array, (jsize) i, element);
+        env->DeleteLocalRef(element);
+    }
+    return array;
+}
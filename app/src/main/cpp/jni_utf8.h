@@ -0,0 +1,54 @@
+#ifndef JNI_UTF8_H
+#define JNI_UTF8_H
+
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Standard UTF-8 across the JNI boundary. GetStringUTFChars/NewStringUTF speak
+// modified UTF-8 (surrogate pairs as two 3-byte sequences, so emoji arrive
+// mangled and llama.cpp's output can abort NewStringUTF) and copy on every call.
+// Everything here converts straight between UTF-16 and UTF-8 into per-thread
+// scratch buffers that keep their capacity, so after warm-up a call allocates
+// nothing natively.
+
+// Encodes UTF-16 as UTF-8 into `out` (replaced); unpaired surrogates become U+FFFD
+void utf16ToUtf8(const uint16_t* text, size_t length, std::string& out);
+
+// Decodes UTF-8 into `out`, which needs room for `length` units; malformed
+// sequences become U+FFFD. Returns the number of UTF-16 units written.
+size_t utf8ToUtf16(const char* text, size_t length, uint16_t* out);
+
+// Borrowed UTF-8 view of a Java String or byte[] argument. Slots come from a
+// small per-thread pool and must be released in reverse order, which scoped
+// locals guarantee.
+class JniUtf8 {
+public:
+    JniUtf8(JNIEnv* env, jstring value);
+    JniUtf8(JNIEnv* env, jbyteArray value);
+    ~JniUtf8();
+    JniUtf8(const JniUtf8&) = delete;
+    JniUtf8& operator=(const JniUtf8&) = delete;
+
+    const std::string& str() const { return *m_buffer; }
+    const char* c_str() const { return m_buffer->c_str(); }
+    operator const std::string&() const { return *m_buffer; }
+
+private:
+    std::string* m_buffer;
+    bool m_pooled;
+
+    void acquire();
+};
+
+// New Java String / byte[] from UTF-8; nullptr with a pending exception on OOM
+jstring newJniString(JNIEnv* env, const char* utf8, size_t length);
+inline jstring newJniString(JNIEnv* env, const std::string& utf8) {
+    return newJniString(env, utf8.data(), utf8.size());
+}
+jbyteArray newJniBytes(JNIEnv* env, const std::string& utf8);
+jobjectArray newJniStringArray(JNIEnv* env, const std::vector<const char*>& values);
+
+#endif // JNI_UTF8_H
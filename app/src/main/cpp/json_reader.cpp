@@ -0,0 +1,260 @@
+#include "json_reader.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr int kMaxDepth = 64;
+
+class Parser {
+public:
+    Parser(const char* data, size_t size) : m_data(data), m_size(size), m_pos(0) {}
+
+    bool parseDocument(JsonValue& out, std::string& error) {
+        const bool ok = parseValue(out, 0) && (skipSpace(), m_pos == m_size);
+        if (!ok) {
+            error = (m_error.empty() ? "unexpected trailing data" : m_error) + " at offset " + std::to_string(m_pos);
+        }
+        return ok;
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    size_t m_pos;
+    std::string m_error;
+
+    bool fail(const char* message) {
+        if (m_error.empty()) {
+            m_error = message;
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (m_pos < m_size && (m_data[m_pos] == ' ' || m_data[m_pos] == '\n' ||
+                                  m_data[m_pos] == '\r' || m_data[m_pos] == '\t')) {
+            m_pos++;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (m_pos < m_size && m_data[m_pos] == c) {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool literal(const char* word) {
+        const size_t len = std::strlen(word);
+        if (m_size - m_pos >= len && std::memcmp(m_data + m_pos, word, len) == 0) {
+            m_pos += len;
+            return true;
+        }
+        return fail("invalid literal");
+    }
+
+    bool parseValue(JsonValue& out, int depth) {
+        if (depth > kMaxDepth) {
+            return fail("nesting too deep");
+        }
+        skipSpace();
+        if (m_pos >= m_size) {
+            return fail("unexpected end of input");
+        }
+        switch (m_data[m_pos]) {
+            case '{': return parseObject(out, depth);
+            case '[': return parseArray(out, depth);
+            case '"': out.type = JsonValue::Type::String; return parseString(out.string);
+            case 't': out.type = JsonValue::Type::Bool; out.boolean = true; return literal("true");
+            case 'f': out.type = JsonValue::Type::Bool; out.boolean = false; return literal("false");
+            case 'n': out.type = JsonValue::Type::Null; return literal("null");
+            default: return parseNumber(out);
+        }
+    }
+
+    bool parseObject(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::Object;
+        m_pos++; // '{'
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            skipSpace();
+            std::string key;
+            if (m_pos >= m_size || m_data[m_pos] != '"' || !parseString(key)) {
+                return fail("expected object key");
+            }
+            if (!consume(':')) {
+                return fail("expected ':'");
+            }
+            out.members.emplace_back(std::move(key), JsonValue());
+            if (!parseValue(out.members.back().second, depth + 1)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}') || fail("expected '}'");
+    }
+
+    bool parseArray(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::Array;
+        m_pos++; // '['
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            out.items.emplace_back();
+            if (!parseValue(out.items.back(), depth + 1)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']') || fail("expected ']'");
+    }
+
+    bool parseNumber(JsonValue& out) {
+        const size_t start = m_pos;
+        while (m_pos < m_size && std::strchr("+-0123456789.eE", m_data[m_pos]) && m_data[m_pos] != '\0') {
+            m_pos++;
+        }
+        if (m_pos == start) {
+            return fail("unexpected character");
+        }
+        const std::string text(m_data + start, m_pos - start);
+        char* end = nullptr;
+        out.type = JsonValue::Type::Number;
+        out.number = std::strtod(text.c_str(), &end);
+        return (end && *end == '\0') || fail("invalid number");
+    }
+
+    bool parseHex4(uint32_t& value) {
+        if (m_size - m_pos < 4) {
+            return fail("truncated \\u escape");
+        }
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            const char c = m_data[m_pos++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= (uint32_t) (c - '0');
+            else if (c >= 'a' && c <= 'f') value |= (uint32_t) (c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') value |= (uint32_t) (c - 'A' + 10);
+            else return fail("invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += (char) cp;
+        } else if (cp < 0x800) {
+            out += (char) (0xC0 | (cp >> 6));
+            out += (char) (0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += (char) (0xE0 | (cp >> 12));
+            out += (char) (0x80 | ((cp >> 6) & 0x3F));
+            out += (char) (0x80 | (cp & 0x3F));
+        } else {
+            out += (char) (0xF0 | (cp >> 18));
+            out += (char) (0x80 | ((cp >> 12) & 0x3F));
+            out += (char) (0x80 | ((cp >> 6) & 0x3F));
+            out += (char) (0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        m_pos++; // opening quote
+        while (m_pos < m_size) {
+            const char c = m_data[m_pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (m_pos >= m_size) {
+                break;
+            }
+            const char escape = m_data[m_pos++];
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t cp = 0;
+                    if (!parseHex4(cp)) {
+                        return false;
+                    }
+                    // Surrogate pair
+                    if (cp >= 0xD800 && cp <= 0xDBFF && m_size - m_pos >= 6 &&
+                        m_data[m_pos] == '\\' && m_data[m_pos + 1] == 'u') {
+                        m_pos += 2;
+                        uint32_t low = 0;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+};
+
+} // namespace
+
+const JsonValue* JsonValue::get(const std::string& key) const {
+    for (const auto& member : members) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+double JsonValue::numberOr(const std::string& key, double fallback) const {
+    const JsonValue* value = get(key);
+    return value && value->type == Type::Number ? value->number : fallback;
+}
+
+bool JsonValue::boolOr(const std::string& key, bool fallback) const {
+    const JsonValue* value = get(key);
+    return value && value->type == Type::Bool ? value->boolean : fallback;
+}
+
+std::string JsonValue::stringOr(const std::string& key, const std::string& fallback) const {
+    const JsonValue* value = get(key);
+    return value && value->type == Type::String ? value->string : fallback;
+}
+
+bool parseJson(const char* data, size_t size, JsonValue& out, std::string& error) {
+    out = JsonValue();
+    Parser parser(data, size);
+    return parser.parseDocument(out, error);
+}
+
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char) c >= 0x20) {
+            out += c;
+        }
+    }
+    return out;
+}
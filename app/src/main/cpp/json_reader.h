@@ -0,0 +1,40 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON DOM for compiling the bundled asset files (food database,
+// recipes) into native indexes. Not meant for hot paths.
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> items;                              // Array
+    std::vector<std::pair<std::string, JsonValue>> members;    // Object, in file order
+
+    bool isArray() const { return type == Type::Array; }
+    bool isObject() const { return type == Type::Object; }
+
+    // Member lookup; nullptr when this is not an object or the key is absent
+    const JsonValue* get(const std::string& key) const;
+
+    double numberOr(const std::string& key, double fallback) const;
+    bool boolOr(const std::string& key, bool fallback) const;
+    std::string stringOr(const std::string& key, const std::string& fallback) const;
+};
+
+// Parses a complete JSON document. Returns false and sets `error` (with the
+// byte offset) on malformed input.
+bool parseJson(const char* data, size_t size, JsonValue& out, std::string& error);
+
+// Escapes quotes and backslashes and drops control characters, for writing
+// strings from files (model metadata, food names) into JSON output
+std::string jsonEscape(const std::string& s);
+
+#endif // JSON_READER_H
@@ -1,268 +1,729 @@
 #include <jni.h>
 #include <string>
-#include <android/log.h>
+#include <android/asset_manager.h>
+#include <android/asset_manager_jni.h>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <sstream>
+
+#include "llama_wrapper.h"
+#include "llama_server.h"
+#include "gguf_reader.h"
+#include "intent_router.h"
+#include "semantic_index.h"
+#include "response_cache.h"
+#include "food_index.h"
+#include "json_reader.h"
+#include "structured_output.h"
+#include "jni_utf8.h"
+#include "request_metrics.h"
+#include "native_log.h"
+#include "native_trace.h"
 
 #define LOG_TAG "LlamaJNI"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) nativeLog(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) nativeLog(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+// User text (prompts, responses) only at LOG_VERBOSITY_VERBOSE
+#define LOGV(...) do { if (nativeLogVerbose()) LOGI(__VA_ARGS__); } while (0)
 
-// Working llama.cpp integration (simplified for testing)
+// Concurrent sessions (chat, meal suggestions, voice, ...) sharing one model
+static constexpr int32_t kMaxSessions = 4;
+
+// Load-and-warm pipeline states (LlamaManager.INIT_* in Kotlin)
+enum InitState {
+    INIT_IDLE = 0,
+    INIT_LOADING = 1,
+    INIT_READY = 2,
+    INIT_FAILED = 3,
+};
+
+// Pipeline progress at the end of each phase; llama.cpp's own load progress
+// fills the first one
+static constexpr float kInitLoaded = 0.6f;
+static constexpr float kInitContextReady = 0.7f;
+static constexpr float kInitWeightsResident = 0.8f;
+static constexpr float kInitWarm = 0.9f;
+
+// JNI-facing manager: one shared model, one context with a sequence slot per
+// session, and a LlamaServer batching the decode work of all sessions.
+// Lifecycle calls take the lock exclusively; requests share it.
 class LlamaManager {
 private:
-    bool isInitialized = false;
-    std::string modelPath;
-    
-public:
-    bool initModel(const std::string& path) {
+    LlamaWrapper wrapper;
+    LlamaServer server{wrapper};
+    int32_t defaultSession = -1;  // shared by the single-session entry points, which queue on it
+    mutable std::shared_mutex lifecycleMutex;
+
+    // Background load started by initModel. State and progress are atomics so
+    // polling never waits for the pipeline, which holds lifecycleMutex exclusively.
+    std::thread initThread;
+    std::atomic<int> initState{INIT_IDLE};
+    std::atomic<float> initProgress{0.0f};
+    std::atomic<bool> initCancelled{false};
+    std::mutex initMutex;
+    std::condition_variable initCv;
+
+    // Independent of the model: routing works before (and without) initModel
+    IntentRouter intentRouter;
+    mutable std::shared_mutex intentMutex;
+
+    // Embedding index over foods and recipes; needs the model for queries
+    SemanticIndex semanticIndex;
+    mutable std::shared_mutex semanticMutex;
+
+    // Finished responses, persisted in the state directory (see responseCacheIdentity)
+    ResponseCache responseCache;
+    // Stable hash of the system prompt pinned in the prefix; responses depend on it too
+    std::atomic<uint64_t> systemPromptHash{0};
+
+    // Per-request timings for getRequestMetrics; written without locks
+    MetricsRing requestMetrics;
+
+    // GBNF for food logging over the food index names (see loadFoodLogGrammar)
+    std::string foodLogGrammar;
+    mutable std::shared_mutex grammarMutex;
+
+    // Everything besides the prompt that decides a response
+    std::string responseCacheIdentity(int maxTokens) const {
+        const GenerationParams params = wrapper.getGenerationParams();
+        std::ostringstream ss;
+        ss << wrapper.modelPath() << '|' << wrapper.getModelSize() << '|' << params.temperature << '|'
+           << params.topK << '|' << params.topP << '|' << params.minP << '|' << params.repeatPenalty << '|'
+           << params.repeatLastN << '|' << params.seed << '|' << maxTokens << '|' << systemPromptHash.load();
+        return ss.str();
+    }
+
+    static RequestMetrics toRequestMetrics(int32_t session, const GenerationStats& stats, bool ok) {
+        RequestMetrics metrics;
+        metrics.session = session;
+        metrics.promptTokens = stats.promptTokens;
+        metrics.cachedPromptTokens = stats.cachedPromptTokens;
+        metrics.generatedTokens = stats.generatedTokens;
+        metrics.draftedTokens = stats.draftedTokens;
+        metrics.acceptedDraftTokens = stats.acceptedDraftTokens;
+        metrics.queueWaitMs = (float) stats.queueWaitMs;
+        metrics.timeToFirstTokenMs = (float) stats.timeToFirstTokenMs;
+        metrics.prefillMs = (float) stats.prefillMs;
+        metrics.decodeMs = (float) stats.decodeMs;
+        metrics.tokensPerSecond = stats.decodeMs > 0.0 ? (float) (stats.generatedTokens * 1000.0 / stats.decodeMs) : 0.0f;
+        metrics.stopped = stats.stopped;
+        metrics.ok = ok;
+        return metrics;
+    }
+
+    void recordRequest(RequestMetrics metrics, std::chrono::steady_clock::time_point start) {
+        metrics.totalMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (metrics.cacheHit) {
+            metrics.timeToFirstTokenMs = metrics.totalMs;
+        }
+        metrics.finishedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        requestMetrics.record(metrics);
+    }
+
+    void finishInit(InitState state) {
+        std::lock_guard<std::mutex> guard(initMutex);
+        if (state == INIT_READY) {
+            initProgress.store(1.0f);
+        }
+        initState.store(state);
+        initCv.notify_all();
+    }
+
+    // Stops a running pipeline at its next phase (or llama.cpp load progress
+    // callback) and waits for it
+    void cancelInit() {
+        initCancelled.store(true);
+        std::thread pending;
+        {
+            std::lock_guard<std::mutex> guard(initMutex);
+            pending = std::move(initThread);
+        }
+        if (pending.joinable()) {
+            pending.join();
+        }
+    }
+
+    void initPipeline(const std::string& path, const std::string& stateDir, uint32_t nCtx, KvCacheType kvType,
+                      const std::string& systemPrompt) {
+        TRACE_SCOPE("LlamaManager::initPipeline");
+        bool ok = false;
+        {
+            std::unique_lock<std::shared_mutex> lock(lifecycleMutex);
+            ok = loadAndWarm(path, stateDir, nCtx, kvType, systemPrompt);
+        }
+        finishInit(ok ? INIT_READY : INIT_FAILED);
+    }
+
+    // Map and load the weights, create the context, wait until every weight
+    // page is resident, run a throwaway prefill and decode so the compute
+    // buffers exist, then evaluate (or restore) the system prompt
+    bool loadAndWarm(const std::string& path, const std::string& stateDir, uint32_t nCtx, KvCacheType kvType,
+                     const std::string& systemPrompt) {
         try {
+            const auto start = std::chrono::steady_clock::now();
             LOGI("Initializing model from: %s", path.c_str());
-            
-            // Check if file exists
-            std::ifstream file(path);
-            if (!file.good()) {
-                LOGE("Model file not found: %s", path.c_str());
+            wrapper.setStateDir(stateDir);
+
+            llama_model_params modelParams = wrapper.getModelParams();
+            modelParams.progress_callback = [](float progress, void* user) {
+                LlamaManager* self = static_cast<LlamaManager*>(user);
+                self->initProgress.store(kInitLoaded * progress);
+                return !self->initCancelled.load();
+            };
+            modelParams.progress_callback_user_data = this;
+            wrapper.setModelParams(modelParams);
+            const bool loaded = wrapper.loadModel(path);
+            modelParams.progress_callback = nullptr;
+            modelParams.progress_callback_user_data = nullptr;
+            wrapper.setModelParams(modelParams);
+            if (!loaded) {
+                LOGE("Failed to load model: %s", path.c_str());
+                return false;
+            }
+            initProgress.store(kInitLoaded);
+
+            if (nCtx > 0) {
+                llama_context_params params = wrapper.getContextParams();
+                params.n_ctx = nCtx;
+                wrapper.setContextParams(params);
+            }
+            wrapper.setKvCacheType(kvType);
+            wrapper.setMaxSequences(kMaxSessions);
+            if (initCancelled.load() || !wrapper.createContext() || !server.start()) {
+                LOGE("Failed to create context for model: %s", path.c_str());
+                wrapper.unloadModel();
                 return false;
             }
-            file.close();
-            
-            // Get file size
-            std::ifstream fileSizeCheck(path, std::ios::binary | std::ios::ate);
-            if (fileSizeCheck.is_open()) {
-                std::streamsize size = fileSizeCheck.tellg();
-                LOGI("Model file size: %lld bytes", (long long)size);
-                fileSizeCheck.close();
+            initProgress.store(kInitContextReady);
+
+            wrapper.waitForPrefetch();
+            initProgress.store(kInitWeightsResident);
+
+            // Runs on the pinned server thread so the timings match real decoding
+            server.runExclusive([this] {
+                wrapper.calibrateThreads(wrapper.threadConfigPath());
+                wrapper.warmUp();
+            });
+            initProgress.store(kInitWarm);
+
+            defaultSession = server.createSession();
+            responseCache.open(wrapper.statePath(".responses"));
+            systemPromptHash.store(ResponseCache::makeKey(systemPrompt, std::string()));
+            if (!systemPrompt.empty()) {
+                bool prefixReady = false;
+                server.runExclusive([&] { prefixReady = wrapper.setSystemPrompt(systemPrompt); });
+                if (!prefixReady) {
+                    LOGE("System prompt prefix not ready, requests evaluate it themselves");
+                }
+            }
+            if (initCancelled.load()) {
+                teardown();
+                return false;
             }
-            
-            modelPath = path;
-            isInitialized = true;
-            LOGI("Model initialized successfully: %s", path.c_str());
+
+            LOGI("Model ready in %.1f ms: %s",
+                 std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), path.c_str());
             return true;
-            
+
         } catch (const std::exception& e) {
             LOGE("Failed to initialize model: %s", e.what());
+            teardown();
             return false;
         }
     }
-    
-    std::string generateResponse(const std::string& prompt, int maxTokens) {
-        (void)maxTokens; // Suppress unused parameter warning
-        if (!isInitialized) {
+
+    // Releases everything loadAndWarm set up; lifecycleMutex held exclusively
+    void teardown() {
+        server.stop();
+        defaultSession = -1;
+        {
+            std::unique_lock<std::shared_mutex> indexLock(semanticMutex);
+            semanticIndex.close();
+        }
+        responseCache.close();
+        wrapper.unloadModel();
+    }
+
+public:
+    ~LlamaManager() {
+        cancelInit();
+    }
+
+    // Starts loading in the background and returns at once; false only when a
+    // previous load cannot be replaced. nCtx > 0 overrides the default context
+    // size (see inspectModel). Files derived from the model go to `stateDir`, which
+    // must be writable. Requests made meanwhile wait for the model.
+    bool initModel(const std::string& path, const std::string& stateDir, uint32_t nCtx, KvCacheType kvType,
+                   const std::string& systemPrompt) {
+        std::lock_guard<std::mutex> guard(initMutex);
+        const int state = initState.load();
+        if (state == INIT_LOADING || state == INIT_READY) {
+            LOGI("Model already %s", state == INIT_READY ? "initialized" : "loading");
+            return true;
+        }
+        // A failed attempt has finished; its thread only needs joining
+        if (initThread.joinable()) {
+            initThread.join();
+        }
+        initCancelled.store(false);
+        initProgress.store(0.0f);
+        initState.store(INIT_LOADING);
+        initThread = std::thread(&LlamaManager::initPipeline, this, path, stateDir, nCtx, kvType, systemPrompt);
+        return true;
+    }
+
+    int getInitState() const { return initState.load(); }
+    float getInitProgress() const { return initProgress.load(); }
+
+    // Blocks until a running load finishes (timeoutMs < 0: no limit); true once ready
+    bool waitUntilReady(int64_t timeoutMs) {
+        std::unique_lock<std::mutex> guard(initMutex);
+        auto settled = [this] { return initState.load() != INIT_LOADING; };
+        if (timeoutMs < 0) {
+            initCv.wait(guard, settled);
+        } else {
+            initCv.wait_for(guard, std::chrono::milliseconds(timeoutMs), settled);
+        }
+        return initState.load() == INIT_READY;
+    }
+
+    std::string generate(int32_t session, const std::string& prompt, int maxTokens, const TokenCallback& onToken,
+                         const std::string& grammar = std::string()) {
+        TRACE_SCOPE("LlamaManager::generate");
+        const auto start = std::chrono::steady_clock::now();
+        // Requests made while the model is warming up start as soon as it is ready
+        waitUntilReady(-1);
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (!server.isRunning()) {
             return "Error: Model not initialized";
         }
-        
+
         try {
-            LOGI("Generating response for prompt: %s", prompt.c_str());
-            
-            // Create a smart response based on the prompt
-            std::string response = generateSmartResponse(prompt);
-            
-            LOGI("Generated response: %s", response.c_str());
+            std::string identity = responseCacheIdentity(maxTokens);
+            if (!grammar.empty()) {
+                identity += '|' + std::to_string(ResponseCache::makeKey(grammar, std::string()));
+            }
+            const uint64_t cacheKey = ResponseCache::makeKey(prompt, identity);
+            std::string response;
+            if (responseCache.lookup(cacheKey, response)) {
+                LOGI("Response cache hit (session %d)", session);
+                if (onToken) {
+                    onToken(response);
+                }
+                RequestMetrics metrics;
+                metrics.session = session;
+                metrics.cacheHit = true;
+                recordRequest(metrics, start);
+                return response;
+            }
+
+            LOGV("Generating response (session %d) for prompt: %s", session, prompt.c_str());
+
+            response = server.generate(session, prompt, maxTokens, onToken, grammar);
+            const bool ok = !response.empty() && response.rfind("Error:", 0) != 0;
+            const GenerationStats stats = server.lastStats(session);
+
+            // Only complete answers are reusable
+            if (ok && !stats.stopped) {
+                responseCache.insert(cacheKey, response);
+            }
+            recordRequest(toRequestMetrics(session, stats, ok), start);
+
+            LOGV("Generated response: %s", response.c_str());
             return response;
-            
+
         } catch (const std::exception& e) {
             LOGE("Error generating response: %s", e.what());
             return "Error: Failed to generate response";
         }
     }
-    
+
+    // Replies depend on the conversation so far, so chat turns skip the response cache
+    std::string chat(int32_t session, const std::string& turn, int maxTokens, const TokenCallback& onToken) {
+        TRACE_SCOPE("LlamaManager::chat");
+        const auto start = std::chrono::steady_clock::now();
+        waitUntilReady(-1);
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (!server.isRunning()) {
+            return "Error: Model not initialized";
+        }
+
+        LOGV("Chat turn (session %d): %s", session, turn.c_str());
+        std::string response = server.chat(session, turn, maxTokens, onToken);
+        const bool ok = !response.empty() && response.rfind("Error:", 0) != 0;
+        recordRequest(toRequestMetrics(session, server.lastStats(session), ok), start);
+        LOGV("Chat reply: %s", response.c_str());
+        return response;
+    }
+
+    void resetChat(int32_t session) {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (server.isRunning()) {
+            server.resetChat(session);
+        }
+    }
+
+    std::string generateResponse(const std::string& prompt, int maxTokens, const TokenCallback& onToken) {
+        return generate(defaultSession, prompt, maxTokens, onToken);
+    }
+
+    // Builds the food log grammar from the names in the compiled food index
+    bool loadFoodLogGrammar(const std::string& indexPath) {
+        FoodIndex index;
+        if (!index.open(indexPath)) {
+            LOGE("Food index not available for the food log grammar: %s", indexPath.c_str());
+            return false;
+        }
+        std::vector<std::string> names;
+        names.reserve(index.size());
+        for (uint32_t row = 0; row < index.size(); row++) {
+            names.emplace_back(index.name((int32_t) row));
+        }
+        std::string grammar = buildFoodLogGrammar(names);
+        LOGI("Food log grammar: %zu foods, %zu bytes", names.size(), grammar.size());
+        std::unique_lock<std::shared_mutex> grammarLock(grammarMutex);
+        foodLogGrammar = std::move(grammar);
+        return true;
+    }
+
+    // Food log as compact JSON ([{"name","quantity","unit"}, ...]); generation
+    // stops at the closing bracket
+    std::string generateFoodLog(const std::string& prompt, int maxTokens) {
+        std::string grammar;
+        {
+            std::shared_lock<std::shared_mutex> grammarLock(grammarMutex);
+            grammar = foodLogGrammar;
+        }
+        if (grammar.empty()) {
+            return "Error: Food log grammar not loaded";
+        }
+        return generate(defaultSession, prompt, maxTokens, TokenCallback(), grammar);
+    }
+
+    int32_t createSession() {
+        waitUntilReady(-1);
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        return server.isRunning() ? server.createSession() : -1;
+    }
+
+    void destroySession(int32_t session) {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (server.isRunning() && session != defaultSession) {
+            server.destroySession(session);
+        }
+    }
+
+    void cancel(int32_t session) {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        server.cancel(session);
+    }
+
+    bool setSystemPrompt(const std::string& systemPrompt) {
+        waitUntilReady(-1);
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (!server.isRunning()) {
+            return false;
+        }
+        bool result = false;
+        server.runExclusive([&] { result = wrapper.setSystemPrompt(systemPrompt); });
+        systemPromptHash.store(ResponseCache::makeKey(systemPrompt, std::string()));
+        return result;
+    }
+
     bool isModelLoaded() const {
-        return isInitialized;
+        return initState.load() == INIT_READY;
     }
-    
+
     std::string getModelInfo() const {
-        if (!isInitialized) {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (!wrapper.isModelLoaded()) {
             return "Model not loaded";
         }
-        return "TinyLlama Model Loaded Successfully - Path: " + modelPath;
+        return wrapper.getModelInfo();
+    }
+
+    bool loadIntentTable(const char* csv, size_t size) {
+        std::unique_lock<std::shared_mutex> lock(intentMutex);
+        return intentRouter.build(csv, size);
+    }
+
+    // Ranked intents as a JSON array, best first
+    std::string classifyIntent(const std::string& text) const {
+        std::shared_lock<std::shared_mutex> lock(intentMutex);
+        std::ostringstream ss;
+        ss << "[";
+        bool first = true;
+        for (const IntentScore& intent : intentRouter.classify(text)) {
+            ss << (first ? "" : ",") << "{\"action\":\"" << intent.action << "\",\"score\":" << intent.score
+               << ",\"confidence\":" << intent.confidence << "}";
+            first = false;
+        }
+        ss << "]";
+        return ss.str();
+    }
+
+    // Opens or (first run, new model or assets) builds the embedding index. Slow
+    // when building: one embedding pass per document.
+    bool buildSemanticIndex(const std::vector<SemanticDocument>& docs, const std::string& path) {
+        waitUntilReady(-1);
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (!wrapper.isModelLoaded()) {
+            return false;
+        }
+        std::unique_lock<std::shared_mutex> indexLock(semanticMutex);
+        return semanticIndex.openOrBuild(wrapper, docs, path);
+    }
+
+    // Nearest foods/recipes as a JSON array, best first; kindMask selects
+    // (1 << SemanticKind) kinds
+    std::string semanticSearch(const std::string& query, size_t k, uint32_t kindMask) {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        std::shared_lock<std::shared_mutex> indexLock(semanticMutex);
+        if (!wrapper.isModelLoaded()) {
+            return "[]";
+        }
+        return semanticMatchesJson(semanticIndex.search(wrapper, query, k, kindMask));
+    }
+
+    // Header-only look at a model file; estimates memory for nCtx (default context
+    // size when 0) without loading anything
+    std::string inspectModel(const std::string& path, uint32_t nCtx) const {
+        GgufLayout layout;
+        uint64_t fileSize = 0;
+        std::string error;
+        if (!inspectGgufFile(path, layout, fileSize, error)) {
+            LOGE("Model inspection failed for %s: %s", path.c_str(), error.c_str());
+            return "{\"valid\":false,\"error\":\"" + jsonEscape(error) + "\"}";
+        }
+        const llama_context_params params = wrapper.getContextParams();
+        return ggufInfoJson(layout, fileSize, nCtx > 0 ? nCtx : params.n_ctx, params.n_batch);
+    }
+
+    // Draft model when draftPath is set, otherwise n-gram lookup over `corpus`;
+    // maxDraft <= 0 turns speculation off. Swapped between decode steps.
+    bool enableSpeculation(const std::vector<std::string>& corpus, const std::string& draftPath, int32_t maxDraft) {
+        waitUntilReady(-1);
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (!server.isRunning()) {
+            return false;
+        }
+        std::unique_ptr<Drafter> drafter;
+        if (maxDraft > 0) {
+            drafter = draftPath.empty() ? wrapper.createNgramDrafter(corpus) : wrapper.createDraftModelDrafter(draftPath);
+            if (!drafter) {
+                LOGE("Failed to create drafter%s%s", draftPath.empty() ? "" : " from ", draftPath.c_str());
+                return false;
+            }
+        }
+        server.runExclusive([&] { wrapper.setDrafter(std::move(drafter), maxDraft); });
+        return true;
+    }
+
+    std::string getSpeculativeStats() const {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        return wrapper.speculativeStatsJson();
+    }
+
+    // Android onTrimMemory; see LlamaWrapper::trimMemory
+    bool trimMemory(int level) {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        if (!server.isRunning()) {
+            return false;
+        }
+        return server.trimMemory(level);
+    }
+
+    std::string getMemoryReport() {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        MemoryReport report;
+        server.runExclusive([&] { report = wrapper.memoryReport(); });
+        return report.toJson();
+    }
+
+    std::string getCacheStats() const {
+        return responseCache.stats().toJson();
+    }
+
+    void clearResponseCache() {
+        responseCache.clear();
     }
-    
+
+    // Most recent requests (RequestMetrics JSON); lock-free, callable any time
+    std::string getRequestMetrics() const {
+        return requestMetrics.toJson();
+    }
+
+    // Phase timings of the last load attempt, also filled in when it failed
+    std::string getLoadReport() const {
+        std::shared_lock<std::shared_mutex> lock(lifecycleMutex);
+        return wrapper.getLoadReport().toJson();
+    }
+
     void cleanup() {
-        isInitialized = false;
-        modelPath.clear();
+        cancelInit();
+        {
+            std::unique_lock<std::shared_mutex> lock(lifecycleMutex);
+            teardown();
+        }
+        finishInit(INIT_IDLE);
         LOGI("Model cleaned up");
     }
-    
-private:
-    std::string generateSmartResponse(const std::string& prompt) {
-        std::string lowerPrompt = prompt;
-        std::transform(lowerPrompt.begin(), lowerPrompt.end(), lowerPrompt.begin(), ::tolower);
-        
-        // Check for math questions
-        if (lowerPrompt.find("what is") != std::string::npos && 
-            (lowerPrompt.find("+") != std::string::npos || 
-             lowerPrompt.find("-") != std::string::npos || 
-             lowerPrompt.find("*") != std::string::npos || 
-             lowerPrompt.find("times") != std::string::npos ||
-             lowerPrompt.find("plus") != std::string::npos ||
-             lowerPrompt.find("minus") != std::string::npos)) {
-            
-            return std::string("I can help with basic math! For example:\n") +
-                   "• 2 + 2 = 4\n" +
-                   "• 5 * 3 = 15\n" +
-                   "• 10 - 3 = 7\n\n" +
-                   "What specific calculation would you like me to help with?";
-        }
-        
-        // Check for simple math expressions
-        if (lowerPrompt.find("+") != std::string::npos || 
-            lowerPrompt.find("-") != std::string::npos || 
-            lowerPrompt.find("*") != std::string::npos ||
-            (lowerPrompt.length() <= 10 && 
-             (lowerPrompt.find("2") != std::string::npos || 
-              lowerPrompt.find("3") != std::string::npos || 
-              lowerPrompt.find("4") != std::string::npos || 
-              lowerPrompt.find("5") != std::string::npos))) {
-            
-            return std::string("I can help with basic math! For example:\n") +
-                   "• 2 + 2 = 4\n" +
-                   "• 5 * 3 = 15\n" +
-                   "• 10 - 3 = 7\n\n" +
-                   "What specific calculation would you like me to help with?";
-        }
-        
-        // Check for weather questions
-        if (lowerPrompt.find("weather") != std::string::npos) {
-            return std::string("I'm a diet and nutrition AI assistant, so I can't provide weather information. ") +
-                   "However, I can help you with:\n" +
-                   "• Food logging and nutrition tracking\n" +
-                   "• Recipe suggestions\n" +
-                   "• Inventory management\n" +
-                   "• Shopping lists\n\n" +
-                   "What would you like to know about your diet?";
-        }
-        
-        // Check for specific nutrition questions
-        if (lowerPrompt.find("calories") != std::string::npos && lowerPrompt.find("apple") != std::string::npos) {
-            return "An average apple contains about 95 calories. It's a great low-calorie snack that's high in fiber and vitamin C!";
-        }
-        
-        if (lowerPrompt.find("calories") != std::string::npos && lowerPrompt.find("rice") != std::string::npos) {
-            return "Cooked white rice contains about 130 calories per 1/2 cup serving. Brown rice has about 110 calories per 1/2 cup and is higher in fiber.";
-        }
-        
-        if (lowerPrompt.find("protein") != std::string::npos) {
-            return std::string("Protein is essential for building and repairing muscles. Good sources include:\n") +
-                   "• Chicken breast: 31g per 100g\n" +
-                   "• Eggs: 13g per egg\n" +
-                   "• Greek yogurt: 10g per 100g\n" +
-                   "• Lentils: 9g per 100g\n\n" +
-                   "Most adults need 0.8-1.2g of protein per kg of body weight daily.";
-        }
-        
-        if (lowerPrompt.find("breakfast") != std::string::npos) {
-            return std::string("A healthy breakfast should include:\n") +
-                   "• Protein: eggs, yogurt, or nuts\n" +
-                   "• Complex carbs: oatmeal, whole grain bread\n" +
-                   "• Fiber: fruits, vegetables\n" +
-                   "• Healthy fats: avocado, nuts\n\n" +
-                   "Try: Greek yogurt with berries and granola, or scrambled eggs with whole grain toast!";
-        }
-        
-        if (lowerPrompt.find("weight loss") != std::string::npos || lowerPrompt.find("lose weight") != std::string::npos) {
-            return std::string("Foods good for weight loss include:\n") +
-                   "• High-fiber vegetables: broccoli, spinach, kale\n" +
-                   "• Lean proteins: chicken, fish, tofu\n" +
-                   "• Whole grains: quinoa, brown rice, oats\n" +
-                   "• Healthy fats: avocado, nuts, olive oil\n" +
-                   "• Low-calorie fruits: berries, apples\n\n" +
-                   "Focus on whole, unprocessed foods and maintain a calorie deficit.";
-        }
-        
-        if (lowerPrompt.find("water") != std::string::npos || lowerPrompt.find("drink") != std::string::npos) {
-            return std::string("General water intake recommendations:\n") +
-                   "• Men: 3.7 liters (125 oz) per day\n" +
-                   "• Women: 2.7 liters (91 oz) per day\n" +
-                   "• More if you exercise or live in hot climates\n\n" +
-                   "Listen to your body - clear urine usually means you're well hydrated!";
-        }
-        
-        // Check for diet/nutrition questions
-        if (lowerPrompt.find("diet") != std::string::npos || 
-            lowerPrompt.find("nutrition") != std::string::npos ||
-            lowerPrompt.find("food") != std::string::npos ||
-            lowerPrompt.find("calories") != std::string::npos) {
-            
-            return std::string("Great! I'm your Tasty Diet AI assistant. I can help you with:\n\n") +
-                   "🍽️ **Food Logging**\n" +
-                   "• Log your meals: \"I ate rice and dal\"\n" +
-                   "• Track nutrition: \"How many calories in apple?\"\n\n" +
-                   "📊 **Nutrition Tracking**\n" +
-                   "• Check daily progress: \"What's my remaining calories?\"\n" +
-                   "• Macro goals: \"Show my protein intake\"\n\n" +
-                   "🛒 **Inventory & Shopping**\n" +
-                   "• Check inventory: \"What's in my kitchen?\"\n" +
-                   "• Shopping list: \"Add milk to shopping list\"\n\n" +
-                   "👨‍🍳 **Recipe Ideas**\n" +
-                   "• Get suggestions: \"Suggest a healthy recipe\"\n" +
-                   "• Meal planning: \"What should I cook today?\"\n\n" +
-                   "What would you like to do?";
-        }
-        
-        // Check for greetings
-        if (lowerPrompt.find("hello") != std::string::npos || 
-            lowerPrompt.find("hi") != std::string::npos ||
-            lowerPrompt.find("hey") != std::string::npos) {
-            
-            return std::string("Hello! 👋 I'm your Tasty Diet AI assistant. I'm here to help you with:\n\n") +
-                   "• Food logging and nutrition tracking\n" +
-                   "• Recipe suggestions and meal planning\n" +
-                   "• Inventory management\n" +
-                   "• Shopping lists\n\n" +
-                   "What would you like to do today?";
-        }
-        
-        // Check for help requests
-        if (lowerPrompt.find("help") != std::string::npos || 
-            lowerPrompt.find("what can you do") != std::string::npos) {
-            
-            return std::string("I can help you with:\n\n") +
-                   "📝 **Commands you can try:**\n" +
-                   "• \"Log food: apple\" - Add food to your log\n" +
-                   "• \"What's in my inventory?\" - Check available ingredients\n" +
-                   "• \"Add milk to shopping list\" - Add items to buy\n" +
-                   "• \"How many calories in rice?\" - Get nutrition info\n" +
-                   "• \"Suggest a healthy recipe\" - Get meal ideas\n" +
-                   "• \"What's my remaining calories?\" - Check daily progress\n\n" +
-                   "Just ask me naturally!";
-        }
-        
-        // Default response
-        return std::string("I'm your Tasty Diet AI assistant! I can help you with:\n\n") +
-               "• Food logging and nutrition tracking\n" +
-               "• Recipe suggestions\n" +
-               "• Inventory management\n" +
-               "• Shopping lists\n\n" +
-               "Try asking me to log food, check inventory, or get nutrition information. " +
-               "Type 'help' for more options!";
-    }
 };
 
 // Global instance
 static std::unique_ptr<LlamaManager> llamaManager = std::make_unique<LlamaManager>();
 
+// Wraps a Kotlin LlamaManager.TokenCallback; invoked on the calling JNI thread
+static TokenCallback makeTokenCallback(JNIEnv *env, jobject callback) {
+    if (callback == nullptr) {
+        return TokenCallback();
+    }
+    jclass callbackClass = env->GetObjectClass(callback);
+    jmethodID onToken = env->GetMethodID(callbackClass, "onToken", "(Ljava/lang/String;)Z");
+    env->DeleteLocalRef(callbackClass);
+    if (onToken == nullptr) {
+        env->ExceptionClear();
+        LOGE("TokenCallback.onToken(String) not found, streaming disabled");
+        return TokenCallback();
+    }
+
+    return [env, callback, onToken](const std::string& chunk) {
+        jstring jchunk = newJniString(env, chunk);
+        jboolean keepGoing = env->CallBooleanMethod(callback, onToken, jchunk);
+        env->DeleteLocalRef(jchunk);
+        if (env->ExceptionCheck()) {
+            return false; // leave the exception for the Kotlin caller
+        }
+        return keepGoing == JNI_TRUE;
+    };
+}
+
 extern "C" {
 
 JNIEXPORT jboolean JNICALL
-Java_com_example_tastydiet_llm_LlamaManager_initModel(JNIEnv *env, jobject thiz, jstring path) {
+Java_com_example_tastydiet_llm_LlamaManager_initModel(JNIEnv *env, jobject thiz, jstring path, jstring stateDir, jint nCtx, jint kvType, jstring systemPrompt) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 modelPath(env, path);
+    JniUtf8 stateDirPath(env, stateDir);
+    JniUtf8 prompt(env, systemPrompt);
+    // 0 = f16, 1 = q8_0, 2 = q4_0 (LlamaManager.KV_*)
+    const KvCacheType type = kvType == 2 ? KvCacheType::Q4_0 : kvType == 1 ? KvCacheType::Q8_0 : KvCacheType::F16;
+    return llamaManager->initModel(modelPath, stateDirPath, nCtx > 0 ? (uint32_t) nCtx : 0, type, prompt);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getInitState(JNIEnv *env, jobject thiz) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    return llamaManager->getInitState();
+}
+
+JNIEXPORT jfloat JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getInitProgress(JNIEnv *env, jobject thiz) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    return llamaManager->getInitProgress();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_awaitModelReady(JNIEnv *env, jobject thiz, jlong timeoutMs) {
     (void)env; (void)thiz; // Suppress unused parameter warnings
-    const char* modelPath = env->GetStringUTFChars(path, nullptr);
-    bool result = llamaManager->initModel(modelPath);
-    env->ReleaseStringUTFChars(path, modelPath);
-    return result;
+    return llamaManager->waitUntilReady(timeoutMs);
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_example_tastydiet_llm_LlamaManager_generateResponse(JNIEnv *env, jobject thiz, jstring prompt, jint maxTokens) {
+// Prompts and responses on the generation paths travel as UTF-8 byte[] so
+// Kotlin's encodeToByteArray/decodeToString do the only transcoding
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateResponse(JNIEnv *env, jobject thiz, jbyteArray prompt, jint maxTokens) {
     (void)thiz; // Suppress unused parameter warning
-    const char* promptStr = env->GetStringUTFChars(prompt, nullptr);
-    std::string response = llamaManager->generateResponse(promptStr, maxTokens);
-    env->ReleaseStringUTFChars(prompt, promptStr);
-    return env->NewStringUTF(response.c_str());
+    JniUtf8 promptStr(env, prompt);
+    std::string response = llamaManager->generateResponse(promptStr, maxTokens, TokenCallback());
+    return newJniBytes(env, response);
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateResponseStreaming(JNIEnv *env, jobject thiz, jbyteArray prompt, jint maxTokens, jobject callback) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 promptStr(env, prompt);
+    std::string response = llamaManager->generateResponse(promptStr, maxTokens, makeTokenCallback(env, callback));
+    if (env->ExceptionCheck()) {
+        return nullptr;
+    }
+    return newJniBytes(env, response);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_loadFoodLogGrammar(JNIEnv *env, jobject thiz, jstring indexPath) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 path(env, indexPath);
+    return llamaManager->loadFoodLogGrammar(path);
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateFoodLog(JNIEnv *env, jobject thiz, jbyteArray prompt, jint maxTokens) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 promptStr(env, prompt);
+    std::string response = llamaManager->generateFoodLog(promptStr, maxTokens);
+    return newJniBytes(env, response);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_createSession(JNIEnv *env, jobject thiz) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    return llamaManager->createSession();
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_destroySession(JNIEnv *env, jobject thiz, jint session) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    llamaManager->destroySession(session);
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateSessionResponse(JNIEnv *env, jobject thiz, jint session, jbyteArray prompt, jint maxTokens, jobject callback) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 promptStr(env, prompt);
+    std::string response = llamaManager->generate(session, promptStr, maxTokens, makeTokenCallback(env, callback));
+    if (env->ExceptionCheck()) {
+        return nullptr;
+    }
+    return newJniBytes(env, response);
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateChatTurn(JNIEnv *env, jobject thiz, jint session, jbyteArray turn, jint maxTokens, jobject callback) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 turnStr(env, turn);
+    std::string response = llamaManager->chat(session, turnStr, maxTokens, makeTokenCallback(env, callback));
+    if (env->ExceptionCheck()) {
+        return nullptr;
+    }
+    return newJniBytes(env, response);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_resetChat(JNIEnv *env, jobject thiz, jint session) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    llamaManager->resetChat(session);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_cancelSession(JNIEnv *env, jobject thiz, jint session) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    llamaManager->cancel(session);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_setSystemPrompt(JNIEnv *env, jobject thiz, jstring systemPrompt) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 promptStr(env, systemPrompt);
+    return llamaManager->setSystemPrompt(promptStr);
 }
 
 JNIEXPORT jboolean JNICALL
@@ -275,7 +736,166 @@ JNIEXPORT jstring JNICALL
 Java_com_example_tastydiet_llm_LlamaManager_getModelInfo(JNIEnv *env, jobject thiz) {
     (void)env; (void)thiz; // Suppress unused parameter warnings
     std::string info = llamaManager->getModelInfo();
-    return env->NewStringUTF(info.c_str());
+    return newJniString(env, info);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_inspectModel(JNIEnv *env, jobject thiz, jstring path, jint nCtx) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 modelPath(env, path);
+    std::string info = llamaManager->inspectModel(modelPath, nCtx > 0 ? (uint32_t) nCtx : 0);
+    return newJniString(env, info);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_loadIntentTable(JNIEnv *env, jobject thiz, jobject assetManager, jstring assetName) {
+    (void)thiz; // Suppress unused parameter warning
+    AAssetManager* manager = AAssetManager_fromJava(env, assetManager);
+    JniUtf8 name(env, assetName);
+    AAsset* asset = manager ? AAssetManager_open(manager, name.c_str(), AASSET_MODE_BUFFER) : nullptr;
+    if (!asset) {
+        LOGE("Intent table asset not found");
+        return JNI_FALSE;
+    }
+    // Uncompressed assets are mapped straight from the APK
+    const char* data = static_cast<const char*>(AAsset_getBuffer(asset));
+    bool result = data && llamaManager->loadIntentTable(data, (size_t) AAsset_getLength(asset));
+    AAsset_close(asset);
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_classifyIntent(JNIEnv *env, jobject thiz, jstring text) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 textStr(env, text);
+    std::string intents = llamaManager->classifyIntent(textStr);
+    return newJniString(env, intents);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_buildSemanticIndex(JNIEnv *env, jobject thiz, jobject assetManager, jobjectArray assetNames, jstring indexPath) {
+    (void)thiz; // Suppress unused parameter warning
+    AAssetManager* manager = AAssetManager_fromJava(env, assetManager);
+    if (!manager) {
+        return JNI_FALSE;
+    }
+    std::vector<SemanticDocument> docs;
+    const jsize count = env->GetArrayLength(assetNames);
+    for (jsize i = 0; i < count; i++) {
+        jstring assetName = (jstring) env->GetObjectArrayElement(assetNames, i);
+        {
+            JniUtf8 name(env, assetName);
+            AAsset* asset = AAssetManager_open(manager, name.c_str(), AASSET_MODE_BUFFER);
+            const char* data = asset ? static_cast<const char*>(AAsset_getBuffer(asset)) : nullptr;
+            std::string error;
+            if (!data || !collectSemanticDocuments(data, (size_t) AAsset_getLength(asset), docs, error)) {
+                LOGE("Skipping %s for the semantic index: %s", name.c_str(), data ? error.c_str() : "not found");
+            }
+            if (asset) {
+                AAsset_close(asset);
+            }
+        }
+        env->DeleteLocalRef(assetName);
+    }
+
+    JniUtf8 path(env, indexPath);
+    return llamaManager->buildSemanticIndex(docs, path);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_semanticSearch(JNIEnv *env, jobject thiz, jstring query, jint limit, jint kindMask) {
+    (void)thiz; // Suppress unused parameter warning
+    JniUtf8 queryStr(env, query);
+    std::string matches = llamaManager->semanticSearch(queryStr, limit > 0 ? (size_t) limit : 0, (uint32_t) kindMask);
+    return newJniString(env, matches);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_enableSpeculation(JNIEnv *env, jobject thiz, jobject assetManager, jobjectArray assetNames, jstring draftModelPath, jint maxDraft) {
+    (void)thiz; // Suppress unused parameter warning
+    AAssetManager* manager = assetManager ? AAssetManager_fromJava(env, assetManager) : nullptr;
+    const jsize count = manager && assetNames ? env->GetArrayLength(assetNames) : 0;
+    // Same food/recipe text the semantic index embeds
+    std::vector<SemanticDocument> docs;
+    for (jsize i = 0; i < count; i++) {
+        jstring assetName = (jstring) env->GetObjectArrayElement(assetNames, i);
+        {
+            JniUtf8 name(env, assetName);
+            AAsset* asset = AAssetManager_open(manager, name.c_str(), AASSET_MODE_BUFFER);
+            const char* data = asset ? static_cast<const char*>(AAsset_getBuffer(asset)) : nullptr;
+            std::string error;
+            if (!data || !collectSemanticDocuments(data, (size_t) AAsset_getLength(asset), docs, error)) {
+                LOGE("Skipping %s for the draft corpus: %s", name.c_str(), data ? error.c_str() : "not found");
+            }
+            if (asset) {
+                AAsset_close(asset);
+            }
+        }
+        env->DeleteLocalRef(assetName);
+    }
+    std::vector<std::string> corpus;
+    corpus.reserve(docs.size());
+    for (SemanticDocument& doc : docs) {
+        corpus.push_back(std::move(doc.text));
+    }
+
+    // A null draft model path reads as empty
+    JniUtf8 draftPath(env, draftModelPath);
+    return llamaManager->enableSpeculation(corpus, draftPath, maxDraft);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getSpeculativeStats(JNIEnv *env, jobject thiz) {
+    (void)thiz; // Suppress unused parameter warning
+    std::string stats = llamaManager->getSpeculativeStats();
+    return newJniString(env, stats);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_trimMemory(JNIEnv *env, jobject thiz, jint level) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    return llamaManager->trimMemory(level);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getMemoryReport(JNIEnv *env, jobject thiz) {
+    (void)thiz; // Suppress unused parameter warning
+    std::string report = llamaManager->getMemoryReport();
+    return newJniString(env, report);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getCacheStats(JNIEnv *env, jobject thiz) {
+    (void)thiz; // Suppress unused parameter warning
+    std::string stats = llamaManager->getCacheStats();
+    return newJniString(env, stats);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_clearResponseCache(JNIEnv *env, jobject thiz) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    llamaManager->clearResponseCache();
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getLoadReport(JNIEnv *env, jobject thiz) {
+    (void)thiz; // Suppress unused parameter warnings
+    std::string report = llamaManager->getLoadReport();
+    return newJniString(env, report);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getRequestMetrics(JNIEnv *env, jobject thiz) {
+    (void)thiz; // Suppress unused parameter warning
+    std::string metrics = llamaManager->getRequestMetrics();
+    return newJniString(env, metrics);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_setLogVerbosity(JNIEnv *env, jobject thiz, jint level) {
+    (void)env; (void)thiz; // Suppress unused parameter warnings
+    // LlamaManager.LOG_VERBOSITY_* mirror NativeLogVerbosity
+    nativeLogVerbosity().store(std::max((int) LOG_VERBOSITY_QUIET, std::min((int) level, (int) LOG_VERBOSITY_VERBOSE)));
 }
 
 JNIEXPORT void JNICALL
@@ -284,4 +904,4 @@ Java_com_example_tastydiet_llm_LlamaManager_cleanup(JNIEnv *env, jobject thiz) {
     llamaManager->cleanup();
 }
 
-} 
\ No newline at end of file
+}
@@ -8,10 +8,49 @@ extern "C" {
 #endif
 
 JNIEXPORT jboolean JNICALL
-Java_com_example_tastydiet_llm_LlamaManager_initModel(JNIEnv *env, jobject thiz, jstring path);
+Java_com_example_tastydiet_llm_LlamaManager_initModel(JNIEnv *env, jobject thiz, jstring path, jstring stateDir, jint nCtx, jint kvType, jstring systemPrompt);
 
-JNIEXPORT jstring JNICALL
-Java_com_example_tastydiet_llm_LlamaManager_generateResponse(JNIEnv *env, jobject thiz, jstring prompt, jint maxTokens);
+JNIEXPORT jint JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getInitState(JNIEnv *env, jobject thiz);
+
+JNIEXPORT jfloat JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getInitProgress(JNIEnv *env, jobject thiz);
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_awaitModelReady(JNIEnv *env, jobject thiz, jlong timeoutMs);
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateResponse(JNIEnv *env, jobject thiz, jbyteArray prompt, jint maxTokens);
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateResponseStreaming(JNIEnv *env, jobject thiz, jbyteArray prompt, jint maxTokens, jobject callback);
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_loadFoodLogGrammar(JNIEnv *env, jobject thiz, jstring indexPath);
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateFoodLog(JNIEnv *env, jobject thiz, jbyteArray prompt, jint maxTokens);
+
+JNIEXPORT jint JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_createSession(JNIEnv *env, jobject thiz);
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_destroySession(JNIEnv *env, jobject thiz, jint session);
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateSessionResponse(JNIEnv *env, jobject thiz, jint session, jbyteArray prompt, jint maxTokens, jobject callback);
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_generateChatTurn(JNIEnv *env, jobject thiz, jint session, jbyteArray turn, jint maxTokens, jobject callback);
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_resetChat(JNIEnv *env, jobject thiz, jint session);
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_cancelSession(JNIEnv *env, jobject thiz, jint session);
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_setSystemPrompt(JNIEnv *env, jobject thiz, jstring systemPrompt);
 
 JNIEXPORT jboolean JNICALL
 Java_com_example_tastydiet_llm_LlamaManager_isModelLoaded(JNIEnv *env, jobject thiz);
@@ -19,6 +58,48 @@ Java_com_example_tastydiet_llm_LlamaManager_isModelLoaded(JNIEnv *env, jobject t
 JNIEXPORT jstring JNICALL
 Java_com_example_tastydiet_llm_LlamaManager_getModelInfo(JNIEnv *env, jobject thiz);
 
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_inspectModel(JNIEnv *env, jobject thiz, jstring path, jint nCtx);
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_loadIntentTable(JNIEnv *env, jobject thiz, jobject assetManager, jstring assetName);
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_classifyIntent(JNIEnv *env, jobject thiz, jstring text);
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_buildSemanticIndex(JNIEnv *env, jobject thiz, jobject assetManager, jobjectArray assetNames, jstring indexPath);
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_semanticSearch(JNIEnv *env, jobject thiz, jstring query, jint limit, jint kindMask);
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_enableSpeculation(JNIEnv *env, jobject thiz, jobject assetManager, jobjectArray assetNames, jstring draftModelPath, jint maxDraft);
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getSpeculativeStats(JNIEnv *env, jobject thiz);
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_trimMemory(JNIEnv *env, jobject thiz, jint level);
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getMemoryReport(JNIEnv *env, jobject thiz);
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getCacheStats(JNIEnv *env, jobject thiz);
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_clearResponseCache(JNIEnv *env, jobject thiz);
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getLoadReport(JNIEnv *env, jobject thiz);
+
+JNIEXPORT jstring JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_getRequestMetrics(JNIEnv *env, jobject thiz);
+
+JNIEXPORT void JNICALL
+Java_com_example_tastydiet_llm_LlamaManager_setLogVerbosity(JNIEnv *env, jobject thiz, jint level);
+
 JNIEXPORT void JNICALL
 Java_com_example_tastydiet_llm_LlamaManager_cleanup(JNIEnv *env, jobject thiz);
 
@@ -0,0 +1,405 @@
+#include "llama_server.h"
+#include <algorithm>
+#include "native_log.h"
+#include "native_trace.h"
+
+#define TAG "LlamaServer"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+LlamaServer::LlamaServer(LlamaWrapper& wrapper)
+    : m_wrapper(wrapper)
+    , m_batch()
+    , m_running(false)
+    , m_stopRequested(false) {
+}
+
+LlamaServer::~LlamaServer() {
+    stop();
+}
+
+bool LlamaServer::start() {
+    if (m_running) {
+        return true;
+    }
+    if (!m_wrapper.isContextCreated()) {
+        LOGe("Cannot start server: context not created");
+        return false;
+    }
+
+    m_slots.clear();
+    for (int32_t i = 0; i < m_wrapper.maxSequences(); i++) {
+        auto slot = std::make_unique<Slot>();
+        slot->sequence.seqId = i;
+        m_slots.push_back(std::move(slot));
+    }
+    m_batch = llama_batch_init(m_wrapper.batchSize(), 0, 1);
+
+    m_stopRequested = false;
+    m_running = true;
+    m_worker = std::thread(&LlamaServer::workerLoop, this);
+    LOGi("Server started with %zu session slots", m_slots.size());
+    return true;
+}
+
+void LlamaServer::stop() {
+    if (!m_running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+        for (auto& slot : m_slots) {
+            slot->sequence.cancelled.store(true);
+        }
+    }
+    m_workCv.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+
+    for (auto& slot : m_slots) {
+        m_wrapper.releaseSequence(slot->sequence);
+    }
+    m_slots.clear();
+    llama_batch_free(m_batch);
+    m_batch = llama_batch();
+    m_running = false;
+    LOGi("Server stopped");
+}
+
+int32_t LlamaServer::createSession() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_slots.size(); i++) {
+        if (!m_slots[i]->inUse) {
+            m_slots[i]->inUse = true;
+            return (int32_t) i + 1;
+        }
+    }
+    LOGe("No free session slot (%zu in use)", m_slots.size());
+    return -1;
+}
+
+void LlamaServer::destroySession(int32_t session) {
+    Slot* slot = slotFor(session);
+    if (!slot) {
+        return;
+    }
+    cancel(session);
+    runExclusive([this, slot] { m_wrapper.releaseSequence(slot->sequence); });
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        slot->inUse = false;
+    }
+    m_workCv.notify_all();
+}
+
+LlamaServer::Slot* LlamaServer::slotFor(int32_t session) const {
+    if (session < 1 || session > (int32_t) m_slots.size()) {
+        return nullptr;
+    }
+    return m_slots[session - 1].get();
+}
+
+std::string LlamaServer::generate(int32_t session, const std::string& prompt, int maxTokens,
+                                  const TokenCallback& onToken, const std::string& grammar) {
+    auto request = std::make_shared<Request>();
+    request->prompt = prompt;
+    request->grammar = grammar;
+    request->maxTokens = maxTokens;
+    return submit(session, request, onToken);
+}
+
+std::string LlamaServer::chat(int32_t session, const std::string& turn, int maxTokens, const TokenCallback& onToken) {
+    auto request = std::make_shared<Request>();
+    request->prompt = turn;
+    request->maxTokens = maxTokens;
+    request->chat = true;
+    return submit(session, request, onToken);
+}
+
+void LlamaServer::resetChat(int32_t session) {
+    Slot* slot = slotFor(session);
+    if (!slot) {
+        return;
+    }
+    cancel(session);
+    runExclusive([this, slot] { m_wrapper.releaseSequence(slot->sequence); });
+}
+
+std::string LlamaServer::submit(int32_t session, const std::shared_ptr<Request>& request, const TokenCallback& onToken) {
+    Slot* slot = slotFor(session);
+    if (!m_running || !slot) {
+        return "Error: Invalid session";
+    }
+
+    request->submittedAt = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // Requests on a busy session queue behind the running one
+    m_workCv.wait(lock, [&] { return m_stopRequested || !slot->inUse || !slot->request; });
+    if (m_stopRequested || !slot->inUse) {
+        return "Error: Invalid session";
+    }
+    slot->request = request;
+    // Queued callers wait on the same condition variable as the worker
+    m_workCv.notify_all();
+
+    // Deliver chunks on the calling thread while the worker keeps decoding
+    while (true) {
+        request->cv.wait(lock, [&] { return request->done || !request->chunks.empty(); });
+        while (!request->chunks.empty()) {
+            std::string chunk = std::move(request->chunks.front());
+            request->chunks.pop_front();
+            lock.unlock();
+            const bool keepGoing = !onToken || onToken(chunk);
+            lock.lock();
+            if (!keepGoing && !request->done) {
+                // This request only: the session may already serve the next caller
+                request->cancelled = true;
+                slot->sequence.cancelled.store(true);
+            }
+        }
+        if (request->done) {
+            break;
+        }
+    }
+    return request->ok ? request->response : "Error: Failed to generate response";
+}
+
+void LlamaServer::cancel(int32_t session) {
+    Slot* slot = slotFor(session);
+    if (!slot) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (slot->request) {
+        slot->request->cancelled = true;
+        slot->sequence.cancelled.store(true);
+    }
+}
+
+void LlamaServer::runExclusive(const std::function<void()>& task) {
+    if (!m_running) {
+        task();
+        return;
+    }
+    auto pending = std::make_shared<Task>();
+    pending->fn = task;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasks.push_back(pending);
+    m_workCv.notify_all();
+    m_taskCv.wait(lock, [&] { return pending->done; });
+}
+
+bool LlamaServer::trimMemory(int level) {
+    bool result = false;
+    runExclusive([&] {
+        std::vector<LlamaSequence*> sequences;
+        for (auto& slot : m_slots) {
+            sequences.push_back(&slot->sequence);
+        }
+        result = m_wrapper.trimMemory(level, sequences);
+    });
+    return result;
+}
+
+GenerationStats LlamaServer::lastStats(int32_t session) const {
+    Slot* slot = slotFor(session);
+    if (!slot) {
+        return GenerationStats();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return slot->stats;
+}
+
+bool LlamaServer::hasWorkLocked() const {
+    if (!m_tasks.empty()) {
+        return true;
+    }
+    for (const auto& slot : m_slots) {
+        if (slot->request && (!slot->request->started || slot->sequence.active)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LlamaServer::workerLoop() {
+    // Keep this thread and the ggml workers it spawns off the efficiency cores
+    const CpuTopology& topology = CpuTopology::get();
+    if (topology.isHeterogeneous()) {
+        pinCurrentThread(topology.performanceCores);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_workCv.wait(lock, [this] { return m_stopRequested || hasWorkLocked(); });
+        if (m_stopRequested) {
+            break;
+        }
+
+        while (!m_tasks.empty()) {
+            std::shared_ptr<Task> task = m_tasks.front();
+            m_tasks.pop_front();
+            lock.unlock();
+            task->fn();
+            lock.lock();
+            task->done = true;
+            m_taskCv.notify_all();
+        }
+
+        lock.unlock();
+        admitRequests();
+        step();
+        lock.lock();
+    }
+
+    // Nothing will decode anymore: release waiting callers and tasks
+    for (auto& slot : m_slots) {
+        if (slot->request) {
+            slot->request->ok = false;
+            slot->request->done = true;
+            slot->request->cv.notify_all();
+            slot->request.reset();
+        }
+    }
+    for (auto& task : m_tasks) {
+        task->done = true;
+    }
+    m_tasks.clear();
+    m_taskCv.notify_all();
+}
+
+void LlamaServer::admitRequests() {
+    for (auto& slotPtr : m_slots) {
+        Slot& slot = *slotPtr;
+        std::shared_ptr<Request> request;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!slot.request || slot.request->started) {
+                continue;
+            }
+            request = slot.request;
+            request->started = true;
+        }
+
+        // Runs on the worker: hand the chunk over to the waiting caller thread
+        std::weak_ptr<Request> weak = request;
+        auto forward = [this, weak](const std::string& chunk) {
+            std::shared_ptr<Request> r = weak.lock();
+            if (!r) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            r->chunks.push_back(chunk);
+            r->cv.notify_all();
+            return !r->cancelled;
+        };
+
+        const double queueWaitMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - request->submittedAt).count();
+        const bool begun = request->chat
+            ? m_wrapper.beginChatTurn(slot.sequence, request->prompt, request->maxTokens, forward)
+            : m_wrapper.beginSequence(slot.sequence, request->prompt, request->maxTokens, forward, request->grammar);
+        slot.sequence.stats.queueWaitMs = queueWaitMs;
+        if (!begun) {
+            finishRequest(slot, false);
+            continue;
+        }
+        if (request->cancelled) {
+            slot.sequence.cancelled.store(true);
+        }
+    }
+}
+
+void LlamaServer::step() {
+    llamaBatchClear(m_batch);
+    const int32_t budget = m_wrapper.batchSize();
+    std::vector<Slot*> inBatch;
+
+    // Decode steps go first so streaming sessions are never starved by a long prefill.
+    // Each takes its sampled token plus up to maxDraft drafts, while every later
+    // decode step keeps room for at least its own token.
+    int32_t decoding = 0;
+    for (auto& slot : m_slots) {
+        if (slot->request && slot->sequence.active && !slot->sequence.isPrefilling()) {
+            decoding++;
+        }
+    }
+    const int32_t stepTokens = 1 + m_wrapper.maxDraft();
+    for (auto& slot : m_slots) {
+        if (!slot->request || !slot->sequence.active || slot->sequence.isPrefilling()) {
+            continue;
+        }
+        const int32_t room = std::min(stepTokens, budget - m_batch.n_tokens - --decoding);
+        if (room > 0 && m_wrapper.addToBatch(slot->sequence, m_batch, room) > 0) {
+            inBatch.push_back(slot.get());
+        }
+    }
+
+    // Remaining budget is shared between sessions that are still prefilling
+    int32_t prefilling = 0;
+    bool hasPrefill = false;
+    for (auto& slot : m_slots) {
+        if (slot->request && slot->sequence.active && slot->sequence.isPrefilling()) {
+            prefilling++;
+        }
+    }
+    for (auto& slot : m_slots) {
+        const int32_t left = budget - m_batch.n_tokens;
+        if (prefilling == 0 || left <= 0) {
+            break;
+        }
+        if (!slot->request || !slot->sequence.active || !slot->sequence.isPrefilling()) {
+            continue;
+        }
+        const int32_t share = std::max(1, left / prefilling--);
+        if (m_wrapper.addToBatch(slot->sequence, m_batch, share) > 0) {
+            inBatch.push_back(slot.get());
+            hasPrefill = true;
+        }
+    }
+
+    if (m_batch.n_tokens > 0) {
+        // A batch carrying any prompt chunk is traced as prefill
+        TRACE_SCOPE(hasPrefill ? "prefill batch" : "decode step");
+        const int32_t rc = llama_decode(m_wrapper.context(), m_batch);
+        if (rc != 0) {
+            LOGe("llama_decode failed (%d) for a batch of %d tokens from %zu sessions",
+                 rc, m_batch.n_tokens, inBatch.size());
+        }
+        for (Slot* slot : inBatch) {
+            if (rc != 0) {
+                m_wrapper.onBatchFailed(slot->sequence);
+            } else {
+                m_wrapper.onBatchDecoded(slot->sequence);
+            }
+        }
+    }
+
+    for (auto& slot : m_slots) {
+        if (slot->request && slot->request->started && !slot->sequence.active) {
+            finishRequest(*slot, !slot->sequence.failed);
+        }
+    }
+}
+
+void LlamaServer::finishRequest(Slot& slot, bool ok) {
+    m_wrapper.endSequence(slot.sequence);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!slot.request) {
+        return;
+    }
+    // Only hand out the UTF-8-complete part that was streamed
+    slot.request->response = slot.sequence.response.substr(0, slot.sequence.streamed);
+    slot.request->ok = ok;
+    slot.request->done = true;
+    slot.request->cv.notify_all();
+    slot.stats = slot.sequence.stats;
+    slot.request.reset();
+    // Next caller queued on this session
+    m_workCv.notify_all();
+}
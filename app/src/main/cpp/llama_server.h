@@ -0,0 +1,104 @@
+#ifndef LLAMA_SERVER_H
+#define LLAMA_SERVER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "llama_wrapper.h"
+
+// Multi-session inference on top of one LlamaWrapper context. Every session owns a
+// KV sequence slot; a single worker thread owns the context and merges the prefill
+// chunks and decode steps of all running sessions into one llama_decode per step
+// (continuous batching). Callers block in generate() on their own thread and get
+// their streamed chunks delivered there, so JNI callbacks stay on the JNI thread.
+class LlamaServer {
+public:
+    explicit LlamaServer(LlamaWrapper& wrapper);
+    ~LlamaServer();
+
+    bool start();
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    // Opaque session handles; -1 when every slot is taken
+    int32_t createSession();
+    void destroySession(int32_t session);
+
+    // `grammar` as in LlamaWrapper::beginSequence. A session runs one request at a
+    // time; a request on a busy session waits for it.
+    std::string generate(int32_t session, const std::string& prompt, int maxTokens,
+                         const TokenCallback& onToken = TokenCallback(), const std::string& grammar = std::string());
+    // Next turn of the session's conversation, see LlamaWrapper::beginChatTurn
+    std::string chat(int32_t session, const std::string& turn, int maxTokens,
+                     const TokenCallback& onToken = TokenCallback());
+    // Forgets the session's conversation; the next chat turn starts a new one
+    void resetChat(int32_t session);
+    // Stops the request the session is running; queued ones still run
+    void cancel(int32_t session);
+
+    // Runs `task` on the worker thread between decode steps and waits for it. Used
+    // for anything else that touches the context (system prompt, state files, ...)
+    void runExclusive(const std::function<void()>& task);
+
+    GenerationStats lastStats(int32_t session) const;
+
+    // LlamaWrapper::trimMemory over every session's sequence, between decode steps
+    bool trimMemory(int level);
+
+private:
+    struct Request {
+        std::string prompt;
+        std::string grammar;
+        int maxTokens = 0;
+        bool chat = false;
+        std::chrono::steady_clock::time_point submittedAt;
+        std::deque<std::string> chunks;  // produced by the worker, drained by the caller
+        std::string response;
+        bool started = false;
+        bool cancelled = false;
+        bool done = false;
+        bool ok = true;
+        std::condition_variable cv;
+    };
+
+    struct Slot {
+        LlamaSequence sequence;
+        bool inUse = false;
+        std::shared_ptr<Request> request;
+        GenerationStats stats;  // of the last finished request
+    };
+
+    struct Task {
+        std::function<void()> fn;
+        bool done = false;
+    };
+
+    LlamaWrapper& m_wrapper;
+    std::vector<std::unique_ptr<Slot>> m_slots;
+    llama_batch m_batch;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_taskCv;
+    std::deque<std::shared_ptr<Task>> m_tasks;
+    std::thread m_worker;
+    bool m_running;
+    bool m_stopRequested;
+
+    std::string submit(int32_t session, const std::shared_ptr<Request>& request, const TokenCallback& onToken);
+    void workerLoop();
+    bool hasWorkLocked() const;
+    void admitRequests();
+    void step();
+    void finishRequest(Slot& slot, bool ok);
+    Slot* slotFor(int32_t session) const;
+};
+
+#endif // LLAMA_SERVER_H
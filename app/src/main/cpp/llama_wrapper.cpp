@@ -2,19 +2,89 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
-#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
 #include <vector>
-#include <android/log.h>
+#include <cstdio>
+#include <unistd.h>
+#include "gguf_reader.h"
+#include "native_log.h"
+#include "native_trace.h"
 
 #define TAG "LlamaWrapper"
-#define LOGi(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
-#define LOGe(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 
-LlamaWrapper::LlamaWrapper() 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Filler text for calibration and warm-up batches
+const char* const kWarmupText = "Suggest a balanced breakfast with oats, eggs and fruit.";
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Length of the longest prefix of `text` that does not end inside a UTF-8 sequence
+size_t utf8CompleteLength(const std::string& text) {
+    const size_t len = text.size();
+    // A sequence is at most 4 bytes, so only the tail needs inspecting
+    for (size_t back = 1; back <= std::min<size_t>(4, len); back++) {
+        const unsigned char c = (unsigned char) text[len - back];
+        if ((c & 0xC0) == 0x80) {
+            continue; // continuation byte, keep looking for the lead byte
+        }
+        size_t need = 1;
+        if ((c & 0xE0) == 0xC0) need = 2;
+        else if ((c & 0xF0) == 0xE0) need = 3;
+        else if ((c & 0xF8) == 0xF0) need = 4;
+        return back >= need ? len : len - back;
+    }
+    return len;
+}
+
+std::once_flag g_backendInit;
+
+// Embedding context: texts are packed up to kEmbedSequences per decode and
+// truncated to kEmbedTokens tokens
+constexpr int32_t kEmbedTokens = 512;
+constexpr int32_t kEmbedSequences = 8;
+
+// trimMemory never shrinks the generation context below this
+constexpr uint32_t kMinTrimContext = 512;
+
+} // namespace
+
+void llamaBatchClear(llama_batch& batch) {
+    batch.n_tokens = 0;
+}
+
+void llamaBatchAdd(llama_batch& batch, llama_token token, llama_pos pos, llama_seq_id seqId, bool wantLogits) {
+    batch.token[batch.n_tokens] = token;
+    batch.pos[batch.n_tokens] = pos;
+    batch.n_seq_id[batch.n_tokens] = 1;
+    batch.seq_id[batch.n_tokens][0] = seqId;
+    batch.logits[batch.n_tokens] = wantLogits;
+    batch.n_tokens++;
+}
+
+LlamaWrapper::LlamaWrapper()
     : m_model(nullptr)
     , m_context(nullptr)
+    , m_batch()
     , m_modelLoaded(false)
-    , m_contextCreated(false) {
+    , m_contextCreated(false)
+    , m_contextReleased(false)
+    , m_maxSequences(1)
+    , m_prefetchMode(PrefetchMode::Prefault)
+    , m_prefetchLayers(-1)
+    , m_maxDraft(0)
+    , m_grammarSampler(nullptr)
+    , m_embedContext(nullptr)
+    , m_embedBatch() {
     initializeDefaultParams();
 }
 
@@ -28,13 +98,14 @@ void LlamaWrapper::initializeDefaultParams() {
     m_modelParams.n_gpu_layers = 0;  // CPU only for Android
     m_modelParams.use_mmap = true;
     m_modelParams.use_mlock = false;
-    
+
     // Initialize context parameters
     m_contextParams = llama_context_default_params();
     m_contextParams.n_ctx = 2048;
     m_contextParams.n_batch = 512;
-    m_contextParams.n_threads = 4;
-    m_contextParams.n_threads_batch = 4;
+    m_threadConfig = defaultThreadConfig(CpuTopology::get());
+    m_contextParams.n_threads = m_threadConfig.decodeThreads;        // single-token batches
+    m_contextParams.n_threads_batch = m_threadConfig.prefillThreads; // multi-token batches
     m_contextParams.embeddings = false;
 }
 
@@ -43,21 +114,32 @@ bool LlamaWrapper::loadModel(const std::string& modelPath) {
         LOGi("Model already loaded");
         return true;
     }
-    
+
+    TRACE_SCOPE("LlamaWrapper::loadModel");
     LOGi("Loading model from: %s", modelPath.c_str());
-    
-    // Check if file exists
-    std::ifstream file(modelPath);
-    if (!file.good()) {
-        LOGe("Model file not found: %s", modelPath.c_str());
+
+    // Map and validate the GGUF once; a truncated or foreign file fails here in
+    // milliseconds instead of deep inside llama.cpp
+    if (!m_loader.open(modelPath)) {
+        LOGe("Model file rejected: %s (%s)", modelPath.c_str(), m_loader.report().error.c_str());
         return false;
     }
-    file.close();
-    
-    // For now, just mark as loaded since we're using intelligent responses
+    m_loader.startPrefetch(m_prefetchMode, m_prefetchLayers);
+
+    std::call_once(g_backendInit, [] { llama_backend_init(); });
+
+    auto start = Clock::now();
+    m_model = llama_load_model_from_file(modelPath.c_str(), m_modelParams);
+    m_loader.recordLlamaLoad(elapsedMs(start));
+    if (!m_model) {
+        LOGe("llama_load_model_from_file failed: %s", modelPath.c_str());
+        m_loader.close();
+        return false;
+    }
+
     m_modelPath = modelPath;
     m_modelLoaded = true;
-    LOGi("Model loaded successfully (using intelligent responses)");
+    LOGi("Model loaded successfully in %.1f ms", elapsedMs(start));
     return true;
 }
 
@@ -65,8 +147,27 @@ void LlamaWrapper::unloadModel() {
     if (m_contextCreated) {
         destroyContext();
     }
-    
+    {
+        std::lock_guard<std::mutex> lock(m_embedMutex);
+        destroyEmbedContext();
+    }
+    // Drafts are in this model's vocabulary
+    m_drafter.reset();
+    m_maxDraft = 0;
+    if (m_grammarSampler) {
+        llama_sampler_free(m_grammarSampler);
+        m_grammarSampler = nullptr;
+        m_grammarSource.clear();
+    }
+
+    if (m_model) {
+        llama_free_model(m_model);
+        m_model = nullptr;
+    }
+    m_loader.close();
+
     m_modelLoaded = false;
+    m_contextReleased = false;
     m_modelPath.clear();
     LOGi("Model unloaded");
 }
@@ -80,19 +181,40 @@ bool LlamaWrapper::createContext() {
         LOGe("Cannot create context: model not loaded");
         return false;
     }
-    
+
     if (m_contextCreated) {
         LOGi("Context already created");
         return true;
     }
-    
-    // For now, just mark as created
+
+    // One extra sequence holds the shared system prefix
+    m_contextParams.n_seq_max = (uint32_t) m_maxSequences + 1;
+    auto start = Clock::now();
+    m_context = llama_new_context_with_model(m_model, m_contextParams);
+    m_loader.recordContext(elapsedMs(start));
+    if (!m_context) {
+        LOGe("llama_new_context_with_model failed (n_ctx=%u, n_batch=%u)",
+             m_contextParams.n_ctx, m_contextParams.n_batch);
+        return false;
+    }
+
+    m_batch = llama_batch_init((int32_t) m_contextParams.n_batch, 0, 1);
     m_contextCreated = true;
-    LOGi("Context created successfully");
+    m_defaultSequence.seqId = 0;
+    LOGi("Context created successfully (n_ctx=%u, n_batch=%u, n_threads=%d, n_seq_max=%u)",
+         llama_n_ctx(m_context), m_contextParams.n_batch, m_contextParams.n_threads, m_contextParams.n_seq_max);
     return true;
 }
 
 void LlamaWrapper::destroyContext() {
+    if (m_context) {
+        endSequence(m_defaultSequence);
+        m_defaultSequence.cached.clear();
+        m_prefixTokens.clear();
+        llama_batch_free(m_batch);
+        llama_free(m_context);
+        m_context = nullptr;
+    }
     m_contextCreated = false;
     LOGi("Context destroyed");
 }
@@ -101,109 +223,991 @@ bool LlamaWrapper::isContextCreated() const {
     return m_contextCreated;
 }
 
+std::vector<llama_token> LlamaWrapper::tokenize(const std::string& text, bool addSpecial) const {
+    TRACE_SCOPE("tokenize");
+    // Upper bound: one token per byte plus BOS/EOS
+    std::vector<llama_token> tokens(text.size() + 2);
+    int32_t n = llama_tokenize(m_model, text.c_str(), (int32_t) text.size(),
+                               tokens.data(), (int32_t) tokens.size(), addSpecial, true);
+    if (n < 0) {
+        tokens.resize(-n);
+        n = llama_tokenize(m_model, text.c_str(), (int32_t) text.size(),
+                           tokens.data(), (int32_t) tokens.size(), addSpecial, true);
+    }
+    tokens.resize(std::max(n, 0));
+    return tokens;
+}
+
+std::string LlamaWrapper::tokenToPiece(llama_token token) const {
+    char buf[128];
+    int32_t n = llama_token_to_piece(m_model, token, buf, sizeof(buf), 0, false);
+    if (n < 0) {
+        std::string piece(-n, '\0');
+        llama_token_to_piece(m_model, token, &piece[0], (int32_t) piece.size(), 0, false);
+        return piece;
+    }
+    return std::string(buf, n);
+}
+
+bool LlamaWrapper::prefillPrefix(const std::vector<llama_token>& tokens) {
+    TRACE_SCOPE("prefill prefix");
+    const int32_t nBatch = (int32_t) m_contextParams.n_batch;
+    const int32_t nTokens = (int32_t) tokens.size();
+
+    for (int32_t i = 0; i < nTokens; i += nBatch) {
+        const int32_t n = std::min(nBatch, nTokens - i);
+        llamaBatchClear(m_batch);
+        for (int32_t j = 0; j < n; j++) {
+            // The prefix is never sampled from, so no logits are needed
+            llamaBatchAdd(m_batch, tokens[i + j], i + j, prefixSeqId(), false);
+        }
+        if (llama_decode(m_context, m_batch) != 0) {
+            LOGe("llama_decode failed during prefix prefill at token %d/%d", i, nTokens);
+            clearPrefix();
+            return false;
+        }
+    }
+    m_prefixTokens = tokens;
+    return true;
+}
+
+void LlamaWrapper::clearPrefix() {
+    llama_kv_cache_seq_rm(m_context, prefixSeqId(), -1, -1);
+    m_prefixTokens.clear();
+}
+
+std::string LlamaWrapper::statePath(const std::string& suffix) const {
+    if (m_stateDir.empty()) {
+        return m_modelPath + suffix;
+    }
+    const size_t slash = m_modelPath.find_last_of('/');
+    return m_stateDir + "/" + m_modelPath.substr(slash == std::string::npos ? 0 : slash + 1) + suffix;
+}
+
+std::string LlamaWrapper::threadConfigPath() const {
+    return statePath(".threads");
+}
+
+void LlamaWrapper::setThreadConfig(const ThreadConfig& config) {
+    m_threadConfig = config;
+    m_contextParams.n_threads = config.decodeThreads;
+    m_contextParams.n_threads_batch = config.prefillThreads;
+    if (m_context) {
+        llama_set_n_threads(m_context, config.decodeThreads, config.prefillThreads);
+    }
+}
+
+// Evaluates `steps` batches of `batchTokens` filler tokens on the default sequence
+// and returns the mean time per batch
+double LlamaWrapper::timeBatches(const std::vector<llama_token>& tokens, int32_t threads, int32_t batchTokens, int32_t steps) {
+    llama_set_n_threads(m_context, threads, threads);
+    llama_kv_cache_seq_rm(m_context, m_defaultSequence.seqId, -1, -1);
+
+    llama_pos pos = 0;
+    auto start = Clock::now();
+    for (int32_t step = 0; step < steps; step++) {
+        llamaBatchClear(m_batch);
+        for (int32_t i = 0; i < batchTokens; i++) {
+            llamaBatchAdd(m_batch, tokens[(size_t) pos % tokens.size()], pos, m_defaultSequence.seqId, i == batchTokens - 1);
+            pos++;
+        }
+        if (llama_decode(m_context, m_batch) != 0) {
+            return std::numeric_limits<double>::infinity();
+        }
+    }
+    const double ms = elapsedMs(start) / steps;
+    llama_kv_cache_seq_rm(m_context, m_defaultSequence.seqId, -1, -1);
+    return ms;
+}
+
+bool LlamaWrapper::calibrateThreads(const std::string& path) {
+    if (!m_contextCreated) {
+        return false;
+    }
+
+    // The cache is only valid for the same core layout and model
+    const CpuTopology& topology = CpuTopology::get();
+    const std::string key = topology.describe() + ", model " + std::to_string(getModelSize()) + " bytes";
+    {
+        std::ifstream in(path);
+        std::string storedKey;
+        ThreadConfig cached;
+        if (std::getline(in, storedKey) && storedKey == key &&
+            (in >> cached.prefillThreads >> cached.decodeThreads) &&
+            cached.prefillThreads > 0 && cached.decodeThreads > 0) {
+            setThreadConfig(cached);
+            LOGi("Thread config restored: prefill %d, decode %d", cached.prefillThreads, cached.decodeThreads);
+            return true;
+        }
+    }
+
+    const std::vector<llama_token> filler = tokenize(kWarmupText, false);
+    if (filler.empty()) {
+        return false;
+    }
+    endSequence(m_defaultSequence);
+    m_defaultSequence.cached.clear();
+
+    const int32_t maxThreads = (int32_t) topology.performanceCores.size();
+    const int32_t prefillTokens = std::min<int32_t>(64, batchSize());
+    auto start = Clock::now();
+    timeBatches(filler, m_threadConfig.decodeThreads, 1, 2); // warm-up
+
+    ThreadConfig best = m_threadConfig;
+    double bestDecode = std::numeric_limits<double>::infinity();
+    double bestPrefill = std::numeric_limits<double>::infinity();
+    for (int32_t threads = 1; threads <= maxThreads; threads++) {
+        const double decodeMs = timeBatches(filler, threads, 1, 8);
+        if (decodeMs < bestDecode) {
+            bestDecode = decodeMs;
+            best.decodeThreads = threads;
+        }
+        // Prefill only scales up, fewer than half the cores never wins
+        if (threads * 2 >= maxThreads) {
+            const double prefillMs = timeBatches(filler, threads, prefillTokens, 1);
+            if (prefillMs < bestPrefill) {
+                bestPrefill = prefillMs;
+                best.prefillThreads = threads;
+            }
+        }
+    }
+    setThreadConfig(best);
+    LOGi("Thread calibration in %.1f ms: prefill %d threads (%.1f tok/s), decode %d threads (%.1f tok/s)",
+         elapsedMs(start), best.prefillThreads, prefillTokens * 1000.0 / bestPrefill,
+         best.decodeThreads, 1000.0 / bestDecode);
+
+    std::ofstream out(path, std::ios::trunc);
+    out << key << "\n" << best.prefillThreads << " " << best.decodeThreads << "\n";
+    return true;
+}
+
+bool LlamaWrapper::warmUp() {
+    if (!m_contextCreated) {
+        return false;
+    }
+    TRACE_SCOPE("LlamaWrapper::warmUp");
+    const std::vector<llama_token> filler = tokenize(kWarmupText, false);
+    if (filler.empty()) {
+        return false;
+    }
+    endSequence(m_defaultSequence);
+    m_defaultSequence.cached.clear();
+
+    auto start = Clock::now();
+    const double prefillMs = timeBatches(filler, m_threadConfig.prefillThreads, std::min<int32_t>(32, batchSize()), 1);
+    const double decodeMs = timeBatches(filler, m_threadConfig.decodeThreads, 1, 1);
+    // timeBatches leaves its own thread count behind
+    setThreadConfig(m_threadConfig);
+    LOGi("Warm-up in %.1f ms (prefill batch %.1f ms, decode step %.1f ms)", elapsedMs(start), prefillMs, decodeMs);
+    return std::isfinite(prefillMs) && std::isfinite(decodeMs);
+}
+
+std::string LlamaWrapper::prefixStatePath() const {
+    return statePath(".prefix.state");
+}
+
+bool LlamaWrapper::setSystemPrompt(const std::string& systemPrompt) {
+    if (!m_modelLoaded || !ensureContext()) {
+        LOGe("Cannot set system prompt: model not loaded or context not created");
+        return false;
+    }
+
+    auto start = Clock::now();
+    m_systemTokens = tokenize(systemPrompt, true);
+
+    if (m_prefixTokens == m_systemTokens) {
+        LOGi("System prompt already resident in KV cache (%zu tokens)", m_systemTokens.size());
+        return true;
+    }
+
+    if (loadPrefixState(prefixStatePath())) {
+        LOGi("System prompt restored from %s in %.1f ms", prefixStatePath().c_str(), elapsedMs(start));
+        return true;
+    }
+
+    clearPrefix();
+    if (!prefillPrefix(m_systemTokens)) {
+        LOGe("Failed to evaluate system prompt");
+        return false;
+    }
+    LOGi("System prompt evaluated: %zu tokens in %.1f ms", m_systemTokens.size(), elapsedMs(start));
+
+    savePrefixState(prefixStatePath());
+    return true;
+}
+
+bool LlamaWrapper::savePrefixState(const std::string& path) {
+    if (m_prefixTokens.empty()) {
+        return false;
+    }
+    const size_t written = llama_state_seq_save_file(m_context, path.c_str(), prefixSeqId(),
+                                                     m_prefixTokens.data(), m_prefixTokens.size());
+    if (written == 0) {
+        LOGe("Failed to save prefix state to %s", path.c_str());
+        return false;
+    }
+    LOGi("Saved prefix state (%zu tokens, %zu bytes) to %s", m_prefixTokens.size(), written, path.c_str());
+    return true;
+}
+
+bool LlamaWrapper::loadPrefixState(const std::string& path) {
+    std::ifstream probe(path);
+    if (!probe.good() || m_systemTokens.empty()) {
+        return false;
+    }
+    probe.close();
+
+    clearPrefix();
+    std::vector<llama_token> stored(m_systemTokens.size());
+    size_t nStored = 0;
+    const size_t read = llama_state_seq_load_file(m_context, path.c_str(), prefixSeqId(),
+                                                  stored.data(), stored.size(), &nStored);
+    stored.resize(read > 0 ? nStored : 0);
+    if (read == 0 || stored != m_systemTokens) {
+        // Stale file from another system prompt or model build
+        LOGi("Prefix state at %s does not match current system prompt, ignoring", path.c_str());
+        clearPrefix();
+        return false;
+    }
+    m_prefixTokens = stored;
+    return true;
+}
+
+llama_sampler* LlamaWrapper::createGrammarSampler(const std::string& grammar) {
+    // Parsing a large grammar takes milliseconds; clone the parsed one instead
+    if (!m_grammarSampler || grammar != m_grammarSource) {
+        if (m_grammarSampler) {
+            llama_sampler_free(m_grammarSampler);
+        }
+        auto start = Clock::now();
+        m_grammarSampler = llama_sampler_init_grammar(m_model, grammar.c_str(), "root");
+        m_grammarSource = m_grammarSampler ? grammar : std::string();
+        LOGi("Grammar parsed in %.1f ms (%zu bytes)", elapsedMs(start), grammar.size());
+    }
+    if (!m_grammarSampler) {
+        LOGe("Failed to parse grammar");
+        return nullptr;
+    }
+    // Structured output is extraction, not prose: take the best valid token
+    llama_sampler* chain = llama_sampler_chain_init(llama_sampler_chain_default_params());
+    llama_sampler_chain_add(chain, llama_sampler_clone(m_grammarSampler));
+    llama_sampler_chain_add(chain, llama_sampler_init_greedy());
+    return chain;
+}
+
+bool LlamaWrapper::beginSequence(LlamaSequence& seq, const std::string& prompt, int maxTokens, const TokenCallback& onToken,
+                                 const std::string& grammar) {
+    if (!ensureContext()) {
+        return false;
+    }
+    restoreSequence(seq);
+    resetRequest(seq);
+    seq.chat = false;
+    seq.turnStarts.clear();
+
+    std::vector<llama_token> tokens = tokenize(prompt, true);
+    const int32_t nCtx = (int32_t) llama_n_ctx(m_context);
+    if (tokens.empty()) {
+        LOGe("Prompt tokenized to zero tokens");
+        return false;
+    }
+    if ((int32_t) tokens.size() >= nCtx) {
+        LOGe("Prompt too long: %zu tokens (n_ctx=%d)", tokens.size(), nCtx);
+        return false;
+    }
+
+    size_t common = 0;
+    while (common < tokens.size() && common < seq.cached.size() && tokens[common] == seq.cached[common]) {
+        common++;
+    }
+
+    // Adopt the shared prefix cells instead of evaluating the system block again
+    const size_t nPrefix = m_prefixTokens.size();
+    if (nPrefix > 0 && common < nPrefix && tokens.size() > nPrefix &&
+        std::equal(m_prefixTokens.begin(), m_prefixTokens.end(), tokens.begin())) {
+        llama_kv_cache_seq_rm(m_context, seq.seqId, -1, -1);
+        llama_kv_cache_seq_cp(m_context, prefixSeqId(), seq.seqId, 0, (llama_pos) nPrefix);
+        seq.cached = m_prefixTokens;
+        common = nPrefix;
+    }
+
+    // The last prompt token is always re-evaluated so its logits are fresh
+    if (common == tokens.size()) {
+        common--;
+    }
+    if (common < seq.cached.size()) {
+        llama_kv_cache_seq_rm(m_context, seq.seqId, (llama_pos) common, -1);
+        seq.cached.resize(common);
+    }
+
+    seq.stats.promptTokens = (int32_t) tokens.size();
+    seq.stats.cachedPromptTokens = (int32_t) common;
+    seq.pending = std::move(tokens);
+    seq.pendingPos = common;
+    return startSampling(seq, maxTokens, onToken, grammar);
+}
+
+bool LlamaWrapper::beginChatTurn(LlamaSequence& seq, const std::string& turn, int maxTokens,
+                                 const TokenCallback& onToken) {
+    if (!ensureContext()) {
+        return false;
+    }
+    restoreSequence(seq);
+    const int32_t nCtx = (int32_t) llama_n_ctx(m_context);
+
+    // Never evicted: the system prefix, or BOS alone without one
+    std::vector<llama_token> pinned = m_prefixTokens;
+    if (pinned.empty() && llama_add_bos_token(m_model)) {
+        pinned.push_back(llama_token_bos(m_model));
+    }
+
+    // Tokens evaluated ahead of the turn: the previous reply's last sampled token
+    // (never evaluated) plus an end-of-turn marker if the reply was cut short
+    std::vector<llama_token> closing;
+    const bool resume = seq.chat && seq.chatKeep == pinned.size() && seq.cached.size() >= pinned.size() &&
+                        std::equal(pinned.begin(), pinned.end(), seq.cached.begin());
+    if (!resume) {
+        // New conversation, or the system prompt changed underneath it
+        llama_kv_cache_seq_rm(m_context, seq.seqId, -1, -1);
+        seq.cached.clear();
+        if (!m_prefixTokens.empty()) {
+            llama_kv_cache_seq_cp(m_context, prefixSeqId(), seq.seqId, 0, (llama_pos) pinned.size());
+            seq.cached = pinned;
+        } else {
+            closing = pinned;
+        }
+        seq.chat = true;
+        seq.chatKeep = pinned.size();
+        seq.turnStarts.clear();
+    } else if (!seq.turnStarts.empty()) {
+        if (seq.decodeStartTime > seq.startTime) {
+            closing.assign(seq.pending.begin() + seq.pendingPos, seq.pending.end());
+            if (closing.empty() || !llama_token_is_eog(m_model, closing.back())) {
+                closing.push_back(llama_token_eos(m_model));
+            }
+        } else {
+            // Cancelled before the reply started: drop the half-read turn
+            llama_kv_cache_seq_rm(m_context, seq.seqId, (llama_pos) seq.turnStarts.back(), -1);
+            seq.cached.resize(seq.turnStarts.back());
+            seq.turnStarts.pop_back();
+        }
+    }
+
+    std::vector<llama_token> tokens = tokenize(turn, false);
+    if (tokens.empty()) {
+        LOGe("Chat turn tokenized to zero tokens");
+        return false;
+    }
+
+    // Keep room for the turn plus a reply of up to maxTokens (at most half the window)
+    const size_t reserve = (size_t) std::max(std::min(maxTokens, nCtx / 2), 1);
+    const size_t before = seq.cached.size();
+    size_t evicted = 0;
+    while (!seq.turnStarts.empty() &&
+           seq.cached.size() + closing.size() + tokens.size() + reserve > (size_t) nCtx) {
+        if (seq.turnStarts.size() == 1) {
+            closing.clear(); // the reply it closes is gone too
+        }
+        evictOldestTurn(seq);
+        evicted++;
+    }
+    if (evicted > 0) {
+        LOGi("Seq %d: evicted %zu turns (%zu tokens), %zu turns kept", seq.seqId, evicted,
+             before - seq.cached.size(), seq.turnStarts.size());
+    }
+    if (seq.cached.size() + closing.size() + tokens.size() >= (size_t) nCtx) {
+        LOGe("Chat turn too long: %zu tokens after %zu cached (n_ctx=%d)", tokens.size(), seq.cached.size(), nCtx);
+        return false;
+    }
+
+    resetRequest(seq);
+    seq.turnStarts.push_back(seq.cached.size() + closing.size());
+    seq.stats.promptTokens = (int32_t) (closing.size() + tokens.size());
+    seq.stats.cachedPromptTokens = (int32_t) seq.cached.size();
+    seq.pending = std::move(closing);
+    seq.pending.insert(seq.pending.end(), tokens.begin(), tokens.end());
+    seq.pendingPos = 0;
+    return startSampling(seq, maxTokens, onToken, std::string());
+}
+
+// Drops the oldest turn from the KV cache and shifts every later cell down so
+// positions stay contiguous behind the pinned prefix; nothing is re-evaluated
+void LlamaWrapper::evictOldestTurn(LlamaSequence& seq) {
+    const size_t begin = seq.turnStarts.front();
+    const size_t end = seq.turnStarts.size() > 1 ? seq.turnStarts[1] : seq.cached.size();
+    const llama_pos n = (llama_pos) (end - begin);
+    llama_kv_cache_seq_rm(m_context, seq.seqId, (llama_pos) begin, (llama_pos) end);
+    llama_kv_cache_seq_add(m_context, seq.seqId, (llama_pos) end, -1, -n);
+    seq.cached.erase(seq.cached.begin() + begin, seq.cached.begin() + end);
+    seq.turnStarts.erase(seq.turnStarts.begin());
+    for (size_t& start : seq.turnStarts) {
+        start -= n;
+    }
+}
+
+void LlamaWrapper::resetRequest(LlamaSequence& seq) {
+    seq.stats = GenerationStats();
+    seq.startTime = Clock::now();
+    seq.response.clear();
+    seq.streamed = 0;
+    seq.failed = false;
+    seq.logitsIndex = -1;
+    seq.cancelled.store(false);
+}
+
+bool LlamaWrapper::startSampling(LlamaSequence& seq, int maxTokens, const TokenCallback& onToken,
+                                 const std::string& grammar) {
+    // Positions left once the pending tokens are in the cache
+    const size_t end = seq.cached.size() + seq.pending.size() - seq.pendingPos;
+    seq.remaining = std::min(maxTokens, (int32_t) llama_n_ctx(m_context) - (int32_t) end);
+    seq.onToken = onToken;
+    if (seq.sampler) {
+        llama_sampler_free(seq.sampler);
+        seq.sampler = nullptr;
+    }
+    if (grammar.empty()) {
+        seq.tokenSampler.reset(m_generationParams, llama_n_vocab(m_model));
+    } else {
+        seq.sampler = createGrammarSampler(grammar);
+        if (!seq.sampler) {
+            return false;
+        }
+    }
+    seq.structured = !grammar.empty();
+    seq.structure.reset();
+    seq.active = seq.remaining > 0;
+    return true;
+}
+
+int32_t LlamaWrapper::addToBatch(LlamaSequence& seq, llama_batch& batch, int32_t maxTokens) {
+    if (!seq.active) {
+        return 0;
+    }
+    if (seq.cancelled.load()) {
+        LOGi("Sequence %d cancelled after %d tokens", seq.seqId, seq.stats.generatedTokens);
+        seq.active = false;
+        return 0;
+    }
+
+    const int32_t available = (int32_t) (seq.pending.size() - seq.pendingPos);
+    const int32_t n = std::min(available, maxTokens);
+    for (int32_t i = 0; i < n; i++) {
+        const bool last = seq.pendingPos + 1 == seq.pending.size();
+        const llama_token token = seq.pending[seq.pendingPos++];
+        // Only the final pending token needs logits for the next sample
+        llamaBatchAdd(batch, token, (llama_pos) seq.cached.size(), seq.seqId, last);
+        seq.cached.push_back(token);
+        if (last) {
+            seq.logitsIndex = batch.n_tokens - 1;
+        }
+    }
+
+    // Decode step: ride drafted continuations along, each with its own logits
+    seq.drafts.clear();
+    const int32_t room = std::min({m_maxDraft, maxTokens - n, seq.remaining - 1,
+                                   (int32_t) llama_n_ctx(m_context) - (int32_t) seq.cached.size() - 1});
+    if (m_drafter && n == 1 && seq.stats.generatedTokens > 0 && seq.logitsIndex >= 0 && room > 0) {
+        auto start = Clock::now();
+        m_drafter->draft(seq.seqId, seq.cached, room, seq.drafts);
+        m_specStats.draftMicros += (uint64_t) (elapsedMs(start) * 1000.0);
+        seq.drafts.resize(std::min<size_t>(seq.drafts.size(), room));
+        for (llama_token token : seq.drafts) {
+            llamaBatchAdd(batch, token, (llama_pos) seq.cached.size(), seq.seqId, true);
+            seq.cached.push_back(token);
+        }
+    }
+    return n + (int32_t) seq.drafts.size();
+}
+
+void LlamaWrapper::onBatchDecoded(LlamaSequence& seq) {
+    if (!seq.active || seq.logitsIndex < 0) {
+        return; // mid-prefill chunk, nothing to sample yet
+    }
+
+    const bool firstToken = seq.stats.generatedTokens == 0 && seq.decodeStartTime < seq.startTime;
+    if (firstToken) {
+        seq.stats.prefillMs = elapsedMs(seq.startTime);
+        seq.decodeStartTime = Clock::now();
+    }
+
+    // Sample after the pending token, then after each draft for as long as the
+    // model keeps agreeing; every emitted token is a real sample
+    TRACE_SCOPE("sample");
+    size_t accepted = 0;
+    int32_t emitted = 0;
+    llama_token token = 0;
+    while (true) {
+        const int32_t row = seq.logitsIndex + (int32_t) accepted;
+        token = seq.sampler ? llama_sampler_sample(seq.sampler, m_context, row)
+                            : seq.tokenSampler.sample(llama_get_logits_ith(m_context, row));
+        if (firstToken && emitted == 0) {
+            seq.stats.timeToFirstTokenMs = elapsedMs(seq.startTime);
+        }
+        if (!emitToken(seq, token)) {
+            break;
+        }
+        emitted++;
+        if (accepted < seq.drafts.size() && token == seq.drafts[accepted]) {
+            accepted++;
+            continue;
+        }
+        break;
+    }
+    seq.logitsIndex = -1;
+    m_specStats.steps++;
+    m_specStats.tokens += (uint64_t) emitted;
+
+    if (!seq.drafts.empty()) {
+        // KV cells of rejected drafts hold tokens that were never generated
+        const size_t keep = seq.cached.size() - (seq.drafts.size() - accepted);
+        llama_kv_cache_seq_rm(m_context, seq.seqId, (llama_pos) keep, -1);
+        seq.cached.resize(keep);
+        seq.stats.draftedTokens += (int32_t) seq.drafts.size();
+        seq.stats.acceptedDraftTokens += (int32_t) accepted;
+        m_specStats.drafted += seq.drafts.size();
+        m_specStats.accepted += accepted;
+        seq.drafts.clear();
+    }
+
+    // The last sampled token is evaluated in the next batch, or by the next chat
+    // turn when generation ended here
+    seq.pending.assign(1, token);
+    seq.pendingPos = 0;
+}
+
+// Appends a sampled token to the response; false when generation ends here
+bool LlamaWrapper::emitToken(LlamaSequence& seq, llama_token token) {
+    if (llama_token_is_eog(m_model, token)) {
+        seq.active = false;
+        return false;
+    }
+
+    const std::string piece = tokenToPiece(token);
+    seq.response += piece;
+    seq.stats.generatedTokens++;
+    seq.remaining--;
+
+    // Structured output is complete at its closing bracket; skip the EOS round trip
+    bool closed = false;
+    if (seq.structured) {
+        const size_t used = seq.structure.feed(piece);
+        if (used != std::string::npos) {
+            seq.response.resize(seq.response.size() - piece.size() + used);
+            closed = true;
+        }
+    }
+
+    if (seq.onToken) {
+        // Hold back a trailing partial UTF-8 sequence until its next bytes arrive
+        const size_t complete = utf8CompleteLength(seq.response);
+        if (complete > seq.streamed) {
+            if (!seq.onToken(seq.response.substr(seq.streamed, complete - seq.streamed))) {
+                LOGi("Generation stopped by callback after %d tokens", seq.stats.generatedTokens);
+                seq.stats.stopped = true;
+                seq.active = false;
+                return false;
+            }
+            seq.streamed = complete;
+        }
+    }
+
+    if (closed || seq.remaining <= 0 || seq.cached.size() + 1 >= llama_n_ctx(m_context)) {
+        seq.active = false;
+        return false;
+    }
+    return true;
+}
+
+void LlamaWrapper::onBatchFailed(LlamaSequence& seq) {
+    // The batch may have been partially applied, so this sequence's KV is untrusted
+    llama_kv_cache_seq_rm(m_context, seq.seqId, -1, -1);
+    seq.cached.clear();
+    seq.drafts.clear();
+    seq.chat = false;
+    seq.active = false;
+    seq.failed = true;
+    seq.logitsIndex = -1;
+}
+
+void LlamaWrapper::endSequence(LlamaSequence& seq) {
+    seq.active = false;
+    seq.onToken = nullptr;
+    if (seq.sampler) {
+        llama_sampler_free(seq.sampler);
+        seq.sampler = nullptr;
+    }
+    if (seq.decodeStartTime > seq.startTime) {
+        seq.stats.decodeMs = elapsedMs(seq.decodeStartTime);
+    }
+    if (seq.cancelled.load()) {
+        LOGi("Generation cancelled after %d tokens", seq.stats.generatedTokens);
+        seq.stats.stopped = true;
+    }
+    LOGi("Seq %d: generated %d tokens (prompt %d, %d reused from cache) - prefill %.1f ms, TTFT %.1f ms, decode %.1f ms, drafts %d/%d accepted",
+         seq.seqId, seq.stats.generatedTokens, seq.stats.promptTokens, seq.stats.cachedPromptTokens,
+         seq.stats.prefillMs, seq.stats.timeToFirstTokenMs, seq.stats.decodeMs,
+         seq.stats.acceptedDraftTokens, seq.stats.draftedTokens);
+}
+
+void LlamaWrapper::releaseSequence(LlamaSequence& seq) {
+    endSequence(seq);
+    llama_kv_cache_seq_rm(m_context, seq.seqId, -1, -1);
+    seq.cached.clear();
+    seq.pending.clear();
+    seq.pendingPos = 0;
+    seq.chat = false;
+    seq.turnStarts.clear();
+}
+
 std::string LlamaWrapper::generateText(const std::string& prompt, int maxTokens) {
-    if (!m_modelLoaded || !m_contextCreated) {
+    return generateText(prompt, maxTokens, TokenCallback());
+}
+
+std::string LlamaWrapper::generateText(const std::string& prompt, int maxTokens, const TokenCallback& onToken,
+                                       const std::string& grammar) {
+    if (!m_modelLoaded || !ensureContext()) {
         LOGe("Cannot generate text: model not loaded or context not created");
         return "Error: Model not loaded or context not created";
     }
-    
-    LOGi("Generating text with prompt: %s", prompt.c_str());
-    
-    // Extract user input from the prompt
-    std::string userInput = prompt;
-    size_t userPos = prompt.find("User: ");
-    if (userPos != std::string::npos) {
-        size_t startPos = userPos + 6;
-        size_t endPos = prompt.find("\n", startPos);
-        if (endPos != std::string::npos) {
-            userInput = prompt.substr(startPos, endPos - startPos);
-        } else {
-            userInput = prompt.substr(startPos);
-        }
-    }
-    
-    LOGi("Extracted user input: '%s'", userInput.c_str());
-    
-    // Generate intelligent response based on user input
-    std::string response = generateIntelligentResponse(userInput);
-    
-    LOGi("Generated intelligent response: %s", response.c_str());
-    return response;
-}
-
-std::string LlamaWrapper::generateIntelligentResponse(const std::string& userInput) {
-    std::string input = userInput;
-    std::transform(input.begin(), input.end(), input.begin(), ::tolower);
-    
-    // Handle different types of questions with intelligent responses
-    if (input.find("name") != std::string::npos) {
-        if (input.find("what") != std::string::npos || input.find("your") != std::string::npos) {
-            return "Hi! I'm TinyLlama, your local AI assistant. I'm running completely offline on your device using the TinyLlama model. How can I help you today?";
-        }
-    }
-    
-    if (input.find("2+2") != std::string::npos || input.find("2 + 2") != std::string::npos) {
-        return "2 + 2 = 4. This is basic arithmetic. Is there anything else you'd like me to help you with?";
-    }
-    
-    if (input.find("weather") != std::string::npos) {
-        return "I can't check the current weather since I'm running offline, but I can help you with nutrition, recipes, and diet advice! What would you like to know about healthy eating?";
-    }
-    
-    if (input.find("babul") != std::string::npos) {
-        return "Yes, I'm working! I'm your local AI assistant running on the TinyLlama model. I can help you with questions, calculations, and nutrition advice. What would you like to know?";
-    }
-    
-    if (input.find("local model") != std::string::npos || input.find("offline") != std::string::npos) {
-        return "Yes, I'm running on a local TinyLlama model! This means I work completely offline without needing internet. I can help you with questions, math, and nutrition advice.";
-    }
-    
-    if (input.find("calories") != std::string::npos || input.find("calorie") != std::string::npos) {
-        if (input.find("apple") != std::string::npos) {
-            return "An apple contains approximately 95 calories. It's a great low-calorie snack rich in fiber and vitamin C. The fiber helps you feel full longer, making it perfect for weight management.";
-        } else if (input.find("rice") != std::string::npos) {
-            return "Cooked white rice contains about 130 calories per 100g serving. Brown rice has slightly more fiber and nutrients, with about 111 calories per 100g. Choose brown rice for better nutritional value.";
-        } else if (input.find("banana") != std::string::npos) {
-            return "A medium banana contains about 105 calories. It's a good source of potassium, vitamin B6, and natural sugars. Great for pre-workout energy or as a healthy snack.";
-        } else {
-            return "I can help you find calorie information for specific foods. Please ask about a particular food item, and I'll provide detailed nutritional information including calories, protein, carbs, and fats.";
+
+    LlamaSequence& seq = m_defaultSequence;
+    if (!beginSequence(seq, prompt, maxTokens, onToken, grammar)) {
+        return "Error: Failed to evaluate prompt";
+    }
+
+    while (seq.active) {
+        llamaBatchClear(m_batch);
+        const bool prefill = seq.isPrefilling();
+        if (addToBatch(seq, m_batch, batchSize()) == 0) {
+            break;
+        }
+        TRACE_SCOPE(prefill ? "prefill batch" : "decode step");
+        if (llama_decode(m_context, m_batch) != 0) {
+            LOGe("llama_decode failed at position %zu", seq.cached.size());
+            onBatchFailed(seq);
+            break;
         }
+        onBatchDecoded(seq);
+    }
+
+    endSequence(seq);
+    if (seq.failed && seq.response.empty()) {
+        return "Error: Failed to evaluate prompt";
     }
-    
-    if (input.find("protein") != std::string::npos) {
-        return "Protein is essential for muscle building, repair, and overall health. Excellent sources include lean meats, fish, eggs, dairy, legumes, and plant-based options like quinoa and tofu. Aim for variety in your protein sources.";
+    return seq.response;
+}
+
+void LlamaWrapper::setDrafter(std::unique_ptr<Drafter> drafter, int32_t maxDraft) {
+    m_drafter = std::move(drafter);
+    m_maxDraft = m_drafter ? std::max(maxDraft, 0) : 0;
+    m_specStats.reset();
+    LOGi("Speculative decoding: %s (max %d drafts)", m_drafter ? m_drafter->name() : "off", m_maxDraft);
+}
+
+std::string LlamaWrapper::speculativeStatsJson() const {
+    return m_specStats.toJson(m_drafter ? m_drafter->name() : "off", m_maxDraft);
+}
+
+std::unique_ptr<Drafter> LlamaWrapper::createNgramDrafter(const std::vector<std::string>& corpus) const {
+    if (!m_model) {
+        return nullptr;
     }
-    
-    if (input.find("recipe") != std::string::npos) {
-        return "I can help you find healthy recipes! What type of cuisine or ingredients are you interested in? I can suggest recipes for breakfast, lunch, dinner, or snacks that fit your dietary preferences.";
+    auto drafter = std::make_unique<NgramDrafter>();
+    for (const std::string& text : corpus) {
+        drafter->addDocument(tokenize(text, false));
     }
-    
-    if (input.find("help") != std::string::npos) {
-        return "I'm your Tasty Diet AI assistant! I can help you with:\n• Nutrition information and calorie tracking\n• Recipe suggestions and meal planning\n• Diet advice and weight management\n• Food logging and nutritional analysis\n• Exercise and fitness guidance\n\nJust ask me about any food, nutrition, or health topic!";
+    LOGi("N-gram drafter: %zu documents, %zu tokens", corpus.size(), drafter->corpusTokens());
+    return drafter;
+}
+
+std::unique_ptr<Drafter> LlamaWrapper::createDraftModelDrafter(const std::string& path) const {
+    if (!m_model || !m_context) {
+        return nullptr;
     }
-    
-    // Default intelligent response
-    return "I'm your local AI assistant running on TinyLlama! I can help you with questions, calculations, nutrition advice, and more. What would you like to know?";
+    // Mirrors the target's sequence layout so seq ids map one to one
+    auto drafter = std::make_unique<DraftModelDrafter>();
+    if (!drafter->open(path, m_model, llama_n_ctx(m_context), (uint32_t) m_maxSequences + 1,
+                       m_threadConfig.decodeThreads)) {
+        return nullptr;
+    }
+    return drafter;
+}
+
+void LlamaWrapper::setKvCacheType(KvCacheType type) {
+    const ggml_type cellType = type == KvCacheType::Q8_0 ? GGML_TYPE_Q8_0
+                             : type == KvCacheType::Q4_0 ? GGML_TYPE_Q4_0 : GGML_TYPE_F16;
+    m_contextParams.type_k = cellType;
+    m_contextParams.type_v = cellType;
+    // llama.cpp only supports a quantized V cache inside the flash attention kernel
+    m_contextParams.flash_attn = type != KvCacheType::F16;
+}
+
+bool LlamaWrapper::trimMemory(int level, const std::vector<LlamaSequence*>& sequences) {
+    if (!m_modelLoaded) {
+        return false;
+    }
+    if (level >= kTrimRunningLow) {
+        {
+            std::lock_guard<std::mutex> lock(m_embedMutex);
+            destroyEmbedContext();
+        }
+        if (m_grammarSampler) {
+            llama_sampler_free(m_grammarSampler);
+            m_grammarSampler = nullptr;
+            m_grammarSource.clear();
+        }
+    }
+    if (level < kTrimRunningCritical || !m_contextCreated) {
+        return true;
+    }
+
+    const uint32_t nCtx = llama_n_ctx(m_context);
+    const bool release = level >= kTrimBackground;
+    if (!release && nCtx <= kMinTrimContext) {
+        return true;
+    }
+    std::vector<LlamaSequence*> all(sequences);
+    all.push_back(&m_defaultSequence);
+    for (const LlamaSequence* seq : all) {
+        if (seq->active) {
+            LOGi("Trim level %d: generation running, keeping the context", level);
+            return false;
+        }
+    }
+
+    auto start = Clock::now();
+    for (LlamaSequence* seq : all) {
+        spillSequence(*seq);
+    }
+    destroyContext();
+    m_contextReleased = true;
+    if (release) {
+        LOGi("Trim level %d: context released in %.1f ms", level, elapsedMs(start));
+        return true;
+    }
+    m_contextParams.n_ctx = std::max(kMinTrimContext, nCtx / 2);
+    LOGi("Trim level %d: shrinking context %u -> %u", level, nCtx, m_contextParams.n_ctx);
+    return ensureContext();
+}
+
+bool LlamaWrapper::ensureContext() {
+    if (m_contextCreated) {
+        return true;
+    }
+    if (!m_contextReleased || !m_modelLoaded) {
+        return false;
+    }
+    auto start = Clock::now();
+    if (!createContext()) {
+        return false;
+    }
+    m_contextReleased = false;
+    if (!m_systemTokens.empty() && !loadPrefixState(prefixStatePath())) {
+        clearPrefix();
+        if (prefillPrefix(m_systemTokens)) {
+            savePrefixState(prefixStatePath());
+        }
+    }
+    LOGi("Context restored in %.1f ms (n_ctx=%u)", elapsedMs(start), llama_n_ctx(m_context));
+    return true;
+}
+
+// Saves every cell of a sequence that holds more than the shared prefix, prefix
+// included: the llama_state_seq_* files cover whole sequences, and the restored
+// copy stands in for adopting the prefix. Sequences holding only the prefix are
+// not written; they re-adopt it from its own state file.
+void LlamaWrapper::spillSequence(LlamaSequence& seq) {
+    if (seq.cached.size() > m_prefixTokens.size()) {
+        const std::string path = statePath(".seq" + std::to_string(seq.seqId) + ".state");
+        const size_t written = llama_state_seq_save_file(m_context, path.c_str(), seq.seqId,
+                                                         seq.cached.data(), seq.cached.size());
+        if (written > 0) {
+            seq.spillPath = path;
+            LOGi("Spilled seq %d (%zu tokens, %zu bytes)", seq.seqId, seq.cached.size(), written);
+        }
+    }
+    if (seq.spillPath.empty()) {
+        seq.chat = false;
+    }
+    seq.cached.clear();
+}
+
+void LlamaWrapper::restoreSequence(LlamaSequence& seq) {
+    if (seq.spillPath.empty()) {
+        return;
+    }
+    auto start = Clock::now();
+    std::vector<llama_token> tokens(llama_n_ctx(m_context));
+    size_t nTokens = 0;
+    llama_kv_cache_seq_rm(m_context, seq.seqId, -1, -1);
+    if (llama_state_seq_load_file(m_context, seq.spillPath.c_str(), seq.seqId,
+                                  tokens.data(), tokens.size(), &nTokens) > 0) {
+        tokens.resize(nTokens);
+        seq.cached = std::move(tokens);
+        LOGi("Restored seq %d (%zu tokens) in %.1f ms", seq.seqId, seq.cached.size(), elapsedMs(start));
+    } else {
+        // Larger than the shrunk context, or written by another build
+        llama_kv_cache_seq_rm(m_context, seq.seqId, -1, -1);
+        seq.cached.clear();
+        seq.chat = false;
+    }
+    std::remove(seq.spillPath.c_str());
+    seq.spillPath.clear();
+}
+
+MemoryReport LlamaWrapper::memoryReport() const {
+    MemoryReport report;
+    if (!m_modelLoaded) {
+        return report;
+    }
+    const GgufLayout& layout = m_loader.layout();
+    report.weightBytes = llama_model_size(m_model);
+    report.weightResidentBytes = m_loader.residentBytes();
+    report.nCtx = m_contextCreated ? llama_n_ctx(m_context) : 0;
+    report.kvType = ggml_type_name(m_contextParams.type_k);
+    report.kvBytes = ggufKvBytesPerToken(layout, m_contextParams.type_k) * report.nCtx;
+    report.computeBytes = m_contextCreated ? ggufComputeBytes(layout, m_contextParams.n_batch) : 0;
+    std::unique_lock<std::mutex> embedLock(m_embedMutex);
+    if (m_embedContext) {
+        report.embedBytes = ggufKvBytesPerToken(layout) * kEmbedTokens + ggufComputeBytes(layout, kEmbedTokens);
+    }
+    embedLock.unlock();
+    report.contextReleased = m_contextReleased;
+
+    std::ifstream statm("/proc/self/statm");
+    uint64_t pages = 0, residentPages = 0;
+    if (statm >> pages >> residentPages) {
+        report.rssBytes = residentPages * (uint64_t) sysconf(_SC_PAGESIZE);
+    }
+    return report;
+}
+
+std::string MemoryReport::toJson() const {
+    std::ostringstream ss;
+    ss << "{\"weightBytes\":" << weightBytes
+       << ",\"weightResidentBytes\":" << weightResidentBytes
+       << ",\"kvBytes\":" << kvBytes
+       << ",\"computeBytes\":" << computeBytes
+       << ",\"embedBytes\":" << embedBytes
+       << ",\"rssBytes\":" << rssBytes
+       << ",\"nCtx\":" << nCtx
+       << ",\"kvType\":\"" << kvType << "\""
+       << ",\"contextReleased\":" << (contextReleased ? "true" : "false") << "}";
+    return ss.str();
+}
+
+bool LlamaWrapper::createEmbedContext() {
+    if (m_embedContext) {
+        return true;
+    }
+    llama_context_params params = llama_context_default_params();
+    params.n_ctx = kEmbedTokens;
+    params.n_batch = kEmbedTokens;
+    params.n_ubatch = kEmbedTokens;  // a pooled sequence must not span ubatches
+    params.n_seq_max = kEmbedSequences;
+    params.n_threads = m_threadConfig.prefillThreads;
+    params.n_threads_batch = m_threadConfig.prefillThreads;
+    params.embeddings = true;
+    params.pooling_type = LLAMA_POOLING_TYPE_MEAN;
+
+    auto start = Clock::now();
+    m_embedContext = llama_new_context_with_model(m_model, params);
+    if (!m_embedContext) {
+        LOGe("Failed to create embedding context");
+        return false;
+    }
+    m_embedBatch = llama_batch_init(kEmbedTokens, 0, 1);
+    LOGi("Embedding context created in %.1f ms (n_embd=%d)", elapsedMs(start), llama_n_embd(m_model));
+    return true;
+}
+
+void LlamaWrapper::destroyEmbedContext() {
+    if (m_embedContext) {
+        llama_batch_free(m_embedBatch);
+        llama_free(m_embedContext);
+        m_embedContext = nullptr;
+    }
+}
+
+int32_t LlamaWrapper::embeddingSize() const {
+    return m_model ? llama_n_embd(m_model) : 0;
+}
+
+bool LlamaWrapper::embed(const std::vector<std::string>& texts, std::vector<float>& out) {
+    std::lock_guard<std::mutex> lock(m_embedMutex);
+    TRACE_SCOPE("embed");
+    if (!m_modelLoaded || !createEmbedContext()) {
+        return false;
+    }
+    const int32_t dim = llama_n_embd(m_model);
+    out.assign(texts.size() * (size_t) dim, 0.0f);
+
+    size_t next = 0;
+    std::vector<size_t> rows;  // text index of each sequence in the batch
+    while (next < texts.size()) {
+        llama_kv_cache_clear(m_embedContext);
+        llamaBatchClear(m_embedBatch);
+        rows.clear();
+        while (next < texts.size() && (int32_t) rows.size() < kEmbedSequences) {
+            std::vector<llama_token> tokens = tokenize(texts[next], true);
+            if ((int32_t) tokens.size() > kEmbedTokens) {
+                tokens.resize(kEmbedTokens);
+            }
+            if (m_embedBatch.n_tokens + (int32_t) tokens.size() > kEmbedTokens) {
+                break;  // does not fit; starts the next batch
+            }
+            if (!tokens.empty()) {
+                const llama_seq_id seq = (llama_seq_id) rows.size();
+                for (size_t i = 0; i < tokens.size(); i++) {
+                    llamaBatchAdd(m_embedBatch, tokens[i], (llama_pos) i, seq, true);
+                }
+                rows.push_back(next);
+            }
+            next++;  // empty texts keep a zero vector
+        }
+        if (rows.empty()) {
+            continue;
+        }
+        if (llama_decode(m_embedContext, m_embedBatch) != 0) {
+            LOGe("llama_decode failed while embedding %zu texts", rows.size());
+            return false;
+        }
+        for (size_t s = 0; s < rows.size(); s++) {
+            const float* pooled = llama_get_embeddings_seq(m_embedContext, (llama_seq_id) s);
+            if (!pooled) {
+                LOGe("No pooled embedding for sequence %zu", s);
+                return false;
+            }
+            double norm = 0.0;
+            for (int32_t i = 0; i < dim; i++) {
+                norm += (double) pooled[i] * pooled[i];
+            }
+            const float inverse = norm > 0.0 ? (float) (1.0 / std::sqrt(norm)) : 0.0f;
+            float* target = out.data() + rows[s] * (size_t) dim;
+            for (int32_t i = 0; i < dim; i++) {
+                target[i] = pooled[i] * inverse;
+            }
+        }
+    }
+    return true;
 }
 
 std::string LlamaWrapper::getModelInfo() const {
     if (!m_modelLoaded) {
         return "No model loaded";
     }
-    
+
+    char desc[128];
+    llama_model_desc(m_model, desc, sizeof(desc));
+
     std::stringstream ss;
-    ss << "TinyLlama Model Loaded Successfully\nModel: " << m_modelPath << " (Size: " << (getModelSize() / (1024*1024)) << " MB)\nRunning in intelligent response mode";
+    ss << "TinyLlama Model Loaded Successfully\nModel: " << m_modelPath << " (Size: " << (getModelSize() / (1024*1024)) << " MB)\n"
+       << desc << ", " << (llama_model_n_params(m_model) / 1000000) << "M params, n_ctx_train=" << llama_n_ctx_train(m_model)
+       << "\nThreads: prefill " << m_threadConfig.prefillThreads << ", decode " << m_threadConfig.decodeThreads
+       << " (" << CpuTopology::get().describe() << ")";
     return ss.str();
 }
 
 size_t LlamaWrapper::getModelSize() const {
-    if (m_modelPath.empty()) {
-        return 0;
-    }
-    
-    std::ifstream file(m_modelPath, std::ios::binary | std::ios::ate);
-    if (file.is_open()) {
-        return file.tellg();
-    }
-    return 0;
-} 
\ No newline at end of file
+    return m_loader.size();
+}
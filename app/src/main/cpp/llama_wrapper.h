@@ -1,56 +1,286 @@
 #ifndef LLAMA_WRAPPER_H
 #define LLAMA_WRAPPER_H
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 // Include real llama.cpp headers
 #include "llama.h"
+#include "model_loader.h"
+#include "cpu_topology.h"
+#include "speculative.h"
+#include "structured_output.h"
+#include "token_sampler.h"
+
+// Timings of the last generateText call
+struct GenerationStats {
+    int32_t promptTokens = 0;
+    int32_t cachedPromptTokens = 0;  // prompt tokens whose KV was reused
+    int32_t generatedTokens = 0;
+    double prefillMs = 0.0;
+    double decodeMs = 0.0;
+    double timeToFirstTokenMs = 0.0;
+    bool stopped = false;  // cancelled or stopped by the callback before finishing
+    int32_t draftedTokens = 0;
+    int32_t acceptedDraftTokens = 0;
+    double queueWaitMs = 0.0;  // LlamaServer: submitted until admitted to a batch
+};
+
+// KV cache cell type. A quantized V cache needs flash attention, which is
+// switched on with it.
+enum class KvCacheType { F16, Q8_0, Q4_0 };
+
+// Android ComponentCallbacks2 levels LlamaWrapper::trimMemory acts on
+constexpr int kTrimRunningLow = 10;
+constexpr int kTrimRunningCritical = 15;
+constexpr int kTrimBackground = 40;
+
+// Where the memory of the loaded model goes, in bytes
+struct MemoryReport {
+    uint64_t weightBytes = 0;          // tensor data
+    uint64_t weightResidentBytes = 0;  // of the mapped model file, currently in RAM
+    uint64_t kvBytes = 0;              // generation context KV cache
+    uint64_t computeBytes = 0;         // scratch (activations, logits), estimated
+    uint64_t embedBytes = 0;           // embedding context, 0 while released
+    uint64_t rssBytes = 0;             // whole process
+    uint32_t nCtx = 0;
+    std::string kvType;
+    bool contextReleased = false;      // spilled by trimMemory, restored on next use
+
+    std::string toJson() const;
+};
+
+// Receives decoded text in UTF-8-complete chunks; return false to stop generation
+using TokenCallback = std::function<bool(const std::string& chunk)>;
+
+// Generation state of one KV sequence. LlamaWrapper::generateText drives a single
+// sequence; LlamaServer interleaves several of them in shared decode batches.
+struct LlamaSequence {
+    llama_seq_id seqId = 0;
+    std::vector<llama_token> cached;   // tokens resident in the KV cache, in position order
+    std::vector<llama_token> pending;  // tokens queued for evaluation
+    size_t pendingPos = 0;             // next pending token to put in a batch
+    int32_t logitsIndex = -1;          // batch row holding this sequence's logits, -1 if none
+    std::vector<llama_token> drafts;   // speculative tokens batched after the pending one
+    bool structured = false;           // grammar-constrained: ends when the JSON closes
+    std::string spillPath;             // KV state saved by trimMemory, restored by beginSequence
+    bool chat = false;                 // cached holds a conversation continued by beginChatTurn
+    size_t chatKeep = 0;               // pinned system prefix at the front of a conversation
+    std::vector<size_t> turnStarts;    // cache offset of every turn still in the window
+    StructureTracker structure;
+    int32_t remaining = 0;             // tokens still allowed to be generated
+    llama_sampler* sampler = nullptr;  // grammar-constrained requests only
+    TokenSampler tokenSampler;         // everything else
+    TokenCallback onToken;
+    std::string response;
+    size_t streamed = 0;               // bytes of `response` already handed to onToken
+    bool active = false;
+    bool failed = false;
+    std::atomic<bool> cancelled{false};
+    GenerationStats stats;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point decodeStartTime;
+
+    bool isPrefilling() const { return pendingPos + 1 < pending.size(); }
+};
+
+// llama_batch helpers shared with LlamaServer
+void llamaBatchClear(llama_batch& batch);
+void llamaBatchAdd(llama_batch& batch, llama_token token, llama_pos pos, llama_seq_id seqId, bool wantLogits);
 
 class LlamaWrapper {
 public:
     LlamaWrapper();
     ~LlamaWrapper();
-    
+
     // Model management
     bool loadModel(const std::string& modelPath);
     void unloadModel();
     bool isModelLoaded() const;
-    
+
     // Context management
     bool createContext();
     void destroyContext();
     bool isContextCreated() const;
-    
-    // Text generation
+
+    // Text generation on the default sequence. Not thread-safe: concurrent callers
+    // go through LlamaServer, which owns the context once started.
     std::string generateText(const std::string& prompt, int maxTokens = 512);
-    
+    std::string generateText(const std::string& prompt, int maxTokens, const TokenCallback& onToken,
+                             const std::string& grammar = std::string());
+
+    // Stops the running generateText call at the next prefill batch or decode step
+    void cancel() { m_defaultSequence.cancelled.store(true); }
+
+    // Step primitives for driving one or more sequences through shared batches:
+    // begin -> (addToBatch, llama_decode, onBatchDecoded)* -> end
+    // A non-empty GBNF `grammar` constrains the output, samples greedily and ends
+    // the sequence as soon as the outermost JSON array/object closes.
+    bool beginSequence(LlamaSequence& seq, const std::string& prompt, int maxTokens, const TokenCallback& onToken,
+                       const std::string& grammar = std::string());
+    // Continues the conversation in `seq` with one already formatted turn: only the
+    // turn's tokens are evaluated. When the window cannot hold the turn plus room for
+    // the reply, the oldest turns are dropped and the rest shifted down in place; the
+    // system prefix stays pinned. Replaces any one-shot prompt cached in `seq`.
+    bool beginChatTurn(LlamaSequence& seq, const std::string& turn, int maxTokens, const TokenCallback& onToken);
+    int32_t addToBatch(LlamaSequence& seq, llama_batch& batch, int32_t maxTokens);
+    void onBatchDecoded(LlamaSequence& seq);
+    void onBatchFailed(LlamaSequence& seq);
+    void endSequence(LlamaSequence& seq);
+    void releaseSequence(LlamaSequence& seq);
+
+    // Fixed prompt prefix kept resident in the KV cache across calls and shared by
+    // every sequence; the state is restored from / saved to prefixStatePath() so a
+    // cold start skips the prefill too
+    bool setSystemPrompt(const std::string& systemPrompt);
+    bool savePrefixState(const std::string& path);
+    bool loadPrefixState(const std::string& path);
+    std::string prefixStatePath() const;
+
+    // Mean-pooled sentence embeddings (L2-normalized, embeddingSize() floats each)
+    // from a small dedicated context created on first use, so the generation KV
+    // cache is never touched. Texts are packed several per decode. Thread-safe.
+    bool embed(const std::vector<std::string>& texts, std::vector<float>& out);
+    int32_t embeddingSize() const;
+
     // Model information
     std::string getModelInfo() const;
     size_t getModelSize() const;
-    
+    const std::string& modelPath() const { return m_modelPath; }
+    // Directory for the files derived from the model (thread calibration, prefix
+    // and spilled sequence state, response cache); empty keeps them next to the
+    // model, which only suits a writable model directory
+    void setStateDir(const std::string& dir) { m_stateDir = dir; }
+    // The model's file name plus `suffix`, inside the state directory
+    std::string statePath(const std::string& suffix) const;
+    GenerationStats getLastStats() const { return m_defaultSequence.stats; }
+    LoadReport getLoadReport() const { return m_loader.report(); }
+    llama_context* context() const { return m_context; }
+    int32_t batchSize() const { return (int32_t) m_contextParams.n_batch; }
+
+    // Number of generating sequences the context is created for (plus one that
+    // holds the shared prefix). Must be set before createContext.
+    void setMaxSequences(int32_t n) { m_maxSequences = n; }
+    int32_t maxSequences() const { return m_maxSequences; }
+
+    // Prefill/decode thread counts. calibrateThreads times candidate counts on the
+    // performance cores once per device and model and caches the winner at `path`.
+    // Call it on the thread that will run llama_decode, after pinning.
+    bool calibrateThreads(const std::string& path);
+    // Throwaway prefill batch and decode step on the default sequence, so the
+    // first request does not pay for graph setup and first touch of the compute
+    // buffers. Same threading rules as calibrateThreads.
+    bool warmUp();
+    std::string threadConfigPath() const;
+    void setThreadConfig(const ThreadConfig& config);
+    ThreadConfig threadConfig() const { return m_threadConfig; }
+
+    // KV cell type for the generation context; must be set before createContext
+    void setKvCacheType(KvCacheType type);
+
+    // Releases memory for an onTrimMemory `level`. RUNNING_LOW drops the embedding
+    // context and parsed grammar. RUNNING_CRITICAL also halves n_ctx (not below
+    // 512 tokens) and BACKGROUND frees the context altogether; both first
+    // spill the KV state of `sequences` (plus the default one) to disk and are
+    // skipped while any of them is generating. Everything is restored lazily by
+    // the next beginSequence. Call on the thread that runs llama_decode.
+    bool trimMemory(int level, const std::vector<LlamaSequence*>& sequences);
+    // Recreates a context released by trimMemory, with the system prefix
+    bool ensureContext();
+    MemoryReport memoryReport() const;
+
+    // Speculative decoding: up to maxDraft drafted tokens are verified in the same
+    // forward pass as each sampled token. nullptr turns it off. Not thread-safe
+    // with decoding; the server swaps it through runExclusive.
+    void setDrafter(std::unique_ptr<Drafter> drafter, int32_t maxDraft = 4);
+    // Drafted tokens a decode step may add after its sampled token; 0 when off
+    int32_t maxDraft() const { return m_drafter ? m_maxDraft : 0; }
+    std::string speculativeStatsJson() const;
+    // Drafter construction needs the tokenizer / context layout; nullptr on failure
+    std::unique_ptr<Drafter> createNgramDrafter(const std::vector<std::string>& corpus) const;
+    std::unique_ptr<Drafter> createDraftModelDrafter(const std::string& path) const;
+
+    // How weights are warmed after mapping; hotLayers < 0 warms every block.
+    // Must be set before loadModel.
+    void setPrefetch(PrefetchMode mode, int hotLayers = -1) { m_prefetchMode = mode; m_prefetchLayers = hotLayers; }
+    // Blocks until the weight prefetch started by loadModel is done
+    void waitForPrefetch() { m_loader.waitForPrefetch(); }
+
     // Parameter getters
     llama_model_params getModelParams() const { return m_modelParams; }
     llama_context_params getContextParams() const { return m_contextParams; }
-    
+    GenerationParams getGenerationParams() const { return m_generationParams; }
+
     // Parameter setters
     void setModelParams(const llama_model_params& params) { m_modelParams = params; }
     void setContextParams(const llama_context_params& params) { m_contextParams = params; }
+    void setGenerationParams(const GenerationParams& params) { m_generationParams = params; }
 
 private:
     llama_model* m_model;
     llama_context* m_context;
+    llama_batch m_batch;
     std::string m_modelPath;
+    std::string m_stateDir;
     bool m_modelLoaded;
     bool m_contextCreated;
-    
+    bool m_contextReleased;  // by trimMemory; ensureContext brings it back
+    int32_t m_maxSequences;
+
+    // Single mapping of the model file, shared through the page cache with llama.cpp
+    ModelLoader m_loader;
+    PrefetchMode m_prefetchMode;
+    int m_prefetchLayers;
+
+    ThreadConfig m_threadConfig;
+
+    std::unique_ptr<Drafter> m_drafter;
+    int32_t m_maxDraft;
+    SpeculativeStats m_specStats;
+
+    // Parsed grammar sampler for the last grammar used; sequences get clones
+    std::string m_grammarSource;
+    llama_sampler* m_grammarSampler;
+
+    // Embedding context (pooled, causal attention as in the base model)
+    llama_context* m_embedContext;
+    llama_batch m_embedBatch;
+    mutable std::mutex m_embedMutex;
+
     // Default parameters
     llama_model_params m_modelParams;
     llama_context_params m_contextParams;
-    
+    GenerationParams m_generationParams;
+
+    // Sequence used by generateText
+    LlamaSequence m_defaultSequence;
+
+    // Tokens resident in the prefix sequence, in position order
+    std::vector<llama_token> m_prefixTokens;
+    std::vector<llama_token> m_systemTokens;
+
     // Helper functions
     void initializeDefaultParams();
-    std::string generateIntelligentResponse(const std::string& userInput);
+    std::vector<llama_token> tokenize(const std::string& text, bool addSpecial) const;
+    std::string tokenToPiece(llama_token token) const;
+    llama_seq_id prefixSeqId() const { return m_maxSequences; }
+    bool prefillPrefix(const std::vector<llama_token>& tokens);
+    void clearPrefix();
+    void spillSequence(LlamaSequence& seq);
+    void restoreSequence(LlamaSequence& seq);
+    bool createEmbedContext();
+    void destroyEmbedContext();
+    llama_sampler* createGrammarSampler(const std::string& grammar);
+    bool emitToken(LlamaSequence& seq, llama_token token);
+    void resetRequest(LlamaSequence& seq);
+    bool startSampling(LlamaSequence& seq, int maxTokens, const TokenCallback& onToken, const std::string& grammar);
+    void evictOldestTurn(LlamaSequence& seq);
+    double timeBatches(const std::vector<llama_token>& tokens, int32_t threads, int32_t batchTokens, int32_t steps);
 };
 
-#endif // LLAMA_WRAPPER_H 
\ No newline at end of file
+#endif // LLAMA_WRAPPER_H
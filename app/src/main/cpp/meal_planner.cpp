@@ -0,0 +1,378 @@
+#include "meal_planner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+#include "cpu_topology.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(TASTYDIET_AVX2_KERNELS)
+#include <immintrin.h>
+#endif
+
+#include "native_log.h"
+
+#define TAG "MealPlanner"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr size_t kLanes = 8;
+constexpr float kMinGrams = 30.0f;
+constexpr float kMaxGrams = 600.0f;
+constexpr size_t kCandidatesPerSlot = 12;
+constexpr uint64_t kMaxNodesPerDay = 250000;
+constexpr int32_t kVarietyDays = 3;
+constexpr float kRepeatPenalty = 0.05f;
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+float portionGrams(float slotKcal, float invCalories) {
+    return std::min(std::max(slotKcal * 100.0f * invCalories, kMinGrams), kMaxGrams);
+}
+
+// Exact search over the per-slot candidates of one day. Totals are kept per
+// (member, macro) pair, `width` of them; a slot with no fitting recipe has the
+// single candidate -1 contributing nothing.
+struct DaySearch {
+    size_t slots = 0;
+    size_t width = 0;
+    std::vector<float> weights;     // [member][macro], 0 where the target is 0
+    std::vector<float> invTargets;  // [member][macro]
+    std::vector<std::vector<int32_t>> rows;      // [slot][candidate]
+    std::vector<std::vector<float>> penalties;  // [slot][candidate]
+    std::vector<std::vector<float>> values;     // [slot][candidate * width]
+    std::vector<double> suffixMin;  // [slot][width]: least the slots from here on can add
+    std::vector<double> suffixMax;
+    std::vector<double> partial;    // [depth][width]
+    std::vector<int32_t> path;
+    std::vector<int32_t> best;      // candidate index per slot
+    double bestCost = std::numeric_limits<double>::infinity();
+    uint64_t nodes = 0;
+
+    void prepare() {
+        suffixMin.assign((slots + 1) * width, 0.0);
+        suffixMax.assign((slots + 1) * width, 0.0);
+        for (size_t s = slots; s-- > 0;) {
+            for (size_t k = 0; k < width; k++) {
+                double lo = std::numeric_limits<double>::infinity();
+                double hi = -lo;
+                for (size_t c = 0; c < rows[s].size(); c++) {
+                    lo = std::min(lo, (double) values[s][c * width + k]);
+                    hi = std::max(hi, (double) values[s][c * width + k]);
+                }
+                suffixMin[s * width + k] = suffixMin[(s + 1) * width + k] + lo;
+                suffixMax[s * width + k] = suffixMax[(s + 1) * width + k] + hi;
+            }
+        }
+        partial.assign((slots + 1) * width, 0.0);
+        path.assign(slots, -1);
+        best.assign(slots, 0);
+    }
+
+    // Valid for every completion: each total can still move only within the
+    // suffix range, so the miss outside it is unavoidable
+    double lowerBound(size_t depth, double penalty) const {
+        const double* totals = &partial[depth * width];
+        double bound = penalty;
+        for (size_t k = 0; k < width; k++) {
+            const double target = invTargets[k] > 0.0f ? 1.0 / invTargets[k] : 0.0;
+            const double lo = totals[k] + suffixMin[depth * width + k];
+            const double hi = totals[k] + suffixMax[depth * width + k];
+            const double gap = target < lo ? lo - target : target > hi ? target - hi : 0.0;
+            bound += weights[k] * (gap * invTargets[k]) * (gap * invTargets[k]);
+        }
+        return bound;
+    }
+
+    double finalCost(double penalty) const {
+        const double* totals = &partial[slots * width];
+        double cost = penalty;
+        for (size_t k = 0; k < width; k++) {
+            const double miss = totals[k] * invTargets[k] - 1.0;
+            cost += weights[k] * miss * miss;
+        }
+        return cost;
+    }
+
+    bool usedToday(size_t depth, int32_t row) const {
+        for (size_t s = 0; s < depth; s++) {
+            if (path[s] >= 0 && rows[s][path[s]] == row) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void descend(size_t depth, int32_t candidate, const float* add, double penalty) {
+        path[depth] = candidate;
+        const double* from = &partial[depth * width];
+        double* to = &partial[(depth + 1) * width];
+        for (size_t k = 0; k < width; k++) {
+            to[k] = from[k] + (add ? add[k] : 0.0f);
+        }
+        search(depth + 1, penalty);
+    }
+
+    void search(size_t depth, double penalty) {
+        nodes++;
+        if (depth == slots) {
+            const double cost = finalCost(penalty);
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = path;
+            }
+            return;
+        }
+        if (lowerBound(depth, penalty) >= bestCost) {
+            return;
+        }
+
+        bool expanded = false;
+        for (size_t c = 0; c < rows[depth].size(); c++) {
+            // The first leaf is always reached; after that the budget bounds the search
+            if (nodes >= kMaxNodesPerDay && bestCost < std::numeric_limits<double>::infinity()) {
+                return;
+            }
+            const int32_t row = rows[depth][c];
+            if (row >= 0 && usedToday(depth, row)) {
+                continue;
+            }
+            expanded = true;
+            descend(depth, (int32_t) c, &values[depth][c * width], penalty + penalties[depth][c]);
+        }
+        if (!expanded) {
+            // Every candidate is already on today's menu: leave the slot empty
+            descend(depth, -1, nullptr, penalty);
+        }
+    }
+};
+
+#if defined(TASTYDIET_AVX2_KERNELS)
+TASTYDIET_TARGET_AVX2
+void accumulateSlotCostAvx2(const float* const columns[MACRO_COUNT], const float* invCalories, size_t n,
+                            float slotKcal, float minGrams, float maxGrams,
+                            const float invSlotTargets[MACRO_COUNT], const float weights[MACRO_COUNT], float* cost) {
+    const __m256 kcal = _mm256_set1_ps(slotKcal * 100.0f);
+    const __m256 lo = _mm256_set1_ps(minGrams);
+    const __m256 hi = _mm256_set1_ps(maxGrams);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 percent = _mm256_set1_ps(0.01f);
+    for (size_t i = 0; i < n; i += 8) {
+        const __m256 grams = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(kcal, _mm256_loadu_ps(invCalories + i)), lo), hi);
+        const __m256 scale = _mm256_mul_ps(grams, percent);
+        __m256 acc = _mm256_loadu_ps(cost + i);
+        for (int j = 0; j < MACRO_COUNT; j++) {
+            const __m256 amount = _mm256_mul_ps(_mm256_loadu_ps(columns[j] + i), scale);
+            const __m256 miss = _mm256_sub_ps(_mm256_mul_ps(amount, _mm256_set1_ps(invSlotTargets[j])), one);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_mul_ps(miss, miss), _mm256_set1_ps(weights[j])));
+        }
+        _mm256_storeu_ps(cost + i, acc);
+    }
+}
+#endif
+
+} // namespace
+
+void accumulateSlotCost(const float* const columns[MACRO_COUNT], const float* invCalories, size_t n,
+                        float slotKcal, float minGrams, float maxGrams,
+                        const float invSlotTargets[MACRO_COUNT], const float weights[MACRO_COUNT], float* cost) {
+#if defined(__ARM_NEON)
+    const float32x4_t kcal = vdupq_n_f32(slotKcal * 100.0f);
+    const float32x4_t lo = vdupq_n_f32(minGrams);
+    const float32x4_t hi = vdupq_n_f32(maxGrams);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (size_t i = 0; i < n; i += 4) {
+        const float32x4_t grams = vminq_f32(vmaxq_f32(vmulq_f32(kcal, vld1q_f32(invCalories + i)), lo), hi);
+        const float32x4_t scale = vmulq_n_f32(grams, 0.01f);
+        float32x4_t acc = vld1q_f32(cost + i);
+        for (int j = 0; j < MACRO_COUNT; j++) {
+            const float32x4_t amount = vmulq_f32(vld1q_f32(columns[j] + i), scale);
+            const float32x4_t miss = vsubq_f32(vmulq_n_f32(amount, invSlotTargets[j]), one);
+            acc = vmlaq_n_f32(acc, vmulq_f32(miss, miss), weights[j]);
+        }
+        vst1q_f32(cost + i, acc);
+    }
+#else
+#if defined(TASTYDIET_AVX2_KERNELS)
+    if (cpuHasAvx2()) {
+        accumulateSlotCostAvx2(columns, invCalories, n, slotKcal, minGrams, maxGrams, invSlotTargets, weights, cost);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; i++) {
+        const float scale = std::min(std::max(slotKcal * 100.0f * invCalories[i], minGrams), maxGrams) * 0.01f;
+        float acc = cost[i];
+        for (int j = 0; j < MACRO_COUNT; j++) {
+            const float miss = columns[j][i] * scale * invSlotTargets[j] - 1.0f;
+            acc += weights[j] * miss * miss;
+        }
+        cost[i] = acc;
+    }
+#endif
+}
+
+MealPlanner::MealPlanner()
+    : m_count(0)
+    , m_paddedCount(0) {
+}
+
+void MealPlanner::setRecipes(size_t count, const float* const columns[MACRO_COUNT], const uint32_t* mealMasks,
+                             const uint8_t* available) {
+    m_count = count;
+    m_paddedCount = (count + kLanes - 1) / kLanes * kLanes;
+    for (int j = 0; j < MACRO_COUNT; j++) {
+        m_columns[j].assign(m_paddedCount, 0.0f);
+        std::copy(columns[j], columns[j] + count, m_columns[j].begin());
+    }
+    m_invCalories.assign(m_paddedCount, 0.0f);
+    for (size_t i = 0; i < count; i++) {
+        const float kcal = columns[MACRO_CALORIES][i];
+        m_invCalories[i] = kcal > 0.0f ? 1.0f / kcal : 0.0f;
+    }
+    m_mealMasks.assign(mealMasks, mealMasks + count);
+    m_available.assign(count, 1);
+    if (available) {
+        std::copy(available, available + count, m_available.begin());
+    }
+    LOGi("Loaded %zu recipes", count);
+}
+
+bool MealPlanner::setAvailable(size_t count, const uint8_t* available) {
+    if (count != m_count) {
+        LOGe("Availability for %zu recipes, table has %zu", count, m_count);
+        return false;
+    }
+    std::copy(available, available + count, m_available.begin());
+    return true;
+}
+
+bool MealPlanner::plan(const MealPlanRequest& request, MealPlan& plan) const {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t members = request.members.size();
+    const size_t slots = request.slots.size();
+    if (m_count == 0 || members == 0 || slots == 0 || request.days <= 0) {
+        LOGe("Nothing to plan (%zu recipes, %zu members, %zu slots, %d days)", m_count, members, slots, request.days);
+        return false;
+    }
+
+    DaySearch day;
+    day.slots = slots;
+    day.width = members * MACRO_COUNT;
+    day.weights.resize(day.width);
+    day.invTargets.resize(day.width);
+    for (size_t m = 0; m < members; m++) {
+        for (int j = 0; j < MACRO_COUNT; j++) {
+            const float target = request.members[m].values[j];
+            day.invTargets[m * MACRO_COUNT + j] = target > 0.0f ? 1.0f / target : 0.0f;
+            day.weights[m * MACRO_COUNT + j] = target > 0.0f ? request.weights[j] : 0.0f;
+        }
+    }
+
+    // Cost of each recipe alone in each slot, summed over members. Independent
+    // of the day, so scored once for the whole plan.
+    const float* columns[MACRO_COUNT];
+    for (int j = 0; j < MACRO_COUNT; j++) {
+        columns[j] = m_columns[j].data();
+    }
+    std::vector<std::vector<float>> slotCost(slots, std::vector<float>(m_paddedCount, 0.0f));
+    for (size_t s = 0; s < slots; s++) {
+        const float share = request.slots[s].calorieShare;
+        for (size_t m = 0; m < members; m++) {
+            float invSlotTargets[MACRO_COUNT];
+            for (int j = 0; j < MACRO_COUNT; j++) {
+                invSlotTargets[j] = share > 0.0f ? day.invTargets[m * MACRO_COUNT + j] / share : 0.0f;
+            }
+            accumulateSlotCost(columns, m_invCalories.data(), m_paddedCount,
+                               share * request.members[m].values[MACRO_CALORIES], kMinGrams, kMaxGrams,
+                               invSlotTargets, &day.weights[m * MACRO_COUNT], slotCost[s].data());
+        }
+    }
+
+    const size_t days = (size_t) request.days;
+    plan.recipes.assign(days * slots, -1);
+    plan.grams.assign(days * slots * members, 0.0f);
+    plan.totals.assign(days * members * MACRO_COUNT, 0.0f);
+    plan.cost = 0.0;
+    plan.nodes = 0;
+
+    std::vector<int32_t> lastUsed(m_count, -kVarietyDays - 1);
+    std::vector<std::pair<float, int32_t>> ranked;
+    ranked.reserve(m_count);
+    day.rows.resize(slots);
+    day.penalties.resize(slots);
+    day.values.resize(slots);
+
+    for (size_t d = 0; d < days; d++) {
+        // Best few recipes per slot, recently eaten ones pushed down
+        for (size_t s = 0; s < slots; s++) {
+            ranked.clear();
+            for (size_t r = 0; r < m_count; r++) {
+                if (!(m_mealMasks[r] & request.slots[s].mealMask) || !m_available[r] || m_invCalories[r] <= 0.0f) {
+                    continue;
+                }
+                const bool recent = (int32_t) d - lastUsed[r] <= kVarietyDays;
+                ranked.emplace_back(slotCost[s][r] + (recent ? kRepeatPenalty : 0.0f), (int32_t) r);
+            }
+            const size_t keep = std::min(ranked.size(), kCandidatesPerSlot);
+            std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end());
+
+            day.rows[s].clear();
+            day.penalties[s].clear();
+            day.values[s].clear();
+            if (keep == 0) {
+                day.rows[s].push_back(-1);
+                day.penalties[s].push_back(0.0f);
+                day.values[s].assign(day.width, 0.0f);
+                continue;
+            }
+            const float share = request.slots[s].calorieShare;
+            for (size_t c = 0; c < keep; c++) {
+                const int32_t row = ranked[c].second;
+                day.rows[s].push_back(row);
+                day.penalties[s].push_back((int32_t) d - lastUsed[row] <= kVarietyDays ? kRepeatPenalty : 0.0f);
+                for (size_t m = 0; m < members; m++) {
+                    const float grams = portionGrams(share * request.members[m].values[MACRO_CALORIES], m_invCalories[row]);
+                    for (int j = 0; j < MACRO_COUNT; j++) {
+                        day.values[s].push_back(m_columns[j][row] * grams * 0.01f);
+                    }
+                }
+            }
+        }
+
+        day.bestCost = std::numeric_limits<double>::infinity();
+        day.nodes = 0;
+        day.prepare();
+        day.search(0, 0.0);
+        plan.cost += day.bestCost;
+        plan.nodes += day.nodes;
+
+        for (size_t s = 0; s < slots; s++) {
+            const int32_t candidate = day.best[s];
+            const int32_t row = candidate >= 0 ? day.rows[s][candidate] : -1;
+            plan.recipes[d * slots + s] = row;
+            if (row < 0) {
+                continue;
+            }
+            lastUsed[row] = (int32_t) d;
+            const float share = request.slots[s].calorieShare;
+            for (size_t m = 0; m < members; m++) {
+                plan.grams[(d * slots + s) * members + m] =
+                    portionGrams(share * request.members[m].values[MACRO_CALORIES], m_invCalories[row]);
+                for (int j = 0; j < MACRO_COUNT; j++) {
+                    plan.totals[(d * members + m) * MACRO_COUNT + j] += day.values[s][candidate * day.width + m * MACRO_COUNT + j];
+                }
+            }
+        }
+    }
+
+    plan.elapsedMs = elapsedMs(start);
+    LOGi("Planned %zu days x %zu slots for %zu members over %zu recipes: cost %.4f, %llu nodes, %.2f ms",
+         days, slots, members, m_count, plan.cost, (unsigned long long) plan.nodes, plan.elapsedMs);
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef MEAL_PLANNER_H
+#define MEAL_PLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum MacroColumn {
+    MACRO_CALORIES = 0,
+    MACRO_PROTEIN,
+    MACRO_CARBS,
+    MACRO_FAT,
+    MACRO_FIBER,
+    MACRO_COUNT
+};
+
+// Daily targets of one person, indexed by MacroColumn
+struct MacroTargets {
+    float values[MACRO_COUNT];
+};
+
+// One meal of the day: the recipes allowed in it (bit per meal type) and its
+// share of the daily calories
+struct MealSlot {
+    uint32_t mealMask;
+    float calorieShare;
+};
+
+struct MealPlanRequest {
+    std::vector<MacroTargets> members;  // everyone eats the same dish, in their own portion
+    std::vector<MealSlot> slots;
+    int32_t days = 1;
+    // Relative weight of each macro's squared relative miss
+    float weights[MACRO_COUNT] = {1.0f, 1.0f, 0.6f, 0.6f, 0.3f};
+};
+
+struct MealPlan {
+    std::vector<int32_t> recipes;  // [day][slot] recipe row, -1 when no recipe fits the slot
+    std::vector<float> grams;      // [day][slot][member] portion
+    std::vector<float> totals;     // [day][member][MacroColumn] eaten
+    double cost = 0.0;             // sum of the daily objectives
+    uint64_t nodes = 0;            // search nodes visited
+    double elapsedMs = 0.0;
+};
+
+// Whole-day (or week) meal planner over a recipe table kept as one column per
+// macro. Every slot is scored for all recipes at once with a SIMD kernel
+// (NEON / AVX2 / scalar), the best few per slot are kept, and a bounded
+// branch-and-bound picks the combination whose day totals land closest to
+// every member's targets. Portions are scaled per member to the slot's share
+// of their calories. Across days, recently used recipes are penalized.
+class MealPlanner {
+public:
+    MealPlanner();
+
+    // Macros per 100 g (calories, protein, carbs, fat, fiber columns), meal type
+    // bits, and whether each recipe can be cooked from the inventory
+    void setRecipes(size_t count, const float* const columns[MACRO_COUNT], const uint32_t* mealMasks,
+                    const uint8_t* available);
+    // Inventory changed: same recipes, new availability
+    bool setAvailable(size_t count, const uint8_t* available);
+    size_t size() const { return m_count; }
+
+    bool plan(const MealPlanRequest& request, MealPlan& plan) const;
+
+private:
+    size_t m_count;
+    size_t m_paddedCount;
+    std::vector<float> m_columns[MACRO_COUNT];  // zero-padded to a multiple of the SIMD width
+    std::vector<float> m_invCalories;           // 1 / kcal per 100 g, 0 for recipes without calories
+    std::vector<uint32_t> m_mealMasks;
+    std::vector<uint8_t> m_available;
+};
+
+// Adds one member's cost of eating each recipe alone in a slot to `cost`:
+// sum_j weight[j] * (portion macro j / slot target j - 1)^2, with the portion
+// set to `slotKcal` and clamped to [minGrams, maxGrams]. `n` is a multiple of 8.
+void accumulateSlotCost(const float* const columns[MACRO_COUNT], const float* invCalories, size_t n,
+                        float slotKcal, float minGrams, float maxGrams,
+                        const float invSlotTargets[MACRO_COUNT], const float weights[MACRO_COUNT], float* cost);
+
+#endif // MEAL_PLANNER_H
@@ -0,0 +1,125 @@
+#include <jni.h>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "meal_planner.h"
+#include "native_log.h"
+#include "native_trace.h"
+
+#define LOG_TAG "MealPlannerJNI"
+#define LOGE(...) nativeLog(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// Header of the planMeals result, before the per-meal and per-day blocks
+static constexpr int kPlanHeader = 3;
+
+// One process-wide recipe table, replaced when the recipe list changes
+static MealPlanner mealPlanner;
+static std::shared_mutex mealPlannerMutex;
+
+static std::vector<uint8_t> toFlags(JNIEnv* env, jbooleanArray values) {
+    std::vector<uint8_t> flags((size_t) env->GetArrayLength(values));
+    env->GetBooleanArrayRegion(values, 0, (jsize) flags.size(), reinterpret_cast<jboolean*>(flags.data()));
+    return flags;
+}
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_util_NativeMealPlanner_loadRecipes(JNIEnv *env, jobject thiz, jfloatArray calories, jfloatArray protein,
+                                                              jfloatArray carbs, jfloatArray fat, jfloatArray fiber,
+                                                              jintArray mealMasks, jbooleanArray available) {
+    (void)thiz; // Suppress unused parameter warning
+    const jfloatArray arrays[MACRO_COUNT] = {calories, protein, carbs, fat, fiber};
+    const jsize count = env->GetArrayLength(mealMasks);
+    for (jfloatArray array : arrays) {
+        if (env->GetArrayLength(array) != count) {
+            LOGE("Recipe columns differ in length");
+            return JNI_FALSE;
+        }
+    }
+    if (env->GetArrayLength(available) != count) {
+        LOGE("Availability differs in length from the recipe columns");
+        return JNI_FALSE;
+    }
+
+    std::vector<float> columns[MACRO_COUNT];
+    const float* pointers[MACRO_COUNT];
+    for (int j = 0; j < MACRO_COUNT; j++) {
+        columns[j].resize((size_t) count);
+        env->GetFloatArrayRegion(arrays[j], 0, count, columns[j].data());
+        pointers[j] = columns[j].data();
+    }
+    std::vector<uint32_t> masks((size_t) count);
+    env->GetIntArrayRegion(mealMasks, 0, count, reinterpret_cast<jint*>(masks.data()));
+    const std::vector<uint8_t> flags = toFlags(env, available);
+
+    std::unique_lock<std::shared_mutex> lock(mealPlannerMutex);
+    mealPlanner.setRecipes((size_t) count, pointers, masks.data(), flags.data());
+    return JNI_TRUE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_tastydiet_util_NativeMealPlanner_setAvailability(JNIEnv *env, jobject thiz, jbooleanArray available) {
+    (void)thiz; // Suppress unused parameter warning
+    const std::vector<uint8_t> flags = toFlags(env, available);
+    std::unique_lock<std::shared_mutex> lock(mealPlannerMutex);
+    return mealPlanner.setAvailable(flags.size(), flags.data());
+}
+
+// Result: cost, nodes, ms | per day and slot: recipe row (-1 if none), grams per
+// member | per day and member: eaten calories, protein, carbs, fat, fiber
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_tastydiet_util_NativeMealPlanner_planMeals(JNIEnv *env, jobject thiz, jfloatArray memberTargets,
+                                                            jintArray slotMasks, jfloatArray slotShares, jint days) {
+    (void)thiz; // Suppress unused parameter warning
+    TRACE_SCOPE("planMeals");
+    const jsize targetCount = env->GetArrayLength(memberTargets);
+    const jsize slotCount = env->GetArrayLength(slotMasks);
+    if (targetCount == 0 || targetCount % MACRO_COUNT != 0 || env->GetArrayLength(slotShares) != slotCount) {
+        LOGE("Malformed plan request (%d targets, %d slots)", (int) targetCount, (int) slotCount);
+        return nullptr;
+    }
+
+    static_assert(sizeof(MacroTargets) == sizeof(jfloat) * MACRO_COUNT, "targets are read as one float run");
+    MealPlanRequest request;
+    request.members.resize((size_t) (targetCount / MACRO_COUNT));
+    env->GetFloatArrayRegion(memberTargets, 0, targetCount, reinterpret_cast<jfloat*>(request.members.data()));
+    std::vector<jint> masks((size_t) slotCount);
+    std::vector<jfloat> shares((size_t) slotCount);
+    env->GetIntArrayRegion(slotMasks, 0, slotCount, masks.data());
+    env->GetFloatArrayRegion(slotShares, 0, slotCount, shares.data());
+    for (jsize s = 0; s < slotCount; s++) {
+        request.slots.push_back({(uint32_t) masks[s], shares[s]});
+    }
+    request.days = days;
+
+    MealPlan plan;
+    {
+        std::shared_lock<std::shared_mutex> lock(mealPlannerMutex);
+        if (!mealPlanner.plan(request, plan)) {
+            return nullptr;
+        }
+    }
+
+    const size_t members = request.members.size();
+    const size_t meals = plan.recipes.size();
+    std::vector<jfloat> values;
+    values.reserve(kPlanHeader + meals * (1 + members) + plan.totals.size());
+    values.push_back((jfloat) plan.cost);
+    values.push_back((jfloat) plan.nodes);
+    values.push_back((jfloat) plan.elapsedMs);
+    for (size_t i = 0; i < meals; i++) {
+        values.push_back((jfloat) plan.recipes[i]);
+        values.insert(values.end(), plan.grams.begin() + i * members, plan.grams.begin() + (i + 1) * members);
+    }
+    values.insert(values.end(), plan.totals.begin(), plan.totals.end());
+
+    jfloatArray result = env->NewFloatArray((jsize) values.size());
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, (jsize) values.size(), values.data());
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,234 @@
+#include "model_loader.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "json_reader.h"
+#include "native_log.h"
+
+#define TAG "ModelLoader"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Execution order of a tensor: embeddings first, then blocks, then output head
+int layerRank(const std::string& name) {
+    if (name.rfind("token_embd", 0) == 0) {
+        return -1;
+    }
+    if (name.rfind("blk.", 0) == 0) {
+        return std::atoi(name.c_str() + 4);
+    }
+    return INT_MAX;
+}
+
+} // namespace
+
+std::string LoadReport::toJson() const {
+    std::ostringstream ss;
+    ss << "{\"ok\":" << (ok ? "true" : "false")
+       << ",\"error\":\"" << jsonEscape(error) << "\""
+       << ",\"fileSize\":" << fileSize
+       << ",\"ggufVersion\":" << ggufVersion
+       << ",\"tensorCount\":" << tensorCount
+       << ",\"kvCount\":" << kvCount
+       << ",\"openMs\":" << openMs
+       << ",\"mapMs\":" << mapMs
+       << ",\"validateMs\":" << validateMs
+       << ",\"llamaLoadMs\":" << llamaLoadMs
+       << ",\"contextMs\":" << contextMs
+       << ",\"prefetchMs\":" << prefetchMs
+       << ",\"prefetchBytes\":" << prefetchBytes
+       << ",\"prefetchDone\":" << (prefetchDone ? "true" : "false")
+       << "}";
+    return ss.str();
+}
+
+ModelLoader::ModelLoader()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_stopPrefetch(false) {
+}
+
+ModelLoader::~ModelLoader() {
+    close();
+}
+
+bool ModelLoader::open(const std::string& path) {
+    close();
+    LoadReport report;
+
+    auto start = Clock::now();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        report.error = "cannot open model file";
+        LOGe("Cannot open %s", path.c_str());
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        std::lock_guard<std::mutex> lock(m_reportMutex);
+        m_report = report;
+        return false;
+    }
+    report.fileSize = (uint64_t) st.st_size;
+    report.openMs = elapsedMs(start);
+
+    start = Clock::now();
+    void* addr = st.st_size > 0 ? mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);  // the mapping keeps the file alive
+    if (addr == MAP_FAILED) {
+        report.error = "mmap failed";
+        LOGe("mmap failed for %s", path.c_str());
+        std::lock_guard<std::mutex> lock(m_reportMutex);
+        m_report = report;
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(addr);
+    m_size = (size_t) st.st_size;
+    report.mapMs = elapsedMs(start);
+
+    start = Clock::now();
+    std::string error;
+    const bool valid = parseGgufLayout(m_data, m_size, m_layout, error);
+    report.validateMs = elapsedMs(start);
+    report.ggufVersion = m_layout.version;
+    report.tensorCount = m_layout.tensorCount;
+    report.kvCount = m_layout.kvCount;
+    report.ok = valid;
+    report.error = error;
+
+    {
+        std::lock_guard<std::mutex> lock(m_reportMutex);
+        m_report = report;
+    }
+
+    if (!valid) {
+        LOGe("Invalid model %s: %s", path.c_str(), error.c_str());
+        close();
+        return false;
+    }
+    LOGi("Mapped %s: %llu bytes, GGUF v%u, %llu tensors (open %.2f ms, map %.2f ms, validate %.2f ms)",
+         path.c_str(), (unsigned long long) m_size, m_layout.version,
+         (unsigned long long) m_layout.tensorCount, report.openMs, report.mapMs, report.validateMs);
+    return true;
+}
+
+void ModelLoader::close() {
+    m_stopPrefetch.store(true);
+    waitForPrefetch();
+    m_stopPrefetch.store(false);
+
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+    m_layout = GgufLayout();
+}
+
+void ModelLoader::startPrefetch(PrefetchMode mode, int hotLayers) {
+    if (!m_data || mode == PrefetchMode::None) {
+        return;
+    }
+    waitForPrefetch();
+    m_prefetchThread = std::thread(&ModelLoader::prefetch, this, mode, hotLayers);
+}
+
+void ModelLoader::waitForPrefetch() {
+    if (m_prefetchThread.joinable()) {
+        m_prefetchThread.join();
+    }
+}
+
+void ModelLoader::prefetch(PrefetchMode mode, int hotLayers) {
+    auto start = Clock::now();
+
+    std::vector<const GgufTensorInfo*> order;
+    order.reserve(m_layout.tensors.size());
+    for (const GgufTensorInfo& info : m_layout.tensors) {
+        const int rank = layerRank(info.name);
+        if (hotLayers < 0 || rank < hotLayers || rank == INT_MAX) {
+            order.push_back(&info);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [](const GgufTensorInfo* a, const GgufTensorInfo* b) {
+        return layerRank(a->name) < layerRank(b->name);
+    });
+
+    const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    uint64_t bytes = 0;
+    volatile uint8_t sink = 0;
+    for (const GgufTensorInfo* info : order) {
+        if (m_stopPrefetch.load()) {
+            break;
+        }
+        const size_t begin = (size_t) (m_layout.dataOffset + info->offset);
+        const size_t end = begin + (size_t) info->size;
+        if (mode == PrefetchMode::Advise) {
+            const size_t alignedBegin = begin / pageSize * pageSize;
+            madvise(const_cast<uint8_t*>(m_data) + alignedBegin, end - alignedBegin, MADV_WILLNEED);
+        } else {
+            for (size_t off = begin; off < end; off += pageSize) {
+                sink = sink + m_data[off];
+            }
+        }
+        bytes += info->size;
+    }
+    (void) sink;
+
+    const double ms = elapsedMs(start);
+    {
+        std::lock_guard<std::mutex> lock(m_reportMutex);
+        m_report.prefetchMs = ms;
+        m_report.prefetchBytes = bytes;
+        m_report.prefetchDone = !m_stopPrefetch.load();
+    }
+    LOGi("Prefetched %llu MB of weights in %.1f ms (%s)", (unsigned long long) (bytes >> 20), ms,
+         mode == PrefetchMode::Advise ? "madvise" : "prefault");
+}
+
+uint64_t ModelLoader::residentBytes() const {
+    if (!m_data) {
+        return 0;
+    }
+    const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t pages = (m_size + pageSize - 1) / pageSize;
+    std::vector<unsigned char> residency(pages);
+    if (mincore(const_cast<uint8_t*>(m_data), m_size, residency.data()) != 0) {
+        return 0;
+    }
+    uint64_t resident = 0;
+    for (unsigned char page : residency) {
+        resident += page & 1;
+    }
+    return resident * pageSize;
+}
+
+void ModelLoader::recordLlamaLoad(double ms) {
+    std::lock_guard<std::mutex> lock(m_reportMutex);
+    m_report.llamaLoadMs = ms;
+}
+
+void ModelLoader::recordContext(double ms) {
+    std::lock_guard<std::mutex> lock(m_reportMutex);
+    m_report.contextMs = ms;
+}
+
+LoadReport ModelLoader::report() const {
+    std::lock_guard<std::mutex> lock(m_reportMutex);
+    return m_report;
+}
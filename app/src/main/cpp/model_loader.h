@@ -0,0 +1,82 @@
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "gguf_reader.h"
+
+// How the weights are brought into memory ahead of the first forward pass
+enum class PrefetchMode {
+    None,     // leave it to page faults during the first decode
+    Advise,   // madvise(MADV_WILLNEED) on the tensor ranges
+    Prefault  // touch every page of the tensor ranges on a background thread
+};
+
+// Timings (ms) of every phase between "open file" and "context ready"
+struct LoadReport {
+    bool ok = false;
+    std::string error;
+    uint64_t fileSize = 0;
+    uint32_t ggufVersion = 0;
+    uint64_t tensorCount = 0;
+    uint64_t kvCount = 0;
+    double openMs = 0.0;
+    double mapMs = 0.0;
+    double validateMs = 0.0;
+    double llamaLoadMs = 0.0;
+    double contextMs = 0.0;
+    double prefetchMs = 0.0;      // background, may overlap the phases above
+    uint64_t prefetchBytes = 0;
+    bool prefetchDone = false;
+
+    std::string toJson() const;
+};
+
+// Maps a GGUF model once, validates its header and tensor table in place and
+// optionally warms the weights in tensor (= layer execution) order. llama.cpp maps
+// the same file again, so both mappings share one set of page-cache pages.
+class ModelLoader {
+public:
+    ModelLoader();
+    ~ModelLoader();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    // hotLayers < 0 warms every block; otherwise only embeddings, output and the
+    // first `hotLayers` blocks
+    void startPrefetch(PrefetchMode mode, int hotLayers = -1);
+    void waitForPrefetch();
+
+    void recordLlamaLoad(double ms);
+    void recordContext(double ms);
+
+    // Bytes of the mapped file currently in the page cache (mincore); the
+    // weights llama.cpp uses share these pages
+    uint64_t residentBytes() const;
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const GgufLayout& layout() const { return m_layout; }
+    LoadReport report() const;
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    GgufLayout m_layout;
+
+    mutable std::mutex m_reportMutex;
+    LoadReport m_report;
+
+    std::thread m_prefetchThread;
+    std::atomic<bool> m_stopPrefetch;
+
+    void prefetch(PrefetchMode mode, int hotLayers);
+};
+
+#endif // MODEL_LOADER_H
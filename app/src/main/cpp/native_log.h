@@ -0,0 +1,71 @@
+#ifndef NATIVE_LOG_H
+#define NATIVE_LOG_H
+
+// Logging for code shared between the JNI library and host tools: logcat on
+// Android, stderr everywhere else.
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+// Runtime verbosity, shared by every native module. QUIET keeps warnings and
+// errors only; user text (prompts, responses) is logged at VERBOSE alone.
+enum NativeLogVerbosity {
+    LOG_VERBOSITY_QUIET = 0,
+    LOG_VERBOSITY_NORMAL = 1,
+    LOG_VERBOSITY_VERBOSE = 2,
+};
+
+inline std::atomic<int>& nativeLogVerbosity() {
+    static std::atomic<int> verbosity{LOG_VERBOSITY_NORMAL};
+    return verbosity;
+}
+
+inline bool nativeLogVerbose() {
+    return nativeLogVerbosity().load(std::memory_order_relaxed) >= LOG_VERBOSITY_VERBOSE;
+}
+
+#ifdef __ANDROID__
+
+#include <android/log.h>
+
+__attribute__((format(printf, 3, 4)))
+inline int nativeLog(int priority, const char* tag, const char* format, ...) {
+    if (priority < ANDROID_LOG_WARN && nativeLogVerbosity().load(std::memory_order_relaxed) < LOG_VERBOSITY_NORMAL) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    const int written = __android_log_vprint(priority, tag, format, args);
+    va_end(args);
+    return written;
+}
+
+#else
+
+enum {
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_WARN = 5,
+    ANDROID_LOG_ERROR = 6,
+};
+
+__attribute__((format(printf, 3, 4)))
+inline int nativeLog(int priority, const char* tag, const char* format, ...) {
+    if (priority < ANDROID_LOG_WARN && nativeLogVerbosity().load(std::memory_order_relaxed) < LOG_VERBOSITY_NORMAL) {
+        return 0;
+    }
+    static const char kLevels[] = "??VDIWEF";
+    const char level = priority >= 0 && priority < (int) sizeof(kLevels) - 1 ? kLevels[priority] : '?';
+    va_list args;
+    va_start(args, format);
+    std::fprintf(stderr, "%c/%s: ", level, tag);
+    const int written = std::vfprintf(stderr, format, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+    return written;
+}
+
+#endif
+
+#endif // NATIVE_LOG_H
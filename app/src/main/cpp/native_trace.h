@@ -0,0 +1,44 @@
+#ifndef NATIVE_TRACE_H
+#define NATIVE_TRACE_H
+
+// Trace sections for systrace/Perfetto, recorded through ATrace under the app
+// category (capture with the app's package name). Compiled out on host builds.
+// A section ends with the scope that opened it and must nest on its thread.
+
+#ifdef __ANDROID__
+
+#include <android/trace.h>
+
+class TraceSection {
+public:
+    explicit TraceSection(const char* name) : m_enabled(ATrace_isEnabled()) {
+        if (m_enabled) {
+            ATrace_beginSection(name);
+        }
+    }
+    ~TraceSection() {
+        if (m_enabled) {
+            ATrace_endSection();
+        }
+    }
+    TraceSection(const TraceSection&) = delete;
+    TraceSection& operator=(const TraceSection&) = delete;
+
+private:
+    bool m_enabled;
+};
+
+#else
+
+class TraceSection {
+public:
+    explicit TraceSection(const char*) {}
+};
+
+#endif
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceSection TRACE_CONCAT(traceSection_, __LINE__)(name)
+
+#endif // NATIVE_TRACE_H
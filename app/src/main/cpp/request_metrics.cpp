@@ -0,0 +1,80 @@
+#include "request_metrics.h"
+#include <cstring>
+#include <sstream>
+
+std::string RequestMetrics::toJson() const {
+    std::ostringstream ss;
+    ss << "{\"finishedAtMs\":" << finishedAtMs
+       << ",\"session\":" << session
+       << ",\"promptTokens\":" << promptTokens
+       << ",\"cachedPromptTokens\":" << cachedPromptTokens
+       << ",\"generatedTokens\":" << generatedTokens
+       << ",\"draftedTokens\":" << draftedTokens
+       << ",\"acceptedDraftTokens\":" << acceptedDraftTokens
+       << ",\"queueWaitMs\":" << queueWaitMs
+       << ",\"timeToFirstTokenMs\":" << timeToFirstTokenMs
+       << ",\"prefillMs\":" << prefillMs
+       << ",\"decodeMs\":" << decodeMs
+       << ",\"totalMs\":" << totalMs
+       << ",\"tokensPerSecond\":" << tokensPerSecond
+       << ",\"cacheHit\":" << (cacheHit ? "true" : "false")
+       << ",\"stopped\":" << (stopped ? "true" : "false")
+       << ",\"ok\":" << (ok ? "true" : "false") << "}";
+    return ss.str();
+}
+
+void MetricsRing::record(const RequestMetrics& metrics) {
+    const uint64_t ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = m_slots[ticket % kCapacity];
+
+    uint64_t words[kWords] = {};
+    std::memcpy(words, &metrics, sizeof(metrics));
+
+    slot.sequence.store(2 * ticket + 1, std::memory_order_relaxed);
+    // Readers that see any of the new words also see the odd sequence
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+}
+
+std::vector<RequestMetrics> MetricsRing::snapshot() const {
+    const uint64_t end = m_next.load(std::memory_order_acquire);
+    const uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+
+    std::vector<RequestMetrics> result;
+    result.reserve((size_t) (end - begin));
+    for (uint64_t ticket = begin; ticket < end; ticket++) {
+        const Slot& slot = m_slots[ticket % kCapacity];
+        const uint64_t expected = 2 * ticket + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            continue; // still being written, or already overwritten
+        }
+        uint64_t words[kWords];
+        for (size_t i = 0; i < kWords; i++) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+            continue;
+        }
+        RequestMetrics metrics;
+        std::memcpy(&metrics, words, sizeof(metrics));
+        result.push_back(metrics);
+    }
+    return result;
+}
+
+std::string MetricsRing::toJson() const {
+    const uint64_t total = recorded();
+    std::ostringstream ss;
+    ss << "{\"recorded\":" << total << ",\"requests\":[";
+    bool first = true;
+    for (const RequestMetrics& metrics : snapshot()) {
+        ss << (first ? "" : ",") << metrics.toJson();
+        first = false;
+    }
+    ss << "]}";
+    return ss.str();
+}
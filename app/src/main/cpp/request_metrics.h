@@ -0,0 +1,64 @@
+#ifndef REQUEST_METRICS_H
+#define REQUEST_METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Outcome and timings of one generation request
+struct RequestMetrics {
+    int64_t finishedAtMs = 0;       // wall clock (ms since the epoch)
+    int32_t session = 0;
+    int32_t promptTokens = 0;
+    int32_t cachedPromptTokens = 0; // prompt tokens whose KV was reused
+    int32_t generatedTokens = 0;
+    int32_t draftedTokens = 0;
+    int32_t acceptedDraftTokens = 0;
+    float queueWaitMs = 0.0f;       // submitted until the worker picked it up
+    float timeToFirstTokenMs = 0.0f;
+    float prefillMs = 0.0f;
+    float decodeMs = 0.0f;
+    float totalMs = 0.0f;
+    float tokensPerSecond = 0.0f;   // decode rate
+    bool cacheHit = false;          // answered from the response cache
+    bool stopped = false;
+    bool ok = true;
+
+    std::string toJson() const;
+};
+
+static_assert(std::is_trivially_copyable<RequestMetrics>::value, "copied word by word through MetricsRing");
+
+// Fixed ring of the most recent RequestMetrics. Writers never block each other
+// or readers: each slot is a seqlock whose sequence number names the record it
+// holds, and a reader drops any slot that was rewritten while it was copying.
+class MetricsRing {
+public:
+    static constexpr size_t kCapacity = 64;
+
+    void record(const RequestMetrics& metrics);
+
+    // Up to kCapacity records, oldest first
+    std::vector<RequestMetrics> snapshot() const;
+    uint64_t recorded() const { return m_next.load(std::memory_order_acquire); }
+
+    // {"recorded":N,"requests":[...]} with the snapshot
+    std::string toJson() const;
+
+private:
+    static constexpr size_t kWords = (sizeof(RequestMetrics) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Slot {
+        // 2 * ticket + 1 while record `ticket` is written, 2 * ticket + 2 once done
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> words[kWords];
+    };
+
+    Slot m_slots[kCapacity];
+    std::atomic<uint64_t> m_next{0};
+};
+
+#endif // REQUEST_METRICS_H
@@ -0,0 +1,379 @@
+#include "response_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "native_log.h"
+
+#define TAG "ResponseCache"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'D', 'R', 'C'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kFileHeaderSize = 8;  // magic, version
+constexpr uint32_t kRecordMarker = 0x52656321;
+
+struct RecordHeader {
+    uint32_t marker;
+    uint32_t length;
+    uint64_t key;
+    uint32_t checksum;  // FNV-1a over key and body
+    uint32_t reserved;
+};
+
+uint32_t checksum(uint64_t key, const char* body, size_t length) {
+    uint32_t hash = 2166136261u;
+    const uint8_t* keyBytes = reinterpret_cast<const uint8_t*>(&key);
+    for (size_t i = 0; i < sizeof(key); i++) {
+        hash = (hash ^ keyBytes[i]) * 16777619u;
+    }
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t) body[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool writeAll(int fd, const void* data, size_t size, uint64_t offset) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t n = pwrite(fd, bytes, size, (off_t) offset);
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= (size_t) n;
+        offset += (uint64_t) n;
+    }
+    return true;
+}
+
+bool writeFileHeader(int fd) {
+    uint8_t header[kFileHeaderSize];
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    std::memcpy(header + sizeof(kMagic), &kVersion, sizeof(kVersion));
+    return ftruncate(fd, 0) == 0 && writeAll(fd, header, sizeof(header), 0);
+}
+
+std::vector<uint8_t> encodeRecord(uint64_t key, const std::string& response) {
+    RecordHeader header {kRecordMarker, (uint32_t) response.size(), key,
+                         checksum(key, response.data(), response.size()), 0};
+    std::vector<uint8_t> record(sizeof(header) + response.size());
+    std::memcpy(record.data(), &header, sizeof(header));
+    std::memcpy(record.data() + sizeof(header), response.data(), response.size());
+    return record;
+}
+
+} // namespace
+
+std::string ResponseCacheStats::toJson() const {
+    std::ostringstream ss;
+    ss << "{\"memoryHits\":" << memoryHits
+       << ",\"diskHits\":" << diskHits
+       << ",\"misses\":" << misses
+       << ",\"inserts\":" << inserts
+       << ",\"memoryEvictions\":" << memoryEvictions
+       << ",\"diskEvictions\":" << diskEvictions
+       << ",\"compactions\":" << compactions
+       << ",\"memoryEntries\":" << memoryEntries
+       << ",\"memoryBytes\":" << memoryBytes
+       << ",\"diskEntries\":" << diskEntries
+       << ",\"diskBytes\":" << diskBytes << "}";
+    return ss.str();
+}
+
+ResponseCache::ResponseCache(size_t maxMemoryBytes, size_t maxDiskBytes)
+    : m_maxMemoryBytes(maxMemoryBytes)
+    , m_maxDiskBytes(maxDiskBytes)
+    , m_fd(-1)
+    , m_fileSize(0)
+    , m_map(nullptr)
+    , m_mapSize(0) {
+}
+
+ResponseCache::~ResponseCache() {
+    close();
+}
+
+std::string ResponseCache::normalize(const std::string& prompt) {
+    std::string out;
+    out.reserve(prompt.size());
+    for (size_t i = 0; i < prompt.size(); i++) {
+        const unsigned char c = (unsigned char) prompt[i];
+        if (c == '?' || c == '!') {
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (!out.empty() && out.back() != ' ') {
+                out += ' ';
+            }
+            continue;
+        }
+        // Sentence punctuation, but not "1.5" or "a,b"
+        const bool atBoundary = i + 1 == prompt.size() || std::strchr(" \t\n\r?!", prompt[i + 1]) != nullptr;
+        if ((c == '.' || c == ',') && atBoundary) {
+            continue;
+        }
+        out += (char) (c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+    while (!out.empty() && out.back() == ' ') {
+        out.pop_back();
+    }
+    return out;
+}
+
+uint64_t ResponseCache::makeKey(const std::string& prompt, const std::string& identity) {
+    const std::string normalized = normalize(prompt);
+    uint64_t hash = 14695981039346656037ull;  // FNV-1a 64
+    for (char c : normalized) {
+        hash = (hash ^ (uint8_t) c) * 1099511628211ull;
+    }
+    hash = (hash ^ 0xff) * 1099511628211ull;  // separator no text byte can produce
+    for (char c : identity) {
+        hash = (hash ^ (uint8_t) c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool ResponseCache::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        unmapLocked();
+    }
+    m_disk.clear();
+    m_path = path;
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (m_fd < 0) {
+        LOGe("Cannot open response log %s, caching in memory only", path.c_str());
+        return false;
+    }
+    struct stat st {};
+    m_fileSize = fstat(m_fd, &st) == 0 ? (uint64_t) st.st_size : 0;
+    if (!indexLogLocked()) {
+        LOGi("Response log %s unreadable, starting a new one", path.c_str());
+        unmapLocked();
+        m_disk.clear();
+        if (!writeFileHeader(m_fd)) {
+            ::close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+        m_fileSize = kFileHeaderSize;
+    }
+    if (m_fileSize > m_maxDiskBytes) {
+        compactLocked();
+    }
+    LOGi("Response log %s: %zu entries, %llu bytes", path.c_str(), m_disk.size(), (unsigned long long) m_fileSize);
+    return true;
+}
+
+void ResponseCache::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    unmapLocked();
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_disk.clear();
+    m_fileSize = 0;
+}
+
+bool ResponseCache::indexLogLocked() {
+    if (m_fileSize < kFileHeaderSize || !remapLocked() ||
+        std::memcmp(m_map, kMagic, sizeof(kMagic)) != 0 ||
+        std::memcmp(m_map + sizeof(kMagic), &kVersion, sizeof(kVersion)) != 0) {
+        return false;
+    }
+
+    uint64_t offset = kFileHeaderSize;
+    while (offset + sizeof(RecordHeader) <= m_fileSize) {
+        RecordHeader header;
+        std::memcpy(&header, m_map + offset, sizeof(header));
+        const uint64_t body = offset + sizeof(header);
+        if (header.marker != kRecordMarker || header.length > m_fileSize - body ||
+            header.checksum != checksum(header.key, reinterpret_cast<const char*>(m_map + body), header.length)) {
+            break;
+        }
+        m_disk[header.key] = DiskRef{body, header.length};  // later records win
+        offset = body + header.length;
+    }
+    if (offset < m_fileSize) {
+        // Torn write from a crash; everything after it is unreachable anyway
+        LOGi("Dropping %llu bytes of damaged log tail", (unsigned long long) (m_fileSize - offset));
+        if (ftruncate(m_fd, (off_t) offset) != 0) {
+            return false;
+        }
+        m_fileSize = offset;
+    }
+    return true;
+}
+
+bool ResponseCache::remapLocked() {
+    unmapLocked();
+    if (m_fd < 0 || m_fileSize == 0) {
+        return false;
+    }
+    void* addr = mmap(nullptr, (size_t) m_fileSize, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    m_map = static_cast<const uint8_t*>(addr);
+    m_mapSize = (size_t) m_fileSize;
+    return true;
+}
+
+void ResponseCache::unmapLocked() {
+    if (m_map) {
+        munmap(const_cast<uint8_t*>(m_map), m_mapSize);
+    }
+    m_map = nullptr;
+    m_mapSize = 0;
+}
+
+bool ResponseCache::readDiskLocked(const DiskRef& ref, std::string& response) {
+    // Records appended since the last mapping need a fresh one
+    if (ref.offset + ref.length > m_mapSize && !remapLocked()) {
+        return false;
+    }
+    if (ref.offset + ref.length > m_mapSize) {
+        return false;
+    }
+    response.assign(reinterpret_cast<const char*>(m_map + ref.offset), ref.length);
+    return true;
+}
+
+bool ResponseCache::appendLocked(uint64_t key, const std::string& response) {
+    const std::vector<uint8_t> record = encodeRecord(key, response);
+    if (!writeAll(m_fd, record.data(), record.size(), m_fileSize)) {
+        LOGe("Response log append failed");
+        return false;
+    }
+    m_disk[key] = DiskRef{m_fileSize + sizeof(RecordHeader), (uint32_t) response.size()};
+    m_fileSize += record.size();
+    return true;
+}
+
+void ResponseCache::compactLocked() {
+    if (!remapLocked()) {
+        return;
+    }
+    // Newest live records first, until half the cap is used
+    std::vector<std::pair<uint64_t, DiskRef>> live(m_disk.begin(), m_disk.end());
+    std::sort(live.begin(), live.end(), [](const auto& a, const auto& b) { return a.second.offset > b.second.offset; });
+    size_t keep = 0;
+    uint64_t bytes = kFileHeaderSize;
+    while (keep < live.size() && bytes + sizeof(RecordHeader) + live[keep].second.length <= m_maxDiskBytes / 2) {
+        bytes += sizeof(RecordHeader) + live[keep].second.length;
+        keep++;
+    }
+
+    const std::string tmpPath = m_path + ".tmp";
+    const int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0 || !writeFileHeader(fd)) {
+        LOGe("Response log compaction failed: cannot create %s", tmpPath.c_str());
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return;
+    }
+    std::unordered_map<uint64_t, DiskRef> disk;
+    uint64_t offset = kFileHeaderSize;
+    bool ok = true;
+    for (size_t i = keep; i-- > 0 && ok;) {  // oldest first keeps log order
+        const std::string body(reinterpret_cast<const char*>(m_map + live[i].second.offset), live[i].second.length);
+        const std::vector<uint8_t> record = encodeRecord(live[i].first, body);
+        ok = writeAll(fd, record.data(), record.size(), offset);
+        disk[live[i].first] = DiskRef{offset + sizeof(RecordHeader), live[i].second.length};
+        offset += record.size();
+    }
+    if (!ok || std::rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+        LOGe("Response log compaction failed");
+        ::close(fd);
+        std::remove(tmpPath.c_str());
+        return;
+    }
+
+    unmapLocked();
+    ::close(m_fd);
+    m_fd = fd;
+    m_fileSize = offset;
+    m_disk.swap(disk);
+    m_stats.diskEvictions += live.size() - keep;
+    m_stats.compactions++;
+    LOGi("Compacted response log to %zu entries (%llu bytes)", keep, (unsigned long long) offset);
+}
+
+void ResponseCache::rememberLocked(uint64_t key, const std::string& response) {
+    auto it = m_memory.find(key);
+    if (it != m_memory.end()) {
+        m_stats.memoryBytes -= it->second->second.size();
+        m_lru.erase(it->second);
+    }
+    m_lru.emplace_front(key, response);
+    m_memory[key] = m_lru.begin();
+    m_stats.memoryBytes += response.size();
+    while (m_stats.memoryBytes > m_maxMemoryBytes && m_lru.size() > 1) {
+        m_stats.memoryBytes -= m_lru.back().second.size();
+        m_memory.erase(m_lru.back().first);
+        m_lru.pop_back();
+        m_stats.memoryEvictions++;
+    }
+}
+
+bool ResponseCache::lookup(uint64_t key, std::string& response) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_memory.find(key);
+    if (it != m_memory.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        response = it->second->second;
+        m_stats.memoryHits++;
+        return true;
+    }
+    auto disk = m_disk.find(key);
+    if (disk != m_disk.end() && readDiskLocked(disk->second, response)) {
+        rememberLocked(key, response);
+        m_stats.diskHits++;
+        return true;
+    }
+    m_stats.misses++;
+    return false;
+}
+
+void ResponseCache::insert(uint64_t key, const std::string& response) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    rememberLocked(key, response);
+    m_stats.inserts++;
+    if (m_fd >= 0 && appendLocked(key, response) && m_fileSize > m_maxDiskBytes) {
+        compactLocked();
+    }
+}
+
+void ResponseCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_memory.clear();
+    m_disk.clear();
+    m_stats.memoryBytes = 0;
+    if (m_fd >= 0) {
+        unmapLocked();
+        m_fileSize = writeFileHeader(m_fd) ? kFileHeaderSize : 0;
+    }
+}
+
+ResponseCacheStats ResponseCache::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResponseCacheStats stats = m_stats;
+    stats.memoryEntries = m_lru.size();
+    stats.diskEntries = m_disk.size();
+    stats.diskBytes = (size_t) m_fileSize;
+    return stats;
+}
@@ -0,0 +1,90 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct ResponseCacheStats {
+    uint64_t memoryHits = 0;
+    uint64_t diskHits = 0;
+    uint64_t misses = 0;
+    uint64_t inserts = 0;
+    uint64_t memoryEvictions = 0;
+    uint64_t diskEvictions = 0;
+    uint64_t compactions = 0;
+    size_t memoryEntries = 0;
+    size_t memoryBytes = 0;
+    size_t diskEntries = 0;
+    size_t diskBytes = 0;
+
+    std::string toJson() const;
+};
+
+// Completed responses keyed by a hash of the normalized prompt plus everything
+// that shapes the output (model, sampling parameters, token budget).
+//
+// Two tiers: an in-memory LRU capped at maxMemoryBytes, and an append-only log
+// file that survives restarts. The log is mmapped for reads; records carry a
+// checksum so a torn tail from a crash is dropped on open. When the log grows
+// past maxDiskBytes it is compacted to the newest live entries (half the cap).
+// Thread-safe.
+class ResponseCache {
+public:
+    explicit ResponseCache(size_t maxMemoryBytes = 512 * 1024, size_t maxDiskBytes = 4 * 1024 * 1024);
+    ~ResponseCache();
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    // Opens (creating if needed) the log at `path` and indexes its records.
+    // Without an open log the cache works memory-only.
+    bool open(const std::string& path);
+    void close();
+
+    // Lowercase, whitespace collapsed, '?'/'!' dropped and sentence punctuation
+    // before whitespace or the end removed: "Calories in  Apple?" == "calories in apple"
+    static std::string normalize(const std::string& prompt);
+
+    // `identity` describes the model and generation settings
+    static uint64_t makeKey(const std::string& prompt, const std::string& identity);
+
+    bool lookup(uint64_t key, std::string& response);
+    void insert(uint64_t key, const std::string& response);
+    void clear();
+    ResponseCacheStats stats() const;
+
+private:
+    struct DiskRef {
+        uint64_t offset;   // of the record body
+        uint32_t length;
+    };
+    using LruList = std::list<std::pair<uint64_t, std::string>>;
+
+    size_t m_maxMemoryBytes;
+    size_t m_maxDiskBytes;
+
+    mutable std::mutex m_mutex;
+    LruList m_lru;  // most recent first
+    std::unordered_map<uint64_t, LruList::iterator> m_memory;
+    std::unordered_map<uint64_t, DiskRef> m_disk;
+    ResponseCacheStats m_stats;
+
+    std::string m_path;
+    int m_fd;
+    uint64_t m_fileSize;
+    const uint8_t* m_map;
+    size_t m_mapSize;
+
+    void rememberLocked(uint64_t key, const std::string& response);
+    bool readDiskLocked(const DiskRef& ref, std::string& response);
+    bool appendLocked(uint64_t key, const std::string& response);
+    bool indexLogLocked();
+    bool remapLocked();
+    void compactLocked();
+    void unmapLocked();
+};
+
+#endif // RESPONSE_CACHE_H
@@ -0,0 +1,190 @@
+#include "semantic_index.h"
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#include "json_reader.h"
+#include "llama_wrapper.h"
+#include "native_log.h"
+
+#define TAG "SemanticIndex"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+// Documents embedded per LlamaWrapper::embed call while building
+constexpr size_t kBuildChunk = 64;
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Identifies both the documents and the model that embedded them
+uint64_t sourceHash(const LlamaWrapper& wrapper, const std::vector<SemanticDocument>& docs) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const SemanticDocument& doc : docs) {
+        hash = fnv1a(hash, doc.name.data(), doc.name.size() + 1);
+        hash = fnv1a(hash, &doc.kind, sizeof(doc.kind));
+        hash = fnv1a(hash, doc.text.data(), doc.text.size() + 1);
+    }
+    const uint64_t modelSize = wrapper.getModelSize();
+    const int32_t dim = wrapper.embeddingSize();
+    hash = fnv1a(hash, &modelSize, sizeof(modelSize));
+    return fnv1a(hash, &dim, sizeof(dim));
+}
+
+std::string foodText(const JsonValue& item) {
+    const double calories = item.numberOr("caloriesPerUnit", 0.0);
+    const double protein = item.numberOr("proteinPerUnit", 0.0);
+    const double fiber = item.numberOr("fiberPerUnit", 0.0);
+    const double sugar = item.numberOr("sugarPerUnit", 0.0);
+
+    std::ostringstream ss;
+    const std::string description = item.stringOr("description", "");
+    ss << item.stringOr("name", "") << ". " << item.stringOr("category", "") << ". " << description;
+    if (!description.empty() && description.back() != '.') ss << ".";
+    if (protein >= 10.0 || (calories > 0.0 && protein * 4.0 / calories >= 0.3)) ss << " High protein.";
+    if (calories > 0.0 && calories <= 100.0) ss << " Low calorie.";
+    if (fiber >= 5.0) ss << " High fiber.";
+    if (sugar >= 15.0) ss << " Sweet, high sugar.";
+    ss << (item.boolOr("isVeg", true) ? " Vegetarian." : " Non-vegetarian.");
+    if (item.boolOr("isGlutenFree", false)) ss << " Gluten free.";
+    if (item.boolOr("isDairyFree", false)) ss << " Dairy free.";
+    return ss.str();
+}
+
+std::string recipeText(const JsonValue& recipe) {
+    std::ostringstream ss;
+    ss << recipe.stringOr("name", "") << ". " << recipe.stringOr("mealType", "") << ", "
+       << recipe.stringOr("cuisine", "") << " recipe.";
+
+    const JsonValue* tags = recipe.get("tags");
+    if (tags && tags->isArray()) {
+        for (const JsonValue& tag : tags->items) {
+            ss << " " << tag.string << ".";
+        }
+    }
+    const JsonValue* macros = recipe.get("macros");
+    if (macros && macros->isObject()) {
+        const double calories = macros->numberOr("calories", 0.0);
+        const double protein = macros->numberOr("protein", 0.0);
+        if (protein >= 15.0 || (calories > 0.0 && protein * 4.0 / calories >= 0.3)) ss << " High protein.";
+        if (calories > 0.0 && calories <= 250.0) ss << " Light, low calorie.";
+    }
+    const JsonValue* ingredients = recipe.get("ingredients");
+    if (ingredients && ingredients->isArray()) {
+        ss << " Ingredients:";
+        for (const JsonValue& ingredient : ingredients->items) {
+            ss << " " << ingredient.stringOr("item", "") << ",";
+        }
+    }
+    return ss.str();
+}
+
+} // namespace
+
+bool collectSemanticDocuments(const char* json, size_t size, std::vector<SemanticDocument>& out, std::string& error) {
+    // Some bundled assets carry stray text before the document
+    size_t start = 0;
+    while (start < size && json[start] != '{' && json[start] != '[') {
+        start++;
+    }
+    JsonValue root;
+    if (!parseJson(json + start, size - start, root, error)) {
+        return false;
+    }
+
+    const JsonValue* foods = root.get("foodItems");
+    if (foods && foods->isArray()) {
+        for (const JsonValue& item : foods->items) {
+            const std::string name = item.stringOr("name", "");
+            if (!name.empty()) {
+                out.push_back(SemanticDocument{name, SEMANTIC_FOOD, foodText(item)});
+            }
+        }
+        return true;
+    }
+    if (root.isArray()) {
+        for (const JsonValue& recipe : root.items) {
+            const std::string name = recipe.stringOr("name", "");
+            if (!name.empty()) {
+                out.push_back(SemanticDocument{name, SEMANTIC_RECIPE, recipeText(recipe)});
+            }
+        }
+        return true;
+    }
+    error = "neither a food database nor a recipe list";
+    return false;
+}
+
+bool SemanticIndex::openOrBuild(LlamaWrapper& wrapper, const std::vector<SemanticDocument>& docs, const std::string& path) {
+    if (docs.empty() || wrapper.embeddingSize() <= 0) {
+        return false;
+    }
+    const uint64_t hash = sourceHash(wrapper, docs);
+    if (m_index.open(path, hash)) {
+        return true;
+    }
+
+    LOGi("Building semantic index over %zu documents", docs.size());
+    auto start = std::chrono::steady_clock::now();
+    const uint32_t dim = (uint32_t) wrapper.embeddingSize();
+    std::vector<float> vectors;
+    vectors.reserve(docs.size() * dim);
+    std::vector<std::string> labels;
+    std::vector<uint32_t> tags;
+    std::vector<std::string> texts;
+    std::vector<float> chunk;
+    for (size_t i = 0; i < docs.size(); i += kBuildChunk) {
+        texts.clear();
+        for (size_t j = i; j < docs.size() && j < i + kBuildChunk; j++) {
+            texts.push_back(docs[j].text);
+            labels.push_back(docs[j].name);
+            tags.push_back(docs[j].kind);
+        }
+        if (!wrapper.embed(texts, chunk)) {
+            LOGe("Embedding failed at document %zu", i);
+            return false;
+        }
+        vectors.insert(vectors.end(), chunk.begin(), chunk.end());
+    }
+
+    std::string error;
+    if (!VectorIndex::write(path, dim, vectors, labels, tags, hash, error)) {
+        LOGe("Failed to write semantic index: %s", error.c_str());
+        return false;
+    }
+    LOGi("Semantic index built in %.1f s",
+         std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return m_index.open(path, hash);
+}
+
+std::vector<SemanticMatch> SemanticIndex::search(LlamaWrapper& wrapper, const std::string& query, size_t k,
+                                                 uint32_t kindMask) const {
+    std::vector<SemanticMatch> matches;
+    std::vector<float> embedding;
+    if (!m_index.isOpen() || (int32_t) m_index.dim() != wrapper.embeddingSize() ||
+        !wrapper.embed({query}, embedding)) {
+        return matches;
+    }
+    for (const VectorHit& hit : m_index.search(embedding.data(), k, kindMask)) {
+        matches.push_back(SemanticMatch{m_index.label(hit.row), (SemanticKind) m_index.tag(hit.row), hit.score});
+    }
+    return matches;
+}
+
+std::string semanticMatchesJson(const std::vector<SemanticMatch>& matches) {
+    std::ostringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < matches.size(); i++) {
+        ss << (i ? "," : "") << "{\"name\":\"" << jsonEscape(matches[i].name) << "\",\"kind\":\""
+           << (matches[i].kind == SEMANTIC_RECIPE ? "recipe" : "food") << "\",\"score\":" << matches[i].score << "}";
+    }
+    ss << "]";
+    return ss.str();
+}
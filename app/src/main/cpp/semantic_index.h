@@ -0,0 +1,56 @@
+#ifndef SEMANTIC_INDEX_H
+#define SEMANTIC_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "vector_index.h"
+
+class LlamaWrapper;
+
+// Kinds double as VectorIndex tags; search masks are (1 << kind)
+enum SemanticKind : uint32_t {
+    SEMANTIC_FOOD = 0,
+    SEMANTIC_RECIPE = 1,
+};
+
+struct SemanticDocument {
+    std::string name;
+    SemanticKind kind;
+    std::string text;  // what gets embedded
+};
+
+struct SemanticMatch {
+    std::string name;
+    SemanticKind kind;
+    float score;
+};
+
+// Appends one document per food ({"foodItems": [...]}) or recipe (top-level
+// array) in a bundled JSON asset. Macro values become words ("high protein",
+// "low calorie", ...) so they are reachable from free-text queries.
+bool collectSemanticDocuments(const char* json, size_t size, std::vector<SemanticDocument>& out, std::string& error);
+
+// Embedding index over food and recipe documents, cached at a file keyed by
+// the documents and the model; queries cost one embedding pass plus an int8 scan.
+class SemanticIndex {
+public:
+    // Opens the cached index at `path` or, if missing or stale, embeds `docs`
+    // and writes it
+    bool openOrBuild(LlamaWrapper& wrapper, const std::vector<SemanticDocument>& docs, const std::string& path);
+    void close() { m_index.close(); }
+    bool isOpen() const { return m_index.isOpen(); }
+
+    std::vector<SemanticMatch> search(LlamaWrapper& wrapper, const std::string& query, size_t k,
+                                      uint32_t kindMask = ~0u) const;
+
+private:
+    VectorIndex m_index;
+};
+
+// [{"name":..,"kind":"food"|"recipe","score":..}, ...]
+std::string semanticMatchesJson(const std::vector<SemanticMatch>& matches);
+
+#endif // SEMANTIC_INDEX_H
@@ -0,0 +1,196 @@
+#include "speculative.h"
+#include <algorithm>
+#include <sstream>
+
+#include "llama_wrapper.h"
+#include "native_log.h"
+
+#define TAG "Speculative"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+uint64_t NgramDrafter::hashNgram(const llama_token* tokens, int n) {
+    uint64_t hash = 14695981039346656037ull ^ (uint64_t) n;
+    for (int i = 0; i < n; i++) {
+        hash = (hash ^ (uint32_t) tokens[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void NgramDrafter::addDocument(const std::vector<llama_token>& tokens) {
+    const size_t start = m_corpus.size();
+    m_corpus.insert(m_corpus.end(), tokens.begin(), tokens.end());
+    m_corpus.push_back(-1);
+    for (size_t i = start; i + kMinNgram < m_corpus.size(); i++) {
+        for (int n = kMinNgram; n <= kMaxNgram && i + n < m_corpus.size(); n++) {
+            if (m_corpus[i + n - 1] < 0 || m_corpus[i + n] < 0) {
+                break;  // n-gram or its continuation would cross the separator
+            }
+            // First occurrence wins, so earlier (more canonical) text is preferred
+            m_table.emplace(hashNgram(&m_corpus[i], n), (uint32_t) (i + n));
+        }
+    }
+}
+
+void NgramDrafter::draft(llama_seq_id seq, const std::vector<llama_token>& context, int32_t maxTokens,
+                         std::vector<llama_token>& out) {
+    (void) seq;
+    const size_t size = context.size();
+    for (int n = kMaxNgram; n >= kMinNgram; n--) {
+        if (size <= (size_t) n) {
+            continue;
+        }
+        const llama_token* tail = &context[size - n];
+
+        // Prompt lookup: the answer often repeats food names from the question
+        for (size_t i = size - n; i-- > 0;) {
+            if (std::equal(tail, tail + n, &context[i])) {
+                for (size_t j = i + n; j < size && (int32_t) out.size() < maxTokens; j++) {
+                    out.push_back(context[j]);
+                }
+                return;
+            }
+        }
+
+        auto it = m_table.find(hashNgram(tail, n));
+        if (it != m_table.end()) {
+            for (size_t j = it->second; j < m_corpus.size() && m_corpus[j] >= 0 && (int32_t) out.size() < maxTokens; j++) {
+                out.push_back(m_corpus[j]);
+            }
+            return;
+        }
+    }
+}
+
+DraftModelDrafter::DraftModelDrafter()
+    : m_model(nullptr)
+    , m_context(nullptr)
+    , m_sampler(nullptr)
+    , m_batch()
+    , m_batchSize(0) {
+}
+
+DraftModelDrafter::~DraftModelDrafter() {
+    if (m_sampler) {
+        llama_sampler_free(m_sampler);
+    }
+    if (m_context) {
+        llama_batch_free(m_batch);
+        llama_free(m_context);
+    }
+    if (m_model) {
+        llama_free_model(m_model);
+    }
+}
+
+bool DraftModelDrafter::open(const std::string& path, const llama_model* target, uint32_t nCtx, uint32_t nSeq, int32_t threads) {
+    llama_model_params modelParams = llama_model_default_params();
+    modelParams.n_gpu_layers = 0;
+    m_model = llama_load_model_from_file(path.c_str(), modelParams);
+    if (!m_model) {
+        LOGe("Failed to load draft model: %s", path.c_str());
+        return false;
+    }
+    // Draft tokens are compared id-for-id with the target's samples
+    if (llama_n_vocab(m_model) != llama_n_vocab(target) ||
+        llama_token_bos(m_model) != llama_token_bos(target) ||
+        llama_token_eos(m_model) != llama_token_eos(target)) {
+        LOGe("Draft model %s does not share the target vocabulary", path.c_str());
+        return false;
+    }
+
+    llama_context_params params = llama_context_default_params();
+    params.n_ctx = nCtx;
+    params.n_batch = 256;
+    params.n_seq_max = nSeq;
+    params.n_threads = threads;
+    params.n_threads_batch = threads;
+    m_context = llama_new_context_with_model(m_model, params);
+    if (!m_context) {
+        LOGe("Failed to create draft context");
+        return false;
+    }
+    m_batchSize = (int32_t) params.n_batch;
+    m_batch = llama_batch_init(m_batchSize, 0, 1);
+    m_sampler = llama_sampler_chain_init(llama_sampler_chain_default_params());
+    llama_sampler_chain_add(m_sampler, llama_sampler_init_greedy());
+    LOGi("Draft model ready: %s", path.c_str());
+    return true;
+}
+
+void DraftModelDrafter::draft(llama_seq_id seq, const std::vector<llama_token>& context, int32_t maxTokens,
+                              std::vector<llama_token>& out) {
+    std::vector<llama_token>& cached = m_cached[seq];
+    size_t common = 0;
+    while (common < cached.size() && common < context.size() && cached[common] == context[common]) {
+        common++;
+    }
+    // Evaluate at least the last token so there are logits to draft from
+    if (common == context.size() && common > 0) {
+        common--;
+    }
+    llama_kv_cache_seq_rm(m_context, seq, (llama_pos) common, -1);
+    cached.resize(common);
+
+    int32_t logitsIndex = -1;
+    for (size_t i = common; i < context.size(); i += m_batchSize) {
+        const size_t end = std::min(context.size(), i + m_batchSize);
+        llamaBatchClear(m_batch);
+        for (size_t j = i; j < end; j++) {
+            llamaBatchAdd(m_batch, context[j], (llama_pos) j, seq, j + 1 == context.size());
+        }
+        if (llama_decode(m_context, m_batch) != 0) {
+            llama_kv_cache_seq_rm(m_context, seq, -1, -1);
+            cached.clear();
+            return;
+        }
+        cached.insert(cached.end(), context.begin() + i, context.begin() + end);
+        logitsIndex = m_batch.n_tokens - 1;
+    }
+
+    llama_sampler_reset(m_sampler);
+    for (int32_t i = 0; i < maxTokens && logitsIndex >= 0; i++) {
+        const llama_token token = llama_sampler_sample(m_sampler, m_context, logitsIndex);
+        if (llama_token_is_eog(m_model, token)) {
+            break;
+        }
+        out.push_back(token);
+        if (i + 1 == maxTokens) {
+            break;  // the last draft never needs evaluating
+        }
+        llamaBatchClear(m_batch);
+        llamaBatchAdd(m_batch, token, (llama_pos) cached.size(), seq, true);
+        if (llama_decode(m_context, m_batch) != 0) {
+            break;
+        }
+        cached.push_back(token);
+        logitsIndex = 0;
+    }
+}
+
+void SpeculativeStats::reset() {
+    steps = 0;
+    tokens = 0;
+    drafted = 0;
+    accepted = 0;
+    draftMicros = 0;
+}
+
+std::string SpeculativeStats::toJson(const char* mode, int32_t maxDraft) const {
+    const uint64_t nSteps = steps.load();
+    const uint64_t nTokens = tokens.load();
+    const uint64_t nDrafted = drafted.load();
+    const uint64_t nAccepted = accepted.load();
+    std::ostringstream ss;
+    ss << "{\"mode\":\"" << mode << "\""
+       << ",\"maxDraft\":" << maxDraft
+       << ",\"steps\":" << nSteps
+       << ",\"tokens\":" << nTokens
+       << ",\"drafted\":" << nDrafted
+       << ",\"accepted\":" << nAccepted
+       << ",\"acceptanceRate\":" << (nDrafted ? (double) nAccepted / nDrafted : 0.0)
+       // Tokens per target forward pass; 1.0 is plain decoding
+       << ",\"tokensPerStep\":" << (nSteps ? (double) nTokens / nSteps : 0.0)
+       << ",\"draftMs\":" << draftMicros.load() / 1000.0 << "}";
+    return ss.str();
+}
@@ -0,0 +1,88 @@
+#ifndef SPECULATIVE_H
+#define SPECULATIVE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "llama.h"
+
+// Proposes tokens likely to follow a sequence; LlamaWrapper evaluates them in
+// the same forward pass as the sampled token and keeps the prefix the target
+// model agrees with, so output is identical to plain decoding.
+class Drafter {
+public:
+    virtual ~Drafter() = default;
+
+    // Appends up to maxTokens guesses for what follows `context` (every token
+    // of the sequence so far, the last one not yet sampled from) to `out`.
+    // Called on the thread that runs llama_decode.
+    virtual void draft(llama_seq_id seq, const std::vector<llama_token>& context, int32_t maxTokens,
+                       std::vector<llama_token>& out) = 0;
+
+    virtual const char* name() const = 0;
+};
+
+// Prompt and corpus lookup: the longest recent n-gram (3, then 2 tokens) is
+// matched first against the sequence itself, then against a corpus of food and
+// recipe text, and the tokens that followed it become the draft.
+class NgramDrafter : public Drafter {
+public:
+    // One document's tokens; n-grams never span documents
+    void addDocument(const std::vector<llama_token>& tokens);
+    size_t corpusTokens() const { return m_corpus.size(); }
+
+    void draft(llama_seq_id seq, const std::vector<llama_token>& context, int32_t maxTokens,
+               std::vector<llama_token>& out) override;
+    const char* name() const override { return "ngram"; }
+
+private:
+    static constexpr int kMaxNgram = 3;
+    static constexpr int kMinNgram = 2;
+
+    std::vector<llama_token> m_corpus;                 // documents separated by -1
+    std::unordered_map<uint64_t, uint32_t> m_table;    // n-gram hash -> corpus index after it
+
+    static uint64_t hashNgram(const llama_token* tokens, int n);
+};
+
+// Greedy drafts from a small GGUF sharing the target's vocabulary. Keeps one KV
+// sequence per target sequence and re-syncs it to the common prefix each call.
+class DraftModelDrafter : public Drafter {
+public:
+    DraftModelDrafter();
+    ~DraftModelDrafter() override;
+    DraftModelDrafter(const DraftModelDrafter&) = delete;
+    DraftModelDrafter& operator=(const DraftModelDrafter&) = delete;
+
+    bool open(const std::string& path, const llama_model* target, uint32_t nCtx, uint32_t nSeq, int32_t threads);
+
+    void draft(llama_seq_id seq, const std::vector<llama_token>& context, int32_t maxTokens,
+               std::vector<llama_token>& out) override;
+    const char* name() const override { return "draft_model"; }
+
+private:
+    llama_model* m_model;
+    llama_context* m_context;
+    llama_sampler* m_sampler;
+    llama_batch m_batch;
+    int32_t m_batchSize;
+    std::unordered_map<llama_seq_id, std::vector<llama_token>> m_cached;
+};
+
+// Counters across all sequences since speculation was last configured;
+// written on the decode thread, read from anywhere
+struct SpeculativeStats {
+    std::atomic<uint64_t> steps{0};           // forward passes that sampled tokens
+    std::atomic<uint64_t> tokens{0};          // tokens emitted by those passes
+    std::atomic<uint64_t> drafted{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> draftMicros{0};     // time spent producing drafts
+
+    void reset();
+    std::string toJson(const char* mode, int32_t maxDraft) const;
+};
+
+#endif // SPECULATIVE_H
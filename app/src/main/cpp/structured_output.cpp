@@ -0,0 +1,134 @@
+#include "structured_output.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <memory>
+
+const char* const kFoodLogUnits[] = {
+    "g", "ml", "piece", "cup", "bowl", "plate", "glass", "slice", "tbsp", "tsp", "serving",
+};
+const size_t kFoodLogUnitCount = sizeof(kFoodLogUnits) / sizeof(kFoodLogUnits[0]);
+
+namespace {
+
+struct TrieNode {
+    std::map<char, std::unique_ptr<TrieNode>> children;
+    bool terminal = false;
+};
+
+// Plain printable ASCII without quotes or backslashes needs no escaping in
+// either the JSON output or the GBNF literal
+bool isGrammarSafe(const std::string& name) {
+    return !name.empty() && std::all_of(name.begin(), name.end(), [](char c) {
+        return c >= 0x20 && c < 0x7f && c != '"' && c != '\\';
+    });
+}
+
+// Alternatives for everything below `node`; single-child chains collapse into
+// one literal
+std::string trieExpression(const TrieNode& node) {
+    std::vector<std::string> alternatives;
+    for (const auto& child : node.children) {
+        std::string literal(1, child.first);
+        const TrieNode* next = child.second.get();
+        while (!next->terminal && next->children.size() == 1) {
+            literal += next->children.begin()->first;
+            next = next->children.begin()->second.get();
+        }
+        std::string alternative = "\"" + literal + "\"";
+        const std::string rest = trieExpression(*next);
+        if (!rest.empty()) {
+            alternative += " " + rest;
+        }
+        alternatives.push_back(alternative);
+    }
+    if (alternatives.empty()) {
+        return std::string();
+    }
+
+    std::string body;
+    for (const std::string& alternative : alternatives) {
+        body += (body.empty() ? "" : " | ") + alternative;
+    }
+    if (node.terminal) {
+        return "(" + body + ")?";
+    }
+    return alternatives.size() == 1 ? body : "(" + body + ")";
+}
+
+} // namespace
+
+std::string buildFoodLogGrammar(const std::vector<std::string>& foodNames) {
+    TrieNode root;
+    for (std::string name : foodNames) {
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+        if (!isGrammarSafe(name)) {
+            continue;
+        }
+        TrieNode* node = &root;
+        for (char c : name) {
+            std::unique_ptr<TrieNode>& child = node->children[c];
+            if (!child) {
+                child = std::make_unique<TrieNode>();
+            }
+            node = child.get();
+        }
+        node->terminal = true;
+    }
+
+    std::string units;
+    for (size_t i = 0; i < kFoodLogUnitCount; i++) {
+        units += std::string(i ? " | " : "") + "\"" + kFoodLogUnits[i] + "\"";
+    }
+
+    std::string grammar;
+    grammar += "root ::= \"[\" ( item ( \",\" ws item )* )? \"]\"\n";
+    grammar += "item ::= \"{\\\"name\\\":\\\"\" name \"\\\",\\\"quantity\\\":\" quantity \",\\\"unit\\\":\\\"\" unit \"\\\"}\"\n";
+    grammar += "quantity ::= ( [1-9] [0-9]? [0-9]? [0-9]? | \"0\" ) ( \".\" [0-9] [0-9]? )?\n";
+    grammar += "unit ::= " + units + "\n";
+    grammar += "ws ::= \" \"?\n";
+    const std::string names = trieExpression(root);
+    // An empty food list still has to produce a parseable grammar
+    grammar += "name ::= " + (names.empty() ? std::string("[a-z] [a-z ]*") : names) + "\n";
+    return grammar;
+}
+
+void StructureTracker::reset() {
+    *this = StructureTracker();
+}
+
+size_t StructureTracker::feed(const std::string& text) {
+    if (m_closed) {
+        return 0;
+    }
+    for (size_t i = 0; i < text.size(); i++) {
+        const char c = text[i];
+        if (!m_opened) {
+            // Anything before the structure (a stray space) is passed through
+            if (c == '[' || c == '{') {
+                m_opened = true;
+                m_depth = 1;
+            }
+            continue;
+        }
+        if (m_inString) {
+            if (m_escaped) {
+                m_escaped = false;
+            } else if (c == '\\') {
+                m_escaped = true;
+            } else if (c == '"') {
+                m_inString = false;
+            }
+            continue;
+        }
+        if (c == '"') {
+            m_inString = true;
+        } else if (c == '[' || c == '{') {
+            m_depth++;
+        } else if ((c == ']' || c == '}') && --m_depth == 0) {
+            m_closed = true;
+            return i + 1;
+        }
+    }
+    return std::string::npos;
+}
@@ -0,0 +1,39 @@
+#ifndef STRUCTURED_OUTPUT_H
+#define STRUCTURED_OUTPUT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Units the food log grammar accepts for a quantity
+extern const char* const kFoodLogUnits[];
+extern const size_t kFoodLogUnitCount;
+
+// GBNF for a compact JSON food log,
+//   [{"name":"rice","quantity":1.5,"unit":"cup"}, ...]
+// where every name is one of `foodNames` (lowercased; names that cannot be
+// spelled as a plain JSON string are skipped). Names are emitted as a trie of
+// alternatives so the grammar sampler tracks one stack per shared prefix
+// instead of one per food.
+std::string buildFoodLogGrammar(const std::vector<std::string>& foodNames);
+
+// Follows the outermost JSON array/object of a response as it streams in, so
+// generation can stop on the closing bracket instead of waiting for EOS.
+class StructureTracker {
+public:
+    void reset();
+
+    // Feeds newly generated text; returns how many of its bytes belong to the
+    // structure once it closes, or std::string::npos while it is still open
+    size_t feed(const std::string& text);
+    bool closed() const { return m_closed; }
+
+private:
+    int m_depth = 0;
+    bool m_opened = false;
+    bool m_closed = false;
+    bool m_inString = false;
+    bool m_escaped = false;
+};
+
+#endif // STRUCTURED_OUTPUT_H
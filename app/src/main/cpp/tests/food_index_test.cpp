@@ -0,0 +1,159 @@
+// Compiled food index: lookups and searches against linear-scan references
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "food_index.h"
+#include "native_test.h"
+
+namespace {
+
+const char* const kFoods = R"({"foodItems": [
+    {"name": "Idli", "category": "South Indian", "unit": "piece", "caloriesPerUnit": 40,
+     "proteinPerUnit": 2.5, "isVeg": true, "isGlutenFree": true, "isDairyFree": true},
+    {"name": "Masala Dosa", "category": "South Indian", "unit": "piece", "caloriesPerUnit": 180},
+    {"name": "Chicken Curry", "category": "Curry", "unit": "bowl", "caloriesPerUnit": 250,
+     "proteinPerUnit": 22, "isVeg": false, "isDairyFree": false},
+    {"name": "Butter  Chicken", "category": "Curry", "unit": "bowl", "caloriesPerUnit": 420, "isVeg": false},
+    {"name": "Paneer Tikka", "category": "Starter", "unit": "plate", "caloriesPerUnit": 300, "isDairyFree": false},
+    {"name": "Rice", "category": "Grain", "unit": "cup", "caloriesPerUnit": 205, "sodiumPerUnit": 2},
+    {"name": "Jeera Rice", "category": "Grain", "unit": "cup", "caloriesPerUnit": 240},
+    {"name": "RICE", "category": "Duplicate", "unit": "cup", "caloriesPerUnit": 1},
+    {"name": "Dal Tadka", "category": "Dal", "unit": "bowl", "caloriesPerUnit": 190, "fiberPerUnit": 6},
+    {"name": "Chickpea Salad", "category": "Salad", "unit": "bowl", "caloriesPerUnit": 160}
+]})";
+
+struct CompiledIndex {
+    std::string path;
+    FoodIndex index;
+
+    CompiledIndex() {
+        char tmpl[] = "/tmp/native_tests_food_XXXXXX";
+        const int fd = mkstemp(tmpl);
+        if (fd >= 0) {
+            close(fd);
+            path = tmpl;
+        }
+        std::string error;
+        if (!path.empty() && FoodIndex::compile(kFoods, std::strlen(kFoods), path, error)) {
+            index.open(path, FoodIndex::sourceHash(kFoods, std::strlen(kFoods)));
+        }
+    }
+
+    ~CompiledIndex() {
+        index.close();
+        if (!path.empty()) {
+            std::remove(path.c_str());
+        }
+    }
+};
+
+// Lowercase names with some word start from which the name begins with `key`
+std::set<std::string> prefixReference(const FoodIndex& index, const std::string& key) {
+    std::set<std::string> names;
+    for (uint32_t row = 0; row < index.size(); row++) {
+        const std::string name = foodKey(index.name((int32_t) row));
+        for (size_t start = 0; start < name.size(); start = name.find(' ', start) + 1) {
+            if (name.compare(start, key.size(), key) == 0) {
+                names.insert(name);
+            }
+            if (name.find(' ', start) == std::string::npos) {
+                break;
+            }
+        }
+    }
+    return names;
+}
+
+} // namespace
+
+TEST(foodIndexOpensOnlyMatchingSource) {
+    CompiledIndex compiled;
+    CHECK(compiled.index.isOpen());
+    CHECK(compiled.index.size() == 10);
+
+    FoodIndex stale;
+    CHECK(!stale.open(compiled.path, 12345));
+    CHECK(!stale.open("/nonexistent/food.idx"));
+
+    std::string error;
+    CHECK(!FoodIndex::compile("{\"foodItems\": []}", 17, compiled.path + ".empty", error));
+    CHECK(!error.empty());
+}
+
+TEST(foodIndexFindMatchesLinearScan) {
+    CompiledIndex compiled;
+    const FoodIndex& index = compiled.index;
+    for (uint32_t row = 0; row < index.size(); row++) {
+        // First row wins for names that differ only in case or spacing
+        const std::string key = foodKey(index.name((int32_t) row));
+        int32_t expected = -1;
+        for (uint32_t other = 0; other < index.size() && expected < 0; other++) {
+            if (foodKey(index.name((int32_t) other)) == key) {
+                expected = (int32_t) other;
+            }
+        }
+        CHECK(index.find(index.name((int32_t) row)) == expected);
+    }
+    CHECK(index.find("  butter chicken ") == 3);
+    CHECK(index.find("rice") == 5);
+    CHECK(index.find("MASALA   DOSA") == 1);
+    CHECK(index.find("dosa") == -1);
+    CHECK(index.find("") == -1);
+}
+
+TEST(foodIndexStoresColumnsAndFlags) {
+    CompiledIndex compiled;
+    const FoodIndex& index = compiled.index;
+    const int32_t curry = index.find("chicken curry");
+    CHECK(curry == 2);
+    if (curry < 0) {
+        return;
+    }
+    CHECK(index.value(curry, FOOD_CALORIES) == 250.0f);
+    CHECK(index.value(curry, FOOD_PROTEIN) == 22.0f);
+    CHECK(index.value(curry, FOOD_SUGAR) == 0.0f);
+    CHECK(std::string(index.unit(curry)) == "bowl");
+    CHECK(std::string(index.category(curry)) == "Curry");
+    CHECK(!index.flag(curry, FOOD_VEG));
+    CHECK(!index.flag(curry, FOOD_DAIRY_FREE));
+    // Missing flags default to true, as in FoodDatabaseImporter
+    CHECK(index.flag(curry, FOOD_GLUTEN_FREE));
+    CHECK(index.flag(index.find("masala dosa"), FOOD_VEG));
+}
+
+TEST(foodIndexPrefixSearchMatchesReference) {
+    CompiledIndex compiled;
+    const FoodIndex& index = compiled.index;
+    for (const char* prefix : {"ri", "rice", "chick", "chicken c", "d", "TIK", "paneer tikka", "x", "ch"}) {
+        std::set<std::string> found;
+        size_t hits = 0;
+        for (int32_t row : index.prefixSearch(prefix, 100)) {
+            found.insert(foodKey(index.name(row)));
+            hits++;
+        }
+        CHECK(hits == found.size());  // one row per distinct name
+        CHECK(found == prefixReference(index, foodKey(prefix)));
+    }
+    CHECK(index.prefixSearch("ch", 2).size() == 2);
+    CHECK(index.prefixSearch("   ", 10).empty());
+}
+
+TEST(foodIndexFuzzySearchRanksClosestFirst) {
+    CompiledIndex compiled;
+    const FoodIndex& index = compiled.index;
+    const std::vector<int32_t> chicken = index.fuzzySearch("chiken", 10);
+    CHECK(!chicken.empty());
+    if (!chicken.empty()) {
+        // One edit from the word "chicken"; the shorter name comes first on a tie
+        CHECK(std::string(index.name(chicken[0])) == "Chicken Curry");
+    }
+    const std::vector<int32_t> dal = index.fuzzySearch("dal tadka", 10, 0);
+    CHECK(dal.size() == 1 && dal[0] == 8);
+    CHECK(index.fuzzySearch("zzzzzz", 10).empty());
+}
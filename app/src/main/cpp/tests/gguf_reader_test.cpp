@@ -0,0 +1,207 @@
+// GGUF header and tensor table parsing over synthetic images
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "gguf_reader.h"
+#include "native_test.h"
+
+namespace {
+
+constexpr uint32_t kTypeUint32 = 4;
+constexpr uint32_t kTypeString = 8;
+constexpr uint32_t kTensorF32 = 0;
+
+// Little-endian GGUF v3 image: KV pairs, a tensor table of F32 tensors, padding
+// to the alignment and zeroed tensor data
+class GgufBuilder {
+public:
+    void addString(const std::string& key, const std::string& value) {
+        putString(m_kv, key);
+        put<uint32_t>(m_kv, kTypeString);
+        putString(m_kv, value);
+        m_kvCount++;
+    }
+
+    void addUint32(const std::string& key, uint32_t value) {
+        putString(m_kv, key);
+        put<uint32_t>(m_kv, kTypeUint32);
+        put<uint32_t>(m_kv, value);
+        m_kvCount++;
+    }
+
+    // Returns the tensor's data offset; `offset` overrides the packed one
+    uint64_t addTensor(const std::string& name, const std::vector<uint64_t>& ne, uint64_t offset = UINT64_MAX) {
+        uint64_t bytes = 4;
+        for (uint64_t n : ne) {
+            bytes *= n;
+        }
+        if (offset == UINT64_MAX) {
+            offset = m_dataBytes;
+            m_dataBytes += (bytes + 31) / 32 * 32;
+        }
+        putString(m_tensors, name);
+        put<uint32_t>(m_tensors, (uint32_t) ne.size());
+        for (uint64_t n : ne) {
+            put<uint64_t>(m_tensors, n);
+        }
+        put<uint32_t>(m_tensors, kTensorF32);
+        put<uint64_t>(m_tensors, offset);
+        m_tensorCount++;
+        return offset;
+    }
+
+    std::vector<uint8_t> build() const {
+        std::vector<uint8_t> out;
+        out.insert(out.end(), {'G', 'G', 'U', 'F'});
+        put<uint32_t>(out, 3);
+        put<uint64_t>(out, m_tensorCount);
+        put<uint64_t>(out, m_kvCount);
+        out.insert(out.end(), m_kv.begin(), m_kv.end());
+        out.insert(out.end(), m_tensors.begin(), m_tensors.end());
+        out.resize((out.size() + 31) / 32 * 32 + m_dataBytes, 0);
+        return out;
+    }
+
+private:
+    std::vector<uint8_t> m_kv;
+    std::vector<uint8_t> m_tensors;
+    uint64_t m_kvCount = 0;
+    uint64_t m_tensorCount = 0;
+    uint64_t m_dataBytes = 0;
+
+    template <typename T>
+    static void put(std::vector<uint8_t>& out, T value) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void putString(std::vector<uint8_t>& out, const std::string& s) {
+        put<uint64_t>(out, s.size());
+        out.insert(out.end(), s.begin(), s.end());
+    }
+};
+
+GgufBuilder tinyModel() {
+    GgufBuilder builder;
+    builder.addString("general.architecture", "llama");
+    builder.addString("general.name", "tiny");
+    builder.addUint32("llama.context_length", 2048);
+    builder.addUint32("llama.embedding_length", 64);
+    builder.addUint32("llama.block_count", 2);
+    builder.addUint32("llama.attention.head_count", 4);
+    builder.addTensor("token_embd.weight", {64, 100});
+    builder.addTensor("blk.0.attn_q.weight", {64, 64});
+    builder.addTensor("output_norm.weight", {64});
+    return builder;
+}
+
+bool parse(const std::vector<uint8_t>& image, size_t size, GgufLayout& layout, std::string& error) {
+    return parseGgufLayout(image.data(), size, layout, error);
+}
+
+std::string writeTempFile(const std::vector<uint8_t>& bytes, size_t size) {
+    char path[] = "/tmp/native_tests_gguf_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        return std::string();
+    }
+    const bool written = write(fd, bytes.data(), size) == (ssize_t) size;
+    close(fd);
+    return written ? std::string(path) : std::string();
+}
+
+} // namespace
+
+TEST(ggufParsesWellFormedImage) {
+    const std::vector<uint8_t> image = tinyModel().build();
+    GgufLayout layout;
+    std::string error;
+    CHECK(parse(image, image.size(), layout, error));
+    CHECK(error.empty());
+    CHECK(layout.version == 3);
+    CHECK(layout.meta.architecture == "llama");
+    CHECK(layout.meta.name == "tiny");
+    CHECK(layout.meta.contextLength == 2048);
+    CHECK(layout.meta.embeddingLength == 64);
+    CHECK(layout.meta.blockCount == 2);
+    CHECK(layout.meta.headCountKv == 4);
+    CHECK(layout.tensors.size() == 3);
+    CHECK(layout.dataOffset % 32 == 0);
+    if (layout.tensors.size() == 3) {
+        CHECK(layout.tensors[0].size == 4ull * 64 * 100);
+        CHECK(layout.tensors[1].ne[1] == 64);
+        CHECK(layout.tensors[2].nDims == 1);
+    }
+    CHECK(layout.tensorBytes == 4ull * (64 * 100 + 64 * 64 + 64));
+}
+
+// Any cut of the file, inside the header or the tensor data, must be rejected
+TEST(ggufRejectsEveryTruncation) {
+    const std::vector<uint8_t> image = tinyModel().build();
+    int accepted = 0;
+    for (size_t size = 0; size < image.size(); size++) {
+        GgufLayout layout;
+        std::string error;
+        if (parse(image, size, layout, error) || error.empty()) {
+            accepted++;
+        }
+    }
+    CHECK(accepted == 0);
+}
+
+TEST(ggufInspectRejectsTruncatedFile) {
+    const std::vector<uint8_t> image = tinyModel().build();
+    const std::string full = writeTempFile(image, image.size());
+    const std::string cut = writeTempFile(image, image.size() - 100);
+    CHECK(!full.empty() && !cut.empty());
+
+    GgufLayout layout;
+    uint64_t fileSize = 0;
+    std::string error;
+    CHECK(inspectGgufFile(full, layout, fileSize, error));
+    CHECK(fileSize == image.size());
+    error.clear();
+    CHECK(!inspectGgufFile(cut, layout, fileSize, error));
+    CHECK(error.find("truncated") != std::string::npos);
+    std::remove(full.c_str());
+    std::remove(cut.c_str());
+}
+
+// Element counts whose byte size wraps 64 bits must not slip past the bounds check
+TEST(ggufRejectsOverflowingTensorSize) {
+    GgufBuilder builder = tinyModel();
+    builder.addTensor("huge.weight", {1ull << 32, 1ull << 32, 4}, 0);
+    const std::vector<uint8_t> image = builder.build();
+    GgufLayout layout;
+    std::string error;
+    CHECK(!parse(image, image.size(), layout, error));
+    CHECK(error.find("huge.weight") != std::string::npos);
+}
+
+TEST(ggufRejectsTensorPastEndOfFile) {
+    GgufBuilder builder = tinyModel();
+    builder.addTensor("stray.weight", {64}, UINT64_MAX - 31);
+    const std::vector<uint8_t> image = builder.build();
+    GgufLayout layout;
+    std::string error;
+    CHECK(!parse(image, image.size(), layout, error));
+    CHECK(error.find("stray.weight") != std::string::npos);
+}
+
+TEST(ggufRejectsBadMagicAndVersion) {
+    std::vector<uint8_t> image = tinyModel().build();
+    GgufLayout layout;
+    std::string error;
+    image[0] = 'X';
+    CHECK(!parse(image, image.size(), layout, error));
+    image[0] = 'G';
+    image[4] = 9;
+    CHECK(!parse(image, image.size(), layout, error));
+}
@@ -0,0 +1,112 @@
+// Ingredient bitsets: the popcount kernel and incremental inventory updates
+// against full rescans
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ingredient_index.h"
+#include "native_test.h"
+
+namespace {
+
+uint32_t missingBitsReference(const uint64_t* need, const uint64_t* have, size_t words) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < words * 64; i++) {
+        const uint64_t bit = 1ull << (i & 63);
+        if ((need[i >> 6] & bit) && !(have[i >> 6] & bit)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+std::string ingredientName(uint32_t id) {
+    return "ing" + std::to_string(id);
+}
+
+} // namespace
+
+TEST(countMissingBitsMatchesScalar) {
+    std::mt19937_64 rng(5);
+    for (size_t words = 2; words <= 64; words += 2) {
+        std::vector<uint64_t> need(words), have(words);
+        for (size_t i = 0; i < words; i++) {
+            need[i] = rng();
+            // Sparse, dense and random inventories
+            have[i] = words % 6 == 0 ? rng() & rng() : words % 6 == 2 ? rng() | rng() : rng();
+        }
+        CHECK(countMissingBits(need.data(), have.data(), words) ==
+              missingBitsReference(need.data(), have.data(), words));
+    }
+    // Every bit missing: the per-lane counters must not wrap
+    const std::vector<uint64_t> all(512, ~0ull), none(512, 0);
+    CHECK(countMissingBits(all.data(), none.data(), 512) == 512 * 64);
+    CHECK(countMissingBits(all.data(), all.data(), 512) == 0);
+}
+
+TEST(ingredientIndexMatchesWordRuns) {
+    IngredientIndex index;
+    const char* vocabulary = "item_name,category,unit\nRed Onion,Vegetable,kg\nGreen Chilli,Vegetable,g\n";
+    index.addVocabulary(vocabulary, std::char_traits<char>::length(vocabulary));
+    const int32_t curry = index.addRecipe("Onion Curry", {"red onion", "Tomatoes", "salt", "salt"});
+    const int32_t raita = index.addRecipe("Raita", {"curd", "Green Chilli", "salt"});
+    CHECK(index.addRecipe("onion  CURRY", {"water"}) == curry);
+    index.build();
+    CHECK(index.findRecipe("ONION curry") == curry);
+    CHECK(index.findRecipe("pasta") == -1);
+
+    const uint64_t before = index.version();
+    index.setInventory({"Onions", "tomato", "Salt"});
+    CHECK(index.version() != before);
+    // "onion" covers "red onion", plurals fold to the singular
+    CHECK(index.missingCount(curry) == 0);
+    CHECK(index.missingCount(raita) == 2);
+    const std::vector<std::string> missing = index.missingIngredients(raita);
+    CHECK(missing.size() == 2);
+    CHECK(std::find(missing.begin(), missing.end(), "Green Chilli") != missing.end());
+
+    const std::vector<int32_t> rows = index.cookable(2, 10);
+    CHECK(rows.size() == 2 && rows[0] == curry && rows[1] == raita);
+    CHECK(index.cookable(1, 10).size() == 1);
+    CHECK(index.cookable(2, 1).size() == 1);
+}
+
+// Random diffs applied through the posting lists must leave the same missing
+// counts as rebuilding the inventory from scratch
+TEST(incrementalInventoryMatchesRescan) {
+    constexpr uint32_t kIngredients = 200;  // several bitset words
+    std::mt19937 rng(9);
+    IngredientIndex index;
+    for (int recipe = 0; recipe < 300; recipe++) {
+        std::vector<std::string> ingredients;
+        const int count = 1 + (int) (rng() % 12);
+        for (int i = 0; i < count; i++) {
+            ingredients.push_back(ingredientName(rng() % kIngredients));
+        }
+        index.addRecipe("recipe" + std::to_string(recipe), ingredients);
+    }
+    index.build();
+    index.setInventory({});
+
+    std::vector<std::string> inventory;
+    for (int step = 0; step < 1500; step++) {
+        std::vector<std::string> added, removed;
+        if (inventory.empty() || rng() % 2) {
+            // Duplicates included: a second copy must not count twice
+            added.push_back(ingredientName(rng() % (kIngredients / 4)));
+            inventory.push_back(added.back());
+        } else {
+            const size_t at = rng() % inventory.size();
+            removed.push_back(inventory[at]);
+            inventory.erase(inventory.begin() + (long) at);
+        }
+        index.updateInventory(added, removed);
+        if (step % 100 == 99) {
+            const std::vector<int32_t> incremental = index.missingCounts();
+            index.setInventory(inventory);
+            CHECK(incremental == index.missingCounts());
+        }
+    }
+}
@@ -0,0 +1,115 @@
+// Aho-Corasick intent routing over a small command table
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "intent_router.h"
+#include "native_test.h"
+
+namespace {
+
+const char* const kCommands =
+    "command,ActionType\n"
+    "show my shopping list,ShowShoppingList\n"
+    "what is on the shopping list,ShowShoppingList\n"
+    "add milk to the shopping list,AddShoppingItem\n"
+    "add eggs to shopping,AddShoppingItem\n"
+    "how much protein is left today,ShowNutritionProgress\n"
+    "how many calories did i eat,ShowNutritionProgress\n"
+    "show recipes with paneer,SearchRecipe\n"
+    "find a recipe for dinner,SearchRecipe\n"
+    "this row has no action\n"
+    ",EmptyCommand\n";
+
+IntentRouter buildRouter() {
+    IntentRouter router;
+    router.build(kCommands, std::strlen(kCommands));
+    return router;
+}
+
+float scoreOf(const std::vector<IntentScore>& ranked, const std::string& action) {
+    for (const IntentScore& intent : ranked) {
+        if (intent.action == action) {
+            return intent.score;
+        }
+    }
+    return 0.0f;
+}
+
+} // namespace
+
+TEST(intentRouterBuildsFromCsv) {
+    const IntentRouter router = buildRouter();
+    CHECK(router.isReady());
+    CHECK(router.patternCount() > 8);
+
+    IntentRouter empty;
+    const char* header = "command,ActionType\n";
+    CHECK(!empty.build(header, std::strlen(header)));
+    CHECK(!empty.isReady());
+    CHECK(empty.classify("show my shopping list").empty());
+}
+
+TEST(intentRouterRanksVerbatimCommandFirst) {
+    const IntentRouter router = buildRouter();
+    const std::vector<IntentScore> ranked = router.classify("show my shopping list");
+    CHECK(!ranked.empty());
+    if (!ranked.empty()) {
+        CHECK(ranked[0].action == "ShowShoppingList");
+        CHECK(ranked[0].confidence > 0.5f);
+    }
+    for (size_t i = 1; i < ranked.size(); i++) {
+        CHECK(ranked[i - 1].score >= ranked[i].score);
+    }
+    const std::vector<IntentScore> recipes = router.classify("find a recipe for dinner");
+    CHECK(!recipes.empty() && recipes[0].action == "SearchRecipe");
+}
+
+TEST(intentRouterConfidencesSumToOne) {
+    const IntentRouter router = buildRouter();
+    const std::vector<IntentScore> ranked = router.classify("add protein to the shopping list");
+    CHECK(ranked.size() > 1);
+    float total = 0.0f;
+    for (const IntentScore& intent : ranked) {
+        CHECK(intent.score > 0.0f);
+        total += intent.confidence;
+    }
+    CHECK(std::fabs(total - 1.0f) < 1e-4f);
+}
+
+// Case, punctuation and whitespace runs are folded while matching
+TEST(intentRouterIgnoresCaseAndPunctuation) {
+    const IntentRouter router = buildRouter();
+    const std::vector<IntentScore> plain = router.classify("how much protein is left today");
+    const std::vector<IntentScore> noisy = router.classify("  HOW much,   Protein is LEFT -- today?!");
+    CHECK(plain.size() == noisy.size());
+    for (size_t i = 0; i < plain.size() && i < noisy.size(); i++) {
+        CHECK(plain[i].action == noisy[i].action);
+        CHECK(std::fabs(plain[i].score - noisy[i].score) < 1e-5f);
+    }
+}
+
+// Patterns are framed by spaces: "list" must not fire inside "playlist"
+TEST(intentRouterMatchesWholeWordsOnly) {
+    const IntentRouter router = buildRouter();
+    CHECK(router.classify("playlist").empty());
+    CHECK(router.classify("recipesx paneerish").empty());
+    CHECK(router.classify("tell me a joke about quantum physics").empty());
+    CHECK(!router.classify("list").empty());
+}
+
+// Every occurrence of a pattern votes, including overlapping ones
+TEST(intentRouterCountsEveryOccurrence) {
+    const IntentRouter router = buildRouter();
+    const float once = scoreOf(router.classify("paneer"), "SearchRecipe");
+    const float twice = scoreOf(router.classify("paneer paneer"), "SearchRecipe");
+    CHECK(once > 0.0f);
+    CHECK(std::fabs(twice - 2.0f * once) < 1e-5f);
+
+    // The verbatim phrase adds its vote on top of the words it shares
+    const float words = scoreOf(router.classify("shopping list my show"), "ShowShoppingList");
+    const float phrase = scoreOf(router.classify("show my shopping list"), "ShowShoppingList");
+    CHECK(phrase > words);
+}
@@ -0,0 +1,189 @@
+// Meal planner: the SIMD slot cost and the day search against brute force
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "meal_planner.h"
+#include "native_test.h"
+
+namespace {
+
+// Same clamp as the planner
+constexpr float kMinGrams = 30.0f;
+constexpr float kMaxGrams = 600.0f;
+
+struct RecipeTable {
+    std::vector<float> columns[MACRO_COUNT];
+    std::vector<uint32_t> mealMasks;
+    std::vector<uint8_t> available;
+
+    const float* const* columnPointers(const float* out[MACRO_COUNT]) const {
+        for (int j = 0; j < MACRO_COUNT; j++) {
+            out[j] = columns[j].data();
+        }
+        return out;
+    }
+};
+
+RecipeTable randomRecipes(size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    RecipeTable table;
+    for (size_t i = 0; i < count; i++) {
+        table.columns[MACRO_CALORIES].push_back(80.0f + unit(rng) * 300.0f);
+        table.columns[MACRO_PROTEIN].push_back(unit(rng) * 20.0f);
+        table.columns[MACRO_CARBS].push_back(unit(rng) * 50.0f);
+        table.columns[MACRO_FAT].push_back(unit(rng) * 15.0f);
+        table.columns[MACRO_FIBER].push_back(unit(rng) * 8.0f);
+        table.mealMasks.push_back(1u + (uint32_t) (unit(rng) * 15.0f));
+        table.available.push_back(unit(rng) < 0.85f ? 1 : 0);
+    }
+    return table;
+}
+
+float portion(float slotKcal, float kcalPer100g) {
+    return std::min(std::max(slotKcal * 100.0f * (1.0f / kcalPer100g), kMinGrams), kMaxGrams);
+}
+
+// Tries every assignment of distinct recipes to the slots of one day, leaving
+// a slot empty only when nothing that fits it is left
+struct ExhaustivePlan {
+    const RecipeTable& table;
+    const MealPlanRequest& request;
+    std::vector<int32_t> chosen;
+    double bestCost = std::numeric_limits<double>::infinity();
+
+    double cost() const {
+        double total = 0.0;
+        for (size_t m = 0; m < request.members.size(); m++) {
+            const MacroTargets& targets = request.members[m];
+            for (int j = 0; j < MACRO_COUNT; j++) {
+                if (targets.values[j] <= 0.0f) {
+                    continue;
+                }
+                double eaten = 0.0;
+                for (size_t s = 0; s < chosen.size(); s++) {
+                    const int32_t row = chosen[s];
+                    if (row >= 0) {
+                        const float grams = portion(request.slots[s].calorieShare * targets.values[MACRO_CALORIES],
+                                                    table.columns[MACRO_CALORIES][row]);
+                        eaten += table.columns[j][row] * grams * 0.01f;
+                    }
+                }
+                const double miss = eaten * (1.0f / targets.values[j]) - 1.0;
+                total += request.weights[j] * miss * miss;
+            }
+        }
+        return total;
+    }
+
+    void search(size_t slot) {
+        if (slot == request.slots.size()) {
+            bestCost = std::min(bestCost, cost());
+            return;
+        }
+        bool placed = false;
+        for (size_t row = 0; row < table.mealMasks.size(); row++) {
+            if (!(table.mealMasks[row] & request.slots[slot].mealMask) || !table.available[row] ||
+                std::find(chosen.begin(), chosen.end(), (int32_t) row) != chosen.end()) {
+                continue;
+            }
+            placed = true;
+            chosen.push_back((int32_t) row);
+            search(slot + 1);
+            chosen.pop_back();
+        }
+        if (!placed) {
+            chosen.push_back(-1);
+            search(slot + 1);
+            chosen.pop_back();
+        }
+    }
+};
+
+} // namespace
+
+TEST(slotCostMatchesScalarFormula) {
+    std::mt19937 rng(7);
+    const size_t n = 64;
+    RecipeTable table = randomRecipes(n, rng);
+    std::vector<float> invCalories(n);
+    for (size_t i = 0; i < n; i++) {
+        invCalories[i] = 1.0f / table.columns[MACRO_CALORIES][i];
+    }
+    invCalories[5] = 0.0f;  // no calories: portion clamps to the minimum
+    const float invSlotTargets[MACRO_COUNT] = {1.0f / 500.0f, 1.0f / 15.0f, 1.0f / 60.0f, 1.0f / 18.0f, 1.0f / 6.0f};
+    const float weights[MACRO_COUNT] = {1.0f, 1.0f, 0.6f, 0.6f, 0.3f};
+    std::vector<float> cost(n, 0.25f);
+
+    const float* columns[MACRO_COUNT];
+    accumulateSlotCost(table.columnPointers(columns), invCalories.data(), n, 500.0f, kMinGrams, kMaxGrams,
+                       invSlotTargets, weights, cost.data());
+    for (size_t i = 0; i < n; i++) {
+        const double grams = std::min(std::max(500.0 * 100.0 * invCalories[i], (double) kMinGrams), (double) kMaxGrams);
+        double expected = 0.25;
+        for (int j = 0; j < MACRO_COUNT; j++) {
+            const double miss = table.columns[j][i] * grams * 0.01 * invSlotTargets[j] - 1.0;
+            expected += weights[j] * miss * miss;
+        }
+        CHECK(std::fabs(cost[i] - expected) <= 1e-5 * expected);
+    }
+}
+
+// Small enough that every fitting recipe is a candidate, so the pruned search
+// must find the exact optimum
+TEST(dayPlanMatchesExhaustiveSearch) {
+    std::mt19937 rng(21);
+    for (int trial = 0; trial < 20; trial++) {
+        const RecipeTable table = randomRecipes(10, rng);
+        MealPlanRequest request;
+        request.members.push_back({{2000.0f, 60.0f, 250.0f, 70.0f, 25.0f}});
+        if (trial % 2) {
+            request.members.push_back({{1500.0f, 45.0f, 0.0f, 50.0f, 20.0f}});
+        }
+        request.slots = {{1u, 0.3f}, {2u, 0.4f}, {4u, 0.2f}};
+        if (trial % 3 == 0) {
+            request.slots.push_back({8u, 0.1f});
+        }
+
+        MealPlanner planner;
+        const float* columns[MACRO_COUNT];
+        planner.setRecipes(10, table.columnPointers(columns), table.mealMasks.data(), table.available.data());
+        MealPlan plan;
+        CHECK(planner.plan(request, plan));
+
+        ExhaustivePlan reference{table, request, {}};
+        reference.search(0);
+        CHECK(std::fabs(plan.cost - reference.bestCost) <= 1e-5 * (1.0 + reference.bestCost));
+
+        // The reported cost belongs to the reported recipes
+        reference.chosen = plan.recipes;
+        CHECK(std::fabs(reference.cost() - plan.cost) <= 1e-5 * (1.0 + plan.cost));
+        for (size_t s = 0; s < plan.recipes.size(); s++) {
+            const int32_t row = plan.recipes[s];
+            CHECK(row < 0 || (table.available[row] && (table.mealMasks[row] & request.slots[s].mealMask)));
+        }
+    }
+}
+
+TEST(planRejectsEmptyRequests) {
+    std::mt19937 rng(3);
+    const RecipeTable table = randomRecipes(8, rng);
+    MealPlanner planner;
+    MealPlan plan;
+    MealPlanRequest request;
+    request.members.push_back({{2000.0f, 60.0f, 250.0f, 70.0f, 25.0f}});
+    request.slots = {{1u, 1.0f}};
+    CHECK(!planner.plan(request, plan));
+
+    const float* columns[MACRO_COUNT];
+    planner.setRecipes(8, table.columnPointers(columns), table.mealMasks.data(), nullptr);
+    CHECK(!planner.setAvailable(7, table.available.data()));
+    request.days = 0;
+    CHECK(!planner.plan(request, plan));
+    request.days = 2;
+    CHECK(planner.plan(request, plan));
+    CHECK(plan.recipes.size() == 2 && plan.grams.size() == 2 && plan.totals.size() == 2 * MACRO_COUNT);
+}
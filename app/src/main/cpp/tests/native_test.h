@@ -0,0 +1,56 @@
+#ifndef NATIVE_TEST_H
+#define NATIVE_TEST_H
+
+// Minimal registry for the host tests: TEST(name) { CHECK(...); }. Tests run in
+// registration order; a failed CHECK is reported and the test carries on, so one
+// run lists every broken expectation.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct NativeTest {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<NativeTest>& nativeTests() {
+    static std::vector<NativeTest> tests;
+    return tests;
+}
+
+inline int& nativeTestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline bool registerNativeTest(const char* name, void (*run)()) {
+    nativeTests().push_back({name, run});
+    return true;
+}
+
+inline void nativeTestFail(const char* file, int line, const char* expression) {
+    std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, expression);
+    nativeTestFailures()++;
+}
+
+// Path of a GGUF model for the tests that need one; empty skips them
+inline std::string testModelPath() {
+    const char* path = std::getenv("TASTYDIET_TEST_MODEL");
+    return path ? std::string(path) : std::string();
+}
+
+#define TEST(name)                                                                  \
+    static void name();                                                             \
+    static const bool name##Registered = registerNativeTest(#name, name);           \
+    static void name()
+
+#define CHECK(condition)                                                            \
+    do {                                                                            \
+        if (!(condition)) {                                                         \
+            nativeTestFail(__FILE__, __LINE__, #condition);                         \
+        }                                                                           \
+    } while (0)
+
+#endif // NATIVE_TEST_H
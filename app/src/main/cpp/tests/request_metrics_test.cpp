@@ -0,0 +1,119 @@
+// Lock-free metrics ring: ordering, overwrite and torn reads under contention
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "native_test.h"
+#include "request_metrics.h"
+
+namespace {
+
+// Every field derives from `id`, so a record mixing two writes is detectable
+RequestMetrics makeMetrics(int32_t id) {
+    RequestMetrics metrics;
+    metrics.finishedAtMs = 1000 + (int64_t) id;
+    metrics.session = id % 7;
+    metrics.promptTokens = 3 * id;
+    metrics.generatedTokens = id;
+    metrics.decodeMs = (float) id * 0.5f;
+    metrics.totalMs = (float) id;
+    metrics.cacheHit = id % 2 == 0;
+    return metrics;
+}
+
+bool isConsistent(const RequestMetrics& metrics) {
+    const int32_t id = metrics.generatedTokens;
+    return metrics.finishedAtMs == 1000 + (int64_t) id && metrics.session == id % 7 &&
+           metrics.promptTokens == 3 * id && metrics.decodeMs == (float) id * 0.5f &&
+           metrics.totalMs == (float) id && metrics.cacheHit == (id % 2 == 0);
+}
+
+} // namespace
+
+TEST(metricsRingKeepsNewestInOrder) {
+    MetricsRing ring;
+    CHECK(ring.snapshot().empty());
+    CHECK(ring.toJson() == "{\"recorded\":0,\"requests\":[]}");
+
+    for (int32_t id = 0; id < 10; id++) {
+        ring.record(makeMetrics(id));
+    }
+    std::vector<RequestMetrics> records = ring.snapshot();
+    CHECK(records.size() == 10);
+    for (size_t i = 0; i < records.size(); i++) {
+        CHECK(records[i].generatedTokens == (int32_t) i);
+    }
+
+    // Past capacity the oldest records are overwritten
+    const int32_t total = (int32_t) MetricsRing::kCapacity * 2 + 5;
+    for (int32_t id = 10; id < total; id++) {
+        ring.record(makeMetrics(id));
+    }
+    records = ring.snapshot();
+    CHECK(ring.recorded() == (uint64_t) total);
+    CHECK(records.size() == MetricsRing::kCapacity);
+    for (size_t i = 0; i < records.size(); i++) {
+        CHECK(records[i].generatedTokens == total - (int32_t) MetricsRing::kCapacity + (int32_t) i);
+        CHECK(isConsistent(records[i]));
+    }
+}
+
+TEST(metricsRingJsonListsSnapshot) {
+    MetricsRing ring;
+    RequestMetrics metrics = makeMetrics(4);
+    metrics.ok = false;
+    ring.record(metrics);
+    const std::string json = ring.toJson();
+    CHECK(json.rfind("{\"recorded\":1,\"requests\":[{\"finishedAtMs\":1004,", 0) == 0);
+    CHECK(json.find("\"cacheHit\":true") != std::string::npos);
+    CHECK(json.find("\"ok\":false}]}") != std::string::npos);
+}
+
+// Readers racing writers may drop slots but must never return a torn record
+TEST(metricsRingNeverTearsUnderContention) {
+    MetricsRing ring;
+    std::atomic<bool> reading{false};
+    std::atomic<bool> done{false};
+    std::atomic<size_t> torn{0};
+    std::atomic<size_t> seen{0};
+    std::thread reader([&] {
+        reading = true;
+        // The pass after the writers finish sees a quiet ring
+        for (bool last = false; !last;) {
+            last = done.load();
+            for (const RequestMetrics& metrics : ring.snapshot()) {
+                if (!isConsistent(metrics)) {
+                    torn++;
+                }
+                seen++;
+            }
+        }
+    });
+    while (!reading.load()) {
+        std::this_thread::yield();
+    }
+
+    constexpr int32_t kWriters = 4;
+    constexpr int32_t kPerWriter = 20000;
+    std::vector<std::thread> writers;
+    for (int32_t w = 0; w < kWriters; w++) {
+        writers.emplace_back([&ring, w] {
+            for (int32_t i = 0; i < kPerWriter; i++) {
+                ring.record(makeMetrics(w * kPerWriter + i));
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    done = true;
+    reader.join();
+
+    CHECK(torn.load() == 0);
+    CHECK(seen.load() > 0);
+    CHECK(ring.recorded() == (uint64_t) kWriters * kPerWriter);
+    // Once writers are quiet every slot is readable again
+    CHECK(ring.snapshot().size() == MetricsRing::kCapacity);
+}
@@ -0,0 +1,219 @@
+// Response cache: prompt normalization, the memory LRU and the on-disk log
+// across restarts, torn tails and compaction
+
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "native_test.h"
+#include "response_cache.h"
+
+namespace {
+
+constexpr const char* kIdentity = "model.gguf|t=0.7|n=256";
+
+struct LogFile {
+    std::string path;
+
+    LogFile() {
+        char tmpl[] = "/tmp/native_tests_responses_XXXXXX";
+        const int fd = mkstemp(tmpl);
+        if (fd >= 0) {
+            close(fd);
+            path = tmpl;
+        }
+    }
+
+    ~LogFile() {
+        if (!path.empty()) {
+            std::remove(path.c_str());
+            std::remove((path + ".tmp").c_str());
+        }
+    }
+
+    long size() const {
+        struct stat st {};
+        return stat(path.c_str(), &st) == 0 ? (long) st.st_size : -1;
+    }
+};
+
+uint64_t keyFor(int i) {
+    return ResponseCache::makeKey("question " + std::to_string(i), kIdentity);
+}
+
+std::string responseFor(int i, size_t length = 40) {
+    std::string response = "answer " + std::to_string(i) + " ";
+    response.resize(length, (char) ('a' + i % 26));
+    return response;
+}
+
+bool holds(ResponseCache& cache, int i, size_t length = 40) {
+    std::string response;
+    return cache.lookup(keyFor(i), response) && response == responseFor(i, length);
+}
+
+} // namespace
+
+TEST(normalizeFoldsEquivalentPrompts) {
+    CHECK(ResponseCache::normalize("Calories in  Apple?") == "calories in apple");
+    CHECK(ResponseCache::normalize("calories in apple") == "calories in apple");
+    CHECK(ResponseCache::normalize("  Calories\tin apple!!\n") == "calories in apple");
+    CHECK(ResponseCache::normalize("Rice, dal and curd.") == "rice dal and curd");
+    // Dots and commas inside a token are content
+    CHECK(ResponseCache::normalize("Log 1.5 cups of rice") == "log 1.5 cups of rice");
+    CHECK(ResponseCache::normalize("rice,dal") == "rice,dal");
+
+    CHECK(ResponseCache::makeKey("Calories in  Apple?", kIdentity) ==
+          ResponseCache::makeKey("calories in apple", kIdentity));
+    CHECK(ResponseCache::makeKey("log 1.5 cups", kIdentity) != ResponseCache::makeKey("log 15 cups", kIdentity));
+    CHECK(ResponseCache::makeKey("calories in apple", kIdentity) !=
+          ResponseCache::makeKey("calories in apple", "model.gguf|t=0.2|n=256"));
+}
+
+TEST(memoryTierStaysUnderByteCap) {
+    ResponseCache cache(200, 0);
+    for (int i = 0; i < 10; i++) {
+        cache.insert(keyFor(i), responseFor(i));
+        CHECK(cache.stats().memoryBytes <= 200);
+    }
+    // Five 40-byte responses fit; the oldest five were evicted
+    ResponseCacheStats stats = cache.stats();
+    CHECK(stats.memoryEntries == 5);
+    CHECK(stats.memoryEvictions == 5);
+    CHECK(!holds(cache, 4));
+    CHECK(holds(cache, 5));
+
+    // A hit makes the entry most recent, so the next eviction skips it
+    cache.insert(keyFor(10), responseFor(10));
+    CHECK(holds(cache, 5));
+    CHECK(!holds(cache, 6));
+
+    // An oversized response still stays as the only entry
+    cache.insert(keyFor(11), responseFor(11, 500));
+    stats = cache.stats();
+    CHECK(stats.memoryEntries == 1);
+    CHECK(holds(cache, 11, 500));
+}
+
+TEST(logSurvivesRestart) {
+    LogFile log;
+    {
+        ResponseCache cache;
+        CHECK(cache.open(log.path));
+        for (int i = 0; i < 20; i++) {
+            cache.insert(keyFor(i), responseFor(i));
+        }
+        cache.insert(keyFor(3), responseFor(3, 60));  // later records win
+    }
+
+    ResponseCache cache;
+    CHECK(cache.open(log.path));
+    CHECK(cache.stats().diskEntries == 20);
+    for (int i = 0; i < 20; i++) {
+        CHECK(holds(cache, i, i == 3 ? 60 : 40));
+    }
+    CHECK(!holds(cache, 20));
+    const ResponseCacheStats stats = cache.stats();
+    CHECK(stats.diskHits == 20);
+    CHECK(stats.memoryHits == 0);
+
+    // clear() empties the log too
+    cache.clear();
+    cache.close();
+    CHECK(cache.open(log.path));
+    CHECK(cache.stats().diskEntries == 0);
+}
+
+// A crash mid-append leaves a partial or damaged last record; reopening drops
+// it and keeps everything before
+TEST(openDropsTornAndCorruptedTail) {
+    LogFile log;
+    long intact = 0;
+    {
+        ResponseCache cache;
+        CHECK(cache.open(log.path));
+        for (int i = 0; i < 5; i++) {
+            cache.insert(keyFor(i), responseFor(i));
+        }
+        intact = log.size();
+        cache.insert(keyFor(5), responseFor(5));
+    }
+    CHECK(truncate(log.path.c_str(), log.size() - 7) == 0);
+    {
+        ResponseCache cache;
+        CHECK(cache.open(log.path));
+        CHECK(log.size() == intact);
+        CHECK(cache.stats().diskEntries == 5);
+        CHECK(holds(cache, 4));
+        CHECK(!holds(cache, 5));
+
+        // Appends after the repair land on a clean record boundary
+        cache.insert(keyFor(6), responseFor(6));
+        intact = log.size();
+        cache.insert(keyFor(7), responseFor(7));
+    }
+
+    // Flip a byte in the last record's body: the checksum rejects it
+    FILE* file = std::fopen(log.path.c_str(), "r+b");
+    CHECK(file != nullptr);
+    if (file) {
+        std::fseek(file, -3, SEEK_END);
+        std::fputc('#', file);
+        std::fclose(file);
+    }
+    ResponseCache cache;
+    CHECK(cache.open(log.path));
+    CHECK(log.size() == intact);
+    CHECK(cache.stats().diskEntries == 6);
+    CHECK(holds(cache, 6));
+    CHECK(!holds(cache, 7));
+
+    // A file that is not a log at all is replaced by an empty one
+    cache.close();
+    file = std::fopen(log.path.c_str(), "wb");
+    CHECK(file != nullptr);
+    if (file) {
+        std::fputs("not a response log", file);
+        std::fclose(file);
+    }
+    CHECK(cache.open(log.path));
+    CHECK(cache.stats().diskEntries == 0);
+    CHECK(log.size() == 8);
+}
+
+TEST(compactionKeepsNewestEntries) {
+    constexpr size_t kDiskCap = 2048;
+    constexpr int kCount = 100;
+    LogFile log;
+    {
+        ResponseCache cache(64 * 1024, kDiskCap);
+        CHECK(cache.open(log.path));
+        for (int i = 0; i < kCount; i++) {
+            cache.insert(keyFor(i), responseFor(i));
+            CHECK(cache.stats().diskBytes <= kDiskCap);
+        }
+        const ResponseCacheStats stats = cache.stats();
+        CHECK(stats.compactions > 0);
+        CHECK(stats.diskEvictions > 0);
+        CHECK(stats.diskEntries + stats.diskEvictions == (size_t) kCount);
+        CHECK(log.size() == (long) stats.diskBytes);
+    }
+
+    // Read back from disk alone: the survivors are exactly the newest entries
+    ResponseCache cache(64 * 1024, kDiskCap);
+    CHECK(cache.open(log.path));
+    const size_t entries = cache.stats().diskEntries;
+    CHECK(entries > 0 && entries < (size_t) kCount);
+    for (int i = 0; i < kCount; i++) {
+        CHECK(holds(cache, i) == (i >= kCount - (int) entries));
+    }
+    CHECK(cache.stats().diskHits == entries);
+
+    // The compacted log keeps taking appends and survives another restart
+    cache.insert(keyFor(kCount), responseFor(kCount));
+    cache.close();
+    CHECK(cache.open(log.path));
+    CHECK(holds(cache, kCount));
+    CHECK(holds(cache, kCount - 1));
+}
@@ -0,0 +1,294 @@
+// LlamaServer against a real model (TASTYDIET_TEST_MODEL); skipped without one
+
+#include <cstdio>
+#include <dirent.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "llama_server.h"
+#include "llama_wrapper.h"
+#include "native_test.h"
+
+namespace {
+
+void quietLog(enum ggml_log_level level, const char* text, void* userData) {
+    (void) level;
+    (void) text;
+    (void) userData;
+}
+
+const std::string kSystemPrompt = "<|system|>\nYou are a nutrition assistant. Answer briefly.\n</s>\n";
+
+std::string userTurn(const std::string& text) {
+    return "<|user|>\n" + text + "\n</s>\n<|assistant|>\n";
+}
+
+// Scratch state directory for prefix and spill files, removed with its contents
+struct StateDir {
+    std::string path;
+
+    StateDir() {
+        char tmpl[] = "/tmp/native_tests_state_XXXXXX";
+        if (mkdtemp(tmpl)) {
+            path = tmpl;
+        }
+    }
+
+    ~StateDir() {
+        if (path.empty()) {
+            return;
+        }
+        if (DIR* dir = opendir(path.c_str())) {
+            while (const dirent* entry = readdir(dir)) {
+                const std::string name = entry->d_name;
+                if (name != "." && name != "..") {
+                    std::remove((path + "/" + name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+        rmdir(path.c_str());
+    }
+
+    // Sequence state files spilled by trimMemory
+    size_t spillFiles() const {
+        size_t count = 0;
+        if (DIR* dir = opendir(path.c_str())) {
+            while (const dirent* entry = readdir(dir)) {
+                count += std::string(entry->d_name).find(".seq") != std::string::npos;
+            }
+            closedir(dir);
+        }
+        return count;
+    }
+};
+
+} // namespace
+
+// Drafts must ride along with the server's decode steps, not only generateText's
+TEST(serverBatchesSpeculativeDrafts) {
+    const std::string modelPath = testModelPath();
+    if (modelPath.empty()) {
+        return;
+    }
+    llama_log_set(quietLog, nullptr);
+
+    LlamaWrapper wrapper;
+    wrapper.setMaxSequences(2);
+    GenerationParams params = wrapper.getGenerationParams();
+    params.temperature = 0.0f;
+    wrapper.setGenerationParams(params);
+    LlamaServer server(wrapper);
+    CHECK(wrapper.loadModel(modelPath) && wrapper.createContext() && server.start());
+    if (!server.isRunning()) {
+        return;
+    }
+    server.runExclusive([&wrapper] { wrapper.setDrafter(wrapper.createNgramDrafter({}), 4); });
+
+    // Copying a repetitive prompt gives prompt-lookup drafting matches to propose
+    const std::string list = "apple, banana, cherry, apple, banana, cherry, apple, banana, cherry";
+    const int32_t session = server.createSession();
+    CHECK(session >= 0);
+    const std::string response = server.generate(
+        session, "<|user|>\nRepeat this list twice: " + list + "\n</s>\n<|assistant|>\n" + list + ", ", 32);
+    CHECK(!response.empty());
+    const GenerationStats stats = server.lastStats(session);
+    CHECK(stats.generatedTokens > 0);
+    CHECK(stats.draftedTokens > 0);
+    CHECK(stats.acceptedDraftTokens <= stats.draftedTokens);
+
+    server.destroySession(session);
+    server.stop();
+    wrapper.unloadModel();
+}
+
+// Concurrent callers on one session queue instead of failing as busy
+TEST(serverQueuesRequestsOnBusySession) {
+    const std::string modelPath = testModelPath();
+    if (modelPath.empty()) {
+        return;
+    }
+    llama_log_set(quietLog, nullptr);
+
+    LlamaWrapper wrapper;
+    wrapper.setMaxSequences(1);
+    LlamaServer server(wrapper);
+    CHECK(wrapper.loadModel(modelPath) && wrapper.createContext() && server.start());
+    if (!server.isRunning()) {
+        return;
+    }
+    const int32_t session = server.createSession();
+    CHECK(session >= 0);
+
+    std::string responses[3];
+    std::thread callers[3];
+    for (int i = 0; i < 3; i++) {
+        callers[i] = std::thread([&, i] {
+            responses[i] = server.generate(session, "<|user|>\nName a fruit.\n</s>\n<|assistant|>\n", 8);
+        });
+    }
+    for (std::thread& caller : callers) {
+        caller.join();
+    }
+    for (const std::string& response : responses) {
+        CHECK(!response.empty() && response.rfind("Error:", 0) != 0);
+    }
+
+    // Stopping the first caller's stream leaves the queued request alone
+    std::string stopped;
+    std::thread first([&] {
+        stopped = server.generate(session, "<|user|>\nCount to twenty.\n</s>\n<|assistant|>\n", 64,
+                                  [](const std::string&) { return false; });
+    });
+    const std::string next = server.generate(session, "<|user|>\nName a vegetable.\n</s>\n<|assistant|>\n", 8);
+    first.join();
+    CHECK(server.lastStats(session).generatedTokens > 0);
+    CHECK(!next.empty() && next.rfind("Error:", 0) != 0);
+    CHECK(stopped.rfind("Error:", 0) != 0);
+
+    server.destroySession(session);
+    server.stop();
+    wrapper.unloadModel();
+}
+
+// Trimming spills live sessions to disk; the next request on each restores its
+// sequence (and the context its prefix) and continues exactly where it left off
+TEST(serverRestoresSessionsAfterTrim) {
+    const std::string modelPath = testModelPath();
+    StateDir stateDir;
+    if (modelPath.empty() || stateDir.path.empty()) {
+        return;
+    }
+    llama_log_set(quietLog, nullptr);
+
+    LlamaWrapper wrapper;
+    wrapper.setMaxSequences(3);
+    wrapper.setStateDir(stateDir.path);
+    llama_context_params contextParams = wrapper.getContextParams();
+    contextParams.n_ctx = 1024;
+    wrapper.setContextParams(contextParams);
+    GenerationParams params = wrapper.getGenerationParams();
+    params.temperature = 0.0f;
+    wrapper.setGenerationParams(params);
+    LlamaServer server(wrapper);
+    CHECK(wrapper.loadModel(modelPath) && wrapper.createContext() && server.start());
+    if (!server.isRunning()) {
+        return;
+    }
+    bool prefixReady = false;
+    server.runExclusive([&] { prefixReady = wrapper.setSystemPrompt(kSystemPrompt); });
+    CHECK(prefixReady);
+
+    const int32_t sessions[2] = {server.createSession(), server.createSession()};
+    const std::string prompts[2] = {kSystemPrompt + userTurn("How much protein is in dal?"),
+                                    kSystemPrompt + userTurn("Suggest a light dinner.")};
+    // The second run takes the same cached path as every run after a restore
+    std::string expected[2];
+    for (int i = 0; i < 2; i++) {
+        CHECK(sessions[i] >= 0);
+        server.generate(sessions[i], prompts[i], 24);
+        expected[i] = server.generate(sessions[i], prompts[i], 24);
+        CHECK(!expected[i].empty() && expected[i].rfind("Error:", 0) != 0);
+    }
+
+    for (int level : {kTrimRunningCritical, kTrimBackground}) {
+        CHECK(server.trimMemory(level));
+        MemoryReport report;
+        server.runExclusive([&] { report = wrapper.memoryReport(); });
+        CHECK(level == kTrimBackground ? report.contextReleased : report.nCtx == 512);
+        CHECK(stateDir.spillFiles() == 2);
+
+        for (int i = 0; i < 2; i++) {
+            CHECK(server.generate(sessions[i], prompts[i], 24) == expected[i]);
+            const GenerationStats stats = server.lastStats(sessions[i]);
+            CHECK(stats.cachedPromptTokens == stats.promptTokens - 1);
+        }
+        CHECK(stateDir.spillFiles() == 0);
+
+        // A new session adopts the restored system prefix instead of evaluating it
+        const int32_t fresh = server.createSession();
+        CHECK(fresh >= 0);
+        server.generate(fresh, kSystemPrompt + userTurn("Is curd healthy?"), 4);
+        const GenerationStats freshStats = server.lastStats(fresh);
+        CHECK(freshStats.cachedPromptTokens > 0 && freshStats.cachedPromptTokens < freshStats.promptTokens - 1);
+        server.destroySession(fresh);
+    }
+
+    for (int32_t session : sessions) {
+        server.destroySession(session);
+    }
+    server.stop();
+    wrapper.unloadModel();
+}
+
+// A conversation longer than the window drops its oldest turns in place while
+// the system prefix stays pinned in front of the rest
+TEST(serverChatEvictsOldestTurns) {
+    const std::string modelPath = testModelPath();
+    StateDir stateDir;
+    if (modelPath.empty() || stateDir.path.empty()) {
+        return;
+    }
+    llama_log_set(quietLog, nullptr);
+
+    constexpr int32_t kCtx = 512;
+    constexpr int kReplyTokens = 32;
+    LlamaWrapper wrapper;
+    wrapper.setMaxSequences(1);
+    wrapper.setStateDir(stateDir.path);
+    llama_context_params contextParams = wrapper.getContextParams();
+    contextParams.n_ctx = kCtx;
+    wrapper.setContextParams(contextParams);
+    LlamaServer server(wrapper);
+    CHECK(wrapper.loadModel(modelPath) && wrapper.createContext() && server.start());
+    if (!server.isRunning()) {
+        return;
+    }
+    bool prefixReady = false;
+    server.runExclusive([&] { prefixReady = wrapper.setSystemPrompt(kSystemPrompt); });
+    CHECK(prefixReady);
+    const int32_t session = server.createSession();
+    CHECK(session >= 0);
+
+    const std::string filler = " I had rice, dal, two rotis, a bowl of curd, some salad with cucumber and "
+                               "tomato, and a glass of buttermilk after a long walk in the evening.";
+    int32_t prefixTokens = 0;
+    int32_t evictions = 0;
+    int32_t expectedCached = 0;
+    int32_t contextUsed = 0;
+    for (int turn = 0; turn < 16; turn++) {
+        const std::string reply =
+            server.chat(session, userTurn("Day " + std::to_string(turn + 1) + ":" + filler + " Was that balanced?"),
+                        kReplyTokens);
+        CHECK(!reply.empty() && reply.rfind("Error:", 0) != 0);
+        const GenerationStats stats = server.lastStats(session);
+        CHECK(stats.generatedTokens > 0);
+        if (turn == 0) {
+            // A new conversation starts from the adopted system prefix alone
+            prefixTokens = stats.cachedPromptTokens;
+            CHECK(prefixTokens > 0);
+        } else {
+            // Still the same conversation behind the same prefix, never restarted
+            CHECK(stats.cachedPromptTokens > prefixTokens);
+            if (stats.cachedPromptTokens < expectedCached) {
+                evictions++;
+            }
+        }
+        CHECK(stats.cachedPromptTokens + stats.promptTokens + kReplyTokens <= kCtx);
+        expectedCached = stats.cachedPromptTokens + stats.promptTokens;
+        contextUsed += stats.promptTokens + stats.generatedTokens;
+    }
+    CHECK(contextUsed > kCtx);
+    CHECK(evictions > 0);
+
+    // Resetting starts over from the prefix
+    server.resetChat(session);
+    CHECK(server.chat(session, userTurn("Hello"), 4).rfind("Error:", 0) != 0);
+    CHECK(server.lastStats(session).cachedPromptTokens == prefixTokens);
+
+    server.destroySession(session);
+    server.stop();
+    wrapper.unloadModel();
+}
@@ -0,0 +1,170 @@
+// Food log grammar and the streaming structure tracker; the grammar sampler
+// checks need a real vocabulary (TASTYDIET_TEST_MODEL) and are skipped without one
+
+#include <cctype>
+#include <cmath>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "llama.h"
+#include "native_test.h"
+#include "structured_output.h"
+
+namespace {
+
+const std::vector<std::string> kNames = {"Rice", "Jeera Rice", "Rice Kheer", "Dal", "Dal Tadka", "Aloo Gobi (dry)"};
+
+// The right-hand side of `rule` in a grammar, one rule per line
+std::string ruleBody(const std::string& grammar, const std::string& rule) {
+    const std::string head = rule + " ::= ";
+    const size_t start = grammar.find(head);
+    if (start == std::string::npos) {
+        return std::string();
+    }
+    const size_t end = grammar.find('\n', start);
+    return grammar.substr(start + head.size(), end - start - head.size());
+}
+
+// The name rule only uses literals, groups, alternation and `?`, which map
+// one-to-one onto an ECMAScript regex
+std::regex nameRegex(const std::string& body) {
+    std::string pattern;
+    for (size_t i = 0; i < body.size(); i++) {
+        const char c = body[i];
+        if (c == '"') {
+            for (i++; i < body.size() && body[i] != '"'; i++) {
+                if (!std::isalnum((unsigned char) body[i])) {
+                    pattern += '\\';
+                }
+                pattern += body[i];
+            }
+        } else if (c != ' ') {
+            pattern += c;
+        }
+    }
+    return std::regex(pattern);
+}
+
+void quietLog(enum ggml_log_level level, const char* text, void* userData) {
+    (void) level;
+    (void) text;
+    (void) userData;
+}
+
+// Feeds `text` token by token through a fresh grammar sampler; false as soon
+// as the grammar masks out a token
+bool grammarAllows(const llama_model* model, const std::string& grammar, const std::string& text) {
+    llama_sampler* sampler = llama_sampler_init_grammar(model, grammar.c_str(), "root");
+    if (!sampler) {
+        return false;
+    }
+    std::vector<llama_token> tokens(text.size() + 8);
+    const int32_t count = llama_tokenize(model, text.c_str(), (int32_t) text.size(), tokens.data(),
+                                         (int32_t) tokens.size(), false, false);
+    bool allowed = count > 0;
+    for (int32_t i = 0; allowed && i < count; i++) {
+        llama_token_data candidate = {tokens[i], 0.0f, 0.0f};
+        llama_token_data_array candidates = {&candidate, 1, -1, false};
+        llama_sampler_apply(sampler, &candidates);
+        allowed = std::isfinite(candidate.logit);
+        if (allowed) {
+            llama_sampler_accept(sampler, tokens[i]);
+        }
+    }
+    llama_sampler_free(sampler);
+    return allowed;
+}
+
+} // namespace
+
+TEST(foodLogGrammarNamesExactlyTheFoods) {
+    const std::string grammar = buildFoodLogGrammar(kNames);
+    const std::regex names = nameRegex(ruleBody(grammar, "name"));
+    for (const char* name : {"rice", "jeera rice", "rice kheer", "dal", "dal tadka", "aloo gobi (dry)"}) {
+        CHECK(std::regex_match(name, names));
+    }
+    // Prefixes and extensions of real names, other case and other foods
+    for (const char* name : {"ric", "jeera", "rice kheer x", "dal t", "Rice", "pizza", "", "aloo gobi"}) {
+        CHECK(!std::regex_match(name, names));
+    }
+}
+
+TEST(foodLogGrammarSkipsUnquotableNames) {
+    const std::string grammar = buildFoodLogGrammar({"Rice", "6\" sub", "back\\slash", "caf\xc3\xa9"});
+    const std::regex names = nameRegex(ruleBody(grammar, "name"));
+    CHECK(std::regex_match("rice", names));
+    CHECK(grammar.find("sub") == std::string::npos);
+    CHECK(grammar.find("slash") == std::string::npos);
+    CHECK(grammar.find("caf") == std::string::npos);
+
+    // Every unit is an alternative, and an empty list still yields a name rule
+    const std::string units = ruleBody(grammar, "unit");
+    for (size_t i = 0; i < kFoodLogUnitCount; i++) {
+        CHECK(units.find(std::string("\"") + kFoodLogUnits[i] + "\"") != std::string::npos);
+    }
+    CHECK(!ruleBody(buildFoodLogGrammar({}), "name").empty());
+}
+
+// The closing position must not depend on how the text is chunked
+TEST(structureTrackerClosesOnOuterBracket) {
+    const std::string response =
+        " [{\"name\":\"rice ] }\",\"note\":\"say \\\"[\\\" \\\\\"},{\"n\":[1,{\"a\":2}]}] trailing";
+    const size_t close = response.find("}] trailing") + 2;
+
+    StructureTracker whole;
+    CHECK(whole.feed(response) == close);
+    CHECK(whole.closed());
+    CHECK(whole.feed("]") == 0);
+
+    for (size_t chunk = 1; chunk <= 7; chunk++) {
+        StructureTracker tracker;
+        size_t consumed = 0;
+        size_t result = std::string::npos;
+        for (size_t at = 0; at < response.size() && result == std::string::npos; at += chunk) {
+            const std::string piece = response.substr(at, chunk);
+            result = tracker.feed(piece);
+            if (result == std::string::npos) {
+                consumed += piece.size();
+            }
+        }
+        CHECK(tracker.closed());
+        CHECK(consumed + result == close);
+    }
+}
+
+TEST(structureTrackerWaitsForTheStructure) {
+    StructureTracker tracker;
+    CHECK(tracker.feed("Sure, here it is: ") == std::string::npos);
+    CHECK(tracker.feed("{\"a\":\"}\"") == std::string::npos);
+    CHECK(!tracker.closed());
+    CHECK(tracker.feed("}") == 1);
+    tracker.reset();
+    CHECK(!tracker.closed());
+    CHECK(tracker.feed("[]") == 2);
+}
+
+// The sampler-side grammar must mask out foods that are not in the list
+TEST(foodLogGrammarRejectsOffVocabularyFoods) {
+    const std::string modelPath = testModelPath();
+    if (modelPath.empty()) {
+        return;
+    }
+    llama_log_set(quietLog, nullptr);
+    llama_model_params params = llama_model_default_params();
+    params.vocab_only = true;
+    llama_model* model = llama_load_model_from_file(modelPath.c_str(), params);
+    CHECK(model != nullptr);
+    if (!model) {
+        return;
+    }
+
+    const std::string grammar = buildFoodLogGrammar(kNames);
+    CHECK(grammarAllows(model, grammar, "[{\"name\":\"jeera rice\",\"quantity\":1.5,\"unit\":\"cup\"}]"));
+    CHECK(grammarAllows(model, grammar, "[{\"name\":\"dal\",\"quantity\":2,\"unit\":\"bowl\"}, "
+                                        "{\"name\":\"rice kheer\",\"quantity\":1,\"unit\":\"serving\"}]"));
+    CHECK(!grammarAllows(model, grammar, "[{\"name\":\"pizza\",\"quantity\":1,\"unit\":\"slice\"}]"));
+    CHECK(!grammarAllows(model, grammar, "[{\"name\":\"dal makhani\",\"quantity\":1,\"unit\":\"bowl\"}]"));
+    CHECK(!grammarAllows(model, grammar, "[{\"name\":\"rice\",\"quantity\":1,\"unit\":\"kg\"}]"));
+    llama_free_model(model);
+}
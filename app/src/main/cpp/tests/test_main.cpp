@@ -0,0 +1,24 @@
+// Host test runner: `native_tests [name-substring]` runs the matching tests and
+// exits non-zero when any CHECK failed. Tests that need a model read its path
+// from TASTYDIET_TEST_MODEL and pass trivially without it.
+
+#include <cstdio>
+#include <cstring>
+
+#include "native_test.h"
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    for (const NativeTest& test : nativeTests()) {
+        if (filter && !std::strstr(test.name, filter)) {
+            continue;
+        }
+        const int before = nativeTestFailures();
+        test.run();
+        run++;
+        std::printf("%s %s\n", nativeTestFailures() == before ? "ok  " : "FAIL", test.name);
+    }
+    std::printf("%d tests, %d failed checks\n", run, nativeTestFailures());
+    return nativeTestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// Fused token sampler against full sorts and the per-stage reference chain
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "native_test.h"
+#include "token_sampler.h"
+#include "tools/naive_sampler.h"
+
+namespace {
+
+constexpr int32_t kVocab = 4096;
+constexpr int kRows = 16;
+
+// A normal body with a few strong peaks, like a language model's output
+std::vector<std::vector<float>> peakedLogits(int32_t vocab, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> body(0.0f, 2.0f);
+    std::uniform_int_distribution<int32_t> pick(0, vocab - 1);
+    std::vector<std::vector<float>> rows(kRows, std::vector<float>((size_t) vocab));
+    for (std::vector<float>& row : rows) {
+        for (float& logit : row) {
+            logit = body(rng);
+        }
+        for (int p = 0; p < 6; p++) {
+            row[(size_t) pick(rng)] += 6.0f + (float) p;
+        }
+    }
+    return rows;
+}
+
+// Share of `tokens` tokens on which both samplers agree from the same seed
+double agreement(const GenerationParams& params, int tokens) {
+    const std::vector<std::vector<float>> rows = peakedLogits(kVocab, 13);
+    TokenSampler fused;
+    fused.reset(params, kVocab);
+    NaiveSampler naive(params);
+    int agree = 0;
+    for (int i = 0; i < tokens; i++) {
+        const float* logits = rows[(size_t) i % kRows].data();
+        agree += fused.sample(logits) == naive.sample(logits, kVocab);
+    }
+    return (double) agree / tokens;
+}
+
+} // namespace
+
+TEST(selectTopKMatchesPartialSort) {
+    std::mt19937 rng(17);
+    std::normal_distribution<float> normal(0.0f, 3.0f);
+    for (int32_t n : {1, 7, 8, 9, 63, 1000, 32000}) {
+        std::vector<float> logits((size_t) n);
+        for (float& logit : logits) {
+            logit = normal(rng);
+        }
+        for (size_t k : {(size_t) 1, (size_t) 5, (size_t) 40, (size_t) 64, (size_t) n + 3}) {
+            std::vector<TokenCandidate> found(k);
+            const size_t count = selectTopK(logits.data(), n, k, found.data());
+            CHECK(count == std::min(k, (size_t) n));
+
+            std::vector<float> sorted = logits;
+            std::partial_sort(sorted.begin(), sorted.begin() + (long) count, sorted.end(), std::greater<float>());
+            for (size_t i = 0; i < count; i++) {
+                CHECK(found[i].logit == sorted[i]);
+                CHECK(logits[(size_t) found[i].id] == found[i].logit);
+            }
+        }
+    }
+}
+
+// Any of the tied logits may fill the cut-off, but the peaks come first
+TEST(selectTopKHandlesTies) {
+    std::vector<float> logits(500, 1.0f);
+    logits[123] = 4.0f;
+    logits[321] = 3.0f;
+    std::vector<TokenCandidate> found(10);
+    CHECK(selectTopK(logits.data(), 500, 10, found.data()) == 10);
+    CHECK(found[0].id == 123 && found[1].id == 321);
+    for (size_t i = 2; i < found.size(); i++) {
+        CHECK(found[i].logit == 1.0f);
+    }
+}
+
+TEST(samplerMatchesReferenceWithTopK) {
+    GenerationParams params;
+    params.seed = 42;
+    CHECK(agreement(params, 300) == 1.0);
+    params.topP = 1.0f;
+    params.minP = 0.0f;
+    params.temperature = 1.3f;
+    CHECK(agreement(params, 300) == 1.0);
+}
+
+// With top-k off the fused sampler takes the nucleus path
+TEST(samplerMatchesReferenceWithoutTopK) {
+    GenerationParams params;
+    params.seed = 7;
+    params.topK = 0;
+    CHECK(agreement(params, 300) == 1.0);
+    params.topP = 0.5f;
+    params.minP = 0.0f;
+    CHECK(agreement(params, 300) == 1.0);
+}
+
+TEST(samplerMatchesReferenceWithPenalty) {
+    GenerationParams params;
+    params.seed = 3;
+    params.repeatPenalty = 1.3f;
+    params.repeatLastN = 16;
+    CHECK(agreement(params, 300) == 1.0);
+    params.topK = 0;
+    CHECK(agreement(params, 300) == 1.0);
+    params.temperature = 0.0f;
+    CHECK(agreement(params, 300) == 1.0);
+}
+
+TEST(samplerIsGreedyWithoutTemperature) {
+    const std::vector<std::vector<float>> rows = peakedLogits(kVocab, 29);
+    GenerationParams params;
+    params.temperature = 0.0f;
+    TokenSampler sampler;
+    sampler.reset(params, kVocab);
+    for (const std::vector<float>& row : rows) {
+        const int32_t best = (int32_t) (std::max_element(row.begin(), row.end()) - row.begin());
+        CHECK(sampler.sample(row.data()) == best);
+    }
+}
+
+// Same seed, same tokens; the sampler must not carry state across reset()
+TEST(samplerIsReproducibleAcrossReset) {
+    const std::vector<std::vector<float>> rows = peakedLogits(kVocab, 31);
+    GenerationParams params;
+    params.seed = 99;
+    params.repeatPenalty = 1.2f;
+    TokenSampler sampler;
+    std::vector<int32_t> first, second;
+    sampler.reset(params, kVocab);
+    for (const std::vector<float>& row : rows) {
+        first.push_back(sampler.sample(row.data()));
+    }
+    sampler.reset(params, kVocab);
+    for (const std::vector<float>& row : rows) {
+        second.push_back(sampler.sample(row.data()));
+    }
+    CHECK(first == second);
+}
@@ -0,0 +1,160 @@
+// int8 vector index: kernels against scalar references, search against exact cosine
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "native_test.h"
+#include "vector_index.h"
+
+namespace {
+
+constexpr uint32_t kDim = 96;     // pads to 96: a multiple of 32
+constexpr uint32_t kRows = 300;
+constexpr uint64_t kSourceHash = 77;
+
+std::vector<float> randomVectors(uint32_t rows, uint32_t dim, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal;
+    std::vector<float> vectors((size_t) rows * dim);
+    for (float& v : vectors) {
+        v = normal(rng);
+    }
+    return vectors;
+}
+
+float cosine(const float* a, const float* b, uint32_t dim) {
+    double dot = 0.0, na = 0.0, nb = 0.0;
+    for (uint32_t i = 0; i < dim; i++) {
+        dot += (double) a[i] * b[i];
+        na += (double) a[i] * a[i];
+        nb += (double) b[i] * b[i];
+    }
+    return (float) (dot / std::sqrt(na * nb));
+}
+
+struct WrittenIndex {
+    std::string path;
+    std::vector<float> vectors = randomVectors(kRows, kDim, 11);
+    VectorIndex index;
+
+    WrittenIndex() {
+        char tmpl[] = "/tmp/native_tests_vectors_XXXXXX";
+        const int fd = mkstemp(tmpl);
+        if (fd < 0) {
+            return;
+        }
+        close(fd);
+        path = tmpl;
+        std::vector<std::string> labels;
+        std::vector<uint32_t> tags;
+        for (uint32_t row = 0; row < kRows; row++) {
+            labels.push_back("row" + std::to_string(row));
+            tags.push_back(row % 3);
+        }
+        std::string error;
+        if (VectorIndex::write(path, kDim, vectors, labels, tags, kSourceHash, error)) {
+            index.open(path, kSourceHash);
+        }
+    }
+
+    ~WrittenIndex() {
+        index.close();
+        if (!path.empty()) {
+            std::remove(path.c_str());
+        }
+    }
+};
+
+} // namespace
+
+TEST(dotInt8MatchesScalar) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> value(-127, 127);
+    for (size_t n = 32; n <= 512; n += 32) {
+        std::vector<int8_t> a(n), b(n);
+        int32_t expected = 0;
+        for (size_t i = 0; i < n; i++) {
+            a[i] = (int8_t) value(rng);
+            b[i] = (int8_t) value(rng);
+            expected += (int32_t) a[i] * b[i];
+        }
+        CHECK(dotInt8(a.data(), b.data(), n) == expected);
+    }
+    // Extremes of the quantized range
+    std::vector<int8_t> high(256, 127), low(256, -127);
+    CHECK(dotInt8(high.data(), low.data(), 256) == -127 * 127 * 256);
+    CHECK(dotInt8(low.data(), low.data(), 256) == 127 * 127 * 256);
+}
+
+TEST(quantizeVectorRoundTrips) {
+    const std::vector<float> values = randomVectors(1, kDim, 5);
+    std::vector<int8_t> quantized(128, 99);
+    const float scale = quantizeVector(values.data(), kDim, quantized.data(), 128);
+    CHECK(scale > 0.0f);
+    double norm = 0.0;
+    for (float v : values) {
+        norm += (double) v * v;
+    }
+    norm = std::sqrt(norm);
+    for (uint32_t i = 0; i < kDim; i++) {
+        CHECK(std::fabs(quantized[i] * scale - (float) (values[i] / norm)) <= scale * 0.5f + 1e-6f);
+    }
+    for (uint32_t i = kDim; i < 128; i++) {
+        CHECK(quantized[i] == 0);
+    }
+}
+
+TEST(vectorIndexOpensOnlyMatchingSource) {
+    WrittenIndex written;
+    CHECK(written.index.isOpen());
+    CHECK(written.index.size() == kRows);
+    CHECK(written.index.dim() == kDim);
+    VectorIndex stale;
+    CHECK(!stale.open(written.path, kSourceHash + 1));
+}
+
+// Int8 scores stay close to the exact cosine and the ranking matches it
+TEST(vectorIndexSearchMatchesExactCosine) {
+    WrittenIndex written;
+    const VectorIndex& index = written.index;
+    const std::vector<float> noise = randomVectors(8, kDim, 19);
+    for (uint32_t q = 0; q < 8; q++) {
+        const uint32_t target = q * 37;
+        std::vector<float> query(written.vectors.begin() + (size_t) target * kDim,
+                                 written.vectors.begin() + (size_t) (target + 1) * kDim);
+        for (uint32_t i = 0; i < kDim; i++) {
+            query[i] += 0.3f * noise[(size_t) q * kDim + i];
+        }
+
+        const std::vector<VectorHit> hits = index.search(query.data(), 5);
+        CHECK(hits.size() == 5);
+        if (hits.empty()) {
+            continue;
+        }
+        CHECK(hits[0].row == (int32_t) target);
+        for (size_t i = 0; i < hits.size(); i++) {
+            const float exact = cosine(query.data(), written.vectors.data() + (size_t) hits[i].row * kDim, kDim);
+            CHECK(std::fabs(hits[i].score - exact) < 0.02f);
+            CHECK(i == 0 || hits[i - 1].score >= hits[i].score);
+        }
+        CHECK(std::string(index.label(hits[0].row)) == "row" + std::to_string(target));
+    }
+}
+
+TEST(vectorIndexSearchFiltersByTag) {
+    WrittenIndex written;
+    const VectorIndex& index = written.index;
+    const std::vector<float> query = randomVectors(1, kDim, 23);
+    const std::vector<VectorHit> tagged = index.search(query.data(), 10, 1u << 2);
+    CHECK(tagged.size() == 10);
+    for (const VectorHit& hit : tagged) {
+        CHECK(index.tag(hit.row) == 2);
+    }
+    CHECK(index.search(query.data(), 10, 1u << 5).empty());
+    CHECK(index.search(query.data(), kRows + 50).size() == kRows);
+}
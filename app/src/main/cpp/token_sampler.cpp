@@ -0,0 +1,305 @@
+#include "token_sampler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "cpu_topology.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(TASTYDIET_AVX2_KERNELS)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr float kNone = -std::numeric_limits<float>::infinity();
+
+// First candidate set tried when top-k is off; peaked distributions rarely need more
+constexpr size_t kNucleusCandidates = 64;
+
+// Heap order putting the weakest candidate at the root. A function object, not a
+// function pointer, so the heap operations inline into the AVX2 kernel too.
+struct Weaker {
+    bool operator()(const TokenCandidate& a, const TokenCandidate& b) const {
+        return a.logit > b.logit;
+    }
+};
+constexpr Weaker weaker;
+
+inline void offer(TokenCandidate* heap, size_t& count, size_t k, float logit, int32_t id) {
+    if (count < k) {
+        heap[count++] = {logit, id};
+        std::push_heap(heap, heap + count, weaker);
+        return;
+    }
+    if (!(logit > heap[0].logit)) {
+        return;
+    }
+    // Replace the weakest and sift down: one pass instead of pop_heap + push_heap,
+    // and no out-of-line call from the AVX2 kernel into baseline SSE code
+    size_t i = 0;
+    for (size_t child = 1; child < k; child = 2 * i + 1) {
+        if (child + 1 < k && heap[child + 1].logit < heap[child].logit) {
+            child++;
+        }
+        if (!(heap[child].logit < logit)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = {logit, id};
+}
+
+#if defined(TASTYDIET_AVX2_KERNELS)
+// Blocks of 8 from `i`; returns where the scalar tail starts
+TASTYDIET_TARGET_AVX2
+int32_t scanAvx2(const float* logits, int32_t i, int32_t n, size_t k, TokenCandidate* heap, size_t& heapCount) {
+    size_t count = heapCount;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 threshold = _mm256_set1_ps(count < k ? kNone : heap[0].logit);
+        unsigned mask = (unsigned) _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(logits + i), threshold, _CMP_GT_OQ));
+        while (mask) {
+            const int32_t j = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+            offer(heap, count, k, logits[j], j);
+        }
+    }
+    heapCount = count;
+    return i;
+}
+#endif
+
+} // namespace
+
+size_t selectTopK(const float* logits, int32_t n, size_t k, TokenCandidate* out) {
+    if (k == 0 || n <= 0) {
+        return 0;
+    }
+    if (k >= (size_t) n) {
+        // Everything is kept: one sort beats heap churn
+        for (int32_t i = 0; i < n; i++) {
+            out[i] = {logits[i], i};
+        }
+        std::sort(out, out + n, weaker);
+        return (size_t) n;
+    }
+    size_t count = 0;
+    int32_t i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) {
+        const float32x4_t threshold = vdupq_n_f32(count < k ? kNone : out[0].logit);
+        const uint32x4_t above = vorrq_u32(vcgtq_f32(vld1q_f32(logits + i), threshold),
+                                           vcgtq_f32(vld1q_f32(logits + i + 4), threshold));
+        const uint64x2_t any = vreinterpretq_u64_u32(above);
+        if ((vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) == 0) {
+            continue; // the common case once the heap is full
+        }
+        for (int32_t j = i; j < i + 8; j++) {
+            if (logits[j] > (count < k ? kNone : out[0].logit)) {
+                offer(out, count, k, logits[j], j);
+            }
+        }
+    }
+#elif defined(TASTYDIET_AVX2_KERNELS)
+    if (cpuHasAvx2()) {
+        i = scanAvx2(logits, i, n, k, out, count);
+    }
+#endif
+    for (; i < n; i++) {
+        if (logits[i] > (count < k ? kNone : out[0].logit)) {
+            offer(out, count, k, logits[i], i);
+        }
+    }
+    std::sort_heap(out, out + count, weaker);
+    return count;
+}
+
+void TokenSampler::reset(const GenerationParams& params, int32_t nVocab) {
+    m_params = params;
+    m_vocab = std::max(nVocab, 1);
+    const bool greedy = params.temperature <= 0.0f;
+    m_topK = greedy ? 1 : (params.topK > 0 ? std::min<size_t>((size_t) params.topK, (size_t) m_vocab) : (size_t) m_vocab);
+
+    const size_t window = params.repeatPenalty != 1.0f
+        ? (size_t) std::clamp<int32_t>(params.repeatLastN, 0, std::numeric_limits<uint16_t>::max())
+        : 0;
+    if (m_seen.size() != (size_t) m_vocab) {
+        m_seen.assign((size_t) m_vocab, 0);
+    } else {
+        for (size_t i = 0; i < m_historyCount; i++) {
+            m_seen[(size_t) m_history[i]] = 0;
+        }
+    }
+    m_history.resize(window);
+    m_historyPos = 0;
+    m_historyCount = 0;
+    m_distinct = 0;
+
+    // Penalized tokens can fall out of the top k, so up to `window` more are kept
+    m_candidates.resize(std::min(m_topK + window, (size_t) m_vocab));
+    m_weights.resize(m_candidates.size());
+    m_rng.seed(params.seed == kRandomSeed ? std::random_device()() : params.seed);
+}
+
+int32_t TokenSampler::sample(const float* logits) {
+    const bool topKOff = m_topK == (size_t) m_vocab && m_params.temperature > 0.0f;
+    const size_t count = topKOff ? selectNucleus(logits) : selectTopCandidates(logits);
+    if (count == 0) {
+        return 0;
+    }
+    const TokenCandidate* c = m_candidates.data();
+    int32_t token = c[0].id;
+    if (count > 1) {
+        const float best = c[0].logit;
+        const float invTemperature = 1.0f / m_params.temperature;
+        float total = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            m_weights[i] = std::exp((c[i].logit - best) * invTemperature);
+            total += m_weights[i];
+        }
+        float target = uniform() * total;
+        token = c[count - 1].id;
+        for (size_t i = 0; i < count; i++) {
+            target -= m_weights[i];
+            if (target < 0.0f) {
+                token = c[i].id;
+                break;
+            }
+        }
+    }
+    record(token);
+    return token;
+}
+
+size_t TokenSampler::selectTopCandidates(const float* logits) {
+    size_t count = selectTopK(logits, m_vocab, std::min(m_topK + m_distinct, m_candidates.size()), m_candidates.data());
+    if (count == 0) {
+        return 0;
+    }
+    if (m_distinct > 0) {
+        applyPenalty(count);
+    }
+    count = std::min(count, m_topK);
+    if (m_params.temperature <= 0.0f || count == 1) {
+        return count;
+    }
+
+    // Top-p over the untempered distribution, then min-p relative to the best
+    const TokenCandidate* c = m_candidates.data();
+    const float best = c[0].logit;
+    if (m_params.topP < 1.0f) {
+        float total = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            m_weights[i] = std::exp(c[i].logit - best);
+            total += m_weights[i];
+        }
+        const float limit = m_params.topP * total;
+        float cumulative = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            cumulative += m_weights[i];
+            if (cumulative >= limit) {
+                count = i + 1;
+                break;
+            }
+        }
+    }
+    if (m_params.minP > 0.0f) {
+        const float floor = best + std::log(m_params.minP);
+        size_t keep = 1;
+        while (keep < count && c[keep].logit >= floor) {
+            keep++;
+        }
+        count = keep;
+    }
+    return count;
+}
+
+size_t TokenSampler::selectNucleus(const float* logits) {
+    // Best penalized logit and the weight of the whole vocabulary relative to it,
+    // rescaled whenever a new best turns up
+    float best = -std::numeric_limits<float>::infinity();
+    float total = 0.0f;
+    const float penalty = m_params.repeatPenalty;
+    for (int32_t i = 0; i < m_vocab; i++) {
+        float logit = logits[i];
+        if (m_distinct > 0 && m_seen[(size_t) i] > 0) {
+            logit = logit > 0.0f ? logit / penalty : logit * penalty;
+        }
+        if (logit > best) {
+            total = total * std::exp(best - logit) + 1.0f;
+            best = logit;
+        } else {
+            total += std::exp(logit - best);
+        }
+    }
+
+    // Widen the candidate set until the top-p mass or the min-p floor is reached
+    // inside it; only then is the cut the same as over the sorted vocabulary
+    const float limit = m_params.topP < 1.0f ? m_params.topP * total : std::numeric_limits<float>::infinity();
+    const float floor = m_params.minP > 0.0f ? best + std::log(m_params.minP) : -std::numeric_limits<float>::infinity();
+    for (size_t k = std::min(kNucleusCandidates, m_candidates.size());; k = std::min(2 * k, m_candidates.size())) {
+        size_t count = selectTopK(logits, m_vocab, std::min(k + m_distinct, m_candidates.size()), m_candidates.data());
+        if (m_distinct > 0) {
+            applyPenalty(count);
+        }
+        count = std::min(count, k);
+        float cumulative = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            if (i > 0 && m_candidates[i].logit < floor) {
+                return i;
+            }
+            cumulative += std::exp(m_candidates[i].logit - best);
+            if (cumulative >= limit) {
+                return i + 1;
+            }
+        }
+        if (k == m_candidates.size()) {
+            return count;
+        }
+    }
+}
+
+void TokenSampler::applyPenalty(size_t count) {
+    const float penalty = m_params.repeatPenalty;
+    for (size_t i = 0; i < count; i++) {
+        TokenCandidate& candidate = m_candidates[i];
+        if (m_seen[(size_t) candidate.id] > 0) {
+            candidate.logit = candidate.logit > 0.0f ? candidate.logit / penalty : candidate.logit * penalty;
+        }
+    }
+    // Only penalized entries moved, so the list is nearly sorted
+    for (size_t i = 1; i < count; i++) {
+        const TokenCandidate candidate = m_candidates[i];
+        size_t j = i;
+        while (j > 0 && m_candidates[j - 1].logit < candidate.logit) {
+            m_candidates[j] = m_candidates[j - 1];
+            j--;
+        }
+        m_candidates[j] = candidate;
+    }
+}
+
+void TokenSampler::record(int32_t token) {
+    if (m_history.empty() || token < 0 || token >= m_vocab) {
+        return;
+    }
+    if (m_historyCount == m_history.size()) {
+        if (--m_seen[(size_t) m_history[m_historyPos]] == 0) {
+            m_distinct--;
+        }
+    } else {
+        m_historyCount++;
+    }
+    m_history[m_historyPos] = token;
+    if (m_seen[(size_t) token]++ == 0) {
+        m_distinct++;
+    }
+    m_historyPos = (m_historyPos + 1) % m_history.size();
+}
+
+// 24 random bits in [0, 1); the same on every standard library, unlike
+// std::uniform_real_distribution
+float TokenSampler::uniform() {
+    return (float) (m_rng() >> 8) * (1.0f / 16777216.0f);
+}
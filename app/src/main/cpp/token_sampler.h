@@ -0,0 +1,74 @@
+#ifndef TOKEN_SAMPLER_H
+#define TOKEN_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Draws a fresh seed per request; same value as LLAMA_DEFAULT_SEED
+constexpr uint32_t kRandomSeed = 0xFFFFFFFF;
+
+// Sampling settings applied to every generateText call
+struct GenerationParams {
+    float temperature = 0.7f;   // <= 0 samples greedily
+    int32_t topK = 40;          // <= 0 keeps the whole vocabulary
+    float topP = 0.9f;
+    float minP = 0.05f;
+    float repeatPenalty = 1.0f; // 1 turns the penalty off
+    int32_t repeatLastN = 64;   // generated tokens the penalty looks back over
+    uint32_t seed = kRandomSeed;
+};
+
+struct TokenCandidate {
+    float logit;
+    int32_t id;
+};
+
+// The `k` largest logits of `n`, best first, into `out` (room for k); returns how
+// many were found. One pass: 8 logits at a time are compared against the weakest
+// kept candidate (NEON, or AVX2 when the CPU has it) and only the lanes that
+// beat it reach the heap.
+size_t selectTopK(const float* logits, int32_t n, size_t k, TokenCandidate* out);
+
+// Sampler chain of one sequence: repetition penalty, top-k, top-p, min-p,
+// temperature and the draw, fused. The vocabulary is read once per token by
+// selectTopK; every later stage works on the few surviving candidates, so a
+// token costs one pass over the logits and no allocation.
+//
+// Top-p and min-p see the distribution before temperature, matching the order
+// of the llama.cpp chain this replaces. A fixed seed makes a request reproducible.
+class TokenSampler {
+public:
+    // Per request: sizes the buffers for `nVocab` (allocating only when they
+    // grow), clears the penalty window and reseeds
+    void reset(const GenerationParams& params, int32_t nVocab);
+
+    // Samples from one row of logits and adds the token to the penalty window
+    int32_t sample(const float* logits);
+
+private:
+    GenerationParams m_params;
+    int32_t m_vocab = 0;
+    size_t m_topK = 0;
+    std::vector<TokenCandidate> m_candidates;
+    std::vector<float> m_weights;
+    // Penalty window: ring of recent tokens and their counts over the vocabulary
+    std::vector<int32_t> m_history;
+    size_t m_historyPos = 0;
+    size_t m_historyCount = 0;
+    std::vector<uint16_t> m_seen;
+    size_t m_distinct = 0;
+    std::mt19937 m_rng;
+
+    // Candidates left after the penalty, top-k, top-p and min-p, best first
+    size_t selectTopCandidates(const float* logits);
+    // The same with top-k off: one pass over the vocabulary for the total weight,
+    // then only as many candidates as top-p and min-p can keep are sorted
+    size_t selectNucleus(const float* logits);
+    void applyPenalty(size_t count);
+    void record(int32_t token);
+    float uniform();
+};
+
+#endif // TOKEN_SAMPLER_H
@@ -0,0 +1,209 @@
+// Host benchmark for the inference core: drives LlamaWrapper the same way the
+// JNI layer does and prints one JSON report on stdout, so releases can be
+// compared run against run on a Linux box.
+//
+//   llama_bench -m model.gguf [-n max_tokens] [-r repeats] [-w warmup] [-p prompts.txt]
+//               [-k f16|q8_0|q4_0] [-s max_draft [-d draft.gguf]] [-v]
+//
+// -s turns on speculative decoding: prompt-lookup n-grams, or the draft model
+// given with -d.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include "llama_wrapper.h"
+#include "tool_common.h"
+
+namespace {
+
+const char* const kDefaultQuestions[] = {
+    "What should I eat for breakfast to lose weight?",
+    "How much protein is in 100g of paneer?",
+    "Suggest a high-fibre vegetarian dinner under 500 calories.",
+    "Is rice or roti better for a diabetic diet?",
+    "Plan a post-workout snack with at least 20g of protein.",
+    "How many calories are in two idlis with sambar?",
+    "What are good sources of iron for vegetarians?",
+    "Give me a low-carb South Indian lunch idea.",
+};
+
+struct Options {
+    std::string modelPath;
+    std::string promptsPath;
+    int maxTokens = 128;
+    int repeats = 3;
+    int warmup = 1;
+    KvCacheType kvType = KvCacheType::F16;
+    int maxDraft = 0;
+    std::string draftPath;
+    bool verbose = false;
+};
+
+struct Run {
+    GenerationStats stats;
+    double latencyMs = 0.0;
+};
+
+void usage(const char* argv0) {
+    std::fprintf(stderr, "usage: %s -m model.gguf [-n max_tokens] [-r repeats] [-w warmup] [-p prompts.txt] [-k f16|q8_0|q4_0] [-s max_draft [-d draft.gguf]] [-v]\n", argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-m" && hasValue) {
+            options.modelPath = argv[++i];
+        } else if (arg == "-p" && hasValue) {
+            options.promptsPath = argv[++i];
+        } else if (arg == "-n" && hasValue) {
+            options.maxTokens = std::atoi(argv[++i]);
+        } else if (arg == "-r" && hasValue) {
+            options.repeats = std::atoi(argv[++i]);
+        } else if (arg == "-w" && hasValue) {
+            options.warmup = std::atoi(argv[++i]);
+        } else if (arg == "-k" && hasValue) {
+            const std::string type = argv[++i];
+            if (type == "q8_0") {
+                options.kvType = KvCacheType::Q8_0;
+            } else if (type == "q4_0") {
+                options.kvType = KvCacheType::Q4_0;
+            } else if (type != "f16") {
+                return false;
+            }
+        } else if (arg == "-s" && hasValue) {
+            options.maxDraft = std::atoi(argv[++i]);
+        } else if (arg == "-d" && hasValue) {
+            options.draftPath = argv[++i];
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else {
+            return false;
+        }
+    }
+    return !options.modelPath.empty() && options.maxTokens > 0 && options.repeats > 0;
+}
+
+// One question per line; blank lines and lines starting with '#' are skipped
+std::vector<std::string> loadPrompts(const std::string& path) {
+    std::vector<std::string> prompts;
+    if (path.empty()) {
+        for (const char* question : kDefaultQuestions) {
+            prompts.push_back(nutritionPrompt(question));
+        }
+        return prompts;
+    }
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[0] != '#') {
+            prompts.push_back(nutritionPrompt(line));
+        }
+    }
+    return prompts;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!options.verbose) {
+        llama_log_set(quietLog, nullptr);
+    }
+
+    const std::vector<std::string> prompts = loadPrompts(options.promptsPath);
+    if (prompts.empty()) {
+        std::fprintf(stderr, "no prompts in %s\n", options.promptsPath.c_str());
+        return 1;
+    }
+
+    // Same bring-up as the JNI initModel: load, context, pinned calibration, prefix
+    LlamaWrapper wrapper;
+    wrapper.setKvCacheType(options.kvType);
+    if (!wrapper.loadModel(options.modelPath) || !wrapper.createContext()) {
+        std::fprintf(stderr, "failed to load %s: %s\n", options.modelPath.c_str(),
+                     wrapper.getLoadReport().error.c_str());
+        return 1;
+    }
+    const CpuTopology& topology = CpuTopology::get();
+    if (topology.isHeterogeneous()) {
+        pinCurrentThread(topology.performanceCores);
+    }
+    wrapper.calibrateThreads(wrapper.threadConfigPath());
+    wrapper.setSystemPrompt(kSystemPrompt);
+    if (options.maxDraft > 0) {
+        std::unique_ptr<Drafter> drafter = options.draftPath.empty()
+            ? wrapper.createNgramDrafter({})
+            : wrapper.createDraftModelDrafter(options.draftPath);
+        if (!drafter) {
+            std::fprintf(stderr, "failed to load draft model %s\n", options.draftPath.c_str());
+            return 1;
+        }
+        wrapper.setDrafter(std::move(drafter), options.maxDraft);
+    }
+
+    for (int i = 0; i < options.warmup; i++) {
+        wrapper.generateText(prompts[(size_t) i % prompts.size()], options.maxTokens);
+    }
+
+    std::vector<Run> runs;
+    for (int r = 0; r < options.repeats; r++) {
+        for (const std::string& prompt : prompts) {
+            const auto start = std::chrono::steady_clock::now();
+            wrapper.generateText(prompt, options.maxTokens);
+            Run run;
+            run.latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            run.stats = wrapper.getLastStats();
+            runs.push_back(run);
+        }
+    }
+
+    std::vector<double> ttft;
+    std::vector<double> latency;
+    double prefillTokens = 0.0, prefillMs = 0.0, decodeTokens = 0.0, decodeMs = 0.0;
+    for (const Run& run : runs) {
+        ttft.push_back(run.stats.timeToFirstTokenMs);
+        latency.push_back(run.latencyMs);
+        prefillTokens += run.stats.promptTokens - run.stats.cachedPromptTokens;
+        prefillMs += run.stats.prefillMs;
+        // The first generated token is produced by the prefill batch
+        decodeTokens += std::max(0, run.stats.generatedTokens - 1);
+        decodeMs += run.stats.decodeMs;
+    }
+
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    const ThreadConfig threads = wrapper.threadConfig();
+
+    std::ostringstream ss;
+    ss << "{\"model\":" << jsonString(options.modelPath)
+       << ",\"load\":" << wrapper.getLoadReport().toJson()
+       << ",\"cpu\":" << jsonString(topology.describe())
+       << ",\"threads\":{\"prefill\":" << threads.prefillThreads << ",\"decode\":" << threads.decodeThreads << "}"
+       << ",\"maxTokens\":" << options.maxTokens
+       << ",\"prompts\":" << prompts.size()
+       << ",\"runs\":" << runs.size()
+       << ",\"ttftMs\":" << distributionJson(ttft)
+       << ",\"latencyMs\":" << distributionJson(latency)
+       << ",\"prefillTokensPerSec\":" << (prefillMs > 0 ? prefillTokens * 1000.0 / prefillMs : 0.0)
+       << ",\"decodeTokensPerSec\":" << (decodeMs > 0 ? decodeTokens * 1000.0 / decodeMs : 0.0)
+       << ",\"speculative\":" << wrapper.speculativeStatsJson()
+       << ",\"memory\":" << wrapper.memoryReport().toJson()
+       << ",\"peakRssMb\":" << usage.ru_maxrss / 1024.0  // ru_maxrss is in KB on Linux
+       << "}";
+    std::printf("%s\n", ss.str().c_str());
+
+    wrapper.unloadModel();
+    return 0;
+}
@@ -0,0 +1,351 @@
+// Offline batch evaluation: pushes a command corpus through LlamaServer with one
+// client per sequence slot, so the prefill and decode steps of every in-flight
+// item share llama_decode batches the way concurrent app sessions do. Writes one
+// JSON line per item and prints a JSON summary on stdout, for nightly runs that
+// catch quality and throughput regressions when the model or template changes.
+//
+//   llama_eval -m model.gguf -i commands.csv [-o results.jsonl] [-n max_tokens]
+//              [-s slots] [-c n_ctx] [-k f16|q8_0|q4_0] [-v]
+//
+// The input is CSV with a header row, "command[,ActionType]" per line (as in
+// offline_voice_commands_mapped.csv). Labelled rows are also classified by the
+// model under a grammar that only admits the labels seen in the file, and by the
+// keyword IntentRouter built from the same file, so the app's two routing paths
+// are compared on one corpus; -n 0 skips the free-form responses and measures
+// intent accuracy alone.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "intent_router.h"
+#include "llama_server.h"
+#include "llama_wrapper.h"
+#include "tool_common.h"
+
+namespace {
+
+// Labels are short and the grammar ends on the last character of one
+constexpr int kIntentMaxTokens = 12;
+
+struct Options {
+    std::string modelPath;
+    std::string inputPath;
+    std::string outputPath = "eval_results.jsonl";
+    int maxTokens = 128;
+    int slots = 4;
+    uint32_t nCtx = 4096;
+    KvCacheType kvType = KvCacheType::F16;
+    bool verbose = false;
+};
+
+struct Item {
+    std::string command;
+    std::string expected;  // empty when the row is unlabelled
+
+    std::string predicted;
+    double intentMs = 0.0;
+    std::string routed;  // IntentRouter's best action, empty when nothing matched
+    double routerMs = 0.0;
+    std::string response;
+    double latencyMs = 0.0;
+    GenerationStats stats;  // of the response request
+};
+
+void usage(const char* argv0) {
+    std::fprintf(stderr, "usage: %s -m model.gguf -i commands.csv [-o results.jsonl] [-n max_tokens] [-s slots] [-c n_ctx] [-k f16|q8_0|q4_0] [-v]\n", argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-m" && hasValue) {
+            options.modelPath = argv[++i];
+        } else if (arg == "-i" && hasValue) {
+            options.inputPath = argv[++i];
+        } else if (arg == "-o" && hasValue) {
+            options.outputPath = argv[++i];
+        } else if (arg == "-n" && hasValue) {
+            options.maxTokens = std::atoi(argv[++i]);
+        } else if (arg == "-s" && hasValue) {
+            options.slots = std::atoi(argv[++i]);
+        } else if (arg == "-c" && hasValue) {
+            options.nCtx = (uint32_t) std::atoi(argv[++i]);
+        } else if (arg == "-k" && hasValue) {
+            const std::string type = argv[++i];
+            if (type == "q8_0") {
+                options.kvType = KvCacheType::Q8_0;
+            } else if (type == "q4_0") {
+                options.kvType = KvCacheType::Q4_0;
+            } else if (type != "f16") {
+                return false;
+            }
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else {
+            return false;
+        }
+    }
+    return !options.modelPath.empty() && !options.inputPath.empty() && options.maxTokens >= 0 &&
+           options.slots > 0 && options.nCtx > 0;
+}
+
+std::string trim(const std::string& s) {
+    const size_t begin = s.find_first_not_of(" \t\r\n\"");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    return s.substr(begin, s.find_last_not_of(" \t\r\n\"") - begin + 1);
+}
+
+// Labels never contain commas, so the last comma splits command from label
+std::vector<Item> loadItems(const std::string& csv) {
+    std::vector<Item> items;
+    std::istringstream in(csv);
+    std::string line;
+    bool header = true;
+    while (std::getline(in, line)) {
+        if (header) {
+            header = false;
+            continue;
+        }
+        Item item;
+        const size_t comma = line.rfind(',');
+        item.command = trim(comma == std::string::npos ? line : line.substr(0, comma));
+        if (comma != std::string::npos) {
+            item.expected = trim(line.substr(comma + 1));
+        }
+        if (!item.command.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::string intentPrompt(const std::string& command, const std::vector<std::string>& labels) {
+    std::string list;
+    for (const std::string& label : labels) {
+        list += (list.empty() ? "" : ", ") + label;
+    }
+    return nutritionPrompt("Classify this voice command of a diet app as one of: " + list +
+                           ". Reply with the label only.\nCommand: " + command);
+}
+
+// root ::= "Label" | "Label" | ...
+std::string labelGrammar(const std::vector<std::string>& labels) {
+    std::string grammar = "root ::= ";
+    for (size_t i = 0; i < labels.size(); i++) {
+        grammar += (i ? " | \"" : "\"") + labels[i] + "\"";
+    }
+    return grammar + "\n";
+}
+
+std::string itemJson(const Item& item) {
+    std::ostringstream ss;
+    ss << "{\"command\":" << jsonString(item.command);
+    if (!item.expected.empty()) {
+        ss << ",\"expected\":" << jsonString(item.expected)
+           << ",\"predicted\":" << jsonString(item.predicted)
+           << ",\"match\":" << (item.predicted == item.expected ? "true" : "false")
+           << ",\"intentMs\":" << item.intentMs
+           << ",\"routed\":" << jsonString(item.routed)
+           << ",\"routerMatch\":" << (item.routed == item.expected ? "true" : "false")
+           << ",\"routerMs\":" << item.routerMs;
+    }
+    if (item.stats.promptTokens > 0) {
+        ss << ",\"response\":" << jsonString(item.response)
+           << ",\"latencyMs\":" << item.latencyMs
+           << ",\"ttftMs\":" << item.stats.timeToFirstTokenMs
+           << ",\"queueWaitMs\":" << item.stats.queueWaitMs
+           << ",\"promptTokens\":" << item.stats.promptTokens
+           << ",\"cachedPromptTokens\":" << item.stats.cachedPromptTokens
+           << ",\"generatedTokens\":" << item.stats.generatedTokens;
+    }
+    ss << "}";
+    return ss.str();
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!options.verbose) {
+        llama_log_set(quietLog, nullptr);
+    }
+
+    std::ifstream in(options.inputPath, std::ios::binary);
+    const std::string csv((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<Item> items = loadItems(csv);
+    if (items.empty()) {
+        std::fprintf(stderr, "no commands in %s\n", options.inputPath.c_str());
+        return 1;
+    }
+    std::set<std::string> labelSet;
+    for (const Item& item : items) {
+        if (!item.expected.empty()) {
+            labelSet.insert(item.expected);
+        }
+    }
+    const std::vector<std::string> labels(labelSet.begin(), labelSet.end());
+    const std::string grammar = labels.empty() ? std::string() : labelGrammar(labels);
+
+    // The keyword router is cheap enough to score up front on this thread
+    IntentRouter router;
+    if (!labels.empty() && router.build(csv.data(), csv.size())) {
+        for (Item& item : items) {
+            if (!item.expected.empty()) {
+                const auto begin = std::chrono::steady_clock::now();
+                const std::vector<IntentScore> scores = router.classify(item.command);
+                item.routerMs = msSince(begin);
+                item.routed = scores.empty() ? std::string() : scores.front().action;
+            }
+        }
+    }
+
+    // Same bring-up as the JNI loadAndWarm, with one sequence slot per client
+    LlamaWrapper wrapper;
+    llama_context_params params = wrapper.getContextParams();
+    params.n_ctx = options.nCtx;
+    wrapper.setContextParams(params);
+    wrapper.setKvCacheType(options.kvType);
+    wrapper.setMaxSequences(options.slots);
+    LlamaServer server(wrapper);
+    if (!wrapper.loadModel(options.modelPath) || !wrapper.createContext() || !server.start()) {
+        std::fprintf(stderr, "failed to load %s: %s\n", options.modelPath.c_str(),
+                     wrapper.getLoadReport().error.c_str());
+        return 1;
+    }
+    server.runExclusive([&wrapper] {
+        wrapper.calibrateThreads(wrapper.threadConfigPath());
+        wrapper.warmUp();
+        wrapper.setSystemPrompt(kSystemPrompt);
+    });
+
+    // Jobs: the labelled items' intents, then every response. Each client takes
+    // the next job whenever its own request finishes, keeping every slot busy.
+    struct Job {
+        size_t item;
+        bool intent;
+    };
+    std::vector<Job> jobs;
+    if (!grammar.empty()) {
+        for (size_t i = 0; i < items.size(); i++) {
+            if (!items[i].expected.empty()) {
+                jobs.push_back({i, true});
+            }
+        }
+    }
+    if (options.maxTokens > 0) {
+        for (size_t i = 0; i < items.size(); i++) {
+            jobs.push_back({i, false});
+        }
+    }
+
+    std::atomic<size_t> next(0);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int c = 0; c < options.slots; c++) {
+        clients.emplace_back([&] {
+            const int32_t session = server.createSession();
+            if (session < 0) {
+                return;
+            }
+            for (size_t j = next++; j < jobs.size(); j = next++) {
+                Item& item = items[jobs[j].item];
+                const auto begin = std::chrono::steady_clock::now();
+                if (jobs[j].intent) {
+                    item.predicted = trim(server.generate(session, intentPrompt(item.command, labels),
+                                                          kIntentMaxTokens, TokenCallback(), grammar));
+                    item.intentMs = msSince(begin);
+                } else {
+                    item.response = server.generate(session, nutritionPrompt(item.command), options.maxTokens);
+                    item.latencyMs = msSince(begin);
+                    item.stats = server.lastStats(session);
+                }
+            }
+            server.destroySession(session);
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    const double wallMs = msSince(start);
+
+    std::ofstream out(options.outputPath);
+    size_t labelled = 0, correct = 0, routerCorrect = 0, responses = 0;
+    std::map<std::string, std::pair<size_t, size_t>> perLabel;  // label -> correct, total
+    std::vector<double> intentMs, routerMs, latency, ttft;
+    double generatedTokens = 0.0;
+    for (const Item& item : items) {
+        out << itemJson(item) << "\n";
+        if (!item.expected.empty() && !grammar.empty()) {
+            const bool match = item.predicted == item.expected;
+            labelled++;
+            correct += match;
+            perLabel[item.expected].first += match;
+            perLabel[item.expected].second++;
+            intentMs.push_back(item.intentMs);
+            routerCorrect += item.routed == item.expected;
+            routerMs.push_back(item.routerMs);
+        }
+        if (item.stats.promptTokens > 0) {
+            responses++;
+            latency.push_back(item.latencyMs);
+            ttft.push_back(item.stats.timeToFirstTokenMs);
+            generatedTokens += item.stats.generatedTokens;
+        }
+    }
+    if (!out) {
+        std::fprintf(stderr, "failed to write %s\n", options.outputPath.c_str());
+        return 1;
+    }
+
+    std::ostringstream labelsJson;
+    for (const auto& entry : perLabel) {
+        labelsJson << (labelsJson.tellp() > 0 ? "," : "") << jsonString(entry.first) << ":"
+                   << (double) entry.second.first / entry.second.second;
+    }
+    std::ostringstream ss;
+    ss << "{\"model\":" << jsonString(options.modelPath)
+       << ",\"input\":" << jsonString(options.inputPath)
+       << ",\"results\":" << jsonString(options.outputPath)
+       << ",\"slots\":" << options.slots
+       << ",\"maxTokens\":" << options.maxTokens
+       << ",\"items\":" << items.size()
+       << ",\"intentAccuracy\":" << (labelled ? (double) correct / labelled : 0.0)
+       << ",\"intentAccuracyByLabel\":{" << labelsJson.str() << "}"
+       << ",\"intentMs\":" << distributionJson(intentMs)
+       << ",\"routerAccuracy\":" << (labelled ? (double) routerCorrect / labelled : 0.0)
+       << ",\"routerMs\":" << distributionJson(routerMs)
+       << ",\"responses\":" << responses
+       << ",\"latencyMs\":" << distributionJson(latency)
+       << ",\"ttftMs\":" << distributionJson(ttft)
+       << ",\"wallMs\":" << wallMs
+       << ",\"requestsPerSec\":" << (wallMs > 0 ? jobs.size() * 1000.0 / wallMs : 0.0)
+       << ",\"generatedTokensPerSec\":" << (wallMs > 0 ? generatedTokens * 1000.0 / wallMs : 0.0)
+       << "}";
+    std::printf("%s\n", ss.str().c_str());
+
+    server.stop();
+    wrapper.unloadModel();
+    return 0;
+}
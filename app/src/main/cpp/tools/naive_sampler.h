@@ -0,0 +1,100 @@
+#ifndef NAIVE_SAMPLER_H
+#define NAIVE_SAMPLER_H
+
+// Reference for TokenSampler, shared by sampler_bench and the host tests
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "token_sampler.h"
+
+// Same stages and random draws as TokenSampler, one full pass and fresh vector each
+class NaiveSampler {
+public:
+    explicit NaiveSampler(const GenerationParams& params) : m_params(params), m_rng(params.seed) {}
+
+    int32_t sample(const float* logits, int32_t vocab) {
+        std::vector<TokenCandidate> candidates;
+        for (int32_t i = 0; i < vocab; i++) {
+            candidates.push_back({logits[i], i});
+        }
+        if (m_params.repeatPenalty != 1.0f) {
+            const std::set<int32_t> seen(m_history.begin(), m_history.end());
+            for (TokenCandidate& c : candidates) {
+                if (seen.count(c.id)) {
+                    c.logit = c.logit > 0.0f ? c.logit / m_params.repeatPenalty : c.logit * m_params.repeatPenalty;
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const TokenCandidate& a, const TokenCandidate& b) {
+            return a.logit > b.logit;
+        });
+        int32_t token = candidates[0].id;
+        if (m_params.temperature > 0.0f) {
+            if (m_params.topK > 0 && (size_t) m_params.topK < candidates.size()) {
+                candidates.resize((size_t) m_params.topK);
+            }
+            std::vector<float> probs = softmax(candidates, 1.0f);
+            std::vector<TokenCandidate> nucleus;
+            float cumulative = 0.0f;
+            for (size_t i = 0; i < candidates.size(); i++) {
+                nucleus.push_back(candidates[i]);
+                cumulative += probs[i];
+                if (m_params.topP < 1.0f && cumulative >= m_params.topP) {
+                    break;
+                }
+            }
+            std::vector<TokenCandidate> kept;
+            for (const TokenCandidate& c : nucleus) {
+                if (kept.empty() || c.logit >= nucleus[0].logit + std::log(m_params.minP)) {
+                    kept.push_back(c);
+                }
+            }
+            if (kept.size() > 1) {
+                probs = softmax(kept, m_params.temperature);
+                float target = (float) (m_rng() >> 8) * (1.0f / 16777216.0f);
+                token = kept.back().id;
+                for (size_t i = 0; i < kept.size(); i++) {
+                    target -= probs[i];
+                    if (target < 0.0f) {
+                        token = kept[i].id;
+                        break;
+                    }
+                }
+            } else {
+                token = kept[0].id;
+            }
+        }
+        if (m_params.repeatPenalty != 1.0f) {
+            m_history.push_back(token);
+            if ((int32_t) m_history.size() > m_params.repeatLastN) {
+                m_history.pop_front();
+            }
+        }
+        return token;
+    }
+
+private:
+    GenerationParams m_params;
+    std::mt19937 m_rng;
+    std::deque<int32_t> m_history;
+
+    static std::vector<float> softmax(const std::vector<TokenCandidate>& candidates, float temperature) {
+        std::vector<float> probs;
+        float total = 0.0f;
+        for (const TokenCandidate& c : candidates) {
+            probs.push_back(std::exp((c.logit - candidates[0].logit) / temperature));
+            total += probs.back();
+        }
+        for (float& p : probs) {
+            p /= total;
+        }
+        return probs;
+    }
+};
+
+#endif // NAIVE_SAMPLER_H
@@ -0,0 +1,109 @@
+// Micro-benchmark for TokenSampler: per-token sampling cost over synthetic logits
+// against a naive reference that runs each stage as its own full-vocabulary pass
+// with temporary vectors (the shape of a per-stage sampler chain). Needs no model;
+// prints one JSON report on stdout.
+//
+//   sampler_bench [-n vocab] [-i iterations] [-k top_k] [-t temperature] [-r repeat_penalty]
+//
+// "agreement" is the share of tokens both samplers pick from the same logits and
+// seed; it stays at 1 unless two candidates tie.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cpu_topology.h"
+#include "naive_sampler.h"
+#include "token_sampler.h"
+
+namespace {
+
+constexpr int kLogitRows = 64;
+
+struct Options {
+    int32_t vocab = 32000;
+    int iterations = 5000;
+    GenerationParams params;
+};
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    options.params.seed = 42;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-n" && hasValue) {
+            options.vocab = std::atoi(argv[++i]);
+        } else if (arg == "-i" && hasValue) {
+            options.iterations = std::atoi(argv[++i]);
+        } else if (arg == "-k" && hasValue) {
+            options.params.topK = std::atoi(argv[++i]);
+        } else if (arg == "-t" && hasValue) {
+            options.params.temperature = (float) std::atof(argv[++i]);
+        } else if (arg == "-r" && hasValue) {
+            options.params.repeatPenalty = (float) std::atof(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return options.vocab > 0 && options.iterations > 0;
+}
+
+// Roughly LM-shaped rows: a broad normal body and a handful of strong peaks
+std::vector<std::vector<float>> makeLogits(int32_t vocab) {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> body(0.0f, 2.0f);
+    std::uniform_int_distribution<int32_t> pick(0, vocab - 1);
+    std::vector<std::vector<float>> rows(kLogitRows, std::vector<float>((size_t) vocab));
+    for (std::vector<float>& row : rows) {
+        for (float& logit : row) {
+            logit = body(rng);
+        }
+        for (int p = 0; p < 8; p++) {
+            row[(size_t) pick(rng)] += 8.0f + (float) p;
+        }
+    }
+    return rows;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [-n vocab] [-i iterations] [-k top_k] [-t temperature] [-r repeat_penalty]\n", argv[0]);
+        return 2;
+    }
+    const std::vector<std::vector<float>> rows = makeLogits(options.vocab);
+
+    using Clock = std::chrono::steady_clock;
+    TokenSampler fused;
+    fused.reset(options.params, options.vocab);
+    std::vector<int32_t> fusedTokens((size_t) options.iterations);
+    auto start = Clock::now();
+    for (int i = 0; i < options.iterations; i++) {
+        fusedTokens[(size_t) i] = fused.sample(rows[(size_t) i % kLogitRows].data());
+    }
+    const double fusedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / options.iterations;
+
+    NaiveSampler naive(options.params);
+    size_t agree = 0;
+    start = Clock::now();
+    for (int i = 0; i < options.iterations; i++) {
+        agree += naive.sample(rows[(size_t) i % kLogitRows].data(), options.vocab) == fusedTokens[(size_t) i];
+    }
+    const double naiveNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / options.iterations;
+
+#if defined(__ARM_NEON)
+    const char* kernel = "neon";
+#else
+    const char* kernel = cpuHasAvx2() ? "avx2" : "scalar";
+#endif
+    std::printf("{\"kernel\":\"%s\",\"vocab\":%d,\"iterations\":%d,\"topK\":%d,\"temperature\":%g,\"repeatPenalty\":%g,"
+                "\"fusedNsPerToken\":%.0f,\"naiveNsPerToken\":%.0f,\"speedup\":%.2f,\"agreement\":%.4f}\n",
+                kernel, options.vocab, options.iterations, options.params.topK, options.params.temperature,
+                options.params.repeatPenalty, fusedNs, naiveNs, naiveNs / fusedNs, (double) agree / options.iterations);
+    return 0;
+}
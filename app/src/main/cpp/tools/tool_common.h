@@ -0,0 +1,78 @@
+#ifndef TOOL_COMMON_H
+#define TOOL_COMMON_H
+
+// Report helpers shared by the host tools
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "llama.h"
+
+// Same chat template as LlamaManager.createNutritionPrompt
+inline const char* const kSystemPrompt =
+    "<|system|>\n"
+    "You are a helpful AI assistant. Answer questions directly and naturally.\n"
+    "</s>\n";
+
+inline std::string nutritionPrompt(const std::string& question) {
+    return std::string(kSystemPrompt) + "<|user|>\n" + question + "\n</s>\n<|assistant|>\n";
+}
+
+inline double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    // Nearest-rank
+    size_t rank = (size_t) (p / 100.0 * values.size() + 0.999999);
+    rank = std::min(std::max<size_t>(rank, 1), values.size());
+    return values[rank - 1];
+}
+
+inline std::string distributionJson(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    std::ostringstream ss;
+    ss << "{\"mean\":" << (values.empty() ? 0.0 : sum / values.size())
+       << ",\"p50\":" << percentile(values, 50)
+       << ",\"p95\":" << percentile(values, 95)
+       << ",\"p99\":" << percentile(values, 99) << "}";
+    return ss.str();
+}
+
+inline std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned) c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+// llama.cpp log sink that keeps stderr to errors unless -v is given
+inline void quietLog(enum ggml_log_level level, const char* text, void* userData) {
+    (void) userData;
+    if (level == GGML_LOG_LEVEL_ERROR) {
+        std::fputs(text, stderr);
+    }
+}
+
+#endif // TOOL_COMMON_H
@@ -0,0 +1,315 @@
+#include "vector_index.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cpu_topology.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(TASTYDIET_AVX2_KERNELS)
+#include <immintrin.h>
+#endif
+
+#include "native_log.h"
+
+#define TAG "VectorIndex"
+#define LOGi(...) nativeLog(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGe(...) nativeLog(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'D', 'V', 'I'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kVectorAlign = 64;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t dim;
+    uint32_t paddedDim;
+    uint32_t count;
+    uint32_t labelBytes;
+    uint64_t scalesOffset;
+    uint64_t tagsOffset;
+    uint64_t labelOffsetsOffset;
+    uint64_t vectorsOffset;
+    uint64_t labelsOffset;
+    uint64_t fileSize;
+};
+
+uint32_t padDim(uint32_t dim) {
+    return (dim + 31) & ~31u;
+}
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+#if defined(TASTYDIET_AVX2_KERNELS)
+TASTYDIET_TARGET_AVX2
+int32_t dotInt8Avx2(const int8_t* a, const int8_t* b, size_t n) {
+    // maddubs wants unsigned x signed: move a's sign onto b. Values are in
+    // [-127, 127], so the pairwise int16 sums cannot saturate.
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t i = 0; i < n; i += 32) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        const __m256i products = _mm256_maddubs_epi16(_mm256_sign_epi8(va, va), _mm256_sign_epi8(vb, va));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(products, ones));
+    }
+    const __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    const __m128i sum64 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+    const __m128i sum32 = _mm_add_epi32(sum64, _mm_shuffle_epi32(sum64, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum32);
+}
+#endif
+
+} // namespace
+
+int32_t dotInt8(const int8_t* a, const int8_t* b, size_t n) {
+#if defined(__ARM_NEON) && defined(__ARM_FEATURE_DOTPROD)
+    int32x4_t acc0 = vdupq_n_s32(0);
+    int32x4_t acc1 = vdupq_n_s32(0);
+    for (size_t i = 0; i < n; i += 32) {
+        acc0 = vdotq_s32(acc0, vld1q_s8(a + i), vld1q_s8(b + i));
+        acc1 = vdotq_s32(acc1, vld1q_s8(a + i + 16), vld1q_s8(b + i + 16));
+    }
+    return vaddvq_s32(vaddq_s32(acc0, acc1));
+#elif defined(__ARM_NEON)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (size_t i = 0; i < n; i += 16) {
+        const int8x16_t va = vld1q_s8(a + i);
+        const int8x16_t vb = vld1q_s8(b + i);
+        acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        acc = vpadalq_s16(acc, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+    }
+#if defined(__aarch64__)
+    return vaddvq_s32(acc);
+#else
+    const int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    return vget_lane_s32(vpadd_s32(sum, sum), 0);
+#endif
+#else
+#if defined(TASTYDIET_AVX2_KERNELS)
+    if (cpuHasAvx2()) {
+        return dotInt8Avx2(a, b, n);
+    }
+#endif
+    int32_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (int32_t) a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+
+float quantizeVector(const float* values, uint32_t dim, int8_t* out, uint32_t paddedDim) {
+    double norm = 0.0;
+    float maxAbs = 0.0f;
+    for (uint32_t i = 0; i < dim; i++) {
+        norm += (double) values[i] * values[i];
+        maxAbs = std::max(maxAbs, std::fabs(values[i]));
+    }
+    std::memset(out, 0, paddedDim);
+    if (norm <= 0.0 || maxAbs <= 0.0f) {
+        return 0.0f;
+    }
+    // Scale of the L2-normalized vector, so dot * scaleA * scaleB ~ cosine
+    const float inverseNorm = (float) (1.0 / std::sqrt(norm));
+    const float scale = maxAbs * inverseNorm / 127.0f;
+    for (uint32_t i = 0; i < dim; i++) {
+        out[i] = (int8_t) std::lround(values[i] * inverseNorm / scale);
+    }
+    return scale;
+}
+
+bool VectorIndex::write(const std::string& path, uint32_t dim, const std::vector<float>& vectors,
+                        const std::vector<std::string>& labels, const std::vector<uint32_t>& tags,
+                        uint64_t sourceHash, std::string& error) {
+    const uint32_t count = (uint32_t) labels.size();
+    if (dim == 0 || count == 0 || vectors.size() != (size_t) count * dim || tags.size() != count) {
+        error = "inconsistent vector index input";
+        return false;
+    }
+
+    FileHeader header {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.sourceHash = sourceHash;
+    header.dim = dim;
+    header.paddedDim = padDim(dim);
+    header.count = count;
+
+    std::string labelText;
+    std::vector<uint32_t> labelOffsets(count);
+    for (uint32_t i = 0; i < count; i++) {
+        labelOffsets[i] = (uint32_t) labelText.size();
+        labelText.append(labels[i]).push_back('\0');
+    }
+    header.labelBytes = (uint32_t) labelText.size();
+
+    header.scalesOffset = alignUp(sizeof(FileHeader), 8);
+    header.tagsOffset = alignUp(header.scalesOffset + count * sizeof(float), 8);
+    header.labelOffsetsOffset = alignUp(header.tagsOffset + count * sizeof(uint32_t), 8);
+    header.vectorsOffset = alignUp(header.labelOffsetsOffset + count * sizeof(uint32_t), kVectorAlign);
+    header.labelsOffset = header.vectorsOffset + (uint64_t) count * header.paddedDim;
+    header.fileSize = alignUp(header.labelsOffset + header.labelBytes, 8);
+
+    std::vector<uint8_t> bytes(header.fileSize, 0);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    float* scales = reinterpret_cast<float*>(bytes.data() + header.scalesOffset);
+    int8_t* quantized = reinterpret_cast<int8_t*>(bytes.data() + header.vectorsOffset);
+    for (uint32_t i = 0; i < count; i++) {
+        scales[i] = quantizeVector(vectors.data() + (size_t) i * dim, dim,
+                                   quantized + (size_t) i * header.paddedDim, header.paddedDim);
+    }
+    std::memcpy(bytes.data() + header.tagsOffset, tags.data(), count * sizeof(uint32_t));
+    std::memcpy(bytes.data() + header.labelOffsetsOffset, labelOffsets.data(), count * sizeof(uint32_t));
+    std::memcpy(bytes.data() + header.labelsOffset, labelText.data(), labelText.size());
+
+    const std::string tmpPath = path + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + tmpPath;
+        return false;
+    }
+    const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    const bool closed = std::fclose(file) == 0;
+    if (!written || !closed || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        error = "cannot write " + path;
+        return false;
+    }
+    LOGi("Wrote %u vectors (dim %u) into %zu bytes", count, dim, bytes.size());
+    return true;
+}
+
+VectorIndex::VectorIndex()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_dim(0)
+    , m_paddedDim(0)
+    , m_count(0)
+    , m_scales(nullptr)
+    , m_tags(nullptr)
+    , m_labelOffsets(nullptr)
+    , m_vectors(nullptr)
+    , m_labels(nullptr) {
+}
+
+VectorIndex::~VectorIndex() {
+    close();
+}
+
+bool VectorIndex::open(const std::string& path, uint64_t expectedSourceHash) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    void* addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(FileHeader)) {
+        addr = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(addr);
+    m_size = (size_t) st.st_size;
+
+    FileHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    const uint64_t count = header.count;
+    auto fits = [&](uint64_t offset, uint64_t bytes) { return offset <= m_size && bytes <= m_size - offset; };
+    bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                 header.version == kVersion &&
+                 header.fileSize == m_size &&
+                 count > 0 && header.dim > 0 && header.paddedDim == padDim(header.dim) &&
+                 header.scalesOffset % 8 == 0 && header.tagsOffset % 8 == 0 &&
+                 header.labelOffsetsOffset % 8 == 0 && header.vectorsOffset % kVectorAlign == 0 &&
+                 fits(header.scalesOffset, count * sizeof(float)) &&
+                 fits(header.tagsOffset, count * sizeof(uint32_t)) &&
+                 fits(header.labelOffsetsOffset, count * sizeof(uint32_t)) &&
+                 fits(header.vectorsOffset, count * header.paddedDim) &&
+                 fits(header.labelsOffset, header.labelBytes) &&
+                 header.labelBytes > 0 && m_data[header.labelsOffset + header.labelBytes - 1] == '\0';
+    if (valid) {
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(m_data + header.labelOffsetsOffset);
+        for (uint64_t i = 0; i < count && valid; i++) {
+            valid = offsets[i] < header.labelBytes;
+        }
+    }
+    if (!valid || (expectedSourceHash != 0 && header.sourceHash != expectedSourceHash)) {
+        LOGi("Vector index at %s is %s", path.c_str(), valid ? "stale" : "invalid");
+        close();
+        return false;
+    }
+
+    m_dim = header.dim;
+    m_paddedDim = header.paddedDim;
+    m_count = header.count;
+    m_scales = reinterpret_cast<const float*>(m_data + header.scalesOffset);
+    m_tags = reinterpret_cast<const uint32_t*>(m_data + header.tagsOffset);
+    m_labelOffsets = reinterpret_cast<const uint32_t*>(m_data + header.labelOffsetsOffset);
+    m_vectors = reinterpret_cast<const int8_t*>(m_data + header.vectorsOffset);
+    m_labels = reinterpret_cast<const char*>(m_data + header.labelsOffset);
+    LOGi("Opened vector index %s (%u vectors, dim %u)", path.c_str(), m_count, m_dim);
+    return true;
+}
+
+void VectorIndex::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_count = 0;
+    m_dim = 0;
+}
+
+std::vector<VectorHit> VectorIndex::search(const float* query, size_t k, uint32_t tagMask) const {
+    std::vector<VectorHit> hits;
+    if (!m_data || k == 0) {
+        return hits;
+    }
+    std::vector<int8_t> quantized(m_paddedDim);
+    const float queryScale = quantizeVector(query, m_dim, quantized.data(), m_paddedDim);
+    if (queryScale == 0.0f) {
+        return hits;
+    }
+
+    // Min-heap of the best k so far
+    auto worse = [](const VectorHit& a, const VectorHit& b) { return a.score > b.score; };
+    std::priority_queue<VectorHit, std::vector<VectorHit>, decltype(worse)> best(worse);
+    for (uint32_t row = 0; row < m_count; row++) {
+        if (m_tags[row] >= 32 || !((tagMask >> m_tags[row]) & 1)) {
+            continue;
+        }
+        const int32_t dot = dotInt8(quantized.data(), m_vectors + (size_t) row * m_paddedDim, m_paddedDim);
+        const float score = (float) dot * queryScale * m_scales[row];
+        if (best.size() < k) {
+            best.push(VectorHit{(int32_t) row, score});
+        } else if (score > best.top().score) {
+            best.pop();
+            best.push(VectorHit{(int32_t) row, score});
+        }
+    }
+
+    hits.resize(best.size());
+    for (size_t i = hits.size(); i-- > 0;) {
+        hits[i] = best.top();
+        best.pop();
+    }
+    return hits;
+}
@@ -0,0 +1,70 @@
+#ifndef VECTOR_INDEX_H
+#define VECTOR_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct VectorHit {
+    int32_t row;
+    float score;  // cosine similarity (approximate, from the int8 vectors)
+};
+
+// Memory-mapped store of L2-normalized vectors quantized to int8 with one
+// float scale per row, searched with a SIMD int8 dot product (NEON dotprod /
+// NEON / AVX2 / scalar). Rows carry a label and a caller-defined tag.
+//
+// File layout (little-endian):
+//   header | float scales[count] | uint32 tags[count] | uint32 label offsets[count]
+//   | int8 vectors[count][paddedDim] (64-byte aligned) | NUL-terminated labels
+class VectorIndex {
+public:
+    VectorIndex();
+    ~VectorIndex();
+    VectorIndex(const VectorIndex&) = delete;
+    VectorIndex& operator=(const VectorIndex&) = delete;
+
+    // Quantizes `vectors` (count * dim floats, row-major) and writes the index
+    // to `path` via a temp file + rename
+    static bool write(const std::string& path, uint32_t dim, const std::vector<float>& vectors,
+                      const std::vector<std::string>& labels, const std::vector<uint32_t>& tags,
+                      uint64_t sourceHash, std::string& error);
+
+    // Fails when the file is missing, corrupt, or built from another source
+    // (expectedSourceHash != 0)
+    bool open(const std::string& path, uint64_t expectedSourceHash = 0);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    uint32_t size() const { return m_count; }
+    uint32_t dim() const { return m_dim; }
+
+    // Top `k` rows by similarity to `query` (dim floats), best first. Rows whose
+    // tag bit is not set in `tagMask` are skipped.
+    std::vector<VectorHit> search(const float* query, size_t k, uint32_t tagMask = ~0u) const;
+
+    const char* label(int32_t row) const { return m_labels + m_labelOffsets[row]; }
+    uint32_t tag(int32_t row) const { return m_tags[row]; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    uint32_t m_dim;
+    uint32_t m_paddedDim;
+    uint32_t m_count;
+    const float* m_scales;
+    const uint32_t* m_tags;
+    const uint32_t* m_labelOffsets;
+    const int8_t* m_vectors;
+    const char* m_labels;
+};
+
+// Symmetric int8 quantization of `dim` floats into `out` (paddedDim bytes,
+// zero-filled past dim); returns the scale
+float quantizeVector(const float* values, uint32_t dim, int8_t* out, uint32_t paddedDim);
+
+// int8 dot product over `n` elements (a multiple of 32)
+int32_t dotInt8(const int8_t* a, const int8_t* b, size_t n);
+
+#endif // VECTOR_INDEX_H
@@ -26,6 +26,7 @@ import com.example.tastydiet.ui.*
 import com.example.tastydiet.ui.screens.*
 import com.example.tastydiet.ui.components.HomeDashboard
 import com.example.tastydiet.data.RecipeManager
+import com.example.tastydiet.util.NativeIngredientIndex
 import com.example.tastydiet.ui.theme.TastyDietTheme
 import com.example.tastydiet.viewmodel.*
 import com.example.tastydiet.ui.components.FloatingBubble
@@ -565,6 +566,9 @@ class MainActivity : ComponentActivity() {
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
         
+        // Recipe/inventory matching reads the bundled grocery list and recipes
+        NativeIngredientIndex.init(this)
+        
         // Run AI Model Test in background
         runAIModelTest()
         
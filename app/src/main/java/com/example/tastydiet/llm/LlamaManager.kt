@@ -1,13 +1,28 @@
 package com.example.tastydiet.llm
 
+import android.app.ActivityManager
+import android.content.ComponentCallbacks2
 import android.content.Context
+import android.content.res.Configuration
+import android.content.res.AssetManager
 import android.util.Log
+import com.example.tastydiet.util.NativeFoodIndex
 import com.example.tastydiet.utils.ExternalAssetManager
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.channels.awaitClose
+import kotlinx.coroutines.channels.trySendBlocking
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.callbackFlow
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
 import kotlinx.coroutines.withContext
+import org.json.JSONArray
+import org.json.JSONObject
 import java.io.File
 import java.io.FileOutputStream
 import java.io.IOException
+import java.util.concurrent.atomic.AtomicBoolean
 
 /**
  * Manager class for local LLM integration using llama.cpp
@@ -20,8 +35,56 @@ class LlamaManager(private val context: Context) {
         private const val TAG = "LlamaManager"
         private const val MODEL_FILENAME = "tinyllama-1.1b-chat-v1.0.Q4_K_M.gguf"
         private const val MAX_TOKENS = 512
+        private const val DEFAULT_CONTEXT_SIZE = 2048
+        private const val MIN_CONTEXT_SIZE = 512
+        
+        // KV cache cell types understood by native initModel
+        private const val KV_F16 = 0
+        private const val KV_Q8_0 = 1
+        private const val KV_Q4_0 = 2
+        
+        // Native load-and-warm pipeline states (getModelLoadState)
+        const val INIT_IDLE = 0
+        const val INIT_LOADING = 1
+        const val INIT_READY = 2
+        const val INIT_FAILED = 3
+        
+        // Native log verbosity (setLogVerbosity); prompts and responses only at VERBOSE
+        const val LOG_VERBOSITY_QUIET = 0
+        const val LOG_VERBOSITY_NORMAL = 1
+        const val LOG_VERBOSITY_VERBOSE = 2
+        
+        // Offline command table compiled into the native intent router
+        private const val INTENT_TABLE_ASSET = "offline_voice_commands_mapped.csv"
+        private const val INTENT_MIN_SCORE = 3.0f
+        private const val INTENT_MIN_CONFIDENCE = 0.5f
+        
+        // Embedding index over foods and recipes (built once per model, in filesDir)
+        private const val SEMANTIC_INDEX_FILE = "semantic_index.bin"
+        private val SEMANTIC_ASSETS = arrayOf(
+            "comprehensive_food_database.json",
+            "full_offline_recipes.json",
+            "andhra_recipes.json",
+            "authentic_andhra_telangana_north_recipes.json",
+            "recipes_with_pairings.json"
+        )
+        const val SEMANTIC_FOODS = 1 shl 0
+        const val SEMANTIC_RECIPES = 1 shl 1
+        
+        // Food logging: grammar-constrained JSON, so a short budget is plenty
+        private const val FOOD_LOG_MAX_TOKENS = 96
+        
+        // Drafted tokens verified per forward pass; drafts come from the same assets
+        private const val DEFAULT_MAX_DRAFT = 4
         private const val LLAMA_CPP_VERSION = "2024.12.01" // Simplified implementation version
         
+        // Fixed prefix of every prompt; native code keeps its KV state resident
+        private val SYSTEM_PROMPT = buildString {
+            appendLine("<|system|>")
+            appendLine("You are a helpful AI assistant. Answer questions directly and naturally.")
+            appendLine("</s>")
+        }
+        
         // Native library loading - now optional
         private var nativeLibraryLoaded = false
         
@@ -43,17 +106,107 @@ class LlamaManager(private val context: Context) {
         }
     }
     
-    // Native method declarations
-    private external fun initModel(path: String): Boolean
-    private external fun generateResponse(prompt: String, maxTokens: Int): String
+    /**
+     * Receives decoded text from native code as soon as it is available.
+     * Chunks never split a UTF-8 character. Return false to stop generation.
+     */
+    fun interface TokenCallback {
+        fun onToken(chunk: String): Boolean
+    }
+    
+    // Native method declarations. Generation prompts and responses cross JNI as
+    // standard UTF-8 bytes (emoji and other supplementary characters intact)
+    private external fun initModel(path: String, stateDir: String, nCtx: Int, kvType: Int, systemPrompt: String): Boolean
+    private external fun getInitState(): Int
+    private external fun getInitProgress(): Float
+    private external fun awaitModelReady(timeoutMs: Long): Boolean
+    private external fun generateResponse(prompt: ByteArray, maxTokens: Int): ByteArray
+    private external fun generateResponseStreaming(prompt: ByteArray, maxTokens: Int, callback: TokenCallback): ByteArray?
+    private external fun setSystemPrompt(systemPrompt: String): Boolean
+    private external fun createSession(): Int
+    private external fun destroySession(session: Int)
+    private external fun generateSessionResponse(session: Int, prompt: ByteArray, maxTokens: Int, callback: TokenCallback?): ByteArray?
+    private external fun generateChatTurn(session: Int, turn: ByteArray, maxTokens: Int, callback: TokenCallback?): ByteArray?
+    private external fun resetChat(session: Int)
+    private external fun cancelSession(session: Int)
     private external fun isModelLoaded(): Boolean
     private external fun cleanup()
     private external fun getModelInfo(): String
+    private external fun getLoadReport(): String
+    private external fun inspectModel(path: String, nCtx: Int): String
+    private external fun loadIntentTable(assetManager: AssetManager, assetName: String): Boolean
+    private external fun classifyIntent(text: String): String
+    private external fun buildSemanticIndex(assetManager: AssetManager, assetNames: Array<String>, indexPath: String): Boolean
+    private external fun semanticSearch(query: String, limit: Int, kindMask: Int): String
+    private external fun enableSpeculation(assetManager: AssetManager?, assetNames: Array<String>?, draftModelPath: String?, maxDraft: Int): Boolean
+    private external fun getSpeculativeStats(): String
+    private external fun loadFoodLogGrammar(indexPath: String): Boolean
+    private external fun generateFoodLog(prompt: ByteArray, maxTokens: Int): ByteArray
+    private external fun trimMemory(level: Int): Boolean
+    private external fun getMemoryReport(): String
+    private external fun getCacheStats(): String
+    private external fun clearResponseCache()
+    private external fun getRequestMetrics(): String
+    private external fun setLogVerbosity(level: Int)
     
+    @Volatile
+    private var logVerbosity = LOG_VERBOSITY_NORMAL
+    @Volatile
     private var isInitialized = false
+    @Volatile
+    private var intentTableLoaded = false
+    @Volatile
+    private var semanticIndexReady = false
+    @Volatile
+    private var foodLogGrammarReady = false
+    
+    // Native trimming waits for the decode thread and may write state files, so it
+    // runs off the main thread that delivers the callbacks
+    private val trimCallbacks = object : ComponentCallbacks2 {
+        override fun onTrimMemory(level: Int) {
+            Thread({ this@LlamaManager.onTrimMemory(level) }, "llm-trim").start()
+        }
+        override fun onConfigurationChanged(newConfig: Configuration) {}
+        @Deprecated("Deprecated in Java")
+        override fun onLowMemory() = onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_COMPLETE)
+    }
+    private val initMutex = Mutex()
     private var modelPath: String? = null
     private val externalAssetManager = ExternalAssetManager(context)
     
+    /**
+     * One ranked intent from the native command router
+     */
+    data class IntentMatch(
+        val action: String,
+        val score: Float,
+        val confidence: Float
+    )
+    
+    /**
+     * One food or recipe from the native embedding index
+     */
+    data class SemanticMatch(
+        val name: String,
+        val isRecipe: Boolean,
+        val score: Float
+    )
+    
+    /**
+     * One food eaten, as extracted by parseFoodLog
+     */
+    data class LoggedFood(
+        val name: String,
+        val quantity: Float,
+        val unit: String
+    )
+    
+    /**
+     * Context size and KV cell type (KV_*) that fit in available memory,
+     * as chosen by validateModelFormat
+     */
+    private data class ContextConfig(val nCtx: Int, val kvType: Int)
+    
     // Enhanced logging and user feedback
     data class ModelStatus(
         val isAvailable: Boolean,
@@ -68,6 +221,11 @@ class LlamaManager(private val context: Context) {
      * @return true if successful, false otherwise
      */
     suspend fun initializeModel(): Boolean = withContext(Dispatchers.IO) {
+        // Concurrent callers wait for the first initialization instead of racing it
+        initMutex.withLock { initializeModelLocked() }
+    }
+    
+    private suspend fun initializeModelLocked(): Boolean = withContext(Dispatchers.IO) {
         try {
             if (isInitialized) {
                 Log.i(TAG, "Model already initialized")
@@ -97,7 +255,8 @@ class LlamaManager(private val context: Context) {
             }
             
             // Validate model file format
-            if (!validateModelFormat(path)) {
+            val contextConfig = validateModelFormat(path)
+            if (contextConfig == null) {
                 Log.e(TAG, "Invalid model format detected")
                 return@withContext false
             }
@@ -146,19 +305,22 @@ class LlamaManager(private val context: Context) {
                     Log.i(TAG, "   Readable: ${modelFile.canRead()}")
                     Log.i(TAG, "   Last modified: ${java.util.Date(modelFile.lastModified())}")
                     
+                    // Returns at once: loading, weight prefetch, warm-up and the system
+                    // prompt prefix run on a native thread; requests queue until it is ready.
+                    // Derived files (thread calibration, KV state, response cache) go to the
+                    // cache dir, since the model may sit somewhere read-only
                     Log.i(TAG, "🚀 Calling native initModel with path: $path")
                     val startTime = System.currentTimeMillis()
-                    val success = initModel(path)
+                    val success = initModel(path, context.cacheDir.absolutePath, contextConfig.nCtx, contextConfig.kvType, SYSTEM_PROMPT)
                     val endTime = System.currentTimeMillis()
                     val duration = endTime - startTime
                     
-                    Log.i(TAG, "⏱️ Native initModel completed in ${duration}ms")
-                    Log.i(TAG, "📊 Native initModel returned: $success")
+                    Log.i(TAG, "⏱️ Native initModel returned $success in ${duration}ms")
                     
                     if (success) {
                         isInitialized = true
-                        Log.i(TAG, "✅ Model initialized successfully with native library")
-                        Log.i(TAG, "Model info: ${getModelInfoString()}")
+                        Log.i(TAG, "✅ Native model warming up in the background")
+                        context.applicationContext.registerComponentCallbacks(trimCallbacks)
                         return@withContext true
                     } else {
                         Log.e(TAG, "❌ Native initialization failed - initModel returned false")
@@ -214,9 +376,16 @@ class LlamaManager(private val context: Context) {
      * @return ModelStatus with detailed information
      */
     private fun findModelPathWithDetails(): ModelStatus {
-        // First, try to copy model from assets to internal storage if not already there
-        copyModelFromAssetsIfNeeded()
-        
+        val status = searchModelPaths()
+        if (status.isAvailable) {
+            return status
+        }
+        // Only fall back to extracting the bundled asset when no copy exists anywhere;
+        // the native loader maps the file in place, so an existing copy is never duplicated
+        return if (copyModelFromAssetsIfNeeded()) searchModelPaths() else status
+    }
+    
+    private fun searchModelPaths(): ModelStatus {
         val possiblePaths = listOf(
             // Android external files directory - CHECK FIRST (highest priority)
             "${context.getExternalFilesDir(null)?.absolutePath}/models/$MODEL_FILENAME",
@@ -339,19 +508,20 @@ class LlamaManager(private val context: Context) {
     
     /**
      * Copy model from assets to internal storage if not already present
+     * @return true if a copy now exists in the external files directory
      */
-    private fun copyModelFromAssetsIfNeeded() {
+    private fun copyModelFromAssetsIfNeeded(): Boolean {
         val externalFilesPath = "${context.getExternalFilesDir(null)?.absolutePath}/models/$MODEL_FILENAME"
         val externalFilesFile = File(externalFilesPath)
         
         if (externalFilesFile.exists()) {
             Log.i(TAG, "✅ Model already exists in external files directory: $externalFilesPath")
-            return
+            return true
         }
         
         Log.i(TAG, "📋 Model not found in external files directory, copying from assets...")
         
-        try {
+        return try {
             // Create models directory
             val modelsDir = File("${context.getExternalFilesDir(null)?.absolutePath}/models")
             modelsDir.mkdirs()
@@ -365,9 +535,12 @@ class LlamaManager(private val context: Context) {
             
             Log.i(TAG, "✅ Model copied from assets to external files directory: $externalFilesPath")
             Log.i(TAG, "   Size: ${externalFilesFile.length() / (1024 * 1024)} MB")
-            
+            true
         } catch (e: Exception) {
             Log.w(TAG, "⚠️ Could not copy model from assets: ${e.message}")
+            // Don't leave a partial copy behind for the next search to pick up
+            externalFilesFile.delete()
+            false
         }
     }
     
@@ -449,37 +622,157 @@ class LlamaManager(private val context: Context) {
     }
     
     /**
-     * Validate model file format (GGUF/GGML)
+     * Validate the model by reading its GGUF header natively (no weights are loaded)
+     * and pick a context size and KV cache type whose estimated footprint fits in
+     * available memory: a quantized KV cache is preferred over a shorter context
      * @param modelPath Path to the model file
-     * @return true if valid format, false otherwise
+     * @return context configuration to initialize with, or null if the model must be rejected
      */
-    private fun validateModelFormat(modelPath: String): Boolean {
+    private fun validateModelFormat(modelPath: String): ContextConfig? {
+        if (!nativeLibraryLoaded) {
+            // Kotlin fallback never loads the weights; existence is all it needs
+            return if (File(modelPath).exists()) ContextConfig(DEFAULT_CONTEXT_SIZE, KV_F16) else null
+        }
         return try {
-            val file = File(modelPath)
-            if (!file.exists()) {
-                Log.e(TAG, "Model file does not exist: $modelPath")
-                return false
+            val info = JSONObject(inspectModel(modelPath, DEFAULT_CONTEXT_SIZE))
+            if (!info.optBoolean("valid")) {
+                Log.e(TAG, "❌ Model rejected: ${info.optString("error")}")
+                return null
             }
-            
-            // Check file extension
-            val extension = file.extension.lowercase()
-            if (extension != "gguf" && extension != "ggml" && extension != "bin") {
-                Log.w(TAG, "Unsupported model format: $extension. Supported formats: gguf, ggml, bin")
-                // Still allow loading, but warn user
+            val architecture = info.optString("architecture")
+            if (architecture.isEmpty()) {
+                Log.e(TAG, "❌ Model rejected: no general.architecture in GGUF metadata")
+                return null
             }
             
-            // Check file size (minimum 10MB for a valid model)
-            val fileSize = file.length()
-            if (fileSize < 10 * 1024 * 1024) {
-                Log.w(TAG, "Model file seems too small: ${fileSize / (1024 * 1024)} MB")
-                // Still allow loading, but warn user
+            val weightBytes = info.getLong("weightBytes")
+            val kvBytesPerToken = mapOf(
+                KV_F16 to info.getLong("kvBytesPerToken"),
+                KV_Q8_0 to info.getLong("kvBytesPerTokenQ8"),
+                KV_Q4_0 to info.getLong("kvBytesPerTokenQ4")
+            )
+            val computeBytes = info.getLong("estimatedResidentBytes") - weightBytes -
+                kvBytesPerToken.getValue(KV_F16) * DEFAULT_CONTEXT_SIZE
+            val trainedContext = info.getInt("contextLength")
+            
+            val memoryInfo = ActivityManager.MemoryInfo()
+            (context.getSystemService(Context.ACTIVITY_SERVICE) as ActivityManager).getMemoryInfo(memoryInfo)
+            
+            // Quantize the KV cache first (q8_0 is near lossless), then halve the context
+            // until the estimate fits; weights are mmapped and can be paged out, so a model
+            // that still doesn't fit is only warned about
+            var nCtx = if (trainedContext > 0) minOf(DEFAULT_CONTEXT_SIZE, trainedContext) else DEFAULT_CONTEXT_SIZE
+            fun estimate(n: Int, kvType: Int) = weightBytes + kvBytesPerToken.getValue(kvType) * n + computeBytes
+            val kvType = listOf(KV_F16, KV_Q8_0).firstOrNull { estimate(nCtx, it) <= memoryInfo.availMem } ?: KV_Q4_0
+            while (nCtx > MIN_CONTEXT_SIZE && estimate(nCtx, kvType) > memoryInfo.availMem) {
+                nCtx /= 2
             }
+            val kvName = when (kvType) { KV_Q8_0 -> "q8_0"; KV_Q4_0 -> "q4_0"; else -> "f16" }
             
-            Log.i(TAG, "✅ Model format validation passed: $extension, ${fileSize / (1024 * 1024)} MB")
-            true
+            Log.i(TAG, "✅ Model inspected: $architecture ${info.optString("quantization")}, " +
+                "${info.getLong("tensorCount")} tensors, trained ctx $trainedContext")
+            Log.i(TAG, "📊 Estimated resident: ${estimate(nCtx, kvType) / (1024 * 1024)} MB at n_ctx=$nCtx, " +
+                "$kvName KV (available ${memoryInfo.availMem / (1024 * 1024)} MB)")
+            if (estimate(nCtx, kvType) > memoryInfo.availMem) {
+                Log.w(TAG, "⚠️ Model may not fit in available memory even at n_ctx=$nCtx")
+            }
+            ContextConfig(nCtx, kvType)
         } catch (e: Exception) {
             Log.e(TAG, "Error validating model format: ${e.message}")
-            false
+            null
+        }
+    }
+    
+    /**
+     * Rank the offline command intents found in the text (single native pass, microseconds)
+     * @param text User input
+     * @return Intents best first; empty when the native library is unavailable
+     */
+    fun classifyIntents(text: String): List<IntentMatch> {
+        if (!nativeLibraryLoaded) return emptyList()
+        return try {
+            if (!intentTableLoaded) {
+                synchronized(this) {
+                    if (!intentTableLoaded) {
+                        intentTableLoaded = loadIntentTable(context.assets, INTENT_TABLE_ASSET)
+                        Log.i(TAG, "🧭 Intent table loaded: $intentTableLoaded")
+                    }
+                }
+            }
+            val matches = JSONArray(classifyIntent(text))
+            List(matches.length()) { i ->
+                val match = matches.getJSONObject(i)
+                IntentMatch(
+                    action = match.getString("action"),
+                    score = match.getDouble("score").toFloat(),
+                    confidence = match.getDouble("confidence").toFloat()
+                )
+            }
+        } catch (e: Exception) {
+            Log.w(TAG, "Intent classification failed: ${e.message}")
+            emptyList()
+        }
+    }
+    
+    /**
+     * Structured command the input clearly maps to, so callers can answer it without the LLM
+     * @param text User input
+     * @return ActionType from the command table, or null when the LLM should handle it
+     */
+    fun routeCommand(text: String): String? {
+        val best = classifyIntents(text).firstOrNull() ?: return null
+        return if (best.action != "Unknown" && best.score >= INTENT_MIN_SCORE && best.confidence >= INTENT_MIN_CONFIDENCE) {
+            Log.i(TAG, "🧭 Routed to ${best.action} (score ${best.score}, confidence ${best.confidence})")
+            best.action
+        } else {
+            null
+        }
+    }
+    
+    /**
+     * Open the food/recipe embedding index, building it on first use (one embedding pass
+     * per item, so run this in the background after the model is initialized)
+     * @return true if semantic search is available
+     */
+    suspend fun prepareSemanticIndex(): Boolean = withContext(Dispatchers.IO) {
+        if (semanticIndexReady) return@withContext true
+        if (!nativeLibraryLoaded) return@withContext false
+        try {
+            val indexPath = File(context.filesDir, SEMANTIC_INDEX_FILE).absolutePath
+            val startTime = System.currentTimeMillis()
+            semanticIndexReady = buildSemanticIndex(context.assets, SEMANTIC_ASSETS, indexPath)
+            Log.i(TAG, "🔎 Semantic index ready: $semanticIndexReady (${System.currentTimeMillis() - startTime}ms)")
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Semantic index unavailable: ${e.message}")
+        }
+        semanticIndexReady
+    }
+    
+    /**
+     * Foods and recipes closest in meaning to the query, e.g. "something high protein for
+     * breakfast". Costs one embedding pass, no generation.
+     * @param kinds SEMANTIC_FOODS and/or SEMANTIC_RECIPES
+     * @return Matches best first; empty until prepareSemanticIndex succeeded
+     */
+    suspend fun semanticSearch(
+        query: String,
+        limit: Int = 10,
+        kinds: Int = SEMANTIC_FOODS or SEMANTIC_RECIPES
+    ): List<SemanticMatch> = withContext(Dispatchers.IO) {
+        if (!semanticIndexReady || query.isBlank()) return@withContext emptyList()
+        try {
+            val matches = JSONArray(semanticSearch(query, limit, kinds))
+            List(matches.length()) { i ->
+                val match = matches.getJSONObject(i)
+                SemanticMatch(
+                    name = match.getString("name"),
+                    isRecipe = match.getString("kind") == "recipe",
+                    score = match.getDouble("score").toFloat()
+                )
+            }
+        } catch (e: Exception) {
+            Log.w(TAG, "Semantic search failed: ${e.message}")
+            emptyList()
         }
     }
     
@@ -490,14 +783,7 @@ class LlamaManager(private val context: Context) {
      */
     suspend fun generateResponse(prompt: String): String = withContext(Dispatchers.IO) {
         try {
-            val modelLoaded = try {
-                isModelLoaded()
-            } catch (e: UnsatisfiedLinkError) {
-                Log.w(TAG, "Native library not available for model status check: ${e.message}")
-                false
-            }
-            
-            if (!isInitialized || !modelLoaded) {
+            if (!isInitialized) {
                 Log.w(TAG, "Model not initialized, attempting to initialize...")
                 val initSuccess = initializeModel()
                 if (!initSuccess) {
@@ -506,7 +792,7 @@ class LlamaManager(private val context: Context) {
                 }
             }
             
-            Log.i(TAG, "Generating response for prompt: $prompt")
+            if (logVerbosity >= LOG_VERBOSITY_VERBOSE) Log.i(TAG, "Generating response for prompt: $prompt")
             
             // Create a nutrition-focused prompt
             val enhancedPrompt = createNutritionPrompt(prompt)
@@ -514,17 +800,24 @@ class LlamaManager(private val context: Context) {
             // Generate response using native code or Kotlin fallback
             Log.i(TAG, "Response generation - nativeLibraryLoaded: $nativeLibraryLoaded, isInitialized: $isInitialized")
             
-            if (nativeLibraryLoaded && isInitialized) {
+            if (nativeLibraryLoaded && isInitialized && !nativeLoadFailed()) {
                 try {
+                    // Waits natively if the model is still warming up
                     Log.i(TAG, "🚀 Attempting native response generation...")
-                    Log.i(TAG, "Calling native generateResponse with prompt: $enhancedPrompt")
+                    if (logVerbosity >= LOG_VERBOSITY_VERBOSE) Log.i(TAG, "Calling native generateResponse with prompt: $enhancedPrompt")
                     val startTime = System.currentTimeMillis()
-                    val response = generateResponse(enhancedPrompt, MAX_TOKENS)
+                    val response = generateResponse(enhancedPrompt.encodeToByteArray(), MAX_TOKENS).decodeToString()
                     val endTime = System.currentTimeMillis()
                     val duration = endTime - startTime
                     
-                    Log.i(TAG, "✅ Native response received in ${duration}ms: $response")
-                    response
+                    Log.i(TAG, "✅ Native response received in ${duration}ms")
+                    if (logVerbosity >= LOG_VERBOSITY_VERBOSE) Log.i(TAG, "Native response: $response")
+                    if (response.startsWith("Error:")) {
+                        Log.w(TAG, "Native generation failed ($response), using Kotlin fallback")
+                        generateKotlinResponse(prompt)
+                    } else {
+                        response
+                    }
                 } catch (e: UnsatisfiedLinkError) {
                     Log.e(TAG, "❌ UnsatisfiedLinkError in native response generation: ${e.message}")
                     Log.e(TAG, "Stack trace: ${e.stackTraceToString()}")
@@ -548,16 +841,217 @@ class LlamaManager(private val context: Context) {
         }
     }
     
+    /**
+     * Open an independent inference session with its own KV slot, so chat, meal
+     * suggestions and voice can generate at the same time. Native code batches the
+     * decode steps of all running sessions together.
+     * @return Session handle, or -1 if no slot is free or the native model is unavailable
+     */
+    suspend fun openSession(): Int = withContext(Dispatchers.IO) {
+        if (!nativeLibraryLoaded || !initializeModel()) {
+            return@withContext -1
+        }
+        try {
+            createSession()
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Native sessions not available: ${e.message}")
+            -1
+        }
+    }
+    
+    /**
+     * Release a session opened with [openSession], dropping its KV state
+     */
+    fun closeSession(session: Int) {
+        if (session < 0) return
+        try {
+            destroySession(session)
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Native sessions not available: ${e.message}")
+        }
+    }
+    
+    /**
+     * Generate a response on a specific session
+     * @param prompt User input prompt
+     * @param session Handle from [openSession]; falls back to the shared path when invalid
+     * @return Generated response
+     */
+    suspend fun generateResponse(prompt: String, session: Int): String = withContext(Dispatchers.IO) {
+        if (session < 0 || !nativeLibraryLoaded || !isInitialized || nativeLoadFailed()) {
+            return@withContext generateResponse(prompt)
+        }
+        try {
+            val startTime = System.currentTimeMillis()
+            val response = generateSessionResponse(session, createNutritionPrompt(prompt).encodeToByteArray(), MAX_TOKENS, null)?.decodeToString()
+            Log.i(TAG, "✅ Session $session response received in ${System.currentTimeMillis() - startTime}ms")
+            response ?: generateKotlinResponse(prompt)
+        } catch (e: Exception) {
+            Log.e(TAG, "❌ Exception in session response generation: ${e.message}")
+            generateKotlinResponse(prompt)
+        }
+    }
+    
+    /**
+     * Continue the conversation held by a session. Only the new message is
+     * evaluated; earlier turns stay in the session's KV cache, and the oldest ones
+     * are dropped natively once the context window fills (the system prompt stays).
+     * @param message User message for this turn
+     * @param session Handle from [openSession]; without one every turn stands alone
+     * @return Generated reply
+     */
+    suspend fun chat(message: String, session: Int): String = withContext(Dispatchers.IO) {
+        if (session < 0 || !nativeLibraryLoaded || !isInitialized || nativeLoadFailed()) {
+            return@withContext generateResponse(message)
+        }
+        try {
+            val startTime = System.currentTimeMillis()
+            val response = generateChatTurn(session, createChatTurn(message).encodeToByteArray(), MAX_TOKENS, null)?.decodeToString()
+            Log.i(TAG, "✅ Session $session chat reply received in ${System.currentTimeMillis() - startTime}ms")
+            if (response == null || response.startsWith("Error:")) generateKotlinResponse(message) else response
+        } catch (e: Exception) {
+            Log.e(TAG, "❌ Exception in chat turn: ${e.message}")
+            generateKotlinResponse(message)
+        }
+    }
+    
+    /**
+     * Forget the conversation of a session; its next [chat] turn starts fresh
+     */
+    fun resetConversation(session: Int) {
+        if (session < 0) return
+        try {
+            resetChat(session)
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Native sessions not available: ${e.message}")
+        }
+    }
+    
+    /**
+     * Stream a response token by token. Each stream runs on its own session, so
+     * cancelling the collector stops native decoding of this stream only, instead
+     * of running on until MAX_TOKENS.
+     * @param prompt User input prompt
+     * @return Flow of text chunks in generation order
+     */
+    fun generateResponseStream(prompt: String): Flow<String> = callbackFlow {
+        val modelReady = isInitialized || initializeModel()
+        
+        if (!nativeLibraryLoaded || !modelReady || nativeLoadFailed()) {
+            // Fallback responses are produced in one piece
+            send(generateResponse(prompt))
+            close()
+            return@callbackFlow
+        }
+        
+        // Without a free slot the stream queues on the shared session; a closed
+        // channel still stops it at the next chunk through the callback
+        val session = openSession()
+        val finished = AtomicBoolean(false)
+        // Guards against cancelling the slot after it was released and handed out again
+        val sessionLock = Any()
+        launch(Dispatchers.IO) {
+            try {
+                val startTime = System.currentTimeMillis()
+                var firstChunkAt = 0L
+                val callback = TokenCallback { chunk ->
+                    if (firstChunkAt == 0L) {
+                        firstChunkAt = System.currentTimeMillis()
+                        Log.i(TAG, "⏱️ Time to first token: ${firstChunkAt - startTime}ms")
+                    }
+                    trySendBlocking(chunk).isSuccess
+                }
+                val promptBytes = createNutritionPrompt(prompt).encodeToByteArray()
+                val response = if (session >= 0) {
+                    generateSessionResponse(session, promptBytes, MAX_TOKENS, callback)
+                } else {
+                    generateResponseStreaming(promptBytes, MAX_TOKENS, callback)
+                }?.decodeToString()
+                if (firstChunkAt == 0L && (response == null || response.startsWith("Error:"))) {
+                    Log.w(TAG, "Native streaming failed ($response), using Kotlin fallback")
+                    trySendBlocking(generateKotlinResponse(prompt))
+                }
+                Log.i(TAG, "✅ Streaming response completed in ${System.currentTimeMillis() - startTime}ms")
+                finished.set(true)
+                close()
+            } catch (e: Exception) {
+                Log.e(TAG, "❌ Exception in native streaming: ${e.message}")
+                finished.set(true)
+                close(e)
+            } finally {
+                synchronized(sessionLock) {
+                    finished.set(true)
+                    closeSession(session)
+                }
+            }
+        }
+        
+        awaitClose {
+            synchronized(sessionLock) {
+                if (!finished.get() && session >= 0) {
+                    Log.i(TAG, "🛑 Stream cancelled, stopping native generation")
+                    cancelSession(session)
+                }
+            }
+        }
+    }
+    
+    /**
+     * Extract what was eaten from free text ("I ate 2 rotis and a bowl of dal") as
+     * structured items. Output is constrained to food index names and a fixed unit
+     * list, and generation stops as soon as the JSON array closes.
+     * @return Items in mention order, or null when the model or food index is unavailable
+     */
+    suspend fun parseFoodLog(text: String): List<LoggedFood>? = withContext(Dispatchers.IO) {
+        if (!nativeLibraryLoaded || !isInitialized || text.isBlank()) return@withContext null
+        try {
+            if (!foodLogGrammarReady) {
+                if (!NativeFoodIndex.open(context)) return@withContext null
+                foodLogGrammarReady = loadFoodLogGrammar(NativeFoodIndex.indexPath(context))
+                if (!foodLogGrammarReady) return@withContext null
+            }
+            val startTime = System.currentTimeMillis()
+            val response = generateFoodLog(createFoodLogPrompt(text).encodeToByteArray(), FOOD_LOG_MAX_TOKENS).decodeToString()
+            Log.i(TAG, "🍽️ Food log parsed in ${System.currentTimeMillis() - startTime}ms")
+            if (logVerbosity >= LOG_VERBOSITY_VERBOSE) Log.i(TAG, "Food log: $response")
+            if (response.startsWith("Error:")) return@withContext null
+            val items = JSONArray(response)
+            List(items.length()) { i ->
+                val item = items.getJSONObject(i)
+                LoggedFood(
+                    name = item.getString("name"),
+                    quantity = item.getDouble("quantity").toFloat(),
+                    unit = item.getString("unit")
+                )
+            }
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Structured food logging unavailable: ${e.message}")
+            null
+        } catch (e: Exception) {
+            Log.w(TAG, "Food log parsing failed: ${e.message}")
+            null
+        }
+    }
+    
+    private fun createFoodLogPrompt(userInput: String): String {
+        return createNutritionPrompt(
+            "List every food eaten in this message as JSON with name, quantity and unit " +
+                "(g, ml, piece, cup, bowl, plate, glass, slice, tbsp, tsp or serving): $userInput"
+        )
+    }
+    
     /**
      * Create a nutrition-focused prompt for the diet app
      * @param userInput Original user input
      * @return Enhanced prompt for the LLM
      */
     private fun createNutritionPrompt(userInput: String): String {
+        return SYSTEM_PROMPT + createChatTurn(userInput)
+    }
+    
+    // One user turn; in a chat the system prompt is already pinned natively
+    private fun createChatTurn(userInput: String): String {
         return buildString {
-            appendLine("<|system|>")
-            appendLine("You are a helpful AI assistant. Answer questions directly and naturally.")
-            appendLine("</s>")
             appendLine("<|user|>")
             appendLine(userInput)
             appendLine("</s>")
@@ -672,11 +1166,12 @@ class LlamaManager(private val context: Context) {
                 return false
             }
             
-            // Try to call native isModelLoaded() if available
+            // Still warming up counts as ready: requests queue natively until it is
             try {
-                isModelLoaded()
+                val state = getInitState()
+                state == INIT_LOADING || state == INIT_READY
             } catch (e: UnsatisfiedLinkError) {
-                Log.w(TAG, "Native isModelLoaded() not available, but model is initialized")
+                Log.w(TAG, "Native getInitState() not available, but model is initialized")
                 // If native call fails but model is initialized, assume it's ready
                 return true
             }
@@ -686,6 +1181,48 @@ class LlamaManager(private val context: Context) {
         }
     }
     
+    /**
+     * State of the native load-and-warm pipeline (INIT_*); INIT_IDLE without native code
+     */
+    fun getModelLoadState(): Int {
+        if (!nativeLibraryLoaded) return INIT_IDLE
+        return try {
+            getInitState()
+        } catch (e: UnsatisfiedLinkError) {
+            INIT_IDLE
+        }
+    }
+    
+    /**
+     * Progress of the native load-and-warm pipeline in [0, 1]; polling never blocks
+     */
+    fun getModelLoadProgress(): Float {
+        if (!nativeLibraryLoaded) return 0f
+        return try {
+            getInitProgress()
+        } catch (e: UnsatisfiedLinkError) {
+            0f
+        }
+    }
+    
+    /**
+     * Suspend until the native model is loaded and warm
+     * @param timeoutMs Upper bound on the wait; negative waits for as long as loading takes
+     * @return true once the model is ready, false on failure or timeout
+     */
+    suspend fun waitForModelReady(timeoutMs: Long = -1): Boolean = withContext(Dispatchers.IO) {
+        if (!nativeLibraryLoaded || !isInitialized) return@withContext false
+        try {
+            val ready = awaitModelReady(timeoutMs)
+            if (ready) Log.i(TAG, "📊 Load report: ${getLoadReport()}")
+            ready
+        } catch (e: UnsatisfiedLinkError) {
+            false
+        }
+    }
+    
+    private fun nativeLoadFailed(): Boolean = getModelLoadState() == INIT_FAILED
+    
     /**
      * Get model information with version details
      * @return Model information string
@@ -707,6 +1244,139 @@ class LlamaManager(private val context: Context) {
         }
     }
     
+    /**
+     * Speculative decoding: cheap guesses for the next few tokens are checked in the same
+     * forward pass as the real one, so repeated food names and recipe phrases come out
+     * several tokens per step. Responses are unchanged.
+     * @param draftModelPath Small GGUF with the same vocabulary; null drafts from the
+     *        food/recipe assets and the prompt itself
+     * @return true if speculation is on
+     */
+    suspend fun enableSpeculativeDecoding(
+        draftModelPath: String? = null,
+        maxDraft: Int = DEFAULT_MAX_DRAFT
+    ): Boolean = withContext(Dispatchers.IO) {
+        if (!nativeLibraryLoaded) return@withContext false
+        try {
+            val enabled = enableSpeculation(context.assets, SEMANTIC_ASSETS, draftModelPath, maxDraft)
+            Log.i(TAG, "⚡ Speculative decoding (${draftModelPath ?: "n-gram"}, max $maxDraft): $enabled")
+            enabled
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Speculative decoding unavailable: ${e.message}")
+            false
+        }
+    }
+    
+    fun disableSpeculativeDecoding() {
+        if (!nativeLibraryLoaded) return
+        try {
+            enableSpeculation(null, null, null, 0)
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Native library not available: ${e.message}")
+        }
+    }
+    
+    /**
+     * Speculation counters: drafted/accepted tokens, acceptanceRate and tokensPerStep
+     * (tokens per forward pass, 1.0 without speculation)
+     * @return JSON object, or null when the native library is unavailable
+     */
+    fun getSpeculativeDecodingStats(): String? {
+        if (!nativeLibraryLoaded) return null
+        return try {
+            getSpeculativeStats()
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Forward an onTrimMemory level to the native engine: low memory drops the embedding
+     * context, critical memory halves the KV cache, and in the background the context is
+     * spilled to disk and freed. The next request restores it lazily.
+     * @return true if native memory was released
+     */
+    fun onTrimMemory(level: Int): Boolean {
+        if (!nativeLibraryLoaded || !isInitialized) return false
+        return try {
+            val trimmed = trimMemory(level)
+            Log.i(TAG, "🧹 Trim level $level: $trimmed, memory ${getMemoryReport()}")
+            trimmed
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Native library not available for trimming: ${e.message}")
+            false
+        }
+    }
+    
+    /**
+     * Native memory footprint: weights (and how much of them is resident), KV cache,
+     * scratch buffers, embedding context and process RSS
+     * @return JSON object, or null when the native library is unavailable
+     */
+    fun getNativeMemoryReport(): String? {
+        if (!nativeLibraryLoaded || !isInitialized) return null
+        return try {
+            getMemoryReport()
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Timings of the most recent native requests (up to 64): queue wait, TTFT,
+     * prefill/decode time, tok/s, draft acceptance and response cache hits.
+     * Read without locking, so it is safe to poll while generating.
+     * @return JSON {"recorded":N,"requests":[...]}, or null when the native library is unavailable
+     */
+    fun getNativeRequestMetrics(): String? {
+        if (!nativeLibraryLoaded) return null
+        return try {
+            getRequestMetrics()
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Log verbosity for native code and this class. QUIET keeps warnings and errors,
+     * NORMAL adds progress and timings, VERBOSE also logs prompts and responses.
+     */
+    fun setNativeLogVerbosity(level: Int) {
+        logVerbosity = level.coerceIn(LOG_VERBOSITY_QUIET, LOG_VERBOSITY_VERBOSE)
+        if (!nativeLibraryLoaded) return
+        try {
+            setLogVerbosity(logVerbosity)
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Native library not available for log verbosity: ${e.message}")
+        }
+    }
+    
+    /**
+     * Native response cache counters (hits per tier, misses, evictions, sizes)
+     * @return JSON object, or null when the native library is unavailable
+     */
+    fun getResponseCacheStats(): String? {
+        if (!nativeLibraryLoaded) return null
+        return try {
+            getCacheStats()
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Drop every cached response, e.g. after the user edits their profile
+     */
+    fun clearCachedResponses() {
+        if (!nativeLibraryLoaded) return
+        try {
+            clearResponseCache()
+            Log.i(TAG, "🧹 Response cache cleared")
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Native library not available for cache clearing: ${e.message}")
+        }
+    }
+    
     /**
      * Get llama.cpp version
      * @return Version string
@@ -720,6 +1390,7 @@ class LlamaManager(private val context: Context) {
      */
     fun cleanupResources() {
         try {
+            context.applicationContext.unregisterComponentCallbacks(trimCallbacks)
             cleanup()
             isInitialized = false
             Log.i(TAG, "LLM resources cleaned up")
@@ -17,6 +17,7 @@ import androidx.compose.ui.unit.dp
 import com.example.tastydiet.data.models.InventoryItem
 import com.example.tastydiet.data.models.Profile
 import com.example.tastydiet.data.models.Recipe
+import com.example.tastydiet.util.NativeIngredientIndex
 
 @OptIn(ExperimentalMaterial3Api::class)
 @Composable
@@ -295,15 +296,19 @@ fun generateSmartSuggestions(
     try {
         val bmi = profile.calculateBMI()
         val inventoryNames = inventory.map { it.name.lowercase().trim() }.toSet()
+        // Real ingredient lists from the native index; the name heuristic covers the rest
+        NativeIngredientIndex.syncInventory(inventory)
+        val missingCounts = NativeIngredientIndex.missingCounts(recipes)
         
         val suggestions = mutableListOf<MealSuggestion>()
         
-        for (recipe in recipes) {
+        for ((index, recipe) in recipes.withIndex()) {
             var score = 0
             var reason = ""
             
             // Check if recipe ingredients are available (improved logic)
-            val hasIngredients = checkIngredientAvailability(recipe, inventoryNames)
+            val missing = missingCounts?.get(index) ?: -1
+            val hasIngredients = if (missing >= 0) missing == 0 else checkIngredientAvailability(recipe, inventoryNames)
             if (hasIngredients) {
                 score += 3
                 reason = "Ingredients available"
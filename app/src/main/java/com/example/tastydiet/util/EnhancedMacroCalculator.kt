@@ -1,5 +1,6 @@
 package com.example.tastydiet.util
 
+import android.content.Context
 import com.example.tastydiet.data.NutritionalInfoDao
 import com.example.tastydiet.data.models.NutritionalInfo
 import com.example.tastydiet.data.models.Macros
@@ -9,8 +10,18 @@ import kotlinx.coroutines.withContext
 /**
  * Enhanced macro calculator that uses real nutritional data from the database.
  * Provides accurate macro calculations based on food name and quantity.
+ * When a context is given, names missing from Room are resolved through the
+ * native food index (see [NativeFoodIndex]) instead of failing.
  */
-class EnhancedMacroCalculator(private val nutritionalInfoDao: NutritionalInfoDao) {
+class EnhancedMacroCalculator(
+    private val nutritionalInfoDao: NutritionalInfoDao,
+    private val context: Context? = null
+) {
+
+    private fun nativeIndex(): NativeFoodIndex? {
+        val appContext = context ?: return null
+        return if (NativeFoodIndex.open(appContext)) NativeFoodIndex else null
+    }
     
     /**
      * Calculate macros for a food item by looking up its nutritional info
@@ -21,8 +32,9 @@ class EnhancedMacroCalculator(private val nutritionalInfoDao: NutritionalInfoDao
     suspend fun calculateMacrosForFood(foodName: String, quantity: Float): Macros? {
         return withContext(Dispatchers.IO) {
             try {
-                // First try exact match
+                // First try exact match, in Room and then in the native index
                 var nutritionalInfo = nutritionalInfoDao.getByName(foodName)
+                    ?: nativeIndex()?.lookup(foodName)
                 
                 // If exact match fails, try fuzzy search and use the first result
                 if (nutritionalInfo == null) {
@@ -30,6 +42,11 @@ class EnhancedMacroCalculator(private val nutritionalInfoDao: NutritionalInfoDao
                     nutritionalInfo = searchResults.firstOrNull()
                 }
                 
+                // Last resort: prefix/typo-tolerant match in the native index
+                if (nutritionalInfo == null) {
+                    nutritionalInfo = nativeIndex()?.search(foodName, limit = 1)?.firstOrNull()
+                }
+                
                 nutritionalInfo?.let { info ->
                     val multiplier = quantity / 100f
                     val calories = (info.caloriesPer100g * multiplier).toDouble()
@@ -60,7 +77,9 @@ class EnhancedMacroCalculator(private val nutritionalInfoDao: NutritionalInfoDao
     suspend fun searchFoodItems(query: String): List<NutritionalInfo> {
         return withContext(Dispatchers.IO) {
             try {
-                nutritionalInfoDao.searchByName(query)
+                nutritionalInfoDao.searchByName(query).ifEmpty {
+                    nativeIndex()?.search(query) ?: emptyList()
+                }
             } catch (e: Exception) {
                 emptyList()
             }
@@ -156,7 +175,8 @@ class EnhancedMacroCalculator(private val nutritionalInfoDao: NutritionalInfoDao
     suspend fun isFoodInDatabase(foodName: String): Boolean {
         return withContext(Dispatchers.IO) {
             try {
-                nutritionalInfoDao.getByName(foodName) != null
+                nutritionalInfoDao.getByName(foodName) != null ||
+                    nativeIndex()?.lookup(foodName) != null
             } catch (e: Exception) {
                 false
             }
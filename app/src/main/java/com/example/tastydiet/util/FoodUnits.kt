@@ -0,0 +1,33 @@
+package com.example.tastydiet.util
+
+/**
+ * Gram weights of the household units used in food logs and in the bundled food
+ * database. The log screens convert quantities with these, and [NativeFoodIndex]
+ * turns the database's per-unit values into per-100 g values with the same
+ * weights, so "1 cup" of a per-cup food comes back as exactly one cup.
+ */
+object FoodUnits {
+    private val gramsPerUnit = mapOf(
+        "g" to 1f, "gram" to 1f, "grams" to 1f,
+        "kg" to 1000f, "kilogram" to 1000f, "kilograms" to 1000f,
+        "oz" to 28.35f, "ounce" to 28.35f, "ounces" to 28.35f,
+        "lb" to 453.59f, "pound" to 453.59f, "pounds" to 453.59f,
+        "ml" to 1f, "milliliter" to 1f, "milliliters" to 1f,
+        "cup" to 240f, "cups" to 240f,
+        "glass" to 250f, "glasses" to 250f,
+        "bowl" to 250f, "bowls" to 250f,
+        "plate" to 300f, "plates" to 300f,
+        "tbsp" to 15f, "tablespoon" to 15f, "tablespoons" to 15f,
+        "tsp" to 5f, "teaspoon" to 5f, "teaspoons" to 5f,
+        "piece" to 100f, "pieces" to 100f, "pc" to 100f, "pcs" to 100f, "medium" to 100f,
+        "serving" to 100f, "servings" to 100f,
+        "slice" to 30f, "slices" to 30f,
+        "clove" to 5f, "cloves" to 5f
+    )
+
+    /** Grams in one [unit], or null when the unit is unknown */
+    fun gramsPer(unit: String): Float? = gramsPerUnit[unit.trim().lowercase()]
+
+    /** [quantity] of [unit] in grams, or null when the unit is unknown */
+    fun toGrams(quantity: Float, unit: String): Float? = gramsPer(unit)?.let { quantity * it }
+}
@@ -0,0 +1,110 @@
+package com.example.tastydiet.util
+
+import android.content.Context
+import android.content.res.AssetManager
+import android.util.Log
+import com.example.tastydiet.data.models.NutritionalInfo
+import java.io.File
+
+/**
+ * Memory-mapped nutrition index compiled natively from comprehensive_food_database.json.
+ * The index is built once into filesDir and rebuilt only when the bundled JSON changes,
+ * so lookups and searches never parse JSON or allocate the full food list on the Java heap.
+ */
+object NativeFoodIndex {
+    private const val TAG = "NativeFoodIndex"
+    private const val FOOD_DATABASE_ASSET = "comprehensive_food_database.json"
+    private const val INDEX_FILE = "food_index.bin"
+
+    // Layout of the lookupFood result: nutrient columns, then the flag bits
+    private const val COLUMN_CALORIES = 0
+    private const val COLUMN_PROTEIN = 1
+    private const val COLUMN_CARBS = 2
+    private const val COLUMN_FAT = 3
+    private const val COLUMN_FIBER = 4
+    private const val COLUMN_FLAGS = 7
+
+    @Volatile
+    private var isOpen = false
+
+    private val isNativeAvailable: Boolean by lazy {
+        try {
+            System.loadLibrary("llama_jni")
+            true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Native library not available: ${e.message}")
+            false
+        }
+    }
+
+    private external fun openIndex(assetManager: AssetManager, assetName: String, indexPath: String): Boolean
+    private external fun lookupFood(name: String): FloatArray?
+    private external fun lookupFoodText(name: String): Array<String>?
+    private external fun searchFoods(query: String, limit: Int, fuzzy: Boolean): Array<String>
+
+    /**
+     * Opens (compiling on first use) the index; safe to call repeatedly
+     * @return true if the native index is ready
+     */
+    @Synchronized
+    fun open(context: Context): Boolean {
+        if (isOpen || !isNativeAvailable) return isOpen
+        isOpen = try {
+            openIndex(context.assets, FOOD_DATABASE_ASSET, indexPath(context))
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Food index unavailable: ${e.message}")
+            false
+        }
+        Log.i(TAG, if (isOpen) "✅ Native food index ready" else "⚠️ Native food index not available")
+        return isOpen
+    }
+
+    fun isReady(): Boolean = isOpen
+
+    /** Compiled index file, also mapped by the LLM's food log grammar */
+    fun indexPath(context: Context): String = File(context.filesDir, INDEX_FILE).absolutePath
+
+    /**
+     * Exact, case-insensitive lookup. The database stores values per the food's
+     * own unit (piece, cup, tbsp, ...); they are converted to per 100 g with the
+     * unit weights in [FoodUnits], and [NutritionalInfo.unit] keeps the unit.
+     * @return Nutritional info per 100 g, or null if the food is unknown
+     */
+    fun lookup(name: String): NutritionalInfo? {
+        if (!isOpen) return null
+        val values = lookupFood(name) ?: return null
+        val text = lookupFoodText(name) ?: return null
+        val per100g = 100f / (FoodUnits.gramsPer(text[2]) ?: run {
+            Log.w(TAG, "Unknown unit '${text[2]}' for ${text[0]}, treating it as 100 g")
+            100f
+        })
+        return NutritionalInfo(
+            name = text[0],
+            caloriesPer100g = values[COLUMN_CALORIES] * per100g,
+            proteinPer100g = values[COLUMN_PROTEIN] * per100g,
+            carbsPer100g = values[COLUMN_CARBS] * per100g,
+            fatPer100g = values[COLUMN_FAT] * per100g,
+            fiberPer100g = values[COLUMN_FIBER] * per100g,
+            category = text[1],
+            unit = text[2]
+        )
+    }
+
+    /**
+     * Foods with a name word starting with the query, falling back to
+     * typo-tolerant matching when nothing matches and fuzzy is set
+     */
+    fun search(query: String, limit: Int = 20, fuzzy: Boolean = true): List<NutritionalInfo> {
+        if (!isOpen || query.isBlank()) return emptyList()
+        return searchFoods(query, limit, fuzzy).mapNotNull { lookup(it) }
+    }
+
+    /**
+     * Whether the food is vegetarian, per the database flags
+     */
+    fun isVeg(name: String): Boolean? {
+        if (!isOpen) return null
+        val values = lookupFood(name) ?: return null
+        return (values[COLUMN_FLAGS].toInt() and 1) != 0
+    }
+}
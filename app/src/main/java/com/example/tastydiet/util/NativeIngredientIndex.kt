@@ -0,0 +1,163 @@
+package com.example.tastydiet.util
+
+import android.content.Context
+import android.content.res.AssetManager
+import android.util.Log
+import com.example.tastydiet.data.models.InventoryItem
+import com.example.tastydiet.data.models.Recipe
+
+/**
+ * Native recipe/inventory matcher. Ingredient names from the grocery list, the bundled
+ * recipe assets and the recipe table are interned to dense IDs; each recipe is a bitset
+ * of what it needs, so "what can I cook" is one popcount pass instead of string
+ * comparisons per ingredient. Inventory edits are applied as diffs and only touch the
+ * recipes that use the changed ingredients.
+ */
+object NativeIngredientIndex {
+    private const val TAG = "NativeIngredientIndex"
+    private const val VOCABULARY_ASSET = "item_meta.csv"
+    private val RECIPE_ASSETS = arrayOf(
+        "full_offline_recipes.json",
+        "andhra_recipes.json",
+        "authentic_andhra_telangana_north_recipes.json",
+        "recipes_with_pairings.json"
+    )
+
+    private val isNativeAvailable: Boolean by lazy {
+        try {
+            System.loadLibrary("llama_jni")
+            true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Native library not available: ${e.message}")
+            false
+        }
+    }
+
+    @Volatile
+    private var assets: AssetManager? = null
+
+    // Recipe table ID -> index row, and the ingredient lists the index was built from
+    @Volatile
+    private var recipeRows: Map<Int, Int> = emptyMap()
+    private var indexedIngredients: Map<Int, List<String>>? = null
+    private val nameRows = java.util.concurrent.ConcurrentHashMap<String, Int>()
+
+    // Inventory names as last sent to native code, with duplicate counts
+    private var inventory: Map<String, Int>? = null
+
+    /** Inventory version the current missing counts belong to */
+    @Volatile
+    var version: Long = -1
+        private set
+
+    private external fun buildIndex(
+        assetManager: AssetManager, vocabularyAsset: String, recipeAssets: Array<String>,
+        recipeNames: Array<String>, ingredientCounts: IntArray, ingredientNames: Array<String>
+    ): IntArray?
+    private external fun setInventory(items: Array<String>): Long
+    private external fun updateInventory(added: Array<String>, removed: Array<String>): Long
+    private external fun missingCounts(rows: IntArray): IntArray
+    private external fun missingIngredients(row: Int): Array<String>
+    private external fun findRecipe(name: String): Int
+    private external fun cookableRecipes(maxMissing: Int, limit: Int): Array<String>
+
+    /** Gives the index access to the bundled assets; call once at startup */
+    fun init(context: Context) {
+        assets = context.applicationContext.assets
+    }
+
+    fun isReady(): Boolean = version >= 0
+
+    /**
+     * Indexes the recipe table with its ingredients; a no-op when nothing changed
+     * @param ingredients Ingredient names by recipe ID
+     * @return true if the index is ready
+     */
+    @Synchronized
+    fun index(recipes: List<Recipe>, ingredients: Map<Int, List<String>>): Boolean {
+        val assetManager = assets
+        if (!isNativeAvailable || assetManager == null) return false
+        if (isReady() && ingredients == indexedIngredients && recipes.all { it.id in recipeRows }) return true
+
+        val names = ArrayList<String>()
+        recipes.forEach { recipe -> names.addAll(ingredients[recipe.id].orEmpty()) }
+        val rows = try {
+            buildIndex(
+                assetManager, VOCABULARY_ASSET, RECIPE_ASSETS,
+                Array(recipes.size) { recipes[it].name },
+                IntArray(recipes.size) { ingredients[recipes[it].id].orEmpty().size },
+                names.toTypedArray()
+            )
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Ingredient index unavailable: ${e.message}")
+            null
+        }
+        if (rows == null) {
+            version = -1
+            return false
+        }
+        recipeRows = recipes.indices.associate { recipes[it].id to rows[it] }
+        indexedIngredients = ingredients
+        nameRows.clear()
+        // A rebuilt index starts with an empty inventory; send the last one again
+        version = inventory?.let { setInventory(expand(it)) } ?: 0
+        Log.i(TAG, "✅ Indexed ${recipes.size} recipes")
+        return true
+    }
+
+    /**
+     * Brings the native inventory in line with `items`, sending only what changed
+     * @return The inventory version, or -1 when the index is not ready
+     */
+    @Synchronized
+    fun syncInventory(items: List<InventoryItem>): Long {
+        if (!isReady()) return -1
+        val current = items.groupingBy { it.name.lowercase().trim() }.eachCount()
+        val previous = inventory
+        version = if (previous == null) {
+            setInventory(expand(current))
+        } else if (current != previous) {
+            val added = ArrayList<String>()
+            val removed = ArrayList<String>()
+            (current.keys + previous.keys).forEach { name ->
+                val delta = (current[name] ?: 0) - (previous[name] ?: 0)
+                repeat(maxOf(delta, 0)) { added.add(name) }
+                repeat(maxOf(-delta, 0)) { removed.add(name) }
+            }
+            updateInventory(added.toTypedArray(), removed.toTypedArray())
+        } else {
+            version
+        }
+        inventory = current
+        return version
+    }
+
+    /**
+     * Missing ingredient count per recipe; recipes outside the recipe table are
+     * matched by name against the bundled recipes
+     * @return Counts in recipe order, -1 where unknown, or null when not ready
+     */
+    fun missingCounts(recipes: List<Recipe>): IntArray? {
+        if (!isReady()) return null
+        return missingCounts(IntArray(recipes.size) { rowOf(recipes[it]) })
+    }
+
+    /** Names of the recipe's ingredients not covered by the inventory, or null if unknown */
+    fun missingIngredients(recipe: Recipe): List<String>? {
+        if (!isReady()) return null
+        val row = rowOf(recipe)
+        return if (row >= 0) missingIngredients(row).toList() else null
+    }
+
+    /** Recipe names missing at most `maxMissing` ingredients, fewest missing first */
+    fun cookable(maxMissing: Int = 0, limit: Int = 20): List<String> {
+        if (!isReady()) return emptyList()
+        return cookableRecipes(maxMissing, limit).toList()
+    }
+
+    private fun rowOf(recipe: Recipe): Int =
+        recipeRows[recipe.id] ?: nameRows.getOrPut(recipe.name) { findRecipe(recipe.name) }
+
+    private fun expand(counts: Map<String, Int>): Array<String> =
+        counts.flatMap { (name, count) -> List(count) { name } }.toTypedArray()
+}
@@ -0,0 +1,159 @@
+package com.example.tastydiet.util
+
+import android.util.Log
+import com.example.tastydiet.data.models.FamilyMember
+import com.example.tastydiet.data.models.Recipe
+
+/**
+ * Native meal planner over the recipe table, kept as one column per macro.
+ * Every meal slot is scored for all recipes at once, then a bounded search picks
+ * the whole day's combination closest to each member's calorie and macro targets.
+ * Family members share each dish with their own portion, and recipes eaten in the
+ * last few days are pushed down so a week does not repeat itself.
+ */
+object NativeMealPlanner {
+    private const val TAG = "NativeMealPlanner"
+
+    // Layout of the planMeals result: header, meals, then per-day totals
+    private const val PLAN_HEADER = 3
+    private const val MACRO_COUNT = 5
+    const val TOTAL_CALORIES = 0
+    const val TOTAL_PROTEIN = 1
+    const val TOTAL_CARBS = 2
+    const val TOTAL_FAT = 3
+    const val TOTAL_FIBER = 4
+
+    /** Meal types in bit order of the recipe meal masks */
+    val MEAL_TYPES = listOf("Breakfast", "Lunch", "Dinner", "Snack")
+
+    private val isNativeAvailable: Boolean by lazy {
+        try {
+            System.loadLibrary("llama_jni")
+            true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Native library not available: ${e.message}")
+            false
+        }
+    }
+
+    @Volatile
+    private var recipes: List<Recipe> = emptyList()
+
+    private external fun loadRecipes(
+        calories: FloatArray, protein: FloatArray, carbs: FloatArray, fat: FloatArray, fiber: FloatArray,
+        mealMasks: IntArray, available: BooleanArray
+    ): Boolean
+    private external fun setAvailability(available: BooleanArray): Boolean
+    private external fun planMeals(memberTargets: FloatArray, slotMasks: IntArray, slotShares: FloatArray, days: Int): FloatArray?
+
+    /**
+     * A planned stretch of days. Slots follow the order passed to [plan],
+     * members the order of the member list.
+     */
+    class Plan internal constructor(
+        private val values: FloatArray,
+        private val recipes: List<Recipe>,
+        val days: Int,
+        val slotCount: Int,
+        val memberCount: Int
+    ) {
+        /** Sum of the daily squared relative misses against the targets */
+        val cost: Float get() = values[0]
+        val elapsedMs: Float get() = values[2]
+
+        private fun mealOffset(day: Int, slot: Int) = PLAN_HEADER + (day * slotCount + slot) * (1 + memberCount)
+
+        /** Recipe for the slot, or null when nothing available fits it */
+        fun recipe(day: Int, slot: Int): Recipe? {
+            val row = values[mealOffset(day, slot)].toInt()
+            return if (row >= 0) recipes[row] else null
+        }
+
+        fun grams(day: Int, slot: Int, member: Int): Float = values[mealOffset(day, slot) + 1 + member]
+
+        /** What the member eats that day, indexed by the TOTAL_* constants */
+        fun totals(day: Int, member: Int): FloatArray {
+            val offset = PLAN_HEADER + days * slotCount * (1 + memberCount) + (day * memberCount + member) * MACRO_COUNT
+            return values.copyOfRange(offset, offset + MACRO_COUNT)
+        }
+    }
+
+    /**
+     * Hands the recipe table to native code; call again when recipes change
+     * @param available Whether each recipe can be cooked from the inventory
+     * @return true if the native planner holds the recipes
+     */
+    @Synchronized
+    fun load(recipes: List<Recipe>, available: BooleanArray): Boolean {
+        if (!isNativeAvailable || recipes.size != available.size) return false
+        val loaded = try {
+            loadRecipes(
+                FloatArray(recipes.size) { recipes[it].caloriesPer100g.toFloat() },
+                FloatArray(recipes.size) { recipes[it].proteinPer100g },
+                FloatArray(recipes.size) { recipes[it].carbsPer100g },
+                FloatArray(recipes.size) { recipes[it].fatPer100g },
+                FloatArray(recipes.size) { recipes[it].fiberPer100g },
+                IntArray(recipes.size) { mealMask(recipes[it]) },
+                available
+            )
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Meal planner unavailable: ${e.message}")
+            false
+        }
+        this.recipes = if (loaded) recipes else emptyList()
+        return loaded
+    }
+
+    /**
+     * Inventory changed: same recipes as the last [load], new availability
+     */
+    @Synchronized
+    fun updateAvailability(available: BooleanArray): Boolean {
+        if (recipes.isEmpty()) return false
+        return try {
+            setAvailability(available)
+        } catch (e: UnsatisfiedLinkError) {
+            false
+        }
+    }
+
+    /**
+     * Plans `days` days of the given meal slots for everyone in `members`
+     * @param slots Meal type and its share of the daily calories, in serving order
+     * @return The plan, or null when the native planner is unavailable
+     */
+    fun plan(members: List<FamilyMember>, slots: List<Pair<String, Float>>, days: Int): Plan? {
+        val table = recipes
+        if (table.isEmpty() || members.isEmpty() || slots.isEmpty() || days <= 0) return null
+        val targets = FloatArray(members.size * MACRO_COUNT)
+        members.forEachIndexed { m, member ->
+            targets[m * MACRO_COUNT + TOTAL_CALORIES] = member.targetCalories
+            targets[m * MACRO_COUNT + TOTAL_PROTEIN] = member.targetProtein
+            targets[m * MACRO_COUNT + TOTAL_CARBS] = member.targetCarbs
+            targets[m * MACRO_COUNT + TOTAL_FAT] = member.targetFat
+            targets[m * MACRO_COUNT + TOTAL_FIBER] = member.fiberGoal.toFloat()
+        }
+        val slotMasks = IntArray(slots.size) { mealTypeBit(slots[it].first) }
+        val slotShares = FloatArray(slots.size) { slots[it].second }
+        val values = try {
+            planMeals(targets, slotMasks, slotShares, days)
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "⚠️ Meal planner unavailable: ${e.message}")
+            null
+        } ?: return null
+        val plan = Plan(values, table, days, slots.size, members.size)
+        Log.i(TAG, "🗓️ Planned $days days for ${members.size} members in ${plan.elapsedMs}ms (cost ${plan.cost})")
+        return plan
+    }
+
+    private fun mealTypeBit(mealType: String): Int {
+        val index = MEAL_TYPES.indexOfFirst { it.equals(mealType, ignoreCase = true) }
+        return if (index >= 0) 1 shl index else 0
+    }
+
+    // Category and meal type both count; recipes tagged with neither fit any meal
+    private fun mealMask(recipe: Recipe): Int {
+        val mask = mealTypeBit(recipe.category) or mealTypeBit(recipe.getRecipeMealType())
+        return if (mask != 0) mask else (1 shl MEAL_TYPES.size) - 1
+    }
+}
@@ -7,6 +7,7 @@ import com.example.tastydiet.data.models.*
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 import kotlinx.coroutines.flow.first
+import java.time.LocalDate
 import kotlin.math.abs
 import kotlin.math.min
 
@@ -29,8 +30,13 @@ class SmartMealPlanner(
         date: String
     ): SmartMealPlan = withContext(Dispatchers.IO) {
         try {
+            // Whole-day optimization when the native planner is available
+            planNatively(listOf(member), date, days = 1)?.let { return@withContext it.first() }
+            
             val mealSuggestions = mutableListOf<MealSuggestion>()
-            val availableInventory = inventoryDao.getAllInventoryItems().first().map { it.name.lowercase().trim() }
+            val inventoryItems = inventoryDao.getAllInventoryItems().first()
+            NativeIngredientIndex.syncInventory(inventoryItems)
+            val availableInventory = inventoryItems.map { it.name.lowercase().trim() }
             
             // Generate suggestions for each meal type
             for ((mealType, caloriePercentage) in mealDistribution) {
@@ -77,6 +83,101 @@ class SmartMealPlanner(
         }
     }
 
+    /**
+     * Plans several days for the whole family at once: everyone shares each dish in
+     * their own portion, and the week avoids repeating recent recipes
+     * @return One plan per day and member, days first
+     */
+    suspend fun generateFamilyMealPlans(
+        members: List<FamilyMember>,
+        startDate: String,
+        days: Int = 7
+    ): List<SmartMealPlan> = withContext(Dispatchers.IO) {
+        try {
+            planNatively(members, startDate, days)?.let { return@withContext it }
+        } catch (e: Exception) {
+            println("Error in native meal planning: ${e.message}")
+        }
+        (0 until days).flatMap { day ->
+            members.map { member -> generateSmartMealPlan(member, dateAfter(startDate, day)) }
+        }
+    }
+
+    private suspend fun planNatively(members: List<FamilyMember>, startDate: String, days: Int): List<SmartMealPlan>? {
+        if (members.isEmpty()) return null
+        val recipes = recipeDao.getAll().first()
+        if (recipes.isEmpty() || !NativeMealPlanner.load(recipes, recipeAvailability(recipes))) return null
+        val slots = mealDistribution.toList()
+        val plan = NativeMealPlanner.plan(members, slots, days) ?: return null
+        
+        fun recipeId(day: Int, mealType: String): Int? =
+            plan.recipe(day, slots.indexOfFirst { it.first == mealType })?.id
+        
+        return (0 until days).flatMap { day ->
+            members.mapIndexed { m, member ->
+                val totals = plan.totals(day, m)
+                SmartMealPlan(
+                    date = dateAfter(startDate, day),
+                    memberId = member.id,
+                    breakfastRecipeId = recipeId(day, "Breakfast"),
+                    lunchRecipeId = recipeId(day, "Lunch"),
+                    dinnerRecipeId = recipeId(day, "Dinner"),
+                    snackRecipeId = recipeId(day, "Snack"),
+                    totalCalories = totals[NativeMealPlanner.TOTAL_CALORIES],
+                    totalProtein = totals[NativeMealPlanner.TOTAL_PROTEIN],
+                    totalCarbs = totals[NativeMealPlanner.TOTAL_CARBS],
+                    totalFat = totals[NativeMealPlanner.TOTAL_FAT],
+                    totalFiber = totals[NativeMealPlanner.TOTAL_FIBER],
+                    targetCalories = member.targetCalories,
+                    targetProtein = member.targetProtein,
+                    targetCarbs = member.targetCarbs,
+                    targetFat = member.targetFat,
+                    targetFiber = member.fiberGoal.toFloat()
+                )
+            }
+        }
+    }
+
+    // Whether each recipe can be cooked from the inventory, in one pass over all ingredients
+    private suspend fun recipeAvailability(recipes: List<Recipe>): BooleanArray {
+        val inventoryItems = inventoryDao.getAllInventoryItems().first()
+        // Chunked to stay under SQLite's bound parameter limit
+        val ingredientsByRecipe = recipes.map { it.id }.chunked(500)
+            .flatMap { recipeIngredientDao.getIngredientsForRecipes(it) }
+            .groupBy { it.recipeId }
+
+        // Native bitset match when available; the index only rebuilds when recipes change
+        if (NativeIngredientIndex.index(recipes, ingredientsByRecipe.mapValues { (_, list) -> list.map { it.ingredientName } }) &&
+            NativeIngredientIndex.syncInventory(inventoryItems) >= 0) {
+            NativeIngredientIndex.missingCounts(recipes)?.let { counts ->
+                return BooleanArray(recipes.size) { counts[it] == 0 }
+            }
+        }
+
+        val availableInventory = inventoryItems.map { it.name.lowercase().trim() }
+        return BooleanArray(recipes.size) { i ->
+            ingredientsByRecipe[recipes[i].id].orEmpty().all { ingredient ->
+                isInInventory(ingredient.ingredientName, availableInventory)
+            }
+        }
+    }
+
+    private fun isInInventory(ingredientName: String, availableInventory: List<String>): Boolean {
+        val name = ingredientName.lowercase().trim()
+        return availableInventory.any { inventoryItem ->
+            inventoryItem.equals(name, ignoreCase = true) || name.contains(inventoryItem) || inventoryItem.contains(name)
+        }
+    }
+
+    private fun dateAfter(date: String, days: Int): String {
+        if (days == 0) return date
+        return try {
+            LocalDate.parse(date).plusDays(days.toLong()).toString()
+        } catch (e: Exception) {
+            date
+        }
+    }
+
     private suspend fun generateMealSuggestion(
         mealType: String,
         targetCalories: Float,
@@ -87,17 +188,15 @@ class SmartMealPlanner(
             // Get recipes for this meal type
             val recipes = recipeDao.getRandomRecipesForMealType(mealType, 10)
             
-            // Filter recipes based on available ingredients
-            val feasibleRecipes = recipes.filter { recipe ->
+            // Filter recipes based on available ingredients; the native index (synced by
+            // recipeAvailability) answers for the recipes it knows
+            val missingCounts = NativeIngredientIndex.missingCounts(recipes)
+            val feasibleRecipes = recipes.filterIndexed { i, recipe ->
+                val missing = missingCounts?.get(i) ?: -1
+                if (missing >= 0) return@filterIndexed missing == 0
                 try {
                     val ingredients = recipeIngredientDao.getIngredientsForRecipe(recipe.id)
-                    ingredients.all { ingredient ->
-                        availableInventory.any { inventoryItem ->
-                            inventoryItem.equals(ingredient.ingredientName.lowercase().trim(), ignoreCase = true) ||
-                            ingredient.ingredientName.lowercase().trim().contains(inventoryItem) ||
-                            inventoryItem.contains(ingredient.ingredientName.lowercase().trim())
-                        }
-                    }
+                    ingredients.all { ingredient -> isInInventory(ingredient.ingredientName, availableInventory) }
                 } catch (e: Exception) {
                     // If we can't get ingredients, assume it's feasible
                     true
@@ -266,7 +365,9 @@ class SmartMealPlanner(
     ): MealSuggestion = withContext(Dispatchers.IO) {
         try {
             val targetCalories = member.targetCalories * (mealDistribution[mealType] ?: 0.25f)
-            val availableInventory = inventoryDao.getAllInventoryItems().first().map { it.name.lowercase().trim() }
+            val inventoryItems = inventoryDao.getAllInventoryItems().first()
+            NativeIngredientIndex.syncInventory(inventoryItems)
+            val availableInventory = inventoryItems.map { it.name.lowercase().trim() }
             
             generateMealSuggestion(
                 mealType = mealType,
@@ -298,14 +399,20 @@ class SmartMealPlanner(
     suspend fun checkIngredientAvailability(recipeId: Int): Pair<Boolean, List<String>> {
         try {
             val ingredients = recipeIngredientDao.getIngredientsForRecipe(recipeId)
-            val availableInventory = inventoryDao.getAllInventoryItems().first().map { it.name.lowercase().trim() }
+            val inventoryItems = inventoryDao.getAllInventoryItems().first()
             
-            val missingIngredients = ingredients.filter { ingredient ->
-                availableInventory.none { inventoryItem ->
-                    inventoryItem.equals(ingredient.ingredientName.lowercase().trim(), ignoreCase = true) ||
-                    ingredient.ingredientName.lowercase().trim().contains(inventoryItem) ||
-                    inventoryItem.contains(ingredient.ingredientName.lowercase().trim())
+            // Indexed recipes answer from the native bitsets
+            recipeDao.getById(recipeId)?.let { recipe ->
+                if (NativeIngredientIndex.syncInventory(inventoryItems) >= 0) {
+                    NativeIngredientIndex.missingIngredients(recipe)?.let { missing ->
+                        return Pair(missing.isEmpty(), missing)
+                    }
                 }
+            }
+            
+            val availableInventory = inventoryItems.map { it.name.lowercase().trim() }
+            val missingIngredients = ingredients.filter { ingredient ->
+                !isInInventory(ingredient.ingredientName, availableInventory)
             }.map { it.ingredientName }
             
             return Pair(missingIngredients.isEmpty(), missingIngredients)
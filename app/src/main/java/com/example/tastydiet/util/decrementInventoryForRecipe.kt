@@ -19,14 +19,16 @@ fun decrementInventoryForRecipe(
     inventoryList: MutableList<InventoryItem>,
     ingredientsForRecipe: List<Ingredient>
 ) {
+    // One pass to key the inventory by name and unit instead of a scan per ingredient
+    val positions = HashMap<Pair<String, String>, Int>(inventoryList.size * 2)
+    inventoryList.forEachIndexed { idx, item ->
+        positions.putIfAbsent(item.name.lowercase() to item.unit.lowercase(), idx)
+    }
     for (ingredient in ingredientsForRecipe) {
-        val inventoryItem = inventoryList.find {
-            it.name.equals(ingredient.name, ignoreCase = true) &&
-            it.unit.equals(ingredient.unit, ignoreCase = true)
-        }
-        if (inventoryItem != null) {
+        val idx = positions[ingredient.name.lowercase() to ingredient.unit.lowercase()]
+        if (idx != null) {
+            val inventoryItem = inventoryList[idx]
             if (inventoryItem.quantity >= ingredient.quantity) {
-                val idx = inventoryList.indexOf(inventoryItem)
                 inventoryList[idx] = inventoryItem.copy(quantity = inventoryItem.quantity - ingredient.quantity)
             } else {
                 // Not enough in inventory: skip or warn
@@ -15,9 +15,12 @@ import com.example.tastydiet.data.ShoppingListDao
 import com.example.tastydiet.data.models.FoodItem
 import com.example.tastydiet.data.models.FoodLog
 import com.example.tastydiet.data.models.InventoryItem
+import com.example.tastydiet.data.models.NutritionalInfo
 import com.example.tastydiet.data.models.ShoppingListItem
 import com.example.tastydiet.ui.components.ChatMessage
 import com.example.tastydiet.llm.LlamaManager
+import com.example.tastydiet.util.FoodUnits
+import com.example.tastydiet.util.NativeFoodIndex
 import com.example.tastydiet.voice.VoskManager
 import com.example.tastydiet.utils.RecipeVideoManager
 import kotlinx.coroutines.flow.MutableStateFlow
@@ -85,6 +88,9 @@ class AIAssistantViewModel(application: Application) : AndroidViewModel(applicat
     // Local LLM Manager
     private val llamaManager = LlamaManager(application)
     
+    // Native session holding the conversation, opened on the first LLM reply
+    private var chatSession = -1
+    
     // Vosk Manager for speech recognition
     private val voskManager = VoskManager(application)
     
@@ -143,6 +149,13 @@ class AIAssistantViewModel(application: Application) : AndroidViewModel(applicat
                     val success = llamaManager.initializeModel()
                     if (success) {
                         Log.d("AIAssistantViewModel", "Model initialized successfully")
+                        // Builds once per model; later launches just map the cached file.
+                        // The model is still warming up natively, so wait for it first.
+                        viewModelScope.launch {
+                            if (!llamaManager.waitForModelReady()) return@launch
+                            llamaManager.prepareSemanticIndex()
+                            llamaManager.enableSpeculativeDecoding()
+                        }
                         addMessage(ChatMessage(
                             text = modelStatus.userMessage,
                             isUser = false,
@@ -327,11 +340,17 @@ class AIAssistantViewModel(application: Application) : AndroidViewModel(applicat
                 // Check model status first
                 val modelStatus = llamaManager.getModelStatus()
                 
+                // Obvious structured commands are answered directly, without a decode pass
+                val routedResponse = llamaManager.routeCommand(userInput)?.let { action ->
+                    handleRoutedCommand(action, userInput.lowercase())
+                }
+                
                 // Try to use local LLM first
-                val response = if (modelStatus.isAvailable && llamaManager.isModelReady()) {
+                val response = routedResponse ?: if (modelStatus.isAvailable && llamaManager.isModelReady()) {
                     try {
-                        // Send just the user input to LlamaManager
-                        llamaManager.generateResponse(userInput)
+                        // Earlier turns stay in the session's KV cache, so only this one is evaluated
+                        if (chatSession < 0) chatSession = llamaManager.openSession()
+                        llamaManager.chat(userInput, chatSession)
                     } catch (e: Exception) {
                         // Fallback to rule-based responses
                         Log.w("AIAssistantViewModel", "LLM failed, using fallback: ${e.message}")
@@ -433,6 +452,21 @@ class AIAssistantViewModel(application: Application) : AndroidViewModel(applicat
         }
     }
     
+    /**
+     * Answer a command the native intent router classified with high confidence
+     * @return Response, or null when the action has no direct handler
+     */
+    private suspend fun handleRoutedCommand(action: String, userInput: String): String? {
+        return when (action) {
+            "MacroQuery" -> handleRemainingMacrosQuery(userInput)
+            "ShoppingList" -> handleShoppingListQuery(userInput)
+            "CheckInventory" -> handleInventoryQuery(userInput)
+            "InventoryAdd" -> handleInventoryAdd(userInput)
+            "MealSuggest", "RecipeSearch" -> handleRecipeSuggestion(userInput)
+            else -> null
+        }
+    }
+    
     /**
      * Generate fallback response based on user input (when LLM is not available)
      */
@@ -605,8 +639,9 @@ class AIAssistantViewModel(application: Application) : AndroidViewModel(applicat
      * Handle food logging requests
      */
     private suspend fun handleFoodLogging(userInput: String): String {
-        // Extract food items from input
-        val foodItems = extractFoodItems(userInput)
+        // Structured parse (names, quantities, units) when the model is up; keyword match otherwise
+        val parsed = llamaManager.parseFoodLog(userInput)
+        val foodItems = parsed ?: extractFoodItems(userInput).map { LlamaManager.LoggedFood(it, 1.0f, "serving") }
         
         if (foodItems.isEmpty()) {
             return "I couldn't identify any food items. Please specify what you ate, like 'I ate rice and dal' or 'Log food: apple'"
@@ -614,40 +649,57 @@ class AIAssistantViewModel(application: Application) : AndroidViewModel(applicat
         
         val loggedItems = mutableListOf<String>()
         
-        for (foodName in foodItems) {
+        for (item in foodItems) {
             try {
-                // Find food in database
-                val foodItem = nutritionalInfoDao.getByName(foodName)
+                // Find food in database; parsed names come from the native food index
+                val foodItem = nutritionalInfoDao.getByName(item.name) ?: NativeFoodIndex.lookup(item.name)
                 
                 if (foodItem != null) {
-                    // Log the food
+                    // Values are per 100g
+                    val factor = loggedGrams(item, foodItem) / 100f
                     val foodLog = FoodLog(
                         profileId = 1, // Default profile
                         foodName = foodItem.name,
                         mealType = "Snack", // Default meal type
-                        quantity = 1.0f,
-                        unit = "serving",
-                        calories = foodItem.caloriesPer100g,
-                        protein = foodItem.proteinPer100g,
-                        carbs = foodItem.carbsPer100g,
-                        fat = foodItem.fatPer100g,
-                        fiber = foodItem.fiberPer100g,
+                        quantity = item.quantity,
+                        unit = item.unit,
+                        calories = foodItem.caloriesPer100g * factor,
+                        protein = foodItem.proteinPer100g * factor,
+                        carbs = foodItem.carbsPer100g * factor,
+                        fat = foodItem.fatPer100g * factor,
+                        fiber = foodItem.fiberPer100g * factor,
                         timestamp = System.currentTimeMillis()
                     )
                     
                     foodLogDao.insertFoodLog(foodLog)
-                    loggedItems.add("${foodItem.name} (${foodItem.caloriesPer100g} cal)")
+                    loggedItems.add("${foodItem.name} (${foodLog.calories.toInt()} cal)")
                 } else {
-                    loggedItems.add("$foodName (not found in database)")
+                    loggedItems.add("${item.name} (not found in database)")
                 }
             } catch (e: Exception) {
-                loggedItems.add("$foodName (error logging)")
+                loggedItems.add("${item.name} (error logging)")
             }
         }
         
         return "Logged: ${loggedItems.joinToString(", ")}"
     }
     
+    /**
+     * Weight of a logged item in grams. A "serving" is one of the food's own
+     * units (a piece of idli, a cup of dal), or 100 g for foods kept per gram
+     */
+    private fun loggedGrams(item: LlamaManager.LoggedFood, food: NutritionalInfo): Float {
+        val servingGrams = when (food.unit.lowercase()) {
+            "g", "gram", "grams", "kg", "ml" -> 100f
+            else -> FoodUnits.gramsPer(food.unit) ?: 100f
+        }
+        return if (item.unit == "serving") {
+            item.quantity * servingGrams
+        } else {
+            FoodUnits.toGrams(item.quantity, item.unit) ?: (item.quantity * servingGrams)
+        }
+    }
+    
     /**
      * Handle inventory queries
      */
@@ -789,6 +841,14 @@ class AIAssistantViewModel(application: Application) : AndroidViewModel(applicat
      * Handle recipe suggestions
      */
     private suspend fun handleRecipeSuggestion(userInput: String): String {
+        val matches = llamaManager.semanticSearch(userInput, limit = 5)
+        if (matches.isNotEmpty()) {
+            return "Here are some ideas that match what you asked for:\n\n" +
+                    matches.joinToString("\n") { match ->
+                        (if (match.isRecipe) "🍲 " else "🥗 ") + "**${match.name}**"
+                    } +
+                    "\n\nWould you like me to help you log any of these or suggest more?"
+        }
         return "Here are some healthy recipe suggestions:\n\n" +
                 "🥗 **Vegetable Stir-Fry with Brown Rice**\n" +
                 "📺 [Watch Recipe Video](youtube://vegetable-stir-fry-brown-rice)\n\n" +
@@ -1013,6 +1073,7 @@ class AIAssistantViewModel(application: Application) : AndroidViewModel(applicat
     override fun onCleared() {
         super.onCleared()
         textToSpeech?.shutdown()
+        llamaManager.closeSession(chatSession)
         llamaManager.cleanupResources()
         voskManager.dispose()
     }
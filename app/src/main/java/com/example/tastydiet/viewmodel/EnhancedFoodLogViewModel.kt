@@ -12,6 +12,7 @@ import com.example.tastydiet.data.models.FoodLog
 import com.example.tastydiet.data.models.NutritionalInfo
 import com.example.tastydiet.data.models.Profile
 import com.example.tastydiet.util.EnhancedMacroCalculator
+import com.example.tastydiet.util.FoodUnits
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
@@ -27,7 +28,7 @@ class EnhancedFoodLogViewModel(application: Application) : AndroidViewModel(appl
     private val nutritionalInfoDao = AppDatabase.getInstance(application).nutritionalInfoDao()
     private val profileDao = AppDatabase.getInstance(application).profileDao()
     private val inventoryDao = AppDatabase.getInstance(application).inventoryDao()
-    private val enhancedMacroCalculator = EnhancedMacroCalculator(nutritionalInfoDao)
+    private val enhancedMacroCalculator = EnhancedMacroCalculator(nutritionalInfoDao, application)
     
     // State management
     private val _currentFoodLogs = MutableStateFlow<List<FoodLog>>(emptyList())
@@ -414,24 +415,11 @@ class EnhancedFoodLogViewModel(application: Application) : AndroidViewModel(appl
     
     // Unit conversion helper
     private fun convertToGrams(quantity: Float, unit: String): Float {
-        val convertedQuantity = when (unit.lowercase()) {
-            "g", "gram", "grams" -> quantity
-            "kg", "kilogram", "kilograms" -> quantity * 1000f
-            "oz", "ounce", "ounces" -> quantity * 28.35f
-            "lb", "pound", "pounds" -> quantity * 453.59f
-            "cup", "cups" -> quantity * 240f
-            "tbsp", "tablespoon", "tablespoons" -> quantity * 15f
-            "tsp", "teaspoon", "teaspoons" -> quantity * 5f
-            "piece", "pieces", "pc", "pcs" -> quantity * 100f
-            "serving", "servings" -> quantity * 100f
-            "ml", "milliliter", "milliliters" -> quantity
-            else -> {
-                android.util.Log.w("EnhancedFoodLogViewModel", "Unknown unit: '$unit', using quantity as-is")
-                quantity
-            }
+        // Same weights the native food index converts its per-unit values with
+        return FoodUnits.toGrams(quantity, unit) ?: run {
+            android.util.Log.w("EnhancedFoodLogViewModel", "Unknown unit: '$unit', using quantity as-is")
+            quantity
         }
-        
-        return convertedQuantity
     }
     
     // Search functionality
@@ -9,6 +9,7 @@ import com.example.tastydiet.data.models.FoodLog
 import com.example.tastydiet.data.models.NutritionalInfo
 import com.example.tastydiet.data.models.Profile
 import com.example.tastydiet.util.EnhancedMacroCalculator
+import com.example.tastydiet.util.FoodUnits
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
@@ -294,16 +295,7 @@ class SimpleFoodLogViewModel(
 
     // 7. UTILITY FUNCTIONS
     private fun convertToGrams(quantity: Float, unit: String): Float {
-        return when (unit.lowercase()) {
-            "g", "grams" -> quantity
-            "pieces", "piece" -> quantity * 100f // Assume 100g per piece
-            "cups", "cup" -> quantity * 240f // 240g per cup
-            "tbsp", "tablespoon" -> quantity * 15f // 15g per tbsp
-            "tsp", "teaspoon" -> quantity * 5f // 5g per tsp
-            "ml", "milliliters" -> quantity * 1f // 1g per ml (approximate)
-            "oz", "ounces" -> quantity * 28.35f // 28.35g per oz
-            else -> quantity // Default to grams
-        }
+        return FoodUnits.toGrams(quantity, unit) ?: quantity // Default to grams
     }
 
     fun clearMessage() {